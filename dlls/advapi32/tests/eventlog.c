@@ -38,6 +38,8 @@ static BOOL (WINAPI *pGetEventLogInformation)(HANDLE,DWORD,LPVOID,DWORD,LPDWORD)
 static ULONG (WINAPI *pEventRegister)(const GUID *,PENABLECALLBACK,void *,REGHANDLE *);
 static ULONG (WINAPI *pEventUnregister)(REGHANDLE);
 static ULONG (WINAPI *pEventWriteString)(REGHANDLE,UCHAR,ULONGLONG,const WCHAR *);
+static ULONG (WINAPI *pEventWrite)(REGHANDLE,const EVENT_DESCRIPTOR *,ULONG,EVENT_DATA_DESCRIPTOR *);
+static BOOLEAN (WINAPI *pEventEnabled)(REGHANDLE,const EVENT_DESCRIPTOR *);
 
 static BOOL (WINAPI *pGetComputerNameExA)(COMPUTER_NAME_FORMAT,LPSTR,LPDWORD);
 static BOOL (WINAPI *pWow64DisableWow64FsRedirection)(PVOID *);
@@ -53,6 +55,8 @@ static void init_function_pointers(void)
     pEventWriteString = (void*)GetProcAddress(hadvapi32, "EventWriteString");
     pEventRegister = (void*)GetProcAddress(hadvapi32, "EventRegister");
     pEventUnregister = (void*)GetProcAddress(hadvapi32, "EventUnregister");
+    pEventWrite = (void*)GetProcAddress(hadvapi32, "EventWrite");
+    pEventEnabled = (void*)GetProcAddress(hadvapi32, "EventEnabled");
 
     pGetComputerNameExA = (void*)GetProcAddress(hkernel32, "GetComputerNameExA");
     pWow64DisableWow64FsRedirection = (void*)GetProcAddress(hkernel32, "Wow64DisableWow64FsRedirection");
@@ -1192,8 +1196,10 @@ static void test_trace_event_params(void)
 {
     static const WCHAR emptyW[] = {0};
     static const GUID test_guid = {0x57696E65, 0x0000, 0x0000, {0x00,0x00, 0x00,0x00,0x00,0x00,0x00,0x01}};
-
+    EVENT_DESCRIPTOR descriptor = {1, 0, 0, TRACE_LEVEL_INFORMATION, 0, 0, 0};
+    EVENT_DATA_DESCRIPTOR data;
     REGHANDLE reg_handle;
+    DWORD value = 1;
     ULONG uret;
 
     if (!pEventRegister)
@@ -1203,7 +1209,7 @@ static void test_trace_event_params(void)
     }
 
     uret = pEventRegister(NULL, NULL, NULL, &reg_handle);
-    todo_wine ok(uret == ERROR_INVALID_PARAMETER, "EventRegister gave wrong error: %#lx\n", uret);
+    ok(uret == ERROR_INVALID_PARAMETER, "EventRegister gave wrong error: %#lx\n", uret);
 
     uret = pEventRegister(&test_guid, NULL, NULL, NULL);
     ok(uret == ERROR_INVALID_PARAMETER, "EventRegister gave wrong error: %#lx\n", uret);
@@ -1212,16 +1218,105 @@ static void test_trace_event_params(void)
     ok(uret == ERROR_SUCCESS, "EventRegister gave wrong error: %#lx\n", uret);
 
     uret = pEventWriteString(0, 0, 0, emptyW);
-    todo_wine ok(uret == ERROR_INVALID_HANDLE, "EventWriteString gave wrong error: %#lx\n", uret);
+    ok(uret == ERROR_INVALID_HANDLE, "EventWriteString gave wrong error: %#lx\n", uret);
 
     uret = pEventWriteString(reg_handle, 0, 0, NULL);
-    todo_wine ok(uret == ERROR_INVALID_PARAMETER, "EventWriteString gave wrong error: %#lx\n", uret);
+    ok(uret == ERROR_INVALID_PARAMETER, "EventWriteString gave wrong error: %#lx\n", uret);
+
+    /* nobody is listening to the test provider */
+    ok(!pEventEnabled(reg_handle, &descriptor), "EventEnabled returned TRUE\n");
+
+    data.Ptr = (ULONG_PTR)&value;
+    data.Size = sizeof(value);
+    data.Reserved = 0;
+    uret = pEventWrite(reg_handle, &descriptor, 1, &data);
+    ok(uret == ERROR_SUCCESS, "EventWrite gave wrong error: %#lx\n", uret);
 
     uret = pEventUnregister(0);
-    todo_wine ok(uret == ERROR_INVALID_HANDLE, "EventUnregister gave wrong error: %#lx\n", uret);
+    ok(uret == ERROR_INVALID_HANDLE, "EventUnregister gave wrong error: %#lx\n", uret);
 
     uret = pEventUnregister(reg_handle);
     ok(uret == ERROR_SUCCESS, "EventUnregister gave wrong error: %#lx\n", uret);
+
+    if (!strcmp(winetest_platform, "wine"))
+    {
+        /* handles of unregistered providers are rejected */
+        uret = pEventWriteString(reg_handle, 0, 0, emptyW);
+        ok(uret == ERROR_INVALID_HANDLE, "EventWriteString gave wrong error: %#lx\n", uret);
+        uret = pEventWrite(reg_handle, &descriptor, 1, &data);
+        ok(uret == ERROR_INVALID_HANDLE, "EventWrite gave wrong error: %#lx\n", uret);
+        ok(!pEventEnabled(reg_handle, &descriptor), "EventEnabled returned TRUE\n");
+        uret = pEventUnregister(reg_handle);
+        ok(uret == ERROR_INVALID_HANDLE, "EventUnregister gave wrong error: %#lx\n", uret);
+        uret = pEventUnregister(0xdeadbeef);
+        ok(uret == ERROR_INVALID_HANDLE, "EventUnregister gave wrong error: %#lx\n", uret);
+    }
+}
+
+static const GUID trace_guid = {0x57696E65, 0x0000, 0x0000, {0x00,0x00, 0x00,0x00,0x00,0x00,0x00,0x02}};
+static const WCHAR trace_string[] = L"wine trace output test";
+
+static void trace_output_child(void)
+{
+    EVENT_DESCRIPTOR descriptor = {1, 0, 0, TRACE_LEVEL_INFORMATION, 0, 0, 0};
+    REGHANDLE reg_handle;
+    ULONG uret;
+
+    uret = pEventRegister(&trace_guid, NULL, NULL, &reg_handle);
+    ok(uret == ERROR_SUCCESS, "EventRegister gave wrong error: %#lx\n", uret);
+    ok(pEventEnabled(reg_handle, &descriptor), "EventEnabled returned FALSE\n");
+    uret = pEventWriteString(reg_handle, TRACE_LEVEL_INFORMATION, 0, trace_string);
+    ok(uret == ERROR_SUCCESS, "EventWriteString gave wrong error: %#lx\n", uret);
+    uret = pEventUnregister(reg_handle);
+    ok(uret == ERROR_SUCCESS, "EventUnregister gave wrong error: %#lx\n", uret);
+}
+
+static void test_trace_output(void)
+{
+    STARTUPINFOA si = {sizeof(si)};
+    PROCESS_INFORMATION pi;
+    char path[MAX_PATH], file[MAX_PATH], cmdline[MAX_PATH + 32], **argv;
+    DWORD size, i;
+    HANDLE handle;
+    char *data;
+    BOOL found = FALSE;
+
+    /* events only reach a trace file through the Wine specific configuration */
+    if (strcmp(winetest_platform, "wine") || !pEventRegister)
+    {
+        skip("trace output test is Wine specific\n");
+        return;
+    }
+
+    GetTempPathA(sizeof(path), path);
+    GetTempFileNameA(path, "etw", 0, file);
+    SetEnvironmentVariableA("WINEETW", "{57696e65-0000-0000-0000-000000000002}");
+    SetEnvironmentVariableA("WINEETWFILE", file);
+
+    winetest_get_mainargs(&argv);
+    sprintf(cmdline, "\"%s\" eventlog trace_output", argv[0]);
+    ok(CreateProcessA(NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi),
+       "CreateProcess failed: %lu\n", GetLastError());
+    wait_child_process(pi.hProcess);
+    CloseHandle(pi.hProcess);
+    CloseHandle(pi.hThread);
+
+    SetEnvironmentVariableA("WINEETW", NULL);
+    SetEnvironmentVariableA("WINEETWFILE", NULL);
+
+    handle = CreateFileA(file, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL);
+    ok(handle != INVALID_HANDLE_VALUE, "CreateFile failed: %lu\n", GetLastError());
+    size = GetFileSize(handle, NULL);
+    data = HeapAlloc(GetProcessHeap(), 0, size);
+    ok(ReadFile(handle, data, size, &size, NULL), "ReadFile failed: %lu\n", GetLastError());
+    CloseHandle(handle);
+    DeleteFileA(file);
+
+    ok(size >= 4 && !memcmp(data, "WETW", 4), "wrong trace file magic\n");
+    for (i = 0; !found && i + sizeof(trace_string) <= size; i++)
+        found = !memcmp(data + i, trace_string, sizeof(trace_string));
+    ok(found, "event string not found in the trace output\n");
+    HeapFree(GetProcessHeap(), 0, data);
 }
 
 static void test_start_trace(void)
@@ -1318,6 +1413,17 @@ done:
 
 START_TEST(eventlog)
 {
+    char **argv;
+    int argc;
+
+    argc = winetest_get_mainargs(&argv);
+    if (argc >= 3 && !strcmp(argv[2], "trace_output"))
+    {
+        init_function_pointers();
+        trace_output_child();
+        return;
+    }
+
     SetLastError(0xdeadbeef);
     CloseEventLog(NULL);
     if (GetLastError() == ERROR_CALL_NOT_IMPLEMENTED)
@@ -1338,6 +1444,7 @@ START_TEST(eventlog)
     test_read();
     test_clear();
     test_trace_event_params();
+    test_trace_output();
 
     /* Functional tests */
     if (create_new_eventlog())
@@ -91,6 +91,97 @@ static void processblock(SHA256_CTX *ctx, const UCHAR *buffer)
     ctx->h[7] += h;
 }
 
+#if defined(__i386__) || defined(__x86_64__)
+
+#include <intrin.h>
+#include <immintrin.h>
+
+#define SHA_TARGET __attribute__((target("sha,ssse3,sse4.1")))
+
+static BOOL have_sha_ni(void)
+{
+    static int supported = -1;
+    int regs[4];
+
+    if (supported != -1) return supported;
+
+    __cpuid(regs, 0);
+    if (regs[0] < 7)
+        return supported = FALSE;
+    __cpuid(regs, 1);
+    /* SSSE3 and SSE4.1 */
+    if (!(regs[2] & (1 << 9)) || !(regs[2] & (1 << 19)))
+        return supported = FALSE;
+    __cpuidex(regs, 7, 0);
+    /* SHA extensions */
+    return supported = !!(regs[1] & (1 << 29));
+}
+
+/* Intel SHA extensions, each loop iteration does four rounds. The state is
+ * kept as ABEF/CDGH, the layout expected by sha256rnds2. */
+static SHA_TARGET void processblocks_sha_ni(SHA256_CTX *ctx, const UCHAR *buffer, ULONG count)
+{
+    const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i state0, state1, abef, cdgh, msg[4], tmp;
+    int i;
+
+    tmp = _mm_loadu_si128((const __m128i *)&ctx->h[0]);
+    state1 = _mm_loadu_si128((const __m128i *)&ctx->h[4]);
+    tmp = _mm_shuffle_epi32(tmp, 0xb1);          /* CDAB */
+    state1 = _mm_shuffle_epi32(state1, 0x1b);    /* EFGH */
+    state0 = _mm_alignr_epi8(tmp, state1, 8);    /* ABEF */
+    state1 = _mm_blend_epi16(state1, tmp, 0xf0); /* CDGH */
+
+    while (count--)
+    {
+        abef = state0;
+        cdgh = state1;
+
+        for (i = 0; i < 16; i++)
+        {
+            if (i < 4)
+                msg[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(buffer + 16 * i)), mask);
+            else
+            {
+                /* W[t-16] + R0(W[t-15]) + W[t-7] + R1(W[t-2]) */
+                tmp = _mm_sha256msg1_epu32(msg[i & 3], msg[(i + 1) & 3]);
+                tmp = _mm_add_epi32(tmp, _mm_alignr_epi8(msg[(i + 3) & 3], msg[(i + 2) & 3], 4));
+                msg[i & 3] = _mm_sha256msg2_epu32(tmp, msg[(i + 3) & 3]);
+            }
+            tmp = _mm_add_epi32(msg[i & 3], _mm_loadu_si128((const __m128i *)&K[4 * i]));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, tmp);
+            tmp = _mm_shuffle_epi32(tmp, 0x0e);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, tmp);
+        }
+
+        state0 = _mm_add_epi32(state0, abef);
+        state1 = _mm_add_epi32(state1, cdgh);
+        buffer += 64;
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1b);       /* FEBA */
+    state1 = _mm_shuffle_epi32(state1, 0xb1);    /* DCHG */
+    state0 = _mm_blend_epi16(tmp, state1, 0xf0); /* DCBA */
+    state1 = _mm_alignr_epi8(state1, tmp, 8);    /* HGFE */
+    _mm_storeu_si128((__m128i *)&ctx->h[0], state0);
+    _mm_storeu_si128((__m128i *)&ctx->h[4], state1);
+}
+
+#endif
+
+static void processblocks(SHA256_CTX *ctx, const UCHAR *buffer, ULONG count)
+{
+#if defined(__i386__) || defined(__x86_64__)
+    if (have_sha_ni())
+    {
+        processblocks_sha_ni(ctx, buffer, count);
+        return;
+    }
+#endif
+    for (; count; count--, buffer += 64)
+        processblock(ctx, buffer);
+}
+
 static void pad(SHA256_CTX *ctx)
 {
     ULONG64 r = ctx->len % 64;
@@ -101,7 +192,7 @@ static void pad(SHA256_CTX *ctx)
     {
         memset(ctx->buf + r, 0, 64 - r);
         r = 0;
-        processblock(ctx, ctx->buf);
+        processblocks(ctx, ctx->buf, 1);
     }
 
     memset(ctx->buf + r, 0, 56 - r);
@@ -115,7 +206,7 @@ static void pad(SHA256_CTX *ctx)
     ctx->buf[62] = ctx->len >> 8;
     ctx->buf[63] = ctx->len;
 
-    processblock(ctx, ctx->buf);
+    processblocks(ctx, ctx->buf, 1);
 }
 
 void sha256_init(SHA256_CTX *ctx)
@@ -147,10 +238,11 @@ void sha256_update(SHA256_CTX *ctx, const UCHAR *buffer, ULONG len)
         memcpy(ctx->buf + r, p, 64 - r);
         len -= 64 - r;
         p += 64 - r;
-        processblock(ctx, ctx->buf);
+        processblocks(ctx, ctx->buf, 1);
     }
-    for (; len >= 64; len -= 64, p += 64)
-        processblock(ctx, p);
+    processblocks(ctx, p, len / 64);
+    p += len & ~63;
+    len &= 63;
     memcpy(ctx->buf, p, len);
 }
 
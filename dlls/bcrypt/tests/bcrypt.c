@@ -427,6 +427,90 @@ static void test_BcryptHash(void)
     ok(ret == STATUS_SUCCESS, "got %#lx\n", ret);
 }
 
+static void test_hash_large(void)
+{
+    static const struct
+    {
+        const WCHAR *alg;
+        ULONG hash_size;
+        const char *hash;
+    }
+    tests[] =
+    {
+        /* one million times 'a', from FIPS 180-2 */
+        { BCRYPT_SHA1_ALGORITHM, 20, "34aa973cd4c4daa4f61eeb2bdbad27316534016f" },
+        { BCRYPT_SHA256_ALGORITHM, 32, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0" },
+        { BCRYPT_SHA384_ALGORITHM, 48, "9d0e1809716474cb086e834e310a4a1ced149e9c00f248527972cec5704c2a5b"
+                                       "07b8b3dc38ecc4ebae97ddd87f3d8985" },
+        { BCRYPT_SHA512_ALGORITHM, 64, "e718483d0ce769644e2e42c7bc15b4638e1f98b13b2044285632a803afa973eb"
+                                       "de0ff244877ea60a4cb0432ce577c31beb009c5c2c49aa2e4eadb217ad8cc09b" },
+    };
+    static const ULONG data_size = 1000000, bench_size = 16 << 20;
+    BCRYPT_ALG_HANDLE alg;
+    BCRYPT_HASH_HANDLE hash;
+    UCHAR *buf, hash_buf[64];
+    char str[129];
+    ULONG i, j, len;
+    NTSTATUS ret;
+    DWORD start, elapsed;
+
+    if (!pBCryptHash) /* < Win10 */
+    {
+        win_skip("BCryptHash is not available\n");
+        return;
+    }
+
+    buf = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, winetest_interactive ? bench_size : data_size);
+    memset(buf, 'a', data_size);
+
+    for (i = 0; i < ARRAY_SIZE(tests); i++)
+    {
+        winetest_push_context("%s", wine_dbgstr_w(tests[i].alg));
+
+        alg = NULL;
+        ret = BCryptOpenAlgorithmProvider(&alg, tests[i].alg, MS_PRIMITIVE_PROVIDER, 0);
+        ok(ret == STATUS_SUCCESS, "got %#lx\n", ret);
+
+        memset(hash_buf, 0, sizeof(hash_buf));
+        ret = pBCryptHash(alg, NULL, 0, buf, data_size, hash_buf, tests[i].hash_size);
+        ok(ret == STATUS_SUCCESS, "got %#lx\n", ret);
+        format_hash(hash_buf, tests[i].hash_size, str);
+        ok(!strcmp(str, tests[i].hash), "got %s\n", str);
+
+        /* odd sized chunks go through the partial block paths */
+        hash = NULL;
+        ret = BCryptCreateHash(alg, &hash, NULL, 0, NULL, 0, 0);
+        ok(ret == STATUS_SUCCESS, "got %#lx\n", ret);
+        for (j = 0, len = 1; j < data_size; j += len, len = (len * 7 + 3) % 300)
+        {
+            ret = BCryptHashData(hash, buf + j, min(len, data_size - j), 0);
+            ok(ret == STATUS_SUCCESS, "got %#lx\n", ret);
+        }
+        memset(hash_buf, 0, sizeof(hash_buf));
+        ret = BCryptFinishHash(hash, hash_buf, tests[i].hash_size, 0);
+        ok(ret == STATUS_SUCCESS, "got %#lx\n", ret);
+        format_hash(hash_buf, tests[i].hash_size, str);
+        ok(!strcmp(str, tests[i].hash), "got %s\n", str);
+        BCryptDestroyHash(hash);
+
+        if (winetest_interactive)
+        {
+            start = GetTickCount();
+            ret = pBCryptHash(alg, NULL, 0, buf, bench_size, hash_buf, tests[i].hash_size);
+            ok(ret == STATUS_SUCCESS, "got %#lx\n", ret);
+            elapsed = GetTickCount() - start;
+            trace("%lu MB in %lu ms\n", bench_size >> 20, elapsed);
+        }
+
+        ret = BCryptCloseAlgorithmProvider(alg, 0);
+        ok(ret == STATUS_SUCCESS, "got %#lx\n", ret);
+
+        winetest_pop_context();
+    }
+
+    HeapFree(GetProcessHeap(), 0, buf);
+}
+
 /* test vectors from RFC 6070 */
 static UCHAR password[] = "password";
 static UCHAR salt[] = "salt";
@@ -3368,6 +3452,7 @@ START_TEST(bcrypt)
     test_BCryptGetFipsAlgorithmMode();
     test_hashes();
     test_BcryptHash();
+    test_hash_large();
     test_BcryptDeriveKeyPBKDF2();
     test_rng();
     test_3des();
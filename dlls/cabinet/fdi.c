@@ -60,6 +60,7 @@
 
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 
@@ -1124,7 +1125,14 @@ static cab_LONG fdi_Zipinflate_codes(const struct Ziphuft *tl, const struct Ziph
         e = ZIPWSIZE - max(d, w);
         e = min(e, n);
         n -= e;
-        do
+        if (d + e <= w || w + e <= d)
+        {
+          /* the ranges don't overlap, copy them in one go */
+          memcpy(CAB(outbuf) + w, CAB(outbuf) + d, e);
+          w += e;
+          d += e;
+        }
+        else do
         {
           CAB(outbuf)[w++] = CAB(outbuf)[d++];
         } while (--e);
@@ -1537,7 +1545,9 @@ static int QTMfdi_decomp(int inlen, int outlen, fdi_decomp_state *decomp_state)
       window_posn += match_length;
 
       /* copy match data - no worries about destination wraps */
-      while (match_length-- > 0) *rundest++ = *runsrc++;
+      if (rundest - runsrc >= match_length || runsrc - rundest >= match_length)
+        memcpy(rundest, runsrc, match_length); /* no overlap */
+      else while (match_length-- > 0) *rundest++ = *runsrc++;
     }
   } /* while (togo > 0) */
 
@@ -1775,7 +1785,9 @@ static int LZXfdi_decomp(int inlen, int outlen, fdi_decomp_state *decomp_state)
             window_posn += match_length;
 
             /* copy match data - no worries about destination wraps */
-            while (match_length-- > 0) *rundest++ = *runsrc++;
+            if (rundest - runsrc >= match_length || runsrc - rundest >= match_length)
+              memcpy(rundest, runsrc, match_length); /* no overlap */
+            else while (match_length-- > 0) *rundest++ = *runsrc++;
           }
         }
         break;
@@ -1864,7 +1876,9 @@ static int LZXfdi_decomp(int inlen, int outlen, fdi_decomp_state *decomp_state)
             window_posn += match_length;
 
             /* copy match data - no worries about destination wraps */
-            while (match_length-- > 0) *rundest++ = *runsrc++;
+            if (rundest - runsrc >= match_length || runsrc - rundest >= match_length)
+              memcpy(rundest, runsrc, match_length); /* no overlap */
+            else while (match_length-- > 0) *rundest++ = *runsrc++;
           }
         }
         break;
@@ -1906,7 +1920,10 @@ static int LZXfdi_decomp(int inlen, int outlen, fdi_decomp_state *decomp_state)
       LZX(intel_curpos) = curpos + outlen;
 
       while (data < dataend) {
-        if (*data++ != 0xE8) { curpos++; continue; }
+        cab_UBYTE *e8 = memchr(data, 0xE8, dataend - data);
+        if (!e8) break;
+        curpos += e8 - data;
+        data = e8 + 1;
         abs_off = data[0] | (data[1]<<8) | (data[2]<<16) | (data[3]<<24);
         if ((abs_off >= -curpos) && (abs_off < filesize)) {
           rel_off = (abs_off >= 0) ? abs_off - curpos : abs_off + filesize;
@@ -1923,6 +1940,31 @@ static int LZXfdi_decomp(int inlen, int outlen, fdi_decomp_state *decomp_state)
   return DECR_OK;
 }
 
+/**********************************************************
+ * fdi_init_decompressor (internal)
+ *
+ * Set up the decompressor for a folder compression type.
+ */
+static int fdi_init_decompressor(cab_UWORD comptype, fdi_decomp_state *decomp_state)
+{
+  switch (comptype & cffoldCOMPTYPE_MASK) {
+  case cffoldCOMPTYPE_NONE:
+    CAB(decompress) = NONEfdi_decomp;
+    return DECR_OK;
+  case cffoldCOMPTYPE_MSZIP:
+    CAB(decompress) = ZIPfdi_decomp;
+    return DECR_OK;
+  case cffoldCOMPTYPE_QUANTUM:
+    CAB(decompress) = QTMfdi_decomp;
+    return QTMfdi_init((comptype >> 8) & 0x1f, (comptype >> 4) & 0xF, decomp_state);
+  case cffoldCOMPTYPE_LZX:
+    CAB(decompress) = LZXfdi_decomp;
+    return LZXfdi_init((comptype >> 8) & 0x1f, decomp_state);
+  default:
+    return DECR_DATAFORMAT;
+  }
+}
+
 /**********************************************************
  * fdi_decomp (internal)
  *
@@ -1953,8 +1995,8 @@ static int fdi_decomp(const struct fdi_file *fi, int savemode, fdi_decomp_state
     if (cando > bytes) cando = bytes;
 
     /* if cando != 0 */
-    if (cando && savemode)
-      CAB(fdi)->write(CAB(filehf), CAB(outpos), cando);
+    if (cando && savemode && CAB(fdi)->write(CAB(filehf), CAB(outpos), cando) != cando)
+      return DECR_OUTPUT;
 
     CAB(outpos) += cando;
     CAB(outlen) -= cando;
@@ -2253,6 +2295,241 @@ static void free_decompression_mem(FDI_Int *fdi, fdi_decomp_state *decomp_state)
   }
 }
 
+/*
+ * Folders can be decompressed ahead of time by worker threads, each with its
+ * own handle to the cabinet, while FDICopy hands the files of the current
+ * folder to the caller.  Notifications and writes still happen in order on
+ * the calling thread.  This requires the alloc, open, read, seek and close
+ * callbacks to be thread safe, so it must be enabled with WINE_FDI_THREADS.
+ */
+struct fdi_prefetch {
+  struct fdi_folder *folder;
+  cab_ULONG size;                      /* uncompressed bytes used by files */
+  cab_UBYTE *data;                     /* decompressed data of the folder  */
+  BOOL skip;                           /* too large to be kept in memory   */
+  int status;                          /* DECR_* code, -1 while pending    */
+};
+
+struct fdi_parallel {
+  FDI_Int *fdi;
+  const char *path;                    /* full path of the cabinet         */
+  cab_UBYTE block_resv;
+  struct fdi_prefetch *folders;
+  unsigned int count;
+  unsigned int next;                   /* next folder to decompress        */
+  unsigned int current;                /* folder being written out         */
+  unsigned int ahead;                  /* how far workers may run ahead    */
+  unsigned int nb_threads;
+  HANDLE threads[MAXIMUM_WAIT_OBJECTS];
+  BOOL abort;
+  CRITICAL_SECTION cs;
+  CONDITION_VARIABLE cv;
+};
+
+/* folders larger than this are decompressed the usual way */
+#define FDI_PREFETCH_MAX (64 * 1024 * 1024)
+
+static unsigned int fdi_get_thread_count(void)
+{
+  char buffer[16];
+  SYSTEM_INFO si;
+  int count;
+
+  if (!GetEnvironmentVariableA("WINE_FDI_THREADS", buffer, sizeof(buffer))) return 0;
+  if ((count = atoi(buffer)) <= 0) {
+    GetSystemInfo(&si);
+    count = si.dwNumberOfProcessors;
+  }
+  return min(count, MAXIMUM_WAIT_OBJECTS);
+}
+
+/* decompress a whole folder into memory */
+static int fdi_prefetch_folder(struct fdi_parallel *par, struct fdi_prefetch *pf)
+{
+  FDI_Int *fdi = par->fdi;
+  fdi_decomp_state *decomp_state;
+  cab_UBYTE buf[cfdata_SIZEOF];
+  cab_UWORD inlen, outlen;
+  cab_ULONG done = 0, cksum;
+  unsigned int block;
+  INT_PTR cabhf;
+  int err;
+
+  if (!(decomp_state = fdi->alloc(sizeof(fdi_decomp_state)))) return DECR_NOMEMORY;
+  ZeroMemory(decomp_state, sizeof(fdi_decomp_state));
+  CAB(fdi) = fdi;
+
+  cabhf = fdi->open((char *)par->path, _O_RDONLY|_O_BINARY, _S_IREAD | _S_IWRITE);
+  if (cabhf == -1 || !cabhf) {
+    fdi->free(decomp_state);
+    return DECR_INPUT;
+  }
+
+  if (!(pf->data = fdi->alloc(pf->size))) err = DECR_NOMEMORY;
+  else if ((err = fdi_init_decompressor(pf->folder->comp_type, decomp_state))) ;
+  else if (fdi->seek(cabhf, pf->folder->offset, SEEK_SET) == -1) err = DECR_INPUT;
+
+  for (block = 0; !err && done < pf->size; block++) {
+    if (par->abort) err = DECR_USERABORT;
+    else if (block >= pf->folder->num_blocks) err = DECR_INPUT;
+    else if (fdi->read(cabhf, buf, cfdata_SIZEOF) != cfdata_SIZEOF) err = DECR_INPUT;
+    else if (fdi->seek(cabhf, par->block_resv, SEEK_CUR) == -1) err = DECR_INPUT;
+    if (err) break;
+
+    inlen = EndGetI16(buf+cfdata_CompressedSize);
+    outlen = EndGetI16(buf+cfdata_UncompressedSize);
+    /* split blocks only happen in cabinet sets, which are not prefetched */
+    if (inlen > CAB_INPUTMAX || !outlen) err = DECR_ILLEGALDATA;
+    else if (fdi->read(cabhf, CAB(inbuf), inlen) != inlen) err = DECR_INPUT;
+    if (err) break;
+
+    CAB(inbuf)[inlen+1] = CAB(inbuf)[inlen+2] = 0;
+    cksum = EndGetI32(buf+cfdata_CheckSum);
+    if (cksum && cksum != checksum(buf+4, 4, checksum(CAB(inbuf), inlen, 0)))
+      err = DECR_CHECKSUM;
+    else if (!(err = CAB(decompress)(inlen, outlen, decomp_state))) {
+      if (outlen > pf->size - done) outlen = pf->size - done;
+      memcpy(pf->data + done, CAB(outbuf), outlen);
+      done += outlen;
+    }
+  }
+
+  free_decompression_temps(fdi, pf->folder, decomp_state);
+  fdi->close(cabhf);
+  fdi->free(decomp_state);
+  return err;
+}
+
+static DWORD WINAPI fdi_prefetch_thread(void *arg)
+{
+  struct fdi_parallel *par = arg;
+  unsigned int index;
+  int status;
+
+  EnterCriticalSection(&par->cs);
+  for (;;) {
+    while (!par->abort && par->next < par->count && par->next >= par->current + par->ahead)
+      SleepConditionVariableCS(&par->cv, &par->cs, INFINITE);
+    if (par->abort || par->next >= par->count) break;
+    index = par->next++;
+    if (!par->folders[index].size || par->folders[index].skip) {
+      par->folders[index].status = DECR_DATAFORMAT;
+      WakeAllConditionVariable(&par->cv);
+      continue;
+    }
+    LeaveCriticalSection(&par->cs);
+
+    status = fdi_prefetch_folder(par, &par->folders[index]);
+    TRACE("folder %u: %u bytes, status %d\n", index, par->folders[index].size, status);
+
+    EnterCriticalSection(&par->cs);
+    par->folders[index].status = status;
+    WakeAllConditionVariable(&par->cv);
+  }
+  LeaveCriticalSection(&par->cs);
+  return 0;
+}
+
+static void fdi_parallel_free(struct fdi_parallel *par)
+{
+  unsigned int i;
+
+  if (!par) return;
+
+  EnterCriticalSection(&par->cs);
+  par->abort = TRUE;
+  WakeAllConditionVariable(&par->cv);
+  LeaveCriticalSection(&par->cs);
+
+  WaitForMultipleObjects(par->nb_threads, par->threads, TRUE, INFINITE);
+  for (i = 0; i < par->nb_threads; i++) CloseHandle(par->threads[i]);
+  for (i = 0; i < par->count; i++)
+    if (par->folders[i].data) par->fdi->free(par->folders[i].data);
+
+  DeleteCriticalSection(&par->cs);
+  par->fdi->free(par->folders);
+  par->fdi->free(par);
+}
+
+/* start decompressing the folders of a single cabinet in the background */
+static struct fdi_parallel *fdi_parallel_create(FDI_Int *fdi, const char *path, fdi_decomp_state *decomp_state)
+{
+  struct fdi_parallel *par;
+  struct fdi_folder *fol;
+  struct fdi_file *file;
+  unsigned int i, count = 0, nb_threads;
+  ULONGLONG size;
+
+  if (!(nb_threads = fdi_get_thread_count())) return NULL;
+  if (CAB(mii).hasnext || CAB(mii).prevname) return NULL;
+  for (fol = CAB(firstfol); fol; fol = fol->next) count++;
+  if (count < 2) return NULL;
+
+  if (!(par = fdi->alloc(sizeof(*par)))) return NULL;
+  ZeroMemory(par, sizeof(*par));
+  if (!(par->folders = fdi->alloc(count * sizeof(*par->folders)))) {
+    fdi->free(par);
+    return NULL;
+  }
+  ZeroMemory(par->folders, count * sizeof(*par->folders));
+
+  for (fol = CAB(firstfol), i = 0; fol; fol = fol->next, i++) {
+    par->folders[i].folder = fol;
+    par->folders[i].status = -1;
+  }
+  for (file = CAB(firstfile); file; file = file->next) {
+    if (file->index >= count) continue;
+    size = (ULONGLONG)file->offset + file->length;
+    if (size > FDI_PREFETCH_MAX) par->folders[file->index].skip = TRUE;
+    else if (size > par->folders[file->index].size) par->folders[file->index].size = size;
+  }
+
+  par->fdi = fdi;
+  par->path = path;
+  par->block_resv = CAB(mii).block_resv;
+  par->count = count;
+  par->ahead = nb_threads + 1;
+  InitializeCriticalSection(&par->cs);
+  InitializeConditionVariable(&par->cv);
+
+  for (i = 0; i < min(nb_threads, count); i++) {
+    if (!(par->threads[i] = CreateThread(NULL, 0, fdi_prefetch_thread, par, 0, NULL))) break;
+    par->nb_threads++;
+  }
+  if (!par->nb_threads) {
+    fdi_parallel_free(par);
+    return NULL;
+  }
+  TRACE("decompressing %u folders with %u threads\n", count, par->nb_threads);
+  return par;
+}
+
+/* wait for a folder to be decompressed, returns NULL if it has to be done the usual way */
+static struct fdi_prefetch *fdi_parallel_get(struct fdi_parallel *par, unsigned int index)
+{
+  struct fdi_prefetch *pf = NULL;
+  unsigned int i;
+
+  if (!par || index >= par->count || index < par->current) return NULL;
+
+  EnterCriticalSection(&par->cs);
+  if (index > par->current) {
+    /* files are stored in folder order, previous folders won't be needed again */
+    for (i = par->current; i < index; i++) {
+      if (par->folders[i].status == -1) continue;
+      if (par->folders[i].data) par->fdi->free(par->folders[i].data);
+      par->folders[i].data = NULL;
+    }
+    par->current = index;
+    WakeAllConditionVariable(&par->cv);
+  }
+  while (par->folders[index].status == -1 && !par->abort)
+    SleepConditionVariableCS(&par->cv, &par->cs, INFINITE);
+  if (par->folders[index].status == DECR_OK && par->folders[index].data) pf = &par->folders[index];
+  LeaveCriticalSection(&par->cs);
+  return pf;
+}
+
 /***********************************************************************
  *		FDICopy (CABINET.22)
  *
@@ -2436,6 +2713,8 @@ BOOL __cdecl FDICopy(
   cab_UBYTE         buf[64];
   struct fdi_folder *fol = NULL, *linkfol = NULL; 
   struct fdi_file   *file = NULL, *linkfile = NULL;
+  struct fdi_parallel *par = NULL;
+  struct fdi_prefetch *pf;
   fdi_decomp_state *decomp_state;
   FDI_Int *fdi = get_fdi_ptr( hfdi );
 
@@ -2569,6 +2848,8 @@ BOOL __cdecl FDICopy(
     linkfile = file;
   }
 
+  par = fdi_parallel_create(fdi, fullpath, decomp_state);
+
   for (file = CAB(firstfile); (file); file = file->next) {
 
     /*
@@ -2673,6 +2954,22 @@ BOOL __cdecl FDICopy(
 
       TRACE("Extracting file %s as requested by callee.\n", debugstr_a(file->filename));
 
+      if ((pf = fdi_parallel_get(par, file->index))) {
+        cab_ULONG pos, len;
+
+        /* write it in blocks, as it would be written without prefetching */
+        for (pos = 0; pos < file->length; pos += len) {
+          len = min(file->length - pos, CAB_BLOCKMAX);
+          if (fdi->write(filehf, pf->data + file->offset + pos, len) != len) {
+            err = DECR_OUTPUT;
+            break;
+          }
+        }
+        /* the decompressor state still belongs to the last folder done the usual way */
+        fol = CAB(current);
+        goto close_file;
+      }
+
       /* set up decomp_state */
       CAB(fdi) = fdi;
       CAB(filehf) = filehf;
@@ -2704,24 +3001,7 @@ BOOL __cdecl FDICopy(
         CAB(outlen) = 0;
 
         /* initialize the new decompressor */
-        switch (ct1) {
-        case cffoldCOMPTYPE_NONE:
-          CAB(decompress) = NONEfdi_decomp;
-          break;
-        case cffoldCOMPTYPE_MSZIP:
-          CAB(decompress) = ZIPfdi_decomp;
-          break;
-        case cffoldCOMPTYPE_QUANTUM:
-          CAB(decompress) = QTMfdi_decomp;
-          err = QTMfdi_init((comptype >> 8) & 0x1f, (comptype >> 4) & 0xF, decomp_state);
-          break;
-        case cffoldCOMPTYPE_LZX:
-          CAB(decompress) = LZXfdi_decomp;
-          err = LZXfdi_init((comptype >> 8) & 0x1f, decomp_state);
-          break;
-        default:
-          err = DECR_DATAFORMAT;
-        }
+        err = fdi_init_decompressor(comptype, decomp_state);
       }
 
       CAB(current) = fol;
@@ -2759,6 +3039,7 @@ BOOL __cdecl FDICopy(
       err = fdi_decomp(file, 1, decomp_state, pszCabPath, pfnfdin, pvUser);
       if (err) CAB(current) = NULL; else CAB(offset) += file->length;
 
+    close_file:
       /* fdintCLOSE_FILE_INFO notification */
       ZeroMemory(&fdin, sizeof(FDINOTIFICATION));
       fdin.pv = pvUser;
@@ -2781,6 +3062,9 @@ BOOL __cdecl FDICopy(
         case DECR_NOMEMORY:
           set_error( fdi, FDIERROR_ALLOC_FAIL, ERROR_NOT_ENOUGH_MEMORY );
           goto bail_and_fail;
+        case DECR_OUTPUT:
+          set_error( fdi, FDIERROR_TARGET_FILE, 0 );
+          goto bail_and_fail;
         default:
           set_error( fdi, FDIERROR_CORRUPT_CABINET, 0 );
           goto bail_and_fail;
@@ -2788,6 +3072,7 @@ BOOL __cdecl FDICopy(
     }
   }
 
+  fdi_parallel_free(par);
   if (fol) free_decompression_temps(fdi, fol, decomp_state);
   free_decompression_mem(fdi, decomp_state);
  
@@ -2795,6 +3080,7 @@ BOOL __cdecl FDICopy(
 
   bail_and_fail: /* here we free ram before error returns */
 
+  fdi_parallel_free(par);
   if (fol) free_decompression_temps(fdi, fol, decomp_state);
 
   if (filehf) fdi->close(filehf);
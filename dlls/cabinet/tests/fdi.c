@@ -941,6 +941,159 @@ static void test_FDICopy(void)
     FDIDestroy(hfdi);
 }
 
+#define FOLDER_FILES     8
+#define FOLDER_FILE_SIZE (256 * 1024)
+
+struct folder_sink
+{
+    char *data;
+    UINT size;
+};
+
+static int last_folder;
+static unsigned int folders_extracted;
+
+static void fill_folder_data(char *data, UINT size, unsigned int seed)
+{
+    UINT i;
+
+    /* compressible, but not trivially */
+    for (i = 0; i < size; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        data[i] = 'a' + (seed >> 28);
+    }
+}
+
+static UINT CDECL fdi_folder_write(INT_PTR hf, void *pv, UINT cb)
+{
+    struct folder_sink *sink = (struct folder_sink *)hf;
+
+    sink->data = sink->data ? HeapReAlloc(GetProcessHeap(), 0, sink->data, sink->size + cb)
+                            : HeapAlloc(GetProcessHeap(), 0, cb);
+    memcpy(sink->data + sink->size, pv, cb);
+    sink->size += cb;
+    return cb;
+}
+
+static INT_PTR CDECL fdi_folder_notify(FDINOTIFICATIONTYPE fdint, FDINOTIFICATION *info)
+{
+    struct folder_sink *sink;
+    unsigned int index;
+    char *expected;
+
+    switch (fdint)
+    {
+    case fdintCOPY_FILE:
+        ok(info->iFolder >= last_folder, "got folder %u after %d\n", info->iFolder, last_folder);
+        last_folder = info->iFolder;
+        sink = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*sink));
+        return (INT_PTR)sink;
+
+    case fdintCLOSE_FILE_INFO:
+        sink = (struct folder_sink *)info->hf;
+        ok(sscanf(info->psz1, "folder%u.dat", &index) == 1, "unexpected file %s\n", info->psz1);
+        ok(sink->size == FOLDER_FILE_SIZE, "%s: got size %u\n", info->psz1, sink->size);
+        expected = HeapAlloc(GetProcessHeap(), 0, FOLDER_FILE_SIZE);
+        fill_folder_data(expected, FOLDER_FILE_SIZE, index);
+        ok(sink->size == FOLDER_FILE_SIZE && !memcmp(sink->data, expected, FOLDER_FILE_SIZE),
+           "%s: wrong data\n", info->psz1);
+        HeapFree(GetProcessHeap(), 0, expected);
+        HeapFree(GetProcessHeap(), 0, sink->data);
+        HeapFree(GetProcessHeap(), 0, sink);
+        folders_extracted++;
+        return TRUE;
+
+    default:
+        return 0;
+    }
+}
+
+static DWORD extract_folders_cab(char *name, char *path)
+{
+    HFDI hfdi;
+    ERF erf;
+    DWORD start;
+    BOOL ret;
+
+    hfdi = FDICreate(fdi_alloc, fdi_free, fdi_open, fdi_read,
+                     fdi_folder_write, fdi_close, fdi_seek, cpuUNKNOWN, &erf);
+    ok(hfdi != NULL, "FDICreate error %d\n", erf.erfOper);
+
+    last_folder = 0;
+    folders_extracted = 0;
+    start = GetTickCount();
+    ret = FDICopy(hfdi, name, path, 0, fdi_folder_notify, NULL, NULL);
+    start = GetTickCount() - start;
+    ok(ret, "FDICopy error %d\n", erf.erfOper);
+    ok(folders_extracted == FOLDER_FILES, "extracted %u files\n", folders_extracted);
+
+    FDIDestroy(hfdi);
+    return start;
+}
+
+/* extraction of a cabinet with one folder per file */
+static void test_FDICopy_folders(void)
+{
+    char name[] = "folders.cab", file[MAX_PATH], path[MAX_PATH], *data;
+    DWORD serial, parallel, written;
+    CCAB cabParams;
+    HANDLE handle;
+    unsigned int i;
+    HFCI hfci;
+    ERF erf;
+    BOOL ret;
+
+    GetCurrentDirectoryA(MAX_PATH, CURR_DIR);
+    data = HeapAlloc(GetProcessHeap(), 0, FOLDER_FILE_SIZE);
+
+    set_cab_parameters(&cabParams);
+    lstrcpyA(cabParams.szCab, name);
+    hfci = FCICreate(&erf, file_placed, mem_alloc, mem_free, fci_open,
+                     fci_read, fci_write, fci_close, fci_seek,
+                     fci_delete, get_temp_file, &cabParams, NULL);
+    ok(hfci != NULL, "Failed to create an FCI context\n");
+
+    for (i = 0; i < FOLDER_FILES; i++)
+    {
+        sprintf(file, "folder%u.dat", i);
+        handle = CreateFileA(file, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL);
+        ok(handle != INVALID_HANDLE_VALUE, "failed to create %s\n", file);
+        fill_folder_data(data, FOLDER_FILE_SIZE, i);
+        WriteFile(handle, data, FOLDER_FILE_SIZE, &written, NULL);
+        CloseHandle(handle);
+
+        add_file(hfci, file);
+        ret = FCIFlushFolder(hfci, get_next_cabinet, progress);
+        ok(ret, "Failed to flush the folder\n");
+    }
+
+    ret = FCIFlushCabinet(hfci, FALSE, get_next_cabinet, progress);
+    ok(ret, "Failed to flush the cabinet\n");
+    FCIDestroy(hfci);
+
+    lstrcpyA(path, CURR_DIR);
+    lstrcatA(path, "\\");
+
+    serial = extract_folders_cab(name, path);
+
+    /* Wine can decompress the folders in worker threads */
+    SetEnvironmentVariableA("WINE_FDI_THREADS", "0");
+    parallel = extract_folders_cab(name, path);
+    SetEnvironmentVariableA("WINE_FDI_THREADS", NULL);
+
+    if (winetest_interactive)
+        trace("extracted %u folders of %u bytes: %lu ms, %lu ms with worker threads\n",
+              FOLDER_FILES, FOLDER_FILE_SIZE, serial, parallel);
+
+    for (i = 0; i < FOLDER_FILES; i++)
+    {
+        sprintf(file, "folder%u.dat", i);
+        DeleteFileA(file);
+    }
+    DeleteFileA(name);
+    HeapFree(GetProcessHeap(), 0, data);
+}
 
 START_TEST(fdi)
 {
@@ -948,4 +1101,5 @@ START_TEST(fdi)
     test_FDIDestroy();
     test_FDIIsCabinet();
     test_FDICopy();
+    test_FDICopy_folders();
 }
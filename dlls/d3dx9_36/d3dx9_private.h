@@ -279,6 +279,7 @@ struct d3dx_regstore
 };
 
 struct d3dx_pres_ins;
+struct d3dx_pres_exec_op;
 
 struct d3dx_preshader
 {
@@ -287,6 +288,10 @@ struct d3dx_preshader
     unsigned int ins_count;
     struct d3dx_pres_ins *ins;
 
+    /* Instructions compiled into a flat list of output components. */
+    unsigned int exec_op_count;
+    struct d3dx_pres_exec_op *exec_ops;
+
     struct d3dx_const_tab inputs;
 };
 
@@ -41,6 +41,307 @@ struct ID3DXMatrixStackImpl
 
 static const unsigned int INITIAL_STACK_SIZE = 32;
 
+/*_________________SIMD helpers____________________*/
+
+/* The vector paths below evaluate every component in the same order as the
+ * scalar code (m[0][j] * x + m[1][j] * y + m[2][j] * z + m[3][j] * w, without
+ * fused multiply-add), so the results are identical to the scalar paths. */
+#if defined(__i386__) || defined(__x86_64__)
+
+#include <immintrin.h>
+
+#define D3DX_SSE_TARGET __attribute__((target("sse")))
+#define D3DX_AVX_TARGET __attribute__((target("avx")))
+
+enum d3dx_simd_level
+{
+    D3DX_SIMD_UNKNOWN,
+    D3DX_SIMD_NONE,
+    D3DX_SIMD_SSE,
+    D3DX_SIMD_AVX,
+};
+
+static enum d3dx_simd_level simd_level;
+
+static enum d3dx_simd_level d3dx_get_simd_level(void)
+{
+    enum d3dx_simd_level level = simd_level;
+
+    if (level != D3DX_SIMD_UNKNOWN)
+        return level;
+
+    if (IsProcessorFeaturePresent(PF_AVX_INSTRUCTIONS_AVAILABLE))
+        level = D3DX_SIMD_AVX;
+    else if (IsProcessorFeaturePresent(PF_XMMI_INSTRUCTIONS_AVAILABLE))
+        level = D3DX_SIMD_SSE;
+    else
+        level = D3DX_SIMD_NONE;
+    TRACE("Using SIMD level %u.\n", level);
+
+    return simd_level = level;
+}
+
+/* The two-elements-per-iteration paths read the second element before the
+ * first one is written, which is only equivalent to the scalar loop if the
+ * input and output arrays are either the same array or disjoint. */
+static BOOL d3dx_array_can_batch(const void *out, UINT outstride, const void *in, UINT instride,
+        UINT elements)
+{
+    const SIZE_T size = sizeof(D3DXVECTOR4);
+    const char *out_end = (const char *)out + (SIZE_T)outstride * (elements - 1) + size;
+    const char *in_end = (const char *)in + (SIZE_T)instride * (elements - 1) + size;
+
+    if (out == in && outstride == instride)
+        return TRUE;
+    return out_end <= (const char *)in || in_end <= (const char *)out;
+}
+
+static inline D3DX_SSE_TARGET void d3dx_load_matrix_sse(const D3DXMATRIX *m, __m128 rows[4])
+{
+    rows[0] = _mm_loadu_ps(m->m[0]);
+    rows[1] = _mm_loadu_ps(m->m[1]);
+    rows[2] = _mm_loadu_ps(m->m[2]);
+    rows[3] = _mm_loadu_ps(m->m[3]);
+}
+
+static inline D3DX_SSE_TARGET void d3dx_store_vec3_sse(D3DXVECTOR3 *out, __m128 v)
+{
+    _mm_storel_pi((__m64 *)&out->x, v);
+    _mm_store_ss(&out->z, _mm_movehl_ps(v, v));
+}
+
+static inline D3DX_SSE_TARGET __m128 d3dx_transform_sse(const __m128 rows[4], const float *v)
+{
+    __m128 r;
+
+    r = _mm_mul_ps(rows[0], _mm_load1_ps(&v[0]));
+    r = _mm_add_ps(r, _mm_mul_ps(rows[1], _mm_load1_ps(&v[1])));
+    r = _mm_add_ps(r, _mm_mul_ps(rows[2], _mm_load1_ps(&v[2])));
+    return _mm_add_ps(r, _mm_mul_ps(rows[3], _mm_load1_ps(&v[3])));
+}
+
+static inline D3DX_SSE_TARGET __m128 d3dx_transform_point_sse(const __m128 rows[4], const float *v)
+{
+    __m128 r;
+
+    r = _mm_mul_ps(rows[0], _mm_load1_ps(&v[0]));
+    r = _mm_add_ps(r, _mm_mul_ps(rows[1], _mm_load1_ps(&v[1])));
+    r = _mm_add_ps(r, _mm_mul_ps(rows[2], _mm_load1_ps(&v[2])));
+    return _mm_add_ps(r, rows[3]);
+}
+
+static inline D3DX_SSE_TARGET __m128 d3dx_transform_normal_sse(const __m128 rows[4], const float *v)
+{
+    __m128 r;
+
+    r = _mm_mul_ps(rows[0], _mm_load1_ps(&v[0]));
+    r = _mm_add_ps(r, _mm_mul_ps(rows[1], _mm_load1_ps(&v[1])));
+    return _mm_add_ps(r, _mm_mul_ps(rows[2], _mm_load1_ps(&v[2])));
+}
+
+static inline D3DX_SSE_TARGET __m128 d3dx_transform_coord_sse(const __m128 rows[4], const float *v)
+{
+    __m128 r = d3dx_transform_point_sse(rows, v);
+
+    return _mm_div_ps(r, _mm_shuffle_ps(r, r, _MM_SHUFFLE(3, 3, 3, 3)));
+}
+
+static D3DX_SSE_TARGET void d3dx_matrix_multiply_sse(D3DXMATRIX *out, const D3DXMATRIX *m1,
+        const D3DXMATRIX *m2, BOOL transpose)
+{
+    __m128 rows[4], r0, r1, r2, r3;
+
+    d3dx_load_matrix_sse(m2, rows);
+    r0 = d3dx_transform_sse(rows, m1->m[0]);
+    r1 = d3dx_transform_sse(rows, m1->m[1]);
+    r2 = d3dx_transform_sse(rows, m1->m[2]);
+    r3 = d3dx_transform_sse(rows, m1->m[3]);
+    if (transpose)
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    _mm_storeu_ps(out->m[0], r0);
+    _mm_storeu_ps(out->m[1], r1);
+    _mm_storeu_ps(out->m[2], r2);
+    _mm_storeu_ps(out->m[3], r3);
+}
+
+static D3DX_SSE_TARGET void d3dx_vec4_transform_array_sse(void *out, UINT outstride, const void *in,
+        UINT instride, const D3DXMATRIX *matrix, UINT elements)
+{
+    __m128 rows[4];
+    UINT i;
+
+    d3dx_load_matrix_sse(matrix, rows);
+    for (i = 0; i < elements; ++i)
+        _mm_storeu_ps((float *)((char *)out + outstride * i),
+                d3dx_transform_sse(rows, (const float *)((const char *)in + instride * i)));
+}
+
+static D3DX_SSE_TARGET void d3dx_vec3_transform_array_sse(D3DXVECTOR4 *out, UINT outstride,
+        const D3DXVECTOR3 *in, UINT instride, const D3DXMATRIX *matrix, UINT elements)
+{
+    __m128 rows[4];
+    UINT i;
+
+    d3dx_load_matrix_sse(matrix, rows);
+    for (i = 0; i < elements; ++i)
+        _mm_storeu_ps((float *)((char *)out + outstride * i),
+                d3dx_transform_point_sse(rows, (const float *)((const char *)in + instride * i)));
+}
+
+static D3DX_SSE_TARGET void d3dx_vec3_transform_coord_array_sse(D3DXVECTOR3 *out, UINT outstride,
+        const D3DXVECTOR3 *in, UINT instride, const D3DXMATRIX *matrix, UINT elements)
+{
+    __m128 rows[4];
+    UINT i;
+
+    d3dx_load_matrix_sse(matrix, rows);
+    for (i = 0; i < elements; ++i)
+        d3dx_store_vec3_sse((D3DXVECTOR3 *)((char *)out + outstride * i),
+                d3dx_transform_coord_sse(rows, (const float *)((const char *)in + instride * i)));
+}
+
+static D3DX_SSE_TARGET void d3dx_vec3_transform_normal_array_sse(D3DXVECTOR3 *out, UINT outstride,
+        const D3DXVECTOR3 *in, UINT instride, const D3DXMATRIX *matrix, UINT elements)
+{
+    __m128 rows[4];
+    UINT i;
+
+    d3dx_load_matrix_sse(matrix, rows);
+    for (i = 0; i < elements; ++i)
+        d3dx_store_vec3_sse((D3DXVECTOR3 *)((char *)out + outstride * i),
+                d3dx_transform_normal_sse(rows, (const float *)((const char *)in + instride * i)));
+}
+
+static inline D3DX_AVX_TARGET __m256 d3dx_broadcast_pair_avx(const float *a, const float *b)
+{
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_broadcast_ss(a)), _mm_broadcast_ss(b), 1);
+}
+
+/* Transforms two elements per iteration, one in each 128-bit lane. */
+static D3DX_AVX_TARGET void d3dx_vec4_transform_array_avx(void *out, UINT outstride, const void *in,
+        UINT instride, const D3DXMATRIX *matrix, UINT elements, BOOL point)
+{
+    __m256 rows[4], r;
+    const float *a, *b;
+    UINT i;
+
+    rows[0] = _mm256_broadcast_ps((const __m128 *)matrix->m[0]);
+    rows[1] = _mm256_broadcast_ps((const __m128 *)matrix->m[1]);
+    rows[2] = _mm256_broadcast_ps((const __m128 *)matrix->m[2]);
+    rows[3] = _mm256_broadcast_ps((const __m128 *)matrix->m[3]);
+
+    for (i = 0; i + 1 < elements; i += 2)
+    {
+        a = (const float *)((const char *)in + instride * i);
+        b = (const float *)((const char *)in + instride * (i + 1));
+
+        r = _mm256_mul_ps(rows[0], d3dx_broadcast_pair_avx(&a[0], &b[0]));
+        r = _mm256_add_ps(r, _mm256_mul_ps(rows[1], d3dx_broadcast_pair_avx(&a[1], &b[1])));
+        r = _mm256_add_ps(r, _mm256_mul_ps(rows[2], d3dx_broadcast_pair_avx(&a[2], &b[2])));
+        if (point)
+            r = _mm256_add_ps(r, rows[3]);
+        else
+            r = _mm256_add_ps(r, _mm256_mul_ps(rows[3], d3dx_broadcast_pair_avx(&a[3], &b[3])));
+
+        _mm_storeu_ps((float *)((char *)out + outstride * i), _mm256_castps256_ps128(r));
+        _mm_storeu_ps((float *)((char *)out + outstride * (i + 1)), _mm256_extractf128_ps(r, 1));
+    }
+
+    if (i < elements)
+    {
+        a = (const float *)((const char *)in + instride * i);
+
+        r = _mm256_mul_ps(rows[0], _mm256_broadcast_ss(&a[0]));
+        r = _mm256_add_ps(r, _mm256_mul_ps(rows[1], _mm256_broadcast_ss(&a[1])));
+        r = _mm256_add_ps(r, _mm256_mul_ps(rows[2], _mm256_broadcast_ss(&a[2])));
+        if (point)
+            r = _mm256_add_ps(r, rows[3]);
+        else
+            r = _mm256_add_ps(r, _mm256_mul_ps(rows[3], _mm256_broadcast_ss(&a[3])));
+
+        _mm_storeu_ps((float *)((char *)out + outstride * i), _mm256_castps256_ps128(r));
+    }
+}
+
+static BOOL d3dx_vec4_transform_array_simd(void *out, UINT outstride, const void *in, UINT instride,
+        const D3DXMATRIX *matrix, UINT elements, BOOL point)
+{
+    switch (d3dx_get_simd_level())
+    {
+        case D3DX_SIMD_AVX:
+            if (elements > 1 && d3dx_array_can_batch(out, outstride, in, instride, elements))
+            {
+                d3dx_vec4_transform_array_avx(out, outstride, in, instride, matrix, elements, point);
+                return TRUE;
+            }
+            /* fall through */
+        case D3DX_SIMD_SSE:
+            if (point)
+                d3dx_vec3_transform_array_sse(out, outstride, in, instride, matrix, elements);
+            else
+                d3dx_vec4_transform_array_sse(out, outstride, in, instride, matrix, elements);
+            return TRUE;
+
+        default:
+            return FALSE;
+    }
+}
+
+static BOOL d3dx_vec3_transform_coord_array_simd(D3DXVECTOR3 *out, UINT outstride,
+        const D3DXVECTOR3 *in, UINT instride, const D3DXMATRIX *matrix, UINT elements)
+{
+    if (d3dx_get_simd_level() < D3DX_SIMD_SSE)
+        return FALSE;
+    d3dx_vec3_transform_coord_array_sse(out, outstride, in, instride, matrix, elements);
+    return TRUE;
+}
+
+static BOOL d3dx_vec3_transform_normal_array_simd(D3DXVECTOR3 *out, UINT outstride,
+        const D3DXVECTOR3 *in, UINT instride, const D3DXMATRIX *matrix, UINT elements)
+{
+    if (d3dx_get_simd_level() < D3DX_SIMD_SSE)
+        return FALSE;
+    d3dx_vec3_transform_normal_array_sse(out, outstride, in, instride, matrix, elements);
+    return TRUE;
+}
+
+static BOOL d3dx_matrix_multiply_simd(D3DXMATRIX *out, const D3DXMATRIX *m1, const D3DXMATRIX *m2,
+        BOOL transpose)
+{
+    if (d3dx_get_simd_level() < D3DX_SIMD_SSE)
+        return FALSE;
+    d3dx_matrix_multiply_sse(out, m1, m2, transpose);
+    return TRUE;
+}
+
+#else
+
+static BOOL d3dx_vec4_transform_array_simd(void *out, UINT outstride, const void *in, UINT instride,
+        const D3DXMATRIX *matrix, UINT elements, BOOL point)
+{
+    return FALSE;
+}
+
+static BOOL d3dx_vec3_transform_coord_array_simd(D3DXVECTOR3 *out, UINT outstride,
+        const D3DXVECTOR3 *in, UINT instride, const D3DXMATRIX *matrix, UINT elements)
+{
+    return FALSE;
+}
+
+static BOOL d3dx_vec3_transform_normal_array_simd(D3DXVECTOR3 *out, UINT outstride,
+        const D3DXVECTOR3 *in, UINT instride, const D3DXMATRIX *matrix, UINT elements)
+{
+    return FALSE;
+}
+
+static BOOL d3dx_matrix_multiply_simd(D3DXMATRIX *out, const D3DXMATRIX *m1, const D3DXMATRIX *m2,
+        BOOL transpose)
+{
+    return FALSE;
+}
+
+#endif
+
 /*_________________D3DXColor____________________*/
 
 D3DXCOLOR* WINAPI D3DXColorAdjustContrast(D3DXCOLOR *pout, const D3DXCOLOR *pc, FLOAT s)
@@ -397,6 +698,9 @@ D3DXMATRIX* WINAPI D3DXMatrixMultiply(D3DXMATRIX *pout, const D3DXMATRIX *pm1, c
 
     TRACE("pout %p, pm1 %p, pm2 %p\n", pout, pm1, pm2);
 
+    if (d3dx_matrix_multiply_simd(pout, pm1, pm2, FALSE))
+        return pout;
+
     for (i=0; i<4; i++)
     {
         for (j=0; j<4; j++)
@@ -416,6 +720,9 @@ D3DXMATRIX* WINAPI D3DXMatrixMultiplyTranspose(D3DXMATRIX *pout, const D3DXMATRI
 
     TRACE("pout %p, pm1 %p, pm2 %p\n", pout, pm1, pm2);
 
+    if (d3dx_matrix_multiply_simd(pout, pm1, pm2, TRUE))
+        return pout;
+
     for (i = 0; i < 4; i++)
         for (j = 0; j < 4; j++)
             temp.m[j][i] = pm1->m[i][0] * pm2->m[0][j] + pm1->m[i][1] * pm2->m[1][j] + pm1->m[i][2] * pm2->m[2][j] + pm1->m[i][3] * pm2->m[3][j];
@@ -1294,6 +1601,9 @@ D3DXPLANE* WINAPI D3DXPlaneTransformArray(D3DXPLANE* out, UINT outstride, const
 
     TRACE("out %p, outstride %u, in %p, instride %u, matrix %p, elements %u\n", out, outstride, in, instride, matrix, elements);
 
+    if (d3dx_vec4_transform_array_simd(out, outstride, in, instride, matrix, elements, FALSE))
+        return out;
+
     for (i = 0; i < elements; ++i) {
         D3DXPlaneTransform(
             (D3DXPLANE*)((char*)out + outstride * i),
@@ -1825,40 +2135,59 @@ D3DXVECTOR3* WINAPI D3DXVec3Normalize(D3DXVECTOR3 *pout, const D3DXVECTOR3 *pv)
     return pout;
 }
 
+static void d3dx_vec3_project_matrix(D3DXMATRIX *m, const D3DXMATRIX *projection, const D3DXMATRIX *view,
+        const D3DXMATRIX *world)
+{
+    D3DXMatrixIdentity(m);
+    if (world) D3DXMatrixMultiply(m, m, world);
+    if (view) D3DXMatrixMultiply(m, m, view);
+    if (projection) D3DXMatrixMultiply(m, m, projection);
+}
+
+static void d3dx_vec3_project_viewport(D3DXVECTOR3 *pout, const D3DVIEWPORT9 *pviewport)
+{
+    pout->x = pviewport->X +  ( 1.0f + pout->x ) * pviewport->Width / 2.0f;
+    pout->y = pviewport->Y +  ( 1.0f - pout->y ) * pviewport->Height / 2.0f;
+    pout->z = pviewport->MinZ + pout->z * ( pviewport->MaxZ - pviewport->MinZ );
+}
+
 D3DXVECTOR3* WINAPI D3DXVec3Project(D3DXVECTOR3 *pout, const D3DXVECTOR3 *pv, const D3DVIEWPORT9 *pviewport, const D3DXMATRIX *pprojection, const D3DXMATRIX *pview, const D3DXMATRIX *pworld)
 {
     D3DXMATRIX m;
 
     TRACE("pout %p, pv %p, pviewport %p, pprojection %p, pview %p, pworld %p\n", pout, pv, pviewport, pprojection, pview, pworld);
 
-    D3DXMatrixIdentity(&m);
-    if (pworld) D3DXMatrixMultiply(&m, &m, pworld);
-    if (pview) D3DXMatrixMultiply(&m, &m, pview);
-    if (pprojection) D3DXMatrixMultiply(&m, &m, pprojection);
+    d3dx_vec3_project_matrix(&m, pprojection, pview, pworld);
 
     D3DXVec3TransformCoord(pout, pv, &m);
 
     if (pviewport)
-    {
-        pout->x = pviewport->X +  ( 1.0f + pout->x ) * pviewport->Width / 2.0f;
-        pout->y = pviewport->Y +  ( 1.0f - pout->y ) * pviewport->Height / 2.0f;
-        pout->z = pviewport->MinZ + pout->z * ( pviewport->MaxZ - pviewport->MinZ );
-    }
+        d3dx_vec3_project_viewport(pout, pviewport);
     return pout;
 }
 
 D3DXVECTOR3* WINAPI D3DXVec3ProjectArray(D3DXVECTOR3* out, UINT outstride, const D3DXVECTOR3* in, UINT instride, const D3DVIEWPORT9* viewport, const D3DXMATRIX* projection, const D3DXMATRIX* view, const D3DXMATRIX* world, UINT elements)
 {
+    D3DXMATRIX m;
     UINT i;
 
     TRACE("out %p, outstride %u, in %p, instride %u, viewport %p, projection %p, view %p, world %p, elements %u\n",
         out, outstride, in, instride, viewport, projection, view, world, elements);
 
-    for (i = 0; i < elements; ++i) {
-        D3DXVec3Project(
-            (D3DXVECTOR3*)((char*)out + outstride * i),
-            (const D3DXVECTOR3*)((const char*)in + instride * i),
-            viewport, projection, view, world);
+    /* The combined matrix is the same for every element. */
+    d3dx_vec3_project_matrix(&m, projection, view, world);
+
+    if (!d3dx_vec3_transform_coord_array_simd(out, outstride, in, instride, &m, elements))
+    {
+        for (i = 0; i < elements; ++i)
+            D3DXVec3TransformCoord((D3DXVECTOR3 *)((char *)out + outstride * i),
+                    (const D3DXVECTOR3 *)((const char *)in + instride * i), &m);
+    }
+
+    if (viewport)
+    {
+        for (i = 0; i < elements; ++i)
+            d3dx_vec3_project_viewport((D3DXVECTOR3 *)((char *)out + outstride * i), viewport);
     }
     return out;
 }
@@ -1883,6 +2212,9 @@ D3DXVECTOR4* WINAPI D3DXVec3TransformArray(D3DXVECTOR4* out, UINT outstride, con
 
     TRACE("out %p, outstride %u, in %p, instride %u, matrix %p, elements %u\n", out, outstride, in, instride, matrix, elements);
 
+    if (d3dx_vec4_transform_array_simd(out, outstride, in, instride, matrix, elements, TRUE))
+        return out;
+
     for (i = 0; i < elements; ++i) {
         D3DXVec3Transform(
             (D3DXVECTOR4*)((char*)out + outstride * i),
@@ -1916,6 +2248,9 @@ D3DXVECTOR3* WINAPI D3DXVec3TransformCoordArray(D3DXVECTOR3* out, UINT outstride
 
     TRACE("out %p, outstride %u, in %p, instride %u, matrix %p, elements %u\n", out, outstride, in, instride, matrix, elements);
 
+    if (d3dx_vec3_transform_coord_array_simd(out, outstride, in, instride, matrix, elements))
+        return out;
+
     for (i = 0; i < elements; ++i) {
         D3DXVec3TransformCoord(
             (D3DXVECTOR3*)((char*)out + outstride * i),
@@ -1944,6 +2279,9 @@ D3DXVECTOR3* WINAPI D3DXVec3TransformNormalArray(D3DXVECTOR3* out, UINT outstrid
 
     TRACE("out %p, outstride %u, in %p, instride %u, matrix %p, elements %u\n", out, outstride, in, instride, matrix, elements);
 
+    if (d3dx_vec3_transform_normal_array_simd(out, outstride, in, instride, matrix, elements))
+        return out;
+
     for (i = 0; i < elements; ++i) {
         D3DXVec3TransformNormal(
             (D3DXVECTOR3*)((char*)out + outstride * i),
@@ -1953,6 +2291,13 @@ D3DXVECTOR3* WINAPI D3DXVec3TransformNormalArray(D3DXVECTOR3* out, UINT outstrid
     return out;
 }
 
+static void d3dx_vec3_unproject_viewport(D3DXVECTOR3 *out, const D3DVIEWPORT9 *viewport)
+{
+    out->x = 2.0f * (out->x - viewport->X) / viewport->Width - 1.0f;
+    out->y = 1.0f - 2.0f * (out->y - viewport->Y) / viewport->Height;
+    out->z = (out->z - viewport->MinZ) / (viewport->MaxZ - viewport->MinZ);
+}
+
 D3DXVECTOR3 * WINAPI D3DXVec3Unproject(D3DXVECTOR3 *out, const D3DXVECTOR3 *v,
         const D3DVIEWPORT9 *viewport, const D3DXMATRIX *projection, const D3DXMATRIX *view,
         const D3DXMATRIX *world)
@@ -1962,38 +2307,47 @@ D3DXVECTOR3 * WINAPI D3DXVec3Unproject(D3DXVECTOR3 *out, const D3DXVECTOR3 *v,
     TRACE("out %p, v %p, viewport %p, projection %p, view %p, world %p.\n",
             out, v, viewport, projection, view, world);
 
-    D3DXMatrixIdentity(&m);
-    if (world)
-        D3DXMatrixMultiply(&m, &m, world);
-    if (view)
-        D3DXMatrixMultiply(&m, &m, view);
-    if (projection)
-        D3DXMatrixMultiply(&m, &m, projection);
+    d3dx_vec3_project_matrix(&m, projection, view, world);
     D3DXMatrixInverse(&m, NULL, &m);
 
     *out = *v;
     if (viewport)
-    {
-        out->x = 2.0f * (out->x - viewport->X) / viewport->Width - 1.0f;
-        out->y = 1.0f - 2.0f * (out->y - viewport->Y) / viewport->Height;
-        out->z = (out->z - viewport->MinZ) / (viewport->MaxZ - viewport->MinZ);
-    }
+        d3dx_vec3_unproject_viewport(out, viewport);
     D3DXVec3TransformCoord(out, out, &m);
     return out;
 }
 
 D3DXVECTOR3* WINAPI D3DXVec3UnprojectArray(D3DXVECTOR3* out, UINT outstride, const D3DXVECTOR3* in, UINT instride, const D3DVIEWPORT9* viewport, const D3DXMATRIX* projection, const D3DXMATRIX* view, const D3DXMATRIX* world, UINT elements)
 {
+    D3DXVECTOR3 *v;
+    D3DXMATRIX m;
     UINT i;
 
     TRACE("out %p, outstride %u, in %p, instride %u, viewport %p, projection %p, view %p, world %p, elements %u\n",
         out, outstride, in, instride, viewport, projection, view, world, elements);
 
-    for (i = 0; i < elements; ++i) {
-        D3DXVec3Unproject(
-            (D3DXVECTOR3*)((char*)out + outstride * i),
-            (const D3DXVECTOR3*)((const char*)in + instride * i),
-            viewport, projection, view, world);
+    /* The combined matrix and its inverse are the same for every element. */
+    d3dx_vec3_project_matrix(&m, projection, view, world);
+    D3DXMatrixInverse(&m, NULL, &m);
+
+    if (viewport)
+    {
+        for (i = 0; i < elements; ++i)
+        {
+            v = (D3DXVECTOR3 *)((char *)out + outstride * i);
+            *v = *(const D3DXVECTOR3 *)((const char *)in + instride * i);
+            d3dx_vec3_unproject_viewport(v, viewport);
+        }
+        /* The elements are transformed in place from here. */
+        in = out;
+        instride = outstride;
+    }
+
+    if (!d3dx_vec3_transform_coord_array_simd(out, outstride, in, instride, &m, elements))
+    {
+        for (i = 0; i < elements; ++i)
+            D3DXVec3TransformCoord((D3DXVECTOR3 *)((char *)out + outstride * i),
+                    (const D3DXVECTOR3 *)((const char *)in + instride * i), &m);
     }
     return out;
 }
@@ -2090,6 +2444,9 @@ D3DXVECTOR4* WINAPI D3DXVec4TransformArray(D3DXVECTOR4* out, UINT outstride, con
 
     TRACE("out %p, outstride %u, in %p, instride %u, matrix %p, elements %u\n", out, outstride, in, instride, matrix, elements);
 
+    if (d3dx_vec4_transform_array_simd(out, outstride, in, instride, matrix, elements, FALSE))
+        return out;
+
     for (i = 0; i < elements; ++i) {
         D3DXVec4Transform(
             (D3DXVECTOR4*)((char*)out + outstride * i),
@@ -257,6 +257,41 @@ struct d3dx_pres_ins
     struct d3dx_pres_operand output;
 };
 
+#define ARGS_ARRAY_SIZE 8
+
+enum pres_exec_arg_type
+{
+    PRES_EXEC_ARG_FLOAT,
+    PRES_EXEC_ARG_DOUBLE,
+    /* Relative addressing, out of bounds or non floating point register,
+     * read through exec_get_arg(). */
+    PRES_EXEC_ARG_GENERIC,
+};
+
+struct d3dx_pres_exec_arg
+{
+    enum pres_exec_arg_type type;
+    const void *ptr;
+    const struct d3dx_pres_operand *opr;
+    unsigned int comp;
+};
+
+/* A single output component of a preshader instruction, with the input
+ * registers resolved at effect creation time. */
+struct d3dx_pres_exec_op
+{
+    enum pres_ops op;
+    /* The result does not depend on any register written at run time. */
+    BOOL folded;
+    double value;
+    unsigned int arg_count;
+    unsigned int component_count;
+    struct d3dx_pres_exec_arg args[ARGS_ARRAY_SIZE];
+    void *out;
+    enum pres_value_type out_type;
+    struct d3dx_pres_reg out_reg;
+};
+
 struct const_upload_info
 {
     BOOL transpose;
@@ -298,6 +333,34 @@ static unsigned int get_reg_components(unsigned int table)
     return get_offset_reg(table, 1);
 }
 
+/* Returns the component offset an out of bounds register access ends up at,
+ * or ~0u if it reads as 0. */
+static unsigned int wrap_reg_offset(const struct d3dx_regstore *rs, unsigned int table, unsigned int offset)
+{
+    unsigned int reg_index, wrap_size;
+
+    reg_index = get_reg_offset(table, offset);
+    if (table == PRES_REGTAB_CONST)
+    {
+        /* As it can be guessed from tests, offset into floating constant table is wrapped
+         * to the nearest power of 2 and not to the actual table size. */
+        for (wrap_size = 1; wrap_size < rs->table_sizes[table]; wrap_size <<= 1)
+            ;
+    }
+    else
+    {
+        wrap_size = rs->table_sizes[table];
+    }
+    if (!wrap_size)
+        return ~0u;
+    reg_index %= wrap_size;
+
+    if (reg_index >= rs->table_sizes[table])
+        return ~0u;
+
+    return get_offset_reg(table, reg_index) + offset % get_reg_components(table);
+}
+
 #define PRES_BITMASK_BLOCK_SIZE (sizeof(unsigned int) * 8)
 
 static HRESULT regstore_alloc_table(struct d3dx_regstore *rs, unsigned int table)
@@ -354,23 +417,28 @@ static double regstore_get_double(struct d3dx_regstore *rs, unsigned int table,
     }
 }
 
-static void regstore_set_double(struct d3dx_regstore *rs, unsigned int table, unsigned int offset, double v)
+static void set_double_value(void *p, enum pres_value_type type, double v)
 {
-    BYTE *p;
-
-    p = (BYTE *)rs->tables[table] + table_info[table].component_size * offset;
-    switch (table_info[table].type)
+    switch (type)
     {
         case PRES_VT_FLOAT : *(float *)p = v; break;
         case PRES_VT_DOUBLE: *(double *)p = v; break;
         case PRES_VT_INT   : *(int *)p = lrint(v); break;
         case PRES_VT_BOOL  : *(BOOL *)p = !!v; break;
         default:
-            FIXME("Bad type %u.\n", table_info[table].type);
+            FIXME("Bad type %u.\n", type);
             break;
     }
 }
 
+static void regstore_set_double(struct d3dx_regstore *rs, unsigned int table, unsigned int offset, double v)
+{
+    BYTE *p;
+
+    p = (BYTE *)rs->tables[table] + table_info[table].component_size * offset;
+    set_double_value(p, table_info[table].type, v);
+}
+
 static void dump_bytecode(void *data, unsigned int size)
 {
     unsigned int *bytecode = (unsigned int *)data;
@@ -1220,6 +1288,256 @@ static HRESULT parse_preshader(struct d3dx_preshader *pres, unsigned int *ptr, u
     return D3D_OK;
 }
 
+static void compile_arg(struct d3dx_regstore *rs, const struct d3dx_pres_operand *opr, unsigned int comp,
+        struct d3dx_pres_exec_arg *arg)
+{
+    unsigned int table = opr->reg.table;
+    unsigned int offset = opr->reg.offset + comp;
+
+    arg->opr = opr;
+    arg->comp = comp;
+    if (opr->index_reg.table == PRES_REGTAB_COUNT && get_reg_offset(table, offset) < rs->table_sizes[table])
+    {
+        arg->ptr = (BYTE *)rs->tables[table] + table_info[table].component_size * offset;
+        switch (table_info[table].type)
+        {
+            case PRES_VT_FLOAT:
+                arg->type = PRES_EXEC_ARG_FLOAT;
+                return;
+            case PRES_VT_DOUBLE:
+                arg->type = PRES_EXEC_ARG_DOUBLE;
+                return;
+            default:
+                break;
+        }
+    }
+    arg->type = PRES_EXEC_ARG_GENERIC;
+    arg->ptr = NULL;
+}
+
+/* Returns TRUE and the value if the argument is known at compile time: an
+ * immediate constant, or a temporary register last written by a folded
+ * instruction in the same run. */
+static BOOL get_compiled_arg_value(const struct d3dx_pres_exec_arg *arg, const float *temp_values,
+        const BOOL *temp_known, double *value)
+{
+    unsigned int offset = arg->opr->reg.offset + arg->comp;
+
+    if (arg->type == PRES_EXEC_ARG_GENERIC)
+        return FALSE;
+    switch (arg->opr->reg.table)
+    {
+        case PRES_REGTAB_IMMED:
+            *value = *(const double *)arg->ptr;
+            return TRUE;
+        case PRES_REGTAB_TEMP:
+            if (!temp_known[offset])
+                return FALSE;
+            *value = temp_values[offset];
+            return TRUE;
+        default:
+            return FALSE;
+    }
+}
+
+static void mark_arg_temp_reads(const struct d3dx_regstore *rs, const struct d3dx_pres_exec_arg *arg,
+        BOOL *live, unsigned int temp_count)
+{
+    const struct d3dx_pres_operand *opr = arg->opr;
+    unsigned int offset;
+
+    if (opr->index_reg.table == PRES_REGTAB_TEMP && opr->index_reg.offset < temp_count)
+        live[opr->index_reg.offset] = TRUE;
+    if (opr->reg.table != PRES_REGTAB_TEMP)
+        return;
+    /* Out of bounds reads are wrapped the same way as in exec_get_arg(). */
+    offset = opr->reg.offset + arg->comp;
+    if (offset >= temp_count)
+        offset = wrap_reg_offset(rs, PRES_REGTAB_TEMP, offset);
+    if (offset < temp_count)
+        live[offset] = TRUE;
+}
+
+/* Removes writes to temporary register components which are never read,
+ * neither later in the same run nor, through the persistent temporary
+ * registers, by the next run. */
+static void eliminate_dead_components(struct d3dx_preshader *pres, unsigned int temp_count)
+{
+    BOOL *live, *live_out, *dead, changed;
+    struct d3dx_pres_exec_op *op;
+    unsigned int i, j, count;
+
+    for (i = 0; i < pres->exec_op_count; ++i)
+    {
+        for (j = 0; j < pres->exec_ops[i].arg_count; ++j)
+        {
+            /* Relative addressing can read any temporary register. */
+            if (pres->exec_ops[i].args[j].opr->reg.table == PRES_REGTAB_TEMP
+                    && pres->exec_ops[i].args[j].opr->index_reg.table != PRES_REGTAB_COUNT)
+                return;
+        }
+    }
+
+    live = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*live) * temp_count * 2
+            + sizeof(*dead) * pres->exec_op_count);
+    if (!live)
+        return;
+    live_out = live + temp_count;
+    dead = live_out + temp_count;
+
+    do
+    {
+        memcpy(live, live_out, sizeof(*live) * temp_count);
+        for (i = pres->exec_op_count; i--;)
+        {
+            op = &pres->exec_ops[i];
+            dead[i] = FALSE;
+            if (op->out_reg.table == PRES_REGTAB_TEMP && op->out_reg.offset < temp_count)
+            {
+                if (!live[op->out_reg.offset])
+                {
+                    dead[i] = TRUE;
+                    continue;
+                }
+                live[op->out_reg.offset] = FALSE;
+            }
+            if (op->folded)
+                continue;
+            for (j = 0; j < op->arg_count; ++j)
+                mark_arg_temp_reads(&pres->regs, &op->args[j], live, temp_count);
+        }
+
+        changed = FALSE;
+        for (i = 0; i < temp_count; ++i)
+        {
+            if (live[i] && !live_out[i])
+            {
+                live_out[i] = TRUE;
+                changed = TRUE;
+            }
+        }
+    } while (changed);
+
+    for (i = 0, count = 0; i < pres->exec_op_count; ++i)
+    {
+        if (!dead[i])
+            pres->exec_ops[count++] = pres->exec_ops[i];
+    }
+    TRACE("Eliminated %u dead components.\n", pres->exec_op_count - count);
+    pres->exec_op_count = count;
+
+    HeapFree(GetProcessHeap(), 0, live);
+}
+
+/* Compiles the preshader into a flat list of output components, with input
+ * registers resolved to pointers, instructions depending only on immediate
+ * constants folded, and dead temporary register writes removed. The
+ * arithmetic is exactly the same as in the interpreter. */
+static void compile_preshader(struct d3dx_preshader *pres)
+{
+    unsigned int i, j, k, temp_count, component_count, count;
+    double args[ARGS_ARRAY_SIZE];
+    const struct d3dx_pres_ins *ins;
+    struct d3dx_pres_exec_op *op;
+    const struct op_info *oi;
+    float *temp_values;
+    BOOL *temp_known;
+    BOOL known;
+
+    if (!pres->ins_count)
+        return;
+
+    for (i = 0, count = 0; i < pres->ins_count; ++i)
+    {
+        ins = &pres->ins[i];
+        oi = &pres_op_info[ins->op];
+        if (ins->op == PRESHADER_OP_NOP)
+            continue;
+        if (oi->func_all_comps)
+        {
+            /* Let the interpreter report the error. */
+            if (oi->input_count * ins->component_count > ARGS_ARRAY_SIZE)
+                return;
+            ++count;
+        }
+        else
+        {
+            count += ins->component_count;
+        }
+    }
+
+    temp_count = get_offset_reg(PRES_REGTAB_TEMP, pres->regs.table_sizes[PRES_REGTAB_TEMP]);
+    if (!(pres->exec_ops = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*pres->exec_ops) * count)))
+        return;
+    if (!(temp_values = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY,
+            (sizeof(*temp_values) + sizeof(*temp_known)) * temp_count)))
+    {
+        HeapFree(GetProcessHeap(), 0, pres->exec_ops);
+        pres->exec_ops = NULL;
+        return;
+    }
+    temp_known = (BOOL *)(temp_values + temp_count);
+
+    pres->exec_op_count = 0;
+    for (i = 0; i < pres->ins_count; ++i)
+    {
+        ins = &pres->ins[i];
+        oi = &pres_op_info[ins->op];
+        if (ins->op == PRESHADER_OP_NOP)
+            continue;
+
+        component_count = oi->func_all_comps ? 1 : ins->component_count;
+        for (j = 0; j < component_count; ++j)
+        {
+            op = &pres->exec_ops[pres->exec_op_count++];
+            op->op = ins->op;
+            op->component_count = ins->component_count;
+            if (oi->func_all_comps)
+            {
+                op->arg_count = oi->input_count * ins->component_count;
+                for (k = 0; k < op->arg_count; ++k)
+                    compile_arg(&pres->regs, &ins->inputs[k / ins->component_count],
+                            ins->scalar_op && k < ins->component_count ? 0 : k % ins->component_count,
+                            &op->args[k]);
+            }
+            else
+            {
+                op->arg_count = oi->input_count;
+                for (k = 0; k < op->arg_count; ++k)
+                    compile_arg(&pres->regs, &ins->inputs[k], ins->scalar_op && !k ? 0 : j, &op->args[k]);
+            }
+
+            op->out_reg.table = ins->output.reg.table;
+            op->out_reg.offset = ins->output.reg.offset + j;
+            op->out = (BYTE *)pres->regs.tables[op->out_reg.table]
+                    + table_info[op->out_reg.table].component_size * op->out_reg.offset;
+            op->out_type = table_info[op->out_reg.table].type;
+
+            known = TRUE;
+            for (k = 0; k < op->arg_count && known; ++k)
+                known = get_compiled_arg_value(&op->args[k], temp_values, temp_known, &args[k]);
+            if (known)
+            {
+                op->folded = TRUE;
+                op->value = pres_op_info[op->op].func(args, op->component_count);
+            }
+
+            if (op->out_reg.table == PRES_REGTAB_TEMP && op->out_reg.offset < temp_count)
+            {
+                temp_known[op->out_reg.offset] = known;
+                /* Temporary registers are stored as float. */
+                if (known)
+                    temp_values[op->out_reg.offset] = op->value;
+            }
+        }
+    }
+    HeapFree(GetProcessHeap(), 0, temp_values);
+
+    eliminate_dead_components(pres, temp_count);
+
+    TRACE("Compiled %u instructions into %u components.\n", pres->ins_count, pres->exec_op_count);
+}
+
 HRESULT d3dx_create_param_eval(struct d3dx_effect *effect, void *byte_code, unsigned int byte_code_size,
         D3DXPARAMETER_TYPE type, struct d3dx_param_eval **peval_out, ULONG64 *version_counter,
         const char **skip_constants, unsigned int skip_constants_count)
@@ -1306,6 +1624,8 @@ HRESULT d3dx_create_param_eval(struct d3dx_effect *effect, void *byte_code, unsi
             goto err_out;
     }
 
+    compile_preshader(&peval->pres);
+
     if (TRACE_ON(d3dx))
     {
         dump_bytecode(byte_code, byte_code_size);
@@ -1339,6 +1659,7 @@ static void d3dx_free_const_tab(struct d3dx_const_tab *ctab)
 
 static void d3dx_free_preshader(struct d3dx_preshader *pres)
 {
+    HeapFree(GetProcessHeap(), 0, pres->exec_ops);
     HeapFree(GetProcessHeap(), 0, pres->ins);
 
     regstore_free_tables(&pres->regs);
@@ -1613,27 +1934,10 @@ static double exec_get_arg(struct d3dx_regstore *rs, const struct d3dx_pres_oper
 
     if (reg_index >= rs->table_sizes[table])
     {
-        unsigned int wrap_size;
-
-        if (table == PRES_REGTAB_CONST)
-        {
-            /* As it can be guessed from tests, offset into floating constant table is wrapped
-             * to the nearest power of 2 and not to the actual table size. */
-            for (wrap_size = 1; wrap_size < rs->table_sizes[table]; wrap_size <<= 1)
-                ;
-        }
-        else
-        {
-            wrap_size = rs->table_sizes[table];
-        }
-        WARN("Wrapping register index %u, table %u, wrap_size %u, table size %u.\n",
-                reg_index, table, wrap_size, rs->table_sizes[table]);
-        reg_index %= wrap_size;
-
-        if (reg_index >= rs->table_sizes[table])
+        WARN("Wrapping register index %u, table %u, table size %u.\n",
+                reg_index, table, rs->table_sizes[table]);
+        if ((offset = wrap_reg_offset(rs, table, offset)) == ~0u)
             return 0.0;
-
-        offset = get_offset_reg(table, reg_index) + offset % get_reg_components(table);
     }
 
     return exec_get_reg_value(rs, table, offset);
@@ -1645,13 +1949,58 @@ static void exec_set_arg(struct d3dx_regstore *rs, const struct d3dx_pres_reg *r
     regstore_set_double(rs, reg->table, reg->offset + comp, res);
 }
 
-#define ARGS_ARRAY_SIZE 8
+static void execute_preshader_ops(struct d3dx_preshader *pres)
+{
+    const struct d3dx_pres_exec_op *op, *end;
+    double args[ARGS_ARRAY_SIZE];
+    unsigned int i;
+    double res;
+
+    for (op = pres->exec_ops, end = op + pres->exec_op_count; op < end; ++op)
+    {
+        if (op->folded)
+        {
+            res = op->value;
+        }
+        else
+        {
+            for (i = 0; i < op->arg_count; ++i)
+            {
+                switch (op->args[i].type)
+                {
+                    case PRES_EXEC_ARG_FLOAT:
+                        args[i] = *(const float *)op->args[i].ptr;
+                        break;
+                    case PRES_EXEC_ARG_DOUBLE:
+                        args[i] = *(const double *)op->args[i].ptr;
+                        break;
+                    default:
+                        args[i] = exec_get_arg(&pres->regs, op->args[i].opr, op->args[i].comp);
+                        break;
+                }
+            }
+            res = pres_op_info[op->op].func(args, op->component_count);
+        }
+
+        if (op->out_type == PRES_VT_FLOAT)
+            *(float *)op->out = res;
+        else
+            set_double_value(op->out, op->out_type, res);
+    }
+}
+
 static HRESULT execute_preshader(struct d3dx_preshader *pres)
 {
     unsigned int i, j, k;
     double args[ARGS_ARRAY_SIZE];
     double res;
 
+    if (pres->exec_ops)
+    {
+        execute_preshader_ops(pres);
+        return D3D_OK;
+    }
+
     for (i = 0; i < pres->ins_count; ++i)
     {
         const struct d3dx_pres_ins *ins;
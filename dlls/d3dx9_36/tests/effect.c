@@ -5066,6 +5066,69 @@ static const DWORD test_effect_preshader_ops_blob[] =
     0x00000003, 0xf0f0f0f0, 0x0f0f0f0f, 0x0000ffff,
 };
 
+static void test_effect_preshader_repeated_updates(IDirect3DDevice9 *device)
+{
+    static const D3DXVECTOR4 fvect1 = {28.0f, 29.0f, 30.0f, 31.0f};
+    static const D3DXVECTOR4 fvect2 = {-1.0f, 2.0f, 0.5f, 4.0f};
+    unsigned int npasses, iterations, i;
+    ID3DXEffect *effect;
+    D3DXHANDLE par;
+    DWORD start;
+    D3DCAPS9 caps;
+    HRESULT hr;
+
+    hr = IDirect3DDevice9_GetDeviceCaps(device, &caps);
+    ok(SUCCEEDED(hr), "Failed to get device caps, hr %#x.\n", hr);
+    if (caps.VertexShaderVersion < D3DVS_VERSION(3, 0)
+            || caps.PixelShaderVersion < D3DPS_VERSION(3, 0))
+    {
+        skip("Test requires VS >= 3 and PS >= 3, skipping.\n");
+        return;
+    }
+
+    hr = D3DXCreateEffect(device, test_effect_preshader_effect_blob, sizeof(test_effect_preshader_effect_blob),
+            NULL, NULL, 0, NULL, &effect, NULL);
+    ok(hr == D3D_OK, "Got result %#x.\n", hr);
+
+    test_effect_clear_vconsts(device);
+
+    par = effect->lpVtbl->GetParameterByName(effect, NULL, "g_Pos2");
+    ok(par != NULL, "GetParameterByName failed.\n");
+
+    hr = effect->lpVtbl->Begin(effect, &npasses, 0);
+    ok(hr == D3D_OK, "Got result %#x.\n", hr);
+    hr = effect->lpVtbl->BeginPass(effect, 0);
+    ok(hr == D3D_OK, "Got result %#x.\n", hr);
+
+    /* Every parameter change reruns the preshaders depending on it. */
+    iterations = winetest_interactive ? 2000 : 16;
+    start = GetTickCount();
+    for (i = 0; i < iterations; ++i)
+    {
+        hr = effect->lpVtbl->SetVector(effect, par, i & 1 ? &fvect1 : &fvect2);
+        ok(hr == D3D_OK, "SetVector failed, hr %#x.\n", hr);
+        hr = effect->lpVtbl->CommitChanges(effect);
+        ok(hr == D3D_OK, "Got result %#x.\n", hr);
+    }
+    if (winetest_interactive)
+        trace("%u preshader parameter updates took %u ms.\n", iterations, GetTickCount() - start);
+
+    hr = effect->lpVtbl->SetVector(effect, par, &fvect1);
+    ok(hr == D3D_OK, "SetVector failed, hr %#x.\n", hr);
+    hr = effect->lpVtbl->CommitChanges(effect);
+    ok(hr == D3D_OK, "Got result %#x.\n", hr);
+
+    test_effect_preshader_compare_vconsts(device, NULL, NULL);
+    test_effect_preshader_op_results(device, NULL, NULL);
+
+    hr = effect->lpVtbl->EndPass(effect);
+    ok(hr == D3D_OK, "Got result %#x.\n", hr);
+    hr = effect->lpVtbl->End(effect);
+    ok(hr == D3D_OK, "Got result %#x.\n", hr);
+
+    effect->lpVtbl->Release(effect);
+}
+
 static void test_effect_preshader_ops(IDirect3DDevice9 *device)
 {
     static D3DLIGHT9 light;
@@ -8721,6 +8784,7 @@ START_TEST(effect)
     test_effect_states(device);
     test_effect_preshader(device);
     test_effect_preshader_ops(device);
+    test_effect_preshader_repeated_updates(device);
     test_effect_isparameterused(device);
     test_effect_out_of_bounds_selector(device);
     test_effect_commitchanges(device);
@@ -3248,6 +3248,184 @@ static void test_D3DXVec_Array(void)
     }
 }
 
+static void test_D3DXVec_Array_large(void)
+{
+    static const D3DVIEWPORT9 viewport = {10, 20, 640, 480, 0.25f, 0.75f};
+    static const unsigned int count = 4096, iterations = 64;
+    D3DXMATRIX mat, mat2, exp_mat, projection, view, world;
+    D3DXVECTOR4 *inp_vec, *out_vec, *exp_vec;
+    DWORD start, array_time, single_time;
+    unsigned int i, j;
+
+    inp_vec = HeapAlloc(GetProcessHeap(), 0, count * sizeof(*inp_vec));
+    out_vec = HeapAlloc(GetProcessHeap(), 0, count * sizeof(*out_vec));
+    exp_vec = HeapAlloc(GetProcessHeap(), 0, count * sizeof(*exp_vec));
+
+    for (i = 0; i < count; ++i)
+    {
+        inp_vec[i].x = (i % 17) * 0.25f - 2.0f;
+        inp_vec[i].y = (i % 23) * -0.5f + 3.0f;
+        inp_vec[i].z = (i % 29) * 0.125f + 1.0f;
+        inp_vec[i].w = (i % 31) * 0.0625f + 0.5f;
+    }
+
+    set_matrix(&mat,
+            1.0f, 2.0f, 3.0f, 4.0f,
+            -5.0f, 6.0f, 7.0f, 0.5f,
+            9.0f, -10.0f, 11.0f, 0.25f,
+            13.0f, 14.0f, -15.0f, 16.0f);
+
+    /* The array functions are expected to give the same results as the
+     * single-element functions, whichever code path they use. */
+    memset(out_vec, 0, count * sizeof(*out_vec));
+    memset(exp_vec, 0, count * sizeof(*exp_vec));
+    D3DXVec3TransformArray(out_vec, sizeof(*out_vec), (D3DXVECTOR3 *)inp_vec, sizeof(*inp_vec), &mat, count);
+    for (i = 0; i < count; ++i)
+        D3DXVec3Transform(&exp_vec[i], (D3DXVECTOR3 *)&inp_vec[i], &mat);
+    expect_vec4_array(count, exp_vec, out_vec, 1);
+
+    memset(out_vec, 0, count * sizeof(*out_vec));
+    memset(exp_vec, 0, count * sizeof(*exp_vec));
+    D3DXVec3TransformCoordArray((D3DXVECTOR3 *)out_vec, sizeof(*out_vec), (D3DXVECTOR3 *)inp_vec,
+            sizeof(*inp_vec), &mat, count);
+    for (i = 0; i < count; ++i)
+        D3DXVec3TransformCoord((D3DXVECTOR3 *)&exp_vec[i], (D3DXVECTOR3 *)&inp_vec[i], &mat);
+    expect_vec4_array(count, exp_vec, out_vec, 1);
+
+    memset(out_vec, 0, count * sizeof(*out_vec));
+    memset(exp_vec, 0, count * sizeof(*exp_vec));
+    D3DXVec3TransformNormalArray((D3DXVECTOR3 *)out_vec, sizeof(*out_vec), (D3DXVECTOR3 *)inp_vec,
+            sizeof(*inp_vec), &mat, count);
+    for (i = 0; i < count; ++i)
+        D3DXVec3TransformNormal((D3DXVECTOR3 *)&exp_vec[i], (D3DXVECTOR3 *)&inp_vec[i], &mat);
+    expect_vec4_array(count, exp_vec, out_vec, 1);
+
+    D3DXVec4TransformArray(out_vec, sizeof(*out_vec), inp_vec, sizeof(*inp_vec), &mat, count);
+    for (i = 0; i < count; ++i)
+        D3DXVec4Transform(&exp_vec[i], &inp_vec[i], &mat);
+    expect_vec4_array(count, exp_vec, out_vec, 1);
+
+    /* In place, with an odd element count. */
+    memcpy(out_vec, inp_vec, count * sizeof(*out_vec));
+    D3DXVec4TransformArray(out_vec, sizeof(*out_vec), out_vec, sizeof(*out_vec), &mat, count - 1);
+    exp_vec[count - 1] = inp_vec[count - 1];
+    expect_vec4_array(count, exp_vec, out_vec, 1);
+
+    D3DXPlaneTransformArray((D3DXPLANE *)out_vec, sizeof(*out_vec), (D3DXPLANE *)inp_vec,
+            sizeof(*inp_vec), &mat, count);
+    for (i = 0; i < count; ++i)
+        D3DXPlaneTransform((D3DXPLANE *)&exp_vec[i], (D3DXPLANE *)&inp_vec[i], &mat);
+    expect_vec4_array(count, exp_vec, out_vec, 1);
+
+    D3DXVec2TransformArray(out_vec, sizeof(*out_vec), (D3DXVECTOR2 *)inp_vec, sizeof(*inp_vec), &mat, count);
+    for (i = 0; i < count; ++i)
+        D3DXVec2Transform(&exp_vec[i], (D3DXVECTOR2 *)&inp_vec[i], &mat);
+    expect_vec4_array(count, exp_vec, out_vec, 1);
+
+    memset(out_vec, 0, count * sizeof(*out_vec));
+    memset(exp_vec, 0, count * sizeof(*exp_vec));
+    D3DXVec2TransformCoordArray((D3DXVECTOR2 *)out_vec, sizeof(*out_vec), (D3DXVECTOR2 *)inp_vec,
+            sizeof(*inp_vec), &mat, count);
+    for (i = 0; i < count; ++i)
+        D3DXVec2TransformCoord((D3DXVECTOR2 *)&exp_vec[i], (D3DXVECTOR2 *)&inp_vec[i], &mat);
+    expect_vec4_array(count, exp_vec, out_vec, 1);
+
+    memset(out_vec, 0, count * sizeof(*out_vec));
+    memset(exp_vec, 0, count * sizeof(*exp_vec));
+    D3DXVec2TransformNormalArray((D3DXVECTOR2 *)out_vec, sizeof(*out_vec), (D3DXVECTOR2 *)inp_vec,
+            sizeof(*inp_vec), &mat, count);
+    for (i = 0; i < count; ++i)
+        D3DXVec2TransformNormal((D3DXVECTOR2 *)&exp_vec[i], (D3DXVECTOR2 *)&inp_vec[i], &mat);
+    expect_vec4_array(count, exp_vec, out_vec, 1);
+
+    D3DXMatrixPerspectiveFovLH(&projection, D3DX_PI / 4.0f, 4.0f / 3.0f, 1.0f, 1000.0f);
+    D3DXMatrixTranslation(&view, 0.0f, 0.0f, 20.0f);
+    D3DXMatrixTranslation(&world, 1.0f, 2.0f, 3.0f);
+
+    memset(out_vec, 0, count * sizeof(*out_vec));
+    memset(exp_vec, 0, count * sizeof(*exp_vec));
+    D3DXVec3ProjectArray((D3DXVECTOR3 *)out_vec, sizeof(*out_vec), (D3DXVECTOR3 *)inp_vec,
+            sizeof(*inp_vec), &viewport, &projection, &view, &world, count);
+    for (i = 0; i < count; ++i)
+        D3DXVec3Project((D3DXVECTOR3 *)&exp_vec[i], (D3DXVECTOR3 *)&inp_vec[i], &viewport,
+                &projection, &view, &world);
+    expect_vec4_array(count, exp_vec, out_vec, 8);
+
+    D3DXVec3ProjectArray((D3DXVECTOR3 *)out_vec, sizeof(*out_vec), (D3DXVECTOR3 *)inp_vec,
+            sizeof(*inp_vec), NULL, &projection, &view, &world, count);
+    for (i = 0; i < count; ++i)
+        D3DXVec3Project((D3DXVECTOR3 *)&exp_vec[i], (D3DXVECTOR3 *)&inp_vec[i], NULL,
+                &projection, &view, &world);
+    expect_vec4_array(count, exp_vec, out_vec, 8);
+
+    /* Unproject the projected points, in place. */
+    D3DXVec3ProjectArray((D3DXVECTOR3 *)out_vec, sizeof(*out_vec), (D3DXVECTOR3 *)inp_vec,
+            sizeof(*inp_vec), &viewport, &projection, &view, &world, count);
+    memcpy(exp_vec, out_vec, count * sizeof(*exp_vec));
+    for (i = 0; i < count; ++i)
+        D3DXVec3Unproject((D3DXVECTOR3 *)&exp_vec[i], (D3DXVECTOR3 *)&exp_vec[i], &viewport,
+                &projection, &view, &world);
+    D3DXVec3UnprojectArray((D3DXVECTOR3 *)out_vec, sizeof(*out_vec), (D3DXVECTOR3 *)out_vec,
+            sizeof(*out_vec), &viewport, &projection, &view, &world, count);
+    expect_vec4_array(count, exp_vec, out_vec, 4);
+
+    D3DXVec3UnprojectArray((D3DXVECTOR3 *)out_vec, sizeof(*out_vec), (D3DXVECTOR3 *)inp_vec,
+            sizeof(*inp_vec), NULL, &projection, &view, &world, count);
+    for (i = 0; i < count; ++i)
+        D3DXVec3Unproject((D3DXVECTOR3 *)&exp_vec[i], (D3DXVECTOR3 *)&inp_vec[i], NULL,
+                &projection, &view, &world);
+    expect_vec4_array(count, exp_vec, out_vec, 4);
+
+    set_matrix(&mat2,
+            0.5f, -2.0f, 1.0f, 4.0f,
+            3.0f, 6.0f, -7.0f, 2.0f,
+            1.0f, 10.0f, 0.25f, -1.0f,
+            -3.0f, 4.0f, 5.0f, 1.0f);
+    for (i = 0; i < 4; ++i)
+        for (j = 0; j < 4; ++j)
+            U(exp_mat).m[i][j] = U(mat).m[i][0] * U(mat2).m[0][j] + U(mat).m[i][1] * U(mat2).m[1][j]
+                    + U(mat).m[i][2] * U(mat2).m[2][j] + U(mat).m[i][3] * U(mat2).m[3][j];
+    D3DXMatrixMultiply(&mat2, &mat, &mat2);
+    expect_matrix(&exp_mat, &mat2, 0);
+
+    if (winetest_interactive)
+    {
+        /* Compare the throughput of the array functions with per-element calls. */
+        start = GetTickCount();
+        for (i = 0; i < iterations; ++i)
+            D3DXVec3TransformArray(out_vec, sizeof(*out_vec), (D3DXVECTOR3 *)inp_vec, sizeof(*inp_vec), &mat, count);
+        array_time = GetTickCount() - start;
+
+        start = GetTickCount();
+        for (i = 0; i < iterations; ++i)
+            for (j = 0; j < count; ++j)
+                D3DXVec3Transform(&out_vec[j], (D3DXVECTOR3 *)&inp_vec[j], &mat);
+        single_time = GetTickCount() - start;
+
+        trace("D3DXVec3TransformArray: %u x %u elements, array %u ms, single %u ms.\n",
+                iterations, count, array_time, single_time);
+
+        start = GetTickCount();
+        for (i = 0; i < iterations; ++i)
+            D3DXVec3TransformCoordArray((D3DXVECTOR3 *)out_vec, sizeof(*out_vec), (D3DXVECTOR3 *)inp_vec,
+                    sizeof(*inp_vec), &mat, count);
+        array_time = GetTickCount() - start;
+
+        start = GetTickCount();
+        for (i = 0; i < iterations; ++i)
+            for (j = 0; j < count; ++j)
+                D3DXVec3TransformCoord((D3DXVECTOR3 *)&out_vec[j], (D3DXVECTOR3 *)&inp_vec[j], &mat);
+        single_time = GetTickCount() - start;
+
+        trace("D3DXVec3TransformCoordArray: %u x %u elements, array %u ms, single %u ms.\n",
+                iterations, count, array_time, single_time);
+    }
+
+    HeapFree(GetProcessHeap(), 0, inp_vec);
+    HeapFree(GetProcessHeap(), 0, out_vec);
+    HeapFree(GetProcessHeap(), 0, exp_vec);
+}
+
 static void test_D3DXFloat_Array(void)
 {
     unsigned int i;
@@ -4587,6 +4765,7 @@ START_TEST(math)
     test_Matrix_Decompose();
     test_Matrix_Transformation2D();
     test_D3DXVec_Array();
+    test_D3DXVec_Array_large();
     test_D3DXFloat_Array();
     test_D3DXSHAdd();
     test_D3DXSHDot();
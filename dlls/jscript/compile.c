@@ -385,6 +385,19 @@ static HRESULT push_instr_uint_str(compiler_ctx_t *ctx, jsop_t op, unsigned arg1
     return S_OK;
 }
 
+static HRESULT push_instr_uint_uint(compiler_ctx_t *ctx, jsop_t op, unsigned arg1, unsigned arg2)
+{
+    unsigned instr;
+
+    instr = push_instr(ctx, op);
+    if(!instr)
+        return E_OUTOFMEMORY;
+
+    instr_ptr(ctx, instr)->u.arg[0].uint = arg1;
+    instr_ptr(ctx, instr)->u.arg[1].uint = arg2;
+    return S_OK;
+}
+
 static HRESULT push_instr_double(compiler_ctx_t *ctx, jsop_t op, double arg)
 {
     unsigned instr;
@@ -440,6 +453,11 @@ static HRESULT compile_unary_expression(compiler_ctx_t *ctx, unary_expression_t
     return push_instr(ctx, op) ? S_OK : E_OUTOFMEMORY;
 }
 
+static unsigned alloc_prop_cache(compiler_ctx_t *ctx)
+{
+    return ctx->code->prop_cache_cnt++;
+}
+
 /* ECMA-262 3rd Edition    11.2.1 */
 static HRESULT compile_member_expression(compiler_ctx_t *ctx, member_expression_t *expr)
 {
@@ -449,7 +467,7 @@ static HRESULT compile_member_expression(compiler_ctx_t *ctx, member_expression_
     if(FAILED(hres))
         return hres;
 
-    return push_instr_bstr(ctx, OP_member, expr->identifier);
+    return push_instr_bstr_uint(ctx, OP_member, expr->identifier, alloc_prop_cache(ctx));
 }
 
 #define LABEL_FLAG 0x80000000
@@ -599,7 +617,9 @@ static HRESULT compile_memberid_expression(compiler_ctx_t *ctx, expression_t *ex
     if(FAILED(hres))
         return hres;
 
-    return push_instr_uint(ctx, OP_memberid, flags);
+    /* names of array expressions are only known at run time */
+    return push_instr_uint_uint(ctx, OP_memberid, flags,
+                                expr->type == EXPR_MEMBER ? alloc_prop_cache(ctx) : NO_PROP_CACHE);
 }
 
 static HRESULT compile_increment_expression(compiler_ctx_t *ctx, unary_expression_t *expr, jsop_t op, int n)
@@ -2470,6 +2490,7 @@ void release_bytecode(bytecode_t *code)
     heap_pool_free(&code->heap);
     heap_free(code->bstr_pool);
     heap_free(code->str_pool);
+    heap_free(code->prop_caches);
     heap_free(code->instrs);
     heap_free(code);
 }
@@ -2751,6 +2772,11 @@ HRESULT compile_script(script_ctx_t *ctx, const WCHAR *code, UINT64 source_conte
 
     heap_pool_init(&compiler.heap);
     hres = compile_function(&compiler, compiler.parser->source, NULL, from_eval, &compiler.code->global_code);
+    if(SUCCEEDED(hres) && compiler.code->prop_cache_cnt) {
+        compiler.code->prop_caches = heap_alloc_zero(compiler.code->prop_cache_cnt * sizeof(*compiler.code->prop_caches));
+        if(!compiler.code->prop_caches)
+            hres = E_OUTOFMEMORY;
+    }
     heap_free(compiler.local_scopes);
     heap_pool_free(&compiler.heap);
     parser_release(compiler.parser);
@@ -60,6 +60,106 @@ struct _dispex_prop_t {
     int bucket_next;
 };
 
+/*
+ * Props are never removed from an object, only marked as deleted, so two
+ * objects that allocated the same names in the same order store a given name
+ * at the same index. Shapes form a per-script transition tree over these
+ * name sequences and let call sites cache name lookups, see
+ * jsdisp_get_id_cached. Objects that grow too large behave like dictionaries
+ * and drop their shape instead of growing the tree without bound.
+ */
+#define MAX_SHAPE_DEPTH 64
+#define MAX_SHAPE_CNT   16384
+
+struct _prop_shape_t {
+    unsigned id;
+    unsigned depth;
+    WCHAR *name;
+    prop_shape_t *children;
+    prop_shape_t *sibling;
+};
+
+static LONG last_shape_id;
+
+static prop_shape_t *alloc_shape(script_ctx_t *ctx, const WCHAR *name, unsigned depth)
+{
+    prop_shape_t *shape;
+
+    if(ctx->shape_cnt >= MAX_SHAPE_CNT)
+        return NULL;
+
+    shape = heap_alloc_zero(sizeof(*shape));
+    if(!shape)
+        return NULL;
+
+    if(name && !(shape->name = heap_strdupW(name))) {
+        heap_free(shape);
+        return NULL;
+    }
+
+    /* 0 marks an empty cache entry */
+    while(!(shape->id = InterlockedIncrement(&last_shape_id)));
+    shape->depth = depth;
+    ctx->shape_cnt++;
+    return shape;
+}
+
+static prop_shape_t *get_root_shape(script_ctx_t *ctx)
+{
+    if(!ctx->shape_root)
+        ctx->shape_root = alloc_shape(ctx, NULL, 0);
+    return ctx->shape_root;
+}
+
+static prop_shape_t *shape_transition(script_ctx_t *ctx, prop_shape_t *shape, const WCHAR *name)
+{
+    prop_shape_t *iter, **prev;
+
+    if(shape->depth >= MAX_SHAPE_DEPTH)
+        return NULL;
+
+    for(prev = &shape->children; (iter = *prev); prev = &iter->sibling) {
+        if(!wcscmp(iter->name, name)) {
+            /* keep recently used transitions in front */
+            *prev = iter->sibling;
+            iter->sibling = shape->children;
+            shape->children = iter;
+            return iter;
+        }
+    }
+
+    iter = alloc_shape(ctx, name, shape->depth + 1);
+    if(!iter)
+        return NULL;
+
+    iter->sibling = shape->children;
+    shape->children = iter;
+    return iter;
+}
+
+void release_shapes(script_ctx_t *ctx)
+{
+    prop_shape_t *shape = ctx->shape_root, *next;
+
+    /* flatten the tree by splicing children into the sibling list */
+    while(shape) {
+        if(shape->children) {
+            prop_shape_t *last = shape->children;
+            while(last->sibling)
+                last = last->sibling;
+            last->sibling = shape->sibling;
+            shape->sibling = shape->children;
+        }
+        next = shape->sibling;
+        heap_free(shape->name);
+        heap_free(shape);
+        shape = next;
+    }
+
+    ctx->shape_root = NULL;
+    ctx->shape_cnt = 0;
+}
+
 static void fix_protref_prop(jsdisp_t *jsdisp, dispex_prop_t *prop)
 {
     DWORD ref;
@@ -230,6 +330,9 @@ static inline dispex_prop_t* alloc_prop(jsdisp_t *This, const WCHAR *name, prop_
     bucket = get_props_idx(This, prop->hash);
     prop->bucket_next = This->props[bucket].bucket_head;
     This->props[bucket].bucket_head = This->prop_cnt++;
+
+    if(This->shape)
+        This->shape = shape_transition(This->ctx, This->shape, name);
     return prop;
 }
 
@@ -1819,6 +1922,7 @@ HRESULT init_dispex(jsdisp_t *dispex, script_ctx_t *ctx, const builtin_info_t *b
 
     script_addref(ctx);
     dispex->ctx = ctx;
+    dispex->shape = get_root_shape(ctx);
 
     return S_OK;
 }
@@ -1965,6 +2069,36 @@ HRESULT jsdisp_get_id(jsdisp_t *jsdisp, const WCHAR *name, DWORD flags, DISPID *
     return DISP_E_UNKNOWNNAME;
 }
 
+/*
+ * Same as jsdisp_get_id, but first tries the DISPID the call site resolved the
+ * name to the last time. That is valid for any object of the same shape, as
+ * long as the prop hasn't been deleted since; the checks below mirror what
+ * find_prop_name_prot would find for the cached prop.
+ */
+HRESULT jsdisp_get_id_cached(jsdisp_t *jsdisp, const WCHAR *name, DWORD flags, prop_cache_t *cache, DISPID *id)
+{
+    dispex_prop_t *prop;
+    HRESULT hres;
+
+    if(jsdisp->shape && jsdisp->shape->id == cache->shape_id && !(flags & fdexNameCaseInsensitive)) {
+        prop = &jsdisp->props[cache->id - 1];
+        if(prop->type != PROP_DELETED)
+            fix_protref_prop(jsdisp, prop);
+        /* the prototype prop may have been deleted, so the name needs a full lookup */
+        if(prop->type != PROP_DELETED) {
+            *id = cache->id;
+            return S_OK;
+        }
+    }
+
+    hres = jsdisp_get_id(jsdisp, name, flags, id);
+    if(SUCCEEDED(hres) && jsdisp->shape && !(flags & fdexNameCaseInsensitive)) {
+        cache->shape_id = jsdisp->shape->id;
+        cache->id = *id;
+    }
+    return hres;
+}
+
 HRESULT jsdisp_call_value(jsdisp_t *jsfunc, IDispatch *jsthis, WORD flags, unsigned argc, jsval_t *argv, jsval_t *r)
 {
     HRESULT hres;
@@ -503,6 +503,20 @@ static HRESULT disp_get_id(script_ctx_t *ctx, IDispatch *disp, const WCHAR *name
     return hres;
 }
 
+static HRESULT disp_get_id_cached(script_ctx_t *ctx, IDispatch *disp, const WCHAR *name, BSTR name_bstr, DWORD flags,
+                                  unsigned cache_idx, DISPID *id)
+{
+    jsdisp_t *jsdisp;
+    HRESULT hres;
+
+    if(cache_idx == NO_PROP_CACHE || !(jsdisp = iface_to_jsdisp(disp)))
+        return disp_get_id(ctx, disp, name, name_bstr, flags, id);
+
+    hres = jsdisp_get_id_cached(jsdisp, name, flags, &ctx->call_ctx->bytecode->prop_caches[cache_idx], id);
+    jsdisp_release(jsdisp);
+    return hres;
+}
+
 static HRESULT disp_cmp(IDispatch *disp1, IDispatch *disp2, BOOL *ret)
 {
     IObjectIdentity *identity;
@@ -1270,6 +1284,7 @@ static HRESULT interp_array(script_ctx_t *ctx)
 static HRESULT interp_member(script_ctx_t *ctx)
 {
     const BSTR arg = get_op_bstr(ctx, 0);
+    const unsigned cache_idx = get_op_uint(ctx, 1);
     IDispatch *obj;
     jsval_t v;
     DISPID id;
@@ -1281,7 +1296,7 @@ static HRESULT interp_member(script_ctx_t *ctx)
     if(FAILED(hres))
         return hres;
 
-    hres = disp_get_id(ctx, obj, arg, arg, 0, &id);
+    hres = disp_get_id_cached(ctx, obj, arg, arg, 0, cache_idx, &id);
     if(SUCCEEDED(hres)) {
         hres = disp_propget(ctx, obj, id, &v);
     }else if(hres == DISP_E_UNKNOWNNAME) {
@@ -1299,6 +1314,7 @@ static HRESULT interp_member(script_ctx_t *ctx)
 static HRESULT interp_memberid(script_ctx_t *ctx)
 {
     const unsigned arg = get_op_uint(ctx, 0);
+    const unsigned cache_idx = get_op_uint(ctx, 1);
     jsval_t objv, namev;
     const WCHAR *name;
     jsstr_t *name_str;
@@ -1323,7 +1339,7 @@ static HRESULT interp_memberid(script_ctx_t *ctx)
     if(FAILED(hres))
         return hres;
 
-    hres = disp_get_id(ctx, obj, name, NULL, arg, &id);
+    hres = disp_get_id_cached(ctx, obj, name, NULL, arg, cache_idx, &id);
     jsstr_release(name_str);
     if(SUCCEEDED(hres)) {
         ref.type = EXPRVAL_IDREF;
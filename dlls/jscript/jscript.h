@@ -52,6 +52,7 @@ typedef struct _jsstr_t jsstr_t;
 typedef struct _jsexcept_t jsexcept_t;
 typedef struct _script_ctx_t script_ctx_t;
 typedef struct _dispex_prop_t dispex_prop_t;
+typedef struct _prop_shape_t prop_shape_t;
 typedef struct _property_desc_t property_desc_t;
 
 typedef struct {
@@ -178,6 +179,12 @@ typedef struct {
     HRESULT (*idx_put)(jsdisp_t*,unsigned,jsval_t);
 } builtin_info_t;
 
+/* Per call site cache of the DISPID a name resolved to on an object of a given shape. */
+typedef struct {
+    unsigned shape_id;
+    DISPID id;
+} prop_cache_t;
+
 struct jsdisp_t {
     IDispatchEx IDispatchEx_iface;
 
@@ -191,6 +198,9 @@ struct jsdisp_t {
 
     jsdisp_t *prototype;
 
+    /* names of props in allocation order, NULL if the object is not cacheable */
+    prop_shape_t *shape;
+
     const builtin_info_t *builtin_info;
 };
 
@@ -256,6 +266,7 @@ HRESULT jsdisp_propput_idx(jsdisp_t*,DWORD,jsval_t) DECLSPEC_HIDDEN;
 HRESULT jsdisp_propget_name(jsdisp_t*,LPCWSTR,jsval_t*) DECLSPEC_HIDDEN;
 HRESULT jsdisp_get_idx(jsdisp_t*,DWORD,jsval_t*) DECLSPEC_HIDDEN;
 HRESULT jsdisp_get_id(jsdisp_t*,const WCHAR*,DWORD,DISPID*) DECLSPEC_HIDDEN;
+HRESULT jsdisp_get_id_cached(jsdisp_t*,const WCHAR*,DWORD,prop_cache_t*,DISPID*) DECLSPEC_HIDDEN;
 HRESULT disp_delete(IDispatch*,DISPID,BOOL*) DECLSPEC_HIDDEN;
 HRESULT disp_delete_name(script_ctx_t*,IDispatch*,jsstr_t*,BOOL*) DECLSPEC_HIDDEN;
 HRESULT jsdisp_delete_idx(jsdisp_t*,DWORD) DECLSPEC_HIDDEN;
@@ -387,6 +398,9 @@ struct _script_ctx_t {
     DWORD last_match_index;
     DWORD last_match_length;
 
+    prop_shape_t *shape_root;
+    unsigned shape_cnt;
+
     union {
         struct {
             jsdisp_t *global;
@@ -418,6 +432,7 @@ struct _script_ctx_t {
 C_ASSERT(RTL_SIZEOF_THROUGH_FIELD(script_ctx_t, set_prototype) == RTL_SIZEOF_THROUGH_FIELD(script_ctx_t, global_objects));
 
 void script_release(script_ctx_t*) DECLSPEC_HIDDEN;
+void release_shapes(script_ctx_t*) DECLSPEC_HIDDEN;
 
 static inline void script_addref(script_ctx_t *ctx)
 {
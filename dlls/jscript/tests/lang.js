@@ -2015,6 +2015,79 @@ ok(tmp, "tmp = " + tmp);
     ok(x === undefined, "x = " + x);
 })();
 
+/* member lookups are cached per call site, make sure the caches don't get stale */
+(function() {
+    function get_x(o) { return o.x; }
+    function call_f(o) { return o.f(); }
+    function set_x(o, v) { o.x = v; }
+    function Point(x, y) { this.x = x; this.y = y; }
+    var i, p, q, dict;
+
+    p = new Point(1, 2);
+    q = new Point(3, 4);
+    for(i = 0; i < 3; i++) {
+        ok(get_x(p) === 1, "get_x(p) = " + get_x(p));
+        ok(get_x(q) === 3, "get_x(q) = " + get_x(q));
+        ok(get_x({y: 5, x: 6}) === 6, "get_x({y: 5, x: 6}) = " + get_x({y: 5, x: 6}));
+        ok(get_x({}) === undefined, "get_x({}) = " + get_x({}));
+        ok(get_x("test") === undefined, "get_x(\"test\") = " + get_x("test"));
+    }
+
+    Point.prototype.x = "proto";
+    ok(get_x(p) === 1, "get_x(p) = " + get_x(p));
+    delete p.x;
+    ok(get_x(p) === "proto", "get_x(p) = " + get_x(p));
+    ok(get_x(q) === 3, "get_x(q) = " + get_x(q));
+    delete Point.prototype.x;
+    ok(get_x(p) === undefined, "get_x(p) = " + get_x(p));
+    set_x(p, 7);
+    ok(get_x(p) === 7, "get_x(p) = " + get_x(p));
+    set_x(q, 8);
+    ok(get_x(q) === 8, "get_x(q) = " + get_x(q));
+
+    Point.prototype.f = function() { return this.x; };
+    ok(call_f(q) === 8, "call_f(q) = " + call_f(q));
+    ok(call_f(p) === 7, "call_f(p) = " + call_f(p));
+    q.f = function() { return "own"; };
+    ok(call_f(q) === "own", "call_f(q) = " + call_f(q));
+    ok(call_f(p) === 7, "call_f(p) = " + call_f(p));
+    Point.prototype.f = function() { return "changed"; };
+    ok(call_f(p) === "changed", "call_f(p) = " + call_f(p));
+    delete Point.prototype.f;
+    tmp = false;
+    try {
+        call_f(p);
+    }catch(e) {
+        tmp = true;
+    }
+    ok(tmp, "expected exception");
+    ok(call_f(q) === "own", "call_f(q) = " + call_f(q));
+
+    /* the cached prop of the set site refers to a deleted prototype prop */
+    function F() {}
+    F.prototype.x = 0;
+    for(i = 0; i < 3; i++) {
+        p = new F();
+        ok(get_x(p) === 0, "get_x(p) = " + get_x(p));
+        set_x(p, i);
+        ok(get_x(p) === i, "get_x(p) = " + get_x(p));
+    }
+    q = new F();
+    ok(get_x(q) === 0, "get_x(q) = " + get_x(q));
+    delete F.prototype.x;
+    set_x(q, 1);
+    ok(get_x(q) === 1, "get_x(q) = " + get_x(q));
+    ok(q.hasOwnProperty("x"), "q.x is not an own property");
+
+    dict = {};
+    for(i = 0; i < 100; i++)
+        dict["p" + i] = i;
+    ok(get_x(dict) === undefined, "get_x(dict) = " + get_x(dict));
+    set_x(dict, 42);
+    ok(get_x(dict) === 42, "get_x(dict) = " + get_x(dict));
+    ok(dict.p99 === 99, "dict.p99 = " + dict.p99);
+})();
+
 var get, set;
 
 /* NoNewline rule parser tests */
@@ -0,0 +1,40 @@
+/*
+ * Copyright 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/* Identifier lookups of locals, enclosing function variables and globals. */
+
+var global_step = 3;
+
+function make_accumulator() {
+    var total = 0, calls = 0;
+
+    return function(n) {
+        var local = n * global_step;
+        calls++;
+        total += local;
+        return total / calls;
+    };
+}
+
+var acc = make_accumulator(), i, avg;
+
+for(i = 0; i < 200000; i++)
+    avg = acc(i & 15);
+
+if(!(avg > 0))
+    throw "unexpected average " + avg;
@@ -0,0 +1,46 @@
+/*
+ * Copyright 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/* Calls of methods found on the prototype chain and of builtin methods. */
+
+function Counter() {
+    this.count = 0;
+}
+
+Counter.prototype.add = function(n) {
+    this.count += n;
+    return this;
+};
+
+Counter.prototype.get = function() {
+    return this.count;
+};
+
+var counters = [new Counter(), new Counter(), new Counter()], i, str = "", total = 0;
+
+for(i = 0; i < 100000; i++)
+    counters[i % 3].add(i & 7).add(1);
+
+for(i = 0; i < counters.length; i++)
+    total += counters[i].get();
+
+for(i = 0; i < 20000; i++)
+    str = "abc".concat(str.length, "d").toLowerCase().substring(0, 8);
+
+if(total != 450000)
+    throw "unexpected total " + total;
@@ -0,0 +1,47 @@
+/*
+ * Copyright 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/* Reads and writes of named props on objects sharing a few layouts. */
+
+function Point(x, y, z) {
+    this.x = x;
+    this.y = y;
+    this.z = z;
+}
+
+var points = [], i, j, sum = 0;
+
+for(i = 0; i < 100; i++) {
+    if(i % 3)
+        points.push(new Point(i, i + 1, i + 2));
+    else
+        points.push({z: i + 2, y: i + 1, x: i});
+}
+
+for(j = 0; j < 2000; j++) {
+    for(i = 0; i < points.length; i++) {
+        var p = points[i];
+        sum += p.x + p.y * 2 + p.z * 3;
+        p.x = p.y;
+        p.y = p.z;
+        p.z = p.x - 1;
+    }
+}
+
+if(isNaN(sum))
+    throw "unexpected sum";
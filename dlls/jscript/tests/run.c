@@ -4142,6 +4142,9 @@ static void run_benchmarks(void)
     run_benchmark("dna.js");
     run_benchmark("base64.js");
     run_benchmark("validateinput.js");
+    run_benchmark("micro-property-access.js");
+    run_benchmark("micro-method-call.js");
+    run_benchmark("micro-closure.js");
 }
 
 static BOOL check_jscript(void)
@@ -1311,6 +1311,99 @@ static void test_dbcs_to_widechar(void)
     }
 }
 
+/* runs of ASCII chars of all lengths, mixed with chars that need a table lookup */
+static void test_ascii_runs(void)
+{
+    static const UINT codepages[] = { 1252, 932, CP_UTF8 };
+    static const WCHAR others[] = { 0xe9, 0x65e5, 0x20ac };
+    WCHAR src[300], bufW[300];
+    char bufA[900], refA[900];
+    int i, j, k, len, reflen, ret;
+
+    for (i = 0; i < ARRAY_SIZE(codepages); i++)
+    {
+        for (len = j = 0; len < 250; j++)
+        {
+            for (k = 0; k < j % 41; k++, len++) src[len] = 'a' + len % 26;
+            src[len++] = others[i];
+        }
+
+        for (k = reflen = 0; k < len; k++)
+            reflen += WideCharToMultiByte(codepages[i], 0, src + k, 1, refA + reflen,
+                                          sizeof(refA) - reflen, NULL, NULL);
+
+        ret = WideCharToMultiByte(codepages[i], 0, src, len, NULL, 0, NULL, NULL);
+        ok(ret == reflen, "%u: got %d, expected %d\n", codepages[i], ret, reflen);
+        memset(bufA, 0xcc, sizeof(bufA));
+        ret = WideCharToMultiByte(codepages[i], 0, src, len, bufA, sizeof(bufA), NULL, NULL);
+        ok(ret == reflen, "%u: got %d, expected %d\n", codepages[i], ret, reflen);
+        ok(!memcmp(bufA, refA, reflen), "%u: wrong conversion\n", codepages[i]);
+        ok(bufA[reflen] == (char)0xcc, "%u: buffer overrun\n", codepages[i]);
+
+        ret = MultiByteToWideChar(codepages[i], 0, refA, reflen, NULL, 0);
+        ok(ret == len, "%u: got %d, expected %d\n", codepages[i], ret, len);
+        memset(bufW, 0xcc, sizeof(bufW));
+        ret = MultiByteToWideChar(codepages[i], 0, refA, reflen, bufW, ARRAY_SIZE(bufW));
+        ok(ret == len, "%u: got %d, expected %d\n", codepages[i], ret, len);
+        ok(!memcmp(bufW, src, len * sizeof(WCHAR)), "%u: wrong conversion\n", codepages[i]);
+        ok(bufW[len] == 0xcccc, "%u: buffer overrun\n", codepages[i]);
+
+        SetLastError(0xdeadbeef);
+        ret = WideCharToMultiByte(codepages[i], 0, src, len, bufA, reflen / 2, NULL, NULL);
+        ok(!ret, "%u: got %d\n", codepages[i], ret);
+        ok(GetLastError() == ERROR_INSUFFICIENT_BUFFER, "%u: got error %lu\n", codepages[i], GetLastError());
+
+        SetLastError(0xdeadbeef);
+        ret = MultiByteToWideChar(codepages[i], 0, refA, reflen, bufW, len / 2);
+        ok(!ret, "%u: got %d\n", codepages[i], ret);
+        ok(GetLastError() == ERROR_INSUFFICIENT_BUFFER, "%u: got error %lu\n", codepages[i], GetLastError());
+    }
+}
+
+/* rough conversion throughput, for the ASCII fast paths */
+static void test_conversion_performance(void)
+{
+    static const unsigned int count = 200, size = 65536;
+    static const UINT codepages[] = { 1252, 932, CP_UTF8 };
+    static const WCHAR others[] = { 0xe9, 0x65e5, 0x20ac };
+    WCHAR *text = HeapAlloc(GetProcessHeap(), 0, size * sizeof(WCHAR));
+    WCHAR *bufW = HeapAlloc(GetProcessHeap(), 0, size * sizeof(WCHAR));
+    char *bufA = HeapAlloc(GetProcessHeap(), 0, size * 3);
+    unsigned int i, j, mixed;
+    int lenA, ret = 0;
+    DWORD start;
+
+    for (i = 0; i < ARRAY_SIZE(codepages); i++)
+    {
+        for (mixed = 0; mixed < 2; mixed++)
+        {
+            for (j = 0; j < size; j++)
+                text[j] = (mixed && j % 8 == 7) ? others[i] : 'a' + j % 26;
+
+            lenA = WideCharToMultiByte(codepages[i], 0, text, size, bufA, size * 3, NULL, NULL);
+            ok(lenA, "%u: conversion failed\n", codepages[i]);
+
+            start = GetTickCount();
+            for (j = 0; j < count; j++)
+                ret = MultiByteToWideChar(codepages[i], 0, bufA, lenA, bufW, size);
+            trace("MultiByteToWideChar(%u, %s): %u calls of %u bytes in %lu ms\n", codepages[i],
+                  mixed ? "mixed" : "ascii", count, lenA, GetTickCount() - start);
+            ok(ret == size, "%u: got %d\n", codepages[i], ret);
+
+            start = GetTickCount();
+            for (j = 0; j < count; j++)
+                ret = WideCharToMultiByte(codepages[i], 0, text, size, bufA, size * 3, NULL, NULL);
+            trace("WideCharToMultiByte(%u, %s): %u calls of %u chars in %lu ms\n", codepages[i],
+                  mixed ? "mixed" : "ascii", count, size, GetTickCount() - start);
+            ok(ret == lenA, "%u: got %d, expected %d\n", codepages[i], ret, lenA);
+        }
+    }
+
+    HeapFree(GetProcessHeap(), 0, text);
+    HeapFree(GetProcessHeap(), 0, bufW);
+    HeapFree(GetProcessHeap(), 0, bufA);
+}
+
 START_TEST(codepage)
 {
     BOOL bUsedDefaultChar;
@@ -1333,4 +1426,6 @@ START_TEST(codepage)
     test_threadcp();
 
     test_dbcs_to_widechar();
+    test_ascii_runs();
+    if (winetest_interactive) test_conversion_performance();
 }
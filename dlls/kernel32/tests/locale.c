@@ -3750,6 +3750,144 @@ static void test_unicode_sorting(void)
     ok(ret1 == ret2, "Got ret1=%d, ret2=%d\n", ret1, ret2);
 }
 
+static int compare_sortkeys(const BYTE *key1, int len1, const BYTE *key2, int len2)
+{
+    int ret = memcmp(key1, key2, min(len1, len2));
+
+    if (!ret) ret = len1 - len2;
+    if (ret < 0) return CSTR_LESS_THAN;
+    if (ret > 0) return CSTR_GREATER_THAN;
+    return CSTR_EQUAL;
+}
+
+static void test_ascii_sorting(void)
+{
+    static const WCHAR *locales[] = { L"en-US", L"fr-FR", L"hu-HU", L"da-DK", L"es-ES_tradnl" };
+    static const DWORD flags[] = { 0, NORM_IGNORECASE, NORM_IGNORENONSPACE, NORM_IGNORESYMBOLS,
+                                   SORT_STRINGSORT, LINGUISTIC_IGNORECASE, SORT_DIGITSASNUMBERS };
+    static const WCHAR *strings[] =
+    {
+        L"abc", L"ABC", L"Abc", L"abcd", L"abd", L"ab c", L"ab-c", L"co-op", L"coop", L"csak",
+        L"cukor", L"chico", L"cuna", L"aarhus", L"zebra", L"file9", L"file10", L"File10.txt",
+        L"", L"a", L"Z", L"0", L"The quick brown fox jumps over the lazy dog",
+    };
+    BYTE key1[256], key2[256];
+    int i, j, k, l, len1, len2, ret, expect;
+
+    if (!pCompareStringEx || !pLCMapStringEx)
+    {
+        win_skip("CompareStringEx or LCMapStringEx not available\n");
+        return;
+    }
+
+    for (i = 0; i < ARRAY_SIZE(locales); i++)
+    {
+        for (j = 0; j < ARRAY_SIZE(flags); j++)
+        {
+            for (k = 0; k < ARRAY_SIZE(strings); k++)
+            {
+                len1 = pLCMapStringEx(locales[i], LCMAP_SORTKEY | flags[j], strings[k], -1,
+                                      (WCHAR *)key1, sizeof(key1), NULL, NULL, 0);
+                ok(len1 > 0, "%s %#lx %s: LCMapStringEx failed\n",
+                   wine_dbgstr_w(locales[i]), flags[j], wine_dbgstr_w(strings[k]));
+
+                /* the same key again, and its size */
+                ret = pLCMapStringEx(locales[i], LCMAP_SORTKEY | flags[j], strings[k], -1,
+                                     NULL, 0, NULL, NULL, 0);
+                ok(ret == len1, "%s %#lx %s: got %d, expected %d\n",
+                   wine_dbgstr_w(locales[i]), flags[j], wine_dbgstr_w(strings[k]), ret, len1);
+                ret = pLCMapStringEx(locales[i], LCMAP_SORTKEY | flags[j], strings[k], -1,
+                                     (WCHAR *)key2, sizeof(key2), NULL, NULL, 0);
+                ok(ret == len1 && !memcmp(key1, key2, len1), "%s %#lx %s: keys differ\n",
+                   wine_dbgstr_w(locales[i]), flags[j], wine_dbgstr_w(strings[k]));
+                ret = pLCMapStringEx(locales[i], LCMAP_SORTKEY | LCMAP_BYTEREV | flags[j], strings[k], -1,
+                                     (WCHAR *)key2, sizeof(key2), NULL, NULL, 0);
+                ok(ret == len1, "%s %#lx %s: got %d, expected %d\n",
+                   wine_dbgstr_w(locales[i]), flags[j], wine_dbgstr_w(strings[k]), ret, len1);
+                for (l = 0; l + 1 < ret; l += 2)
+                    if (key2[l] != key1[l + 1] || key2[l + 1] != key1[l]) break;
+                ok(l + 1 >= ret, "%s %#lx %s: byte reversed key differs at %d\n",
+                   wine_dbgstr_w(locales[i]), flags[j], wine_dbgstr_w(strings[k]), l);
+
+                for (l = 0; l < ARRAY_SIZE(strings); l++)
+                {
+                    len2 = pLCMapStringEx(locales[i], LCMAP_SORTKEY | flags[j], strings[l], -1,
+                                          (WCHAR *)key2, sizeof(key2), NULL, NULL, 0);
+                    expect = compare_sortkeys(key1, len1, key2, len2);
+                    ret = pCompareStringEx(locales[i], flags[j], strings[k], -1, strings[l], -1, NULL, NULL, 0);
+                    ok(ret == expect, "%s %#lx %s %s: got %d, expected %d\n", wine_dbgstr_w(locales[i]),
+                       flags[j], wine_dbgstr_w(strings[k]), wine_dbgstr_w(strings[l]), ret, expect);
+                }
+            }
+        }
+    }
+}
+
+/* rough timings of the common string operations, for the ASCII fast paths */
+static void test_string_performance(void)
+{
+    static const unsigned int count = 100000;
+    static const WCHAR *strings[] =
+    {
+        L"System.Collections.Generic", L"system.collections.generic", L"System.Collections.Concurrent",
+        L"C:\\windows\\system32\\kernel32.dll", L"C:\\windows\\system32\\KERNELBASE.dll",
+    };
+    WCHAR text[1024], dst[1030];
+    BYTE key[512];
+    unsigned int i;
+    DWORD start;
+    int ret = 0;
+
+    if (!pCompareStringEx || !pLCMapStringEx || !pNormalizeString)
+    {
+        win_skip("CompareStringEx, LCMapStringEx or NormalizeString not available\n");
+        return;
+    }
+
+    start = GetTickCount();
+    for (i = 0; i < count; i++)
+        ret = pCompareStringEx(L"en-US", 0, strings[i % 5], -1, strings[(i + 1) % 5], -1, NULL, NULL, 0);
+    trace("CompareStringEx: %u calls in %lu ms\n", count, GetTickCount() - start);
+    ok(ret, "CompareStringEx failed\n");
+
+    start = GetTickCount();
+    for (i = 0; i < count; i++)
+        ret = pCompareStringEx(L"en-US", NORM_IGNORECASE, strings[0], -1, strings[1], -1, NULL, NULL, 0);
+    trace("CompareStringEx(NORM_IGNORECASE): %u calls in %lu ms\n", count, GetTickCount() - start);
+    ok(ret == CSTR_EQUAL, "got %d\n", ret);
+
+    start = GetTickCount();
+    for (i = 0; i < count; i++)
+        ret = CompareStringOrdinal(strings[i % 5], -1, strings[(i + 1) % 5], -1, TRUE);
+    trace("CompareStringOrdinal: %u calls in %lu ms\n", count, GetTickCount() - start);
+    ok(ret, "CompareStringOrdinal failed\n");
+
+    start = GetTickCount();
+    for (i = 0; i < count; i++)
+    {
+        ret = pLCMapStringEx(L"en-US", LCMAP_SORTKEY, strings[i % 5], -1, NULL, 0, NULL, NULL, 0);
+        ret = pLCMapStringEx(L"en-US", LCMAP_SORTKEY, strings[i % 5], -1, (WCHAR *)key, ret, NULL, NULL, 0);
+    }
+    trace("LCMapStringEx(LCMAP_SORTKEY): %u size and key calls in %lu ms\n", count, GetTickCount() - start);
+    ok(ret, "LCMapStringEx failed\n");
+
+    for (i = 0; i < ARRAY_SIZE(text) - 1; i++) text[i] = 'a' + i % 26;
+    text[i] = 0;
+    start = GetTickCount();
+    for (i = 0; i < count / 100; i++)
+        ret = pNormalizeString(NormalizationC, text, -1, dst, ARRAY_SIZE(dst));
+    trace("NormalizeString(NormalizationC): %u calls of %u chars in %lu ms\n", count / 100,
+          (unsigned int)ARRAY_SIZE(text), GetTickCount() - start);
+    ok(ret == ARRAY_SIZE(text), "got %d\n", ret);
+
+    start = GetTickCount();
+    for (i = 0; i < count / 100; i++)
+        ret = pNormalizeString(NormalizationKD, text, -1, dst, ARRAY_SIZE(dst));
+    trace("NormalizeString(NormalizationKD): %u calls of %u chars in %lu ms\n", count / 100,
+          (unsigned int)ARRAY_SIZE(text), GetTickCount() - start);
+    ok(ret == ARRAY_SIZE(text), "got %d\n", ret);
+}
+
 static void test_FoldStringA(void)
 {
   int ret, i, j;
@@ -6967,6 +7105,16 @@ static void test_NormalizeString(void)
     static const WCHAR part1_nfc11[] = {0xC5,0};
     static const WCHAR part1_nfd11[] = {'A',0x030A,0};
 
+    /* ASCII runs, long enough for the vectorized scan, before composable chars */
+    static const WCHAR part2_str1[] = L"The quick brown fox jumps over the lazy dog";
+    static const WCHAR part2_str2[] = L"The quick brown fox jumps over the lazy doge\x0301";
+    static const WCHAR part2_nfc2[] = L"The quick brown fox jumps over the lazy dog\x00e9";
+    static const WCHAR part2_str3[] = L"The quick brown fox jumps over the lazy dog\x00e9 \x00aa\x1100\x1161";
+    static const WCHAR part2_nfd3[] = L"The quick brown fox jumps over the lazy doge\x0301 \x00aa\x1100\x1161";
+    static const WCHAR part2_nfc3[] = L"The quick brown fox jumps over the lazy dog\x00e9 \x00aa\xac00";
+    static const WCHAR part2_nfkc3[] = L"The quick brown fox jumps over the lazy dog\x00e9 a\xac00";
+    static const WCHAR part2_nfkd3[] = L"The quick brown fox jumps over the lazy doge\x0301 a\x1100\x1161";
+
     static const WCHAR composite_src[] =
     {
         0x008a, 0x008e, 0x009a, 0x009e, 0x009f, 0x00c0, 0x00c1, 0x00c2,
@@ -7007,6 +7155,9 @@ static void test_NormalizeString(void)
         { part1_str9, { part1_str9, part1_str9, part1_nfkc9, part1_nfkc9 } },
         { part1_str10, { part1_str10, part1_str10, part1_nfkc10, part1_nfkc10 } },
         { part1_str11, { part1_nfc11, part1_nfd11, part1_nfc11, part1_nfd11 } },
+        { part2_str1, { part2_str1, part2_str1, part2_str1, part2_str1 } },
+        { part2_str2, { part2_nfc2, part2_str2, part2_nfc2, part2_str2 } },
+        { part2_str3, { part2_nfc3, part2_nfd3, part2_nfkc3, part2_nfkd3 } },
         { 0 }
     };
     const struct test_data_normal *ptest = test_arr;
@@ -8331,6 +8482,8 @@ START_TEST(locale)
   test_geo_name();
   test_sorting();
   test_unicode_sorting();
+  test_ascii_sorting();
+  if (winetest_interactive) test_string_performance();
   test_EnumCalendarInfoA();
   test_EnumCalendarInfoW();
   test_EnumCalendarInfoExA();
@@ -25,6 +25,9 @@
 
 #include <stdarg.h>
 #include <stdlib.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -302,6 +305,8 @@ struct norm_table
 
 static CPTABLEINFO ansi_cpinfo;
 static CPTABLEINFO oem_cpinfo;
+static BOOL ansi_is_ascii;
+static BOOL oem_is_ascii;
 static UINT unix_cp = CP_UTF8;
 static LCID system_lcid;
 static LCID user_lcid;
@@ -316,6 +321,7 @@ static const NLS_LOCALE_DATA *system_locale;
 static const NLS_LOCALE_DATA *user_locale;
 
 static CPTABLEINFO codepages[128];
+static BOOL codepages_is_ascii[128];
 static unsigned int nb_codepages;
 
 static struct norm_table *norm_info;
@@ -1896,6 +1902,25 @@ static void update_locale_registry(void)
 }
 
 
+/* check whether a code page maps 7-bit ASCII to itself both ways */
+static BOOL is_ascii_compatible( const CPTABLEINFO *info )
+{
+    unsigned int i;
+
+    if (info->CodePage == CP_UTF8) return FALSE;
+    for (i = 0; i < 0x80; i++)
+    {
+        if (info->MultiByteTable[i] != i) return FALSE;
+        if (info->DBCSOffsets)
+        {
+            if (info->DBCSOffsets[i] || ((const WCHAR *)info->WideCharTable)[i] != i) return FALSE;
+        }
+        else if (((const unsigned char *)info->WideCharTable)[i] != i) return FALSE;
+    }
+    return TRUE;
+}
+
+
 /***********************************************************************
  *		init_locale
  */
@@ -1936,6 +1961,8 @@ void init_locale( HMODULE module )
     oem_ptr = NtCurrentTeb()->Peb->OemCodePageData ? NtCurrentTeb()->Peb->OemCodePageData : utf8;
     RtlInitCodePageTable( ansi_ptr, &ansi_cpinfo );
     RtlInitCodePageTable( oem_ptr, &oem_cpinfo );
+    ansi_is_ascii = is_ascii_compatible( &ansi_cpinfo );
+    oem_is_ascii = is_ascii_compatible( &oem_cpinfo );
 
     RegCreateKeyExW( HKEY_LOCAL_MACHINE, L"System\\CurrentControlSet\\Control\\Nls",
                      0, NULL, REG_OPTION_NON_VOLATILE, KEY_ALL_ACCESS, NULL, &nls_key, NULL );
@@ -2227,6 +2254,7 @@ static const CPTABLEINFO *get_codepage_table( UINT codepage )
         return NULL;
     }
     RtlInitCodePageTable( ptr, &codepages[i] );
+    codepages_is_ascii[i] = is_ascii_compatible( &codepages[i] );
     nb_codepages++;
 done:
     RtlLeaveCriticalSection( &locale_section );
@@ -2619,7 +2647,49 @@ static int mbstowcs_decompose( const CPTABLEINFO *info, const unsigned char *src
 }
 
 
-static int mbstowcs_sbcs( const CPTABLEINFO *info, const unsigned char *src, int srclen,
+static BOOL is_ascii_codepage( const CPTABLEINFO *info )
+{
+    if (info == &ansi_cpinfo) return ansi_is_ascii;
+    if (info == &oem_cpinfo) return oem_is_ascii;
+    if (info >= codepages && info < codepages + ARRAY_SIZE(codepages)) return codepages_is_ascii[info - codepages];
+    return FALSE;
+}
+
+
+/* convert a block of 16 chars if they are all 7-bit ASCII */
+static inline BOOL mbstowcs_ascii_block( const unsigned char *src, WCHAR *dst )
+{
+#ifdef __SSE2__
+    __m128i chars = _mm_loadu_si128( (const __m128i *)src );
+
+    if (_mm_movemask_epi8( chars )) return FALSE;
+    _mm_storeu_si128( (__m128i *)dst, _mm_unpacklo_epi8( chars, _mm_setzero_si128() ));
+    _mm_storeu_si128( (__m128i *)(dst + 8), _mm_unpackhi_epi8( chars, _mm_setzero_si128() ));
+    return TRUE;
+#else
+    return FALSE;
+#endif
+}
+
+
+/* convert a block of 16 chars if they are all 7-bit ASCII */
+static inline BOOL wcstombs_ascii_block( const WCHAR *src, char *dst )
+{
+#ifdef __SSE2__
+    __m128i lo = _mm_loadu_si128( (const __m128i *)src );
+    __m128i hi = _mm_loadu_si128( (const __m128i *)(src + 8) );
+    __m128i high_bits = _mm_and_si128( _mm_or_si128( lo, hi ), _mm_set1_epi16( 0xff80 ));
+
+    if (_mm_movemask_epi8( _mm_cmpeq_epi16( high_bits, _mm_setzero_si128() )) != 0xffff) return FALSE;
+    _mm_storeu_si128( (__m128i *)dst, _mm_packus_epi16( lo, hi ));
+    return TRUE;
+#else
+    return FALSE;
+#endif
+}
+
+
+static int mbstowcs_sbcs( const CPTABLEINFO *info, BOOL ascii, const unsigned char *src, int srclen,
                           WCHAR *dst, int dstlen )
 {
     const USHORT *table = info->MultiByteTable;
@@ -2636,6 +2706,13 @@ static int mbstowcs_sbcs( const CPTABLEINFO *info, const unsigned char *src, int
 
     while (srclen >= 16)
     {
+        if (ascii && mbstowcs_ascii_block( src, dst ))
+        {
+            src += 16;
+            dst += 16;
+            srclen -= 16;
+            continue;
+        }
         dst[0]  = table[src[0]];
         dst[1]  = table[src[1]];
         dst[2]  = table[src[2]];
@@ -2683,7 +2760,7 @@ static int mbstowcs_sbcs( const CPTABLEINFO *info, const unsigned char *src, int
 }
 
 
-static int mbstowcs_dbcs( const CPTABLEINFO *info, const unsigned char *src, int srclen,
+static int mbstowcs_dbcs( const CPTABLEINFO *info, BOOL ascii, const unsigned char *src, int srclen,
                           WCHAR *dst, int dstlen )
 {
     USHORT off;
@@ -2698,6 +2775,14 @@ static int mbstowcs_dbcs( const CPTABLEINFO *info, const unsigned char *src, int
 
     for (i = dstlen; srclen && i; i--, srclen--, src++, dst++)
     {
+        if (ascii && *src < 0x80 && srclen >= 16 && i >= 16 && mbstowcs_ascii_block( src, dst ))
+        {
+            src += 15;
+            dst += 15;
+            srclen -= 15;
+            i -= 15;
+            continue;
+        }
         if ((off = info->DBCSOffsets[*src]))
         {
             if (srclen > 1 && src[1])
@@ -2740,9 +2825,9 @@ static int mbstowcs_codepage( const CPTABLEINFO *info, DWORD flags, const char *
     if (flags & MB_COMPOSITE) return mbstowcs_decompose( info, str, srclen, dst, dstlen );
 
     if (info->DBCSOffsets)
-        return mbstowcs_dbcs( info, str, srclen, dst, dstlen );
+        return mbstowcs_dbcs( info, is_ascii_codepage( info ), str, srclen, dst, dstlen );
     else
-        return mbstowcs_sbcs( info, str, srclen, dst, dstlen );
+        return mbstowcs_sbcs( info, is_ascii_codepage( info ), str, srclen, dst, dstlen );
 }
 
 
@@ -2900,7 +2985,7 @@ static int wcstombs_utf8( DWORD flags, const WCHAR *src, int srclen, char *dst,
 }
 
 
-static int wcstombs_sbcs( const CPTABLEINFO *info, const WCHAR *src, unsigned int srclen,
+static int wcstombs_sbcs( const CPTABLEINFO *info, BOOL ascii, const WCHAR *src, unsigned int srclen,
                           char *dst, unsigned int dstlen )
 {
     const char *table = info->WideCharTable;
@@ -2918,6 +3003,13 @@ static int wcstombs_sbcs( const CPTABLEINFO *info, const WCHAR *src, unsigned in
 
     while (srclen >= 16)
     {
+        if (ascii && wcstombs_ascii_block( src, dst ))
+        {
+            src += 16;
+            dst += 16;
+            srclen -= 16;
+            continue;
+        }
         dst[0]  = table[src[0]];
         dst[1]  = table[src[1]];
         dst[2]  = table[src[2]];
@@ -2965,7 +3057,7 @@ static int wcstombs_sbcs( const CPTABLEINFO *info, const WCHAR *src, unsigned in
 }
 
 
-static int wcstombs_dbcs( const CPTABLEINFO *info, const WCHAR *src, unsigned int srclen,
+static int wcstombs_dbcs( const CPTABLEINFO *info, BOOL ascii, const WCHAR *src, unsigned int srclen,
                           char *dst, unsigned int dstlen )
 {
     const USHORT *table = info->WideCharTable;
@@ -2979,6 +3071,14 @@ static int wcstombs_dbcs( const CPTABLEINFO *info, const WCHAR *src, unsigned in
 
     for (i = dstlen; srclen && i; i--, srclen--, src++)
     {
+        if (ascii && *src < 0x80 && srclen >= 16 && i >= 16 && wcstombs_ascii_block( src, dst ))
+        {
+            src += 15;
+            dst += 16;
+            srclen -= 15;
+            i -= 15;
+            continue;
+        }
         if (table[*src] & 0xff00)
         {
             if (i == 1) break;  /* do not output a partial char */
@@ -3253,9 +3353,9 @@ static int wcstombs_codepage( const CPTABLEINFO *info, DWORD flags, const WCHAR
             return wcstombs_sbcs_slow( info, flags, src, srclen, dst, dstlen, defchar, used );
     }
     if (info->DBCSOffsets)
-        return wcstombs_dbcs( info, src, srclen, dst, dstlen );
+        return wcstombs_dbcs( info, is_ascii_codepage( info ), src, srclen, dst, dstlen );
     else
-        return wcstombs_sbcs( info, src, srclen, dst, dstlen );
+        return wcstombs_sbcs( info, is_ascii_codepage( info ), src, srclen, dst, dstlen );
 }
 
 
@@ -3817,6 +3917,236 @@ static int get_sortkey( const struct sortguid *sortid, DWORD flags,
 }
 
 
+/* per-thread memo of recent sort keys, callers usually ask for the size first and then for the key */
+
+#define SORTKEY_CACHE_ENTRIES 4
+#define SORTKEY_CACHE_MAX_SRC 64
+#define SORTKEY_CACHE_MAX_KEY 256
+/* upper bound of the get_sortkey() result, see init_sortkey_state() */
+#define SORTKEY_MAX_LEN(len) (22 * (len) + 9)
+
+struct sortkey_cache_entry
+{
+    const struct sortguid *sortid;
+    DWORD                  flags;
+    UINT                   hash;
+    int                    srclen;
+    int                    keylen;
+    WCHAR                  src[SORTKEY_CACHE_MAX_SRC];
+    BYTE                   key[SORTKEY_CACHE_MAX_KEY];
+};
+
+struct sortkey_cache
+{
+    unsigned int              next;  /* next entry to replace */
+    struct sortkey_cache_entry entries[SORTKEY_CACHE_ENTRIES];
+};
+
+static DWORD sortkey_cache_index = FLS_OUT_OF_INDEXES;
+
+static void WINAPI free_sortkey_cache( void *cache )
+{
+    RtlFreeHeap( GetProcessHeap(), 0, cache );
+}
+
+static struct sortkey_cache *get_sortkey_cache(void)
+{
+    struct sortkey_cache *cache;
+    DWORD index = sortkey_cache_index;
+
+    if (index == FLS_OUT_OF_INDEXES)
+    {
+        if ((index = FlsAlloc( free_sortkey_cache )) == FLS_OUT_OF_INDEXES) return NULL;
+        if (InterlockedCompareExchange( (LONG *)&sortkey_cache_index, index, FLS_OUT_OF_INDEXES ) !=
+            FLS_OUT_OF_INDEXES)
+        {
+            FlsFree( index );
+            index = sortkey_cache_index;
+        }
+    }
+    if ((cache = FlsGetValue( index ))) return cache;
+    if (!(cache = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*cache) ))) return NULL;
+    if (!FlsSetValue( index, cache ))
+    {
+        RtlFreeHeap( GetProcessHeap(), 0, cache );
+        return NULL;
+    }
+    return cache;
+}
+
+static UINT hash_sortkey_source( const WCHAR *src, int srclen )
+{
+    UINT hash = 2166136261u;
+    int i;
+
+    for (i = 0; i < srclen; i++) hash = (hash ^ src[i]) * 16777619;
+    return hash;
+}
+
+/* implementation of LCMAP_SORTKEY with a lookup in the thread's sort key memo */
+static int get_sortkey_cached( const struct sortguid *sortid, DWORD flags,
+                               const WCHAR *src, int srclen, BYTE *dst, int dstlen )
+{
+    BYTE buffer[SORTKEY_MAX_LEN( SORTKEY_CACHE_MAX_SRC )];
+    struct sortkey_cache_entry *entry;
+    struct sortkey_cache *cache;
+    DWORD key_flags = flags & ~LCMAP_BYTEREV;
+    const BYTE *key;
+    UINT i, hash;
+    int ret;
+
+    if (srclen > SORTKEY_CACHE_MAX_SRC || !(cache = get_sortkey_cache()))
+        return get_sortkey( sortid, flags, src, srclen, dst, dstlen );
+
+    hash = hash_sortkey_source( src, srclen );
+    for (i = 0; i < SORTKEY_CACHE_ENTRIES; i++)
+    {
+        entry = &cache->entries[i];
+        if (entry->sortid == sortid && entry->flags == key_flags && entry->hash == hash &&
+            entry->srclen == srclen && !memcmp( entry->src, src, srclen * sizeof(WCHAR) ))
+            break;
+    }
+
+    if (i < SORTKEY_CACHE_ENTRIES)
+    {
+        key = entry->key;
+        ret = entry->keylen;
+    }
+    else
+    {
+        ret = get_sortkey( sortid, key_flags, src, srclen, buffer, sizeof(buffer) );
+        key = buffer;
+        if (ret <= SORTKEY_CACHE_MAX_KEY)
+        {
+            entry = &cache->entries[cache->next++ % SORTKEY_CACHE_ENTRIES];
+            entry->sortid = sortid;
+            entry->flags = key_flags;
+            entry->hash = hash;
+            entry->srclen = srclen;
+            entry->keylen = ret;
+            memcpy( entry->src, src, srclen * sizeof(WCHAR) );
+            memcpy( entry->key, buffer, ret );
+        }
+    }
+
+    /* let get_sortkey() deal with partial keys */
+    if (dstlen && dstlen < ret) return get_sortkey( sortid, flags, src, srclen, dst, dstlen );
+    if (!dstlen) return ret;
+    memcpy( dst, key, ret );
+    if (flags & LCMAP_BYTEREV) map_byterev( (WCHAR *)dst, ret / sizeof(WCHAR), (WCHAR *)dst );
+    return ret;
+}
+
+
+/* get the weights of an ASCII char that append_weights() would handle with append_normal_weights()
+ * or as a plain symbol, i.e. one char giving exactly two primary, one diacritic and one case weight */
+static BOOL get_simple_ascii_weights( WCHAR ch, DWORD flags, BYTE case_mask, UINT except,
+                                      union char_weights *weights )
+{
+    if (ch >= 0x80) return FALSE;
+    *weights = get_char_weights( ch, except );
+    if (weights->_case & CASE_COMPR_6) return FALSE;
+    weights->_case &= case_mask;
+
+    switch (weights->script)
+    {
+    case SCRIPT_UNSORTABLE:
+    case SCRIPT_NONSPACE_MARK:
+    case SCRIPT_EXPANSION:
+    case SCRIPT_EASTASIA_SPECIAL:
+    case SCRIPT_JAMO_SPECIAL:
+    case SCRIPT_EXTENSION_A:
+    case SCRIPT_PUNCTUATION:
+        return FALSE;
+    case SCRIPT_SYMBOL_1:
+    case SCRIPT_SYMBOL_2:
+    case SCRIPT_SYMBOL_3:
+    case SCRIPT_SYMBOL_4:
+    case SCRIPT_SYMBOL_5:
+    case SCRIPT_SYMBOL_6:
+        return !(flags & NORM_IGNORESYMBOLS);
+    case SCRIPT_DIGIT:
+        if (flags & SORT_DIGITSASNUMBERS) return FALSE;
+        break;
+    }
+    if (weights->script >= SCRIPT_PUA_FIRST) return FALSE;
+    if (weights->script <= SCRIPT_ARABIC && weights->script != SCRIPT_HEBREW)
+    {
+        if (flags & LINGUISTIC_IGNOREDIACRITIC) weights->diacritic = 2;
+        if (flags & LINGUISTIC_IGNORECASE) weights->_case = 2;
+    }
+    return TRUE;
+}
+
+/* compare the diacritic or case weights of two simple ASCII strings of the same length,
+ * the same way compare_sortkeys() does once remove_unneeded_weights() has trimmed them */
+static int compare_simple_ascii_level( const struct sortguid *sortid, DWORD flags, BYTE case_mask,
+                                       UINT except, const WCHAR *src1, const WCHAR *src2, int len,
+                                       BOOL diacritic )
+{
+    BOOL reverse = diacritic && (sortid->flags & FLAG_REVERSEDIACRITICS);
+    union char_weights weights1, weights2;
+    int i, pos, len1 = 0, len2 = 0, diff = 0, diff_pos = len;
+    BYTE val1, val2;
+
+    for (i = 0; i < len; i++)
+    {
+        pos = reverse ? len - 1 - i : i;
+        get_simple_ascii_weights( src1[pos], flags, case_mask, except, &weights1 );
+        get_simple_ascii_weights( src2[pos], flags, case_mask, except, &weights2 );
+        val1 = diacritic ? weights1.diacritic : weights1._case;
+        val2 = diacritic ? weights2.diacritic : weights2._case;
+        if (val1 > 2) len1 = i + 1;
+        if (val2 > 2) len2 = i + 1;
+        if (val1 != val2 && diff_pos == len)
+        {
+            diff = val1 - val2;
+            diff_pos = i;
+        }
+    }
+    if (diff_pos < min( len1, len2 )) return diff;
+    return len1 - len2;
+}
+
+/* fast path of compare_string() for strings made of simple ASCII chars */
+/* return FALSE if the strings need the full comparison */
+static BOOL compare_simple_ascii( const struct sortguid *sortid, DWORD flags, BYTE case_mask, UINT except,
+                                  const WCHAR *src1, int srclen1, const WCHAR *src2, int srclen2, int *ret )
+{
+    union char_weights weights1, weights2;
+    int i, len = min( srclen1, srclen2 );
+
+    for (i = 0; i < len; i++)
+    {
+        if (!get_simple_ascii_weights( src1[i], flags, case_mask, except, &weights1 )) return FALSE;
+        if (!get_simple_ascii_weights( src2[i], flags, case_mask, except, &weights2 )) return FALSE;
+        /* the primary weights up to here are identical, so the first difference decides */
+        if (weights1.script != weights2.script)
+        {
+            *ret = weights1.script - weights2.script;
+            return TRUE;
+        }
+        if (weights1.primary != weights2.primary)
+        {
+            *ret = weights1.primary - weights2.primary;
+            return TRUE;
+        }
+    }
+
+    /* the remaining chars of the longer string all add primary weights */
+    for (i = len; i < srclen1; i++)
+        if (!get_simple_ascii_weights( src1[i], flags, case_mask, except, &weights1 )) return FALSE;
+    for (i = len; i < srclen2; i++)
+        if (!get_simple_ascii_weights( src2[i], flags, case_mask, except, &weights2 )) return FALSE;
+    if ((*ret = srclen1 - srclen2)) return TRUE;
+
+    if (!(flags & NORM_IGNORENONSPACE) &&
+        (*ret = compare_simple_ascii_level( sortid, flags, case_mask, except, src1, src2, len, TRUE )))
+        return TRUE;
+    *ret = compare_simple_ascii_level( sortid, flags, case_mask, except, src1, src2, len, FALSE );
+    return TRUE;
+}
+
 /* implementation of CompareStringEx */
 static int compare_string( const struct sortguid *sortid, DWORD flags,
                            const WCHAR *src1, int srclen1, const WCHAR *src2, int srclen2 )
@@ -3837,6 +4167,10 @@ static int compare_string( const struct sortguid *sortid, DWORD flags,
     if (flags & NORM_IGNOREKANATYPE) case_mask &= ~CASE_KATAKANA;
     if ((flags & NORM_LINGUISTIC_CASING) && except && sortid->ling_except) except = sortid->ling_except;
 
+    if (srclen1 == srclen2 && !memcmp( src1, src2, srclen1 * sizeof(WCHAR) )) return 0;
+    if (compare_simple_ascii( sortid, flags, case_mask, except, src1, srclen1, src2, srclen2, &ret ))
+        return ret;
+
     init_sortkey_state( &s1, flags, srclen1, primary1, sizeof(primary1) );
     init_sortkey_state( &s2, flags, srclen2, primary2, sizeof(primary2) );
 
@@ -6618,7 +6952,7 @@ INT WINAPI DECLSPEC_HOTPATCH LCMapStringEx( const WCHAR *locale, DWORD flags, co
         FIXME( "LCMAP_SORTHANDLE not supported\n" );
         return 0;
     }
-    if (flags & LCMAP_SORTKEY) return get_sortkey( sortid, flags, src, srclen, (BYTE *)dst, dstlen );
+    if (flags & LCMAP_SORTKEY) return get_sortkey_cached( sortid, flags, src, srclen, (BYTE *)dst, dstlen );
 
     return lcmap_string( sortid, flags, src, srclen, dst, dstlen );
 }
@@ -149,6 +149,7 @@ static const MSIVIEWOPS alter_ops =
     ALTER_get_dimensions,
     ALTER_get_column_info,
     ALTER_modify,
+    NULL,
     ALTER_delete,
     NULL,
     NULL,
@@ -136,6 +136,7 @@ static const MSIVIEWOPS create_ops =
     CREATE_get_dimensions,
     CREATE_get_column_info,
     CREATE_modify,
+    NULL,
     CREATE_delete,
     NULL,
     NULL,
@@ -179,6 +179,7 @@ static const MSIVIEWOPS delete_ops =
     DELETE_get_dimensions,
     DELETE_get_column_info,
     DELETE_modify,
+    NULL,
     DELETE_delete,
     NULL,
     NULL,
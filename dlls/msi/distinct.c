@@ -262,6 +262,7 @@ static const MSIVIEWOPS distinct_ops =
     DISTINCT_get_dimensions,
     DISTINCT_get_column_info,
     DISTINCT_modify,
+    NULL,
     DISTINCT_delete,
     NULL,
     NULL,
@@ -107,6 +107,7 @@ static const MSIVIEWOPS drop_ops =
     DROP_get_dimensions,
     NULL,
     NULL,
+    NULL,
     DROP_delete,
     NULL,
     NULL,
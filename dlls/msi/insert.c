@@ -332,6 +332,7 @@ static const MSIVIEWOPS insert_ops =
     INSERT_get_dimensions,
     INSERT_get_column_info,
     INSERT_modify,
+    NULL,
     INSERT_delete,
     NULL,
     NULL,
@@ -318,6 +318,21 @@ typedef struct tagMSIVIEWOPS
      */
     UINT (*modify)( struct tagMSIVIEW *view, MSIMODIFY eModifyMode, MSIRECORD *record, UINT row );
 
+    /*
+     * find_matching_rows - iterates through rows that match a value
+     *
+     * If the column type is a string then a string ID should be passed in.
+     *  If the value to be looked up is an integer then no transformation of
+     *  the input value is required, except if the column is a string, in which
+     *  case a string ID should be passed in.
+     * The handle is an input/output parameter that keeps track of the current
+     *  position in the iteration. It must be initialised to zero before the
+     *  first call and continued to be passed in to subsequent calls.
+     * Rows are returned in ascending order. The index is built on first use
+     *  and is dropped whenever rows of the table are added, removed or changed.
+     */
+    UINT (*find_matching_rows)( struct tagMSIVIEW *view, UINT col, UINT val, UINT *row, MSIITERHANDLE *handle );
+
     /*
      * delete - destroys the structure completely
      */
@@ -782,6 +797,7 @@ extern const WCHAR *msi_string_lookup( const string_table *st, UINT id, int *len
 extern HRESULT msi_init_string_table( IStorage *stg ) DECLSPEC_HIDDEN;
 extern string_table *msi_load_string_table( IStorage *stg, UINT *bytes_per_strref ) DECLSPEC_HIDDEN;
 extern UINT msi_save_string_table( const string_table *st, IStorage *storage, UINT *bytes_per_strref ) DECLSPEC_HIDDEN;
+extern BOOL msi_string_ids_unique( const string_table *st ) DECLSPEC_HIDDEN;
 extern UINT msi_get_string_table_codepage( const string_table *st ) DECLSPEC_HIDDEN;
 extern UINT msi_set_string_table_codepage( string_table *st, UINT codepage ) DECLSPEC_HIDDEN;
 extern WCHAR *msi_strdupW( const WCHAR *value, int len ) DECLSPEC_HIDDEN;
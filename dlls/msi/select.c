@@ -364,6 +364,7 @@ static const MSIVIEWOPS select_ops =
     SELECT_get_dimensions,
     SELECT_get_column_info,
     SELECT_modify,
+    NULL,
     SELECT_delete,
     NULL,
     NULL,
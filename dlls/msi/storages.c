@@ -453,6 +453,7 @@ static const MSIVIEWOPS storages_ops =
     STORAGES_get_dimensions,
     STORAGES_get_column_info,
     STORAGES_modify,
+    NULL,
     STORAGES_delete,
     NULL,
     NULL,
@@ -385,6 +385,7 @@ static const MSIVIEWOPS streams_ops =
     STREAMS_get_dimensions,
     STREAMS_get_column_info,
     STREAMS_modify,
+    NULL,
     STREAMS_delete,
     NULL,
     NULL,
@@ -56,6 +56,7 @@ struct string_table
     UINT sortcount;
     struct msistring *strings; /* an array of strings */
     UINT *sorted;              /* index */
+    BOOL duplicates;           /* some string is stored under more than one id */
 };
 
 static BOOL validate_codepage( UINT codepage )
@@ -198,7 +199,10 @@ static void insert_string_sorted( string_table *st, UINT string_id )
 
     i = find_insert_index( st, string_id );
     if (i == -1)
+    {
+        st->duplicates = TRUE;
         return;
+    }
 
     memmove( &st->sorted[i] + 1, &st->sorted[i], (st->sortcount - i) * sizeof(UINT) );
     st->sorted[i] = string_id;
@@ -668,6 +672,13 @@ err:
     return ret;
 }
 
+/* whether equal strings are guaranteed to have equal ids; loaded string tables
+ * aren't deduplicated and different strings may convert to the same text */
+BOOL msi_string_ids_unique( const string_table *st )
+{
+    return !st->duplicates;
+}
+
 UINT msi_get_string_table_codepage( const string_table *st )
 {
     return st->codepage;
@@ -359,6 +359,22 @@ static void msi_free_colinfo( MSICOLUMNINFO *colinfo, UINT count )
     for (i = 0; i < count; i++) msi_free( colinfo[i].hash_table );
 }
 
+/* grow the number of buckets with the table so that chains stay short */
+static inline UINT table_hash_size( const MSITABLE *table )
+{
+    return max( MSITABLE_HASH_TABLE_SIZE, table->row_count | 1 );
+}
+
+static void msi_reset_hash_tables( MSICOLUMNINFO *colinfo, UINT count )
+{
+    UINT i;
+    for (i = 0; i < count; i++)
+    {
+        msi_free( colinfo[i].hash_table );
+        colinfo[i].hash_table = NULL;
+    }
+}
+
 static void free_table( MSITABLE *table )
 {
     UINT i;
@@ -1526,6 +1542,10 @@ static UINT table_create_new_row( struct tagMSIVIEW *view, UINT *num, BOOL tempo
 
     (*row_count)++;
 
+    /* the empty row is appended, but TABLE_insert_row moves the rows after
+     * the insert position down to make room for it, so reset the hash tables */
+    msi_reset_hash_tables( tv->columns, tv->num_cols );
+
     return ERROR_SUCCESS;
 }
 
@@ -1757,11 +1777,7 @@ static UINT TABLE_delete_row( struct tagMSIVIEW *view, UINT row )
     tv->table->row_count--;
 
     /* reset the hash tables */
-    for (i = 0; i < tv->num_cols; i++)
-    {
-        msi_free( tv->columns[i].hash_table );
-        tv->columns[i].hash_table = NULL;
-    }
+    msi_reset_hash_tables( tv->columns, tv->num_cols );
 
     for (i = row + 1; i < num_rows; i++)
     {
@@ -1910,6 +1926,92 @@ static UINT TABLE_modify( struct tagMSIVIEW *view, MSIMODIFY eModifyMode,
     return r;
 }
 
+static UINT TABLE_find_matching_rows( struct tagMSIVIEW *view, UINT col,
+    UINT val, UINT *row, MSIITERHANDLE *handle )
+{
+    MSITABLEVIEW *tv = (MSITABLEVIEW*)view;
+    const MSICOLUMNHASHENTRY *entry;
+    UINT hash_size;
+
+    TRACE("%p, %d, %u, %p\n", view, col, val, *handle);
+
+    if( !tv->table )
+        return ERROR_INVALID_PARAMETER;
+
+    if( (col==0) || (col > tv->num_cols) )
+        return ERROR_INVALID_PARAMETER;
+
+    hash_size = table_hash_size( tv->table );
+    if( !tv->columns[col-1].hash_table )
+    {
+        UINT i;
+        UINT num_rows = tv->table->row_count;
+        MSICOLUMNHASHENTRY **hash_table;
+        MSICOLUMNHASHENTRY *new_entry, **tail;
+
+        if( tv->columns[col-1].offset >= tv->row_size )
+        {
+            ERR("Stuffed up %d >= %d\n", tv->columns[col-1].offset, tv->row_size );
+            ERR("%p %p\n", tv, tv->columns );
+            return ERROR_FUNCTION_FAILED;
+        }
+
+        /* allocate contiguous memory for the table and its entries so we
+         * don't have to do an expensive cleanup */
+        hash_table = msi_alloc( hash_size * sizeof(MSICOLUMNHASHENTRY*) +
+                                num_rows * sizeof(MSICOLUMNHASHENTRY) );
+        tail = msi_alloc_zero( hash_size * sizeof(MSICOLUMNHASHENTRY*) );
+        if( !hash_table || !tail )
+        {
+            msi_free( hash_table );
+            msi_free( tail );
+            return ERROR_OUTOFMEMORY;
+        }
+
+        memset( hash_table, 0, hash_size * sizeof(MSICOLUMNHASHENTRY*) );
+
+        new_entry = (MSICOLUMNHASHENTRY *)(hash_table + hash_size);
+
+        /* append so that each chain stays in row order */
+        for (i = 0; i < num_rows; i++)
+        {
+            UINT row_value;
+
+            if (TABLE_fetch_int( view, i, col, &row_value ) != ERROR_SUCCESS)
+                continue;
+
+            new_entry->next = NULL;
+            new_entry->value = row_value;
+            new_entry->row = i;
+            if (tail[row_value % hash_size])
+                tail[row_value % hash_size]->next = new_entry;
+            else
+                hash_table[row_value % hash_size] = new_entry;
+            tail[row_value % hash_size] = new_entry;
+            new_entry++;
+        }
+        msi_free( tail );
+
+        tv->columns[col-1].hash_table = hash_table;
+    }
+
+    if( !*handle )
+        entry = tv->columns[col-1].hash_table[val % hash_size];
+    else
+        entry = (*handle)->next;
+
+    while (entry && entry->value != val)
+        entry = entry->next;
+
+    *handle = entry;
+    if (!entry)
+        return ERROR_NO_MORE_ITEMS;
+
+    *row = entry->row;
+
+    return ERROR_SUCCESS;
+}
+
 static UINT TABLE_delete( struct tagMSIVIEW *view )
 {
     MSITABLEVIEW *tv = (MSITABLEVIEW*)view;
@@ -2178,6 +2280,7 @@ static const MSIVIEWOPS table_ops =
     TABLE_get_dimensions,
     TABLE_get_column_info,
     TABLE_modify,
+    TABLE_find_matching_rows,
     TABLE_delete,
     TABLE_add_ref,
     TABLE_release,
@@ -2755,6 +2858,7 @@ static const MSIVIEWOPS transform_view_ops =
     TransformView_get_dimensions,
     TransformView_get_column_info,
     NULL,
+    NULL,
     TransformView_delete,
     NULL,
     NULL,
@@ -3154,6 +3258,29 @@ static UINT msi_table_find_row( MSITABLEVIEW *tv, MSIRECORD *rec, UINT *row, UIN
     data = msi_record_to_row( tv, rec );
     if( !data )
         return r;
+
+    /* only rows that share the value of the first key column can match */
+    for( i = 0; i < tv->num_cols; i++ )
+        if( tv->columns[i].type & MSITYPE_KEY ) break;
+
+    if( i < tv->num_cols && tv->columns == tv->table->colinfo )
+    {
+        MSIITERHANDLE handle = NULL;
+        UINT n;
+
+        while( TABLE_find_matching_rows( &tv->view, i + 1, data[i], &n, &handle ) == ERROR_SUCCESS )
+        {
+            r = msi_row_matches( tv, n, data, column );
+            if( r == ERROR_SUCCESS )
+            {
+                *row = n;
+                break;
+            }
+        }
+        msi_free( data );
+        return r;
+    }
+
     for( i = 0; i < tv->table->row_count; i++ )
     {
         r = msi_row_matches( tv, i, data, column );
@@ -9376,6 +9376,122 @@ static void test_viewfetch_wraparound(void)
     DeleteFileA(msifile);
 }
 
+static UINT count_query_rows( MSIHANDLE hdb, const char *query, UINT *count )
+{
+    MSIHANDLE hview, hrec;
+    UINT r;
+
+    *count = 0;
+    r = MsiDatabaseOpenViewA( hdb, query, &hview );
+    if (r != ERROR_SUCCESS)
+        return r;
+    r = MsiViewExecute( hview, 0 );
+    while (r == ERROR_SUCCESS && (r = MsiViewFetch( hview, &hrec )) == ERROR_SUCCESS)
+    {
+        (*count)++;
+        MsiCloseHandle( hrec );
+    }
+    MsiViewClose( hview );
+    MsiCloseHandle( hview );
+    return r == ERROR_NO_MORE_ITEMS ? ERROR_SUCCESS : r;
+}
+
+static void test_large_join(void)
+{
+    static const struct
+    {
+        const char *query;
+        UINT count;
+    }
+    queries[] =
+    {
+        /* join on a string key */
+        { "SELECT `Feature_`, `Component_` FROM `FeatureComponents`, `Component` "
+          "WHERE `Component_` = `Component`", 4000 },
+        { "SELECT `Component`, `Feature_` FROM `Component`, `FeatureComponents` "
+          "WHERE `Component`.`Component` = `FeatureComponents`.`Component_` "
+          "AND `Feature_` = 'feature3'", 100 },
+        /* three tables, as used when costing directories */
+        { "SELECT `Component`, `DefaultDir` FROM `FeatureComponents`, `Component`, `Directory` "
+          "WHERE `Component_` = `Component` AND `Directory_` = `Directory` "
+          "AND `Feature_` = 'feature7'", 100 },
+        /* constants */
+        { "SELECT * FROM `Component` WHERE `Directory_` = 'dir13'", 100 },
+        { "SELECT * FROM `Component` WHERE `Attributes` = 4", 250 },
+        { "SELECT * FROM `Component` WHERE `Attributes` = 4 AND `Directory_` = 'dir12'", 50 },
+        { "SELECT * FROM `Component` WHERE `Attributes` = 100000", 0 },
+        { "SELECT * FROM `Component` WHERE `Component` = 'nosuchcomponent'", 0 },
+        { "SELECT * FROM `Component` WHERE `Component` = 'comp1999' OR `Component` = 'comp0'", 2 },
+        /* empty strings and nulls compare equal */
+        { "SELECT * FROM `Component` WHERE `Condition` = ''", 1000 },
+        { "SELECT * FROM `Component` WHERE `KeyPath` = `Condition`", 1000 },
+        /* integer join */
+        { "SELECT * FROM `One`, `Two` WHERE `A` = `C`", 2000 },
+        { "SELECT * FROM `One`, `Two` WHERE `A` = `C` AND `B` <> `D`", 0 },
+    };
+    MSIHANDLE hdb;
+    char buf[256];
+    DWORD start;
+    UINT r, i, count;
+
+    hdb = create_db();
+    ok( hdb, "failed to create db\n" );
+
+    create_component_table( hdb );
+    create_feature_components_table( hdb );
+    create_directory_table( hdb );
+
+    r = run_query( hdb, 0, "CREATE TABLE `One` (`A` SHORT, `B` LONG PRIMARY KEY `A`)" );
+    ok( r == ERROR_SUCCESS, "cannot create table: %u\n", r );
+    r = run_query( hdb, 0, "CREATE TABLE `Two` (`C` LONG, `D` SHORT PRIMARY KEY `C`)" );
+    ok( r == ERROR_SUCCESS, "cannot create table: %u\n", r );
+
+    start = GetTickCount();
+    for (i = 0; i < 20; i++)
+    {
+        sprintf( buf, "INSERT INTO `Directory` (`Directory`, `Directory_Parent`, `DefaultDir`) "
+                 "VALUES( 'dir%u', 'TARGETDIR', 'Dir%u' )", i, i );
+        r = run_query( hdb, 0, buf );
+        ok( r == ERROR_SUCCESS, "failed to insert into Directory table: %u\n", r );
+    }
+    for (i = 0; i < 2000; i++)
+    {
+        sprintf( buf, "'comp%u', '{%08X-0000-0000-0000-000000000000}', 'dir%u', %u, '%s', ''",
+                 i, i, i % 20, i % 8, (i & 1) ? "1" : "" );
+        add_component_entry( hdb, buf );
+        sprintf( buf, "'feature%u', 'comp%u'", i % 20, i );
+        add_feature_components_entry( hdb, buf );
+        sprintf( buf, "'feature%u', 'comp%u'", 20 + i % 20, i );
+        add_feature_components_entry( hdb, buf );
+
+        sprintf( buf, "INSERT INTO `One` (`A`, `B`) VALUES (%u, %u)", i, i );
+        r = run_query( hdb, 0, buf );
+        ok( r == ERROR_SUCCESS, "cannot insert into table: %u\n", r );
+        sprintf( buf, "INSERT INTO `Two` (`C`, `D`) VALUES (%u, %u)", i, i );
+        r = run_query( hdb, 0, buf );
+        ok( r == ERROR_SUCCESS, "cannot insert into table: %u\n", r );
+    }
+    if (winetest_interactive)
+        trace( "populating tables took %lu ms\n", GetTickCount() - start );
+
+    /* inserting a duplicate key is still caught */
+    r = run_query( hdb, 0, "INSERT INTO `Two` (`C`, `D`) VALUES (1234, 1)" );
+    ok( r == ERROR_FUNCTION_FAILED, "got %u\n", r );
+
+    for (i = 0; i < ARRAY_SIZE(queries); i++)
+    {
+        start = GetTickCount();
+        r = count_query_rows( hdb, queries[i].query, &count );
+        ok( r == ERROR_SUCCESS, "%u: got %u\n", i, r );
+        ok( count == queries[i].count, "%u: got %u rows, expected %u\n", i, count, queries[i].count );
+        if (winetest_interactive)
+            trace( "%u: %lu ms\n", i, GetTickCount() - start );
+    }
+
+    MsiCloseHandle( hdb );
+    DeleteFileA( msifile );
+}
+
 START_TEST(db)
 {
     test_msidatabase();
@@ -9436,4 +9552,5 @@ START_TEST(db)
     test_viewmodify_insert();
     test_view_get_error();
     test_viewfetch_wraparound();
+    test_large_join();
 }
@@ -210,6 +210,7 @@ static const MSIVIEWOPS update_ops =
     UPDATE_get_dimensions,
     UPDATE_get_column_info,
     UPDATE_modify,
+    NULL,
     UPDATE_delete,
     NULL,
     NULL,
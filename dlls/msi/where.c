@@ -572,6 +572,28 @@ static UINT STRCMP_Evaluate( MSIWHEREVIEW *wv, const UINT rows[], const struct c
     UINT r;
 
     *val = TRUE;
+
+    /* columns holding the same string id hold the same string, anything
+     * else needs a string compare since ids aren't necessarily unique */
+    if (expr->left->type == EXPR_COL_NUMBER_STRING &&
+        expr->right->type == EXPR_COL_NUMBER_STRING)
+    {
+        UINT l_id, r_id;
+
+        r = expr_fetch_value(&expr->left->u.column, rows, &l_id);
+        if (r != ERROR_SUCCESS)
+            return r;
+        r = expr_fetch_value(&expr->right->u.column, rows, &r_id);
+        if (r != ERROR_SUCCESS)
+            return r;
+
+        if (l_id == r_id)
+        {
+            *val = (expr->op == OP_EQ);
+            return ERROR_SUCCESS;
+        }
+    }
+
     r = STRING_evaluate(wv, rows, expr->left, record, &l_str);
     if (r == ERROR_CONTINUE)
         return r;
@@ -647,36 +669,162 @@ static UINT WHERE_evaluate( MSIWHEREVIEW *wv, const UINT rows[],
     return ERROR_SUCCESS;
 }
 
+static inline BOOL is_column( const struct expr *expr )
+{
+    return expr->type == EXPR_COL_NUMBER || expr->type == EXPR_COL_NUMBER32 ||
+           expr->type == EXPR_COL_NUMBER_STRING;
+}
+
+static inline UINT column_bias( const struct expr *expr )
+{
+    return expr->type == EXPR_COL_NUMBER32 ? 0x80000000 : 0x8000;
+}
+
+/* Looks for an equality in the top level AND chain of the condition that
+ * pins a column of the given table to a value known before the table is
+ * scanned, i.e. a constant or a column of a table that is already bound.
+ * Only the rows holding that value can satisfy the condition, so they can
+ * be fetched with find_matching_rows instead of scanning the whole table.
+ *
+ * Returns ERROR_SUCCESS when a lookup was found, ERROR_NO_MORE_ITEMS when
+ * no row can match and ERROR_FUNCTION_FAILED when the table must be scanned.
+ */
+static UINT find_index_lookup( MSIWHEREVIEW *wv, const struct expr *cond, const JOINTABLE *table,
+                               const UINT rows[], UINT *column, UINT *value )
+{
+    const struct expr *col, *other;
+    UINT r;
+
+    if (!cond || (cond->type != EXPR_COMPLEX && cond->type != EXPR_STRCMP))
+        return ERROR_FUNCTION_FAILED;
+
+    if (cond->type == EXPR_COMPLEX && cond->u.expr.op == OP_AND)
+    {
+        r = find_index_lookup( wv, cond->u.expr.left, table, rows, column, value );
+        if (r != ERROR_FUNCTION_FAILED)
+            return r;
+        return find_index_lookup( wv, cond->u.expr.right, table, rows, column, value );
+    }
+
+    if (cond->u.expr.op != OP_EQ || !table->view->ops->find_matching_rows)
+        return ERROR_FUNCTION_FAILED;
+
+    col = cond->u.expr.left;
+    other = cond->u.expr.right;
+    if (!is_column( col ) || col->u.column.parsed.table != table)
+    {
+        col = cond->u.expr.right;
+        other = cond->u.expr.left;
+        if (!is_column( col ) || col->u.column.parsed.table != table)
+            return ERROR_FUNCTION_FAILED;
+    }
+
+    /* the index looks up a single string id, which only finds all the rows
+     * holding the string if the string table stores it under no other id */
+    if (col->type == EXPR_COL_NUMBER_STRING && !msi_string_ids_unique( wv->db->strings ))
+        return ERROR_FUNCTION_FAILED;
+
+    if (is_column( other ))
+    {
+        if ((col->type == EXPR_COL_NUMBER_STRING) != (other->type == EXPR_COL_NUMBER_STRING))
+            return ERROR_FUNCTION_FAILED;
+        if (rows[other->u.column.parsed.table->table_index] == INVALID_ROW_INDEX)
+            return ERROR_FUNCTION_FAILED;
+        r = expr_fetch_value( &other->u.column, rows, value );
+        if (r != ERROR_SUCCESS)
+            return ERROR_FUNCTION_FAILED;
+
+        if (col->type == EXPR_COL_NUMBER_STRING)
+        {
+            /* empty strings and nulls compare equal, leave them to the scan */
+            if (!*value)
+                return ERROR_FUNCTION_FAILED;
+        }
+        else
+            *value = *value - column_bias( other ) + column_bias( col );
+    }
+    else if (other->type == EXPR_SVAL && col->type == EXPR_COL_NUMBER_STRING)
+    {
+        if (!other->u.sval || !other->u.sval[0])
+            return ERROR_FUNCTION_FAILED;
+        if (msi_string2id( wv->db->strings, other->u.sval, -1, value ) != ERROR_SUCCESS)
+            return ERROR_NO_MORE_ITEMS;
+    }
+    else if (other->type == EXPR_UVAL && col->type != EXPR_COL_NUMBER_STRING)
+        *value = other->u.uval + column_bias( col );
+    else
+        return ERROR_FUNCTION_FAILED;
+
+    /* short integer columns can't hold values outside of their range */
+    if (col->type == EXPR_COL_NUMBER && *value > 0xffff)
+        return ERROR_NO_MORE_ITEMS;
+
+    *column = col->u.column.parsed.column;
+    return ERROR_SUCCESS;
+}
+
+static UINT check_condition( MSIWHEREVIEW *wv, MSIRECORD *record, JOINTABLE **tables,
+                             UINT table_rows[] );
+
+/* evaluates the condition for the current row and adds it, or goes on with the
+ * next table; the scan stops on failure unless the row simply didn't match */
+static UINT check_row( MSIWHEREVIEW *wv, MSIRECORD *record, JOINTABLE **tables,
+                       UINT table_rows[], INT *val )
+{
+    UINT r;
+
+    *val = 0;
+    wv->rec_index = 0;
+    r = WHERE_evaluate( wv, table_rows, wv->cond, val, record );
+    if (r != ERROR_SUCCESS && r != ERROR_CONTINUE)
+        return r;
+    if (!*val)
+        return r;
+    if (*(tables + 1))
+        return check_condition(wv, record, tables + 1, table_rows);
+    if (r != ERROR_SUCCESS)
+        return r;
+    add_row (wv, table_rows);
+    return ERROR_SUCCESS;
+}
+
 static UINT check_condition( MSIWHEREVIEW *wv, MSIRECORD *record, JOINTABLE **tables,
                              UINT table_rows[] )
 {
-    UINT r = ERROR_FUNCTION_FAILED;
+    MSIITERHANDLE handle = NULL;
+    UINT r, column, value, row;
     INT val;
 
-    for (table_rows[(*tables)->table_index] = 0;
-         table_rows[(*tables)->table_index] < (*tables)->row_count;
-         table_rows[(*tables)->table_index]++)
+    r = find_index_lookup( wv, wv->cond, *tables, table_rows, &column, &value );
+    if (r != ERROR_FUNCTION_FAILED)
     {
-        val = 0;
-        wv->rec_index = 0;
-        r = WHERE_evaluate( wv, table_rows, wv->cond, &val, record );
-        if (r != ERROR_SUCCESS && r != ERROR_CONTINUE)
-            break;
-        if (val)
+        if (r == ERROR_SUCCESS)
         {
-            if (*(tables + 1))
-            {
-                r = check_condition(wv, record, tables + 1, table_rows);
-                if (r != ERROR_SUCCESS)
-                    break;
-            }
-            else
+            TRACE("looking up %u in column %u\n", value, column);
+
+            while ((*tables)->view->ops->find_matching_rows( (*tables)->view, column, value,
+                                                             &row, &handle ) == ERROR_SUCCESS)
             {
-                if (r != ERROR_SUCCESS)
+                table_rows[(*tables)->table_index] = row;
+                r = check_row( wv, record, tables, table_rows, &val );
+                if (r != ERROR_SUCCESS && (r != ERROR_CONTINUE || val))
                     break;
-                add_row (wv, table_rows);
             }
         }
+        else r = ERROR_SUCCESS;
+
+        table_rows[(*tables)->table_index] = INVALID_ROW_INDEX;
+        return r;
+    }
+
+    r = ERROR_FUNCTION_FAILED;
+    for (table_rows[(*tables)->table_index] = 0;
+         table_rows[(*tables)->table_index] < (*tables)->row_count;
+         table_rows[(*tables)->table_index]++)
+    {
+        r = check_row( wv, record, tables, table_rows, &val );
+        if (r != ERROR_SUCCESS && (r != ERROR_CONTINUE || val))
+            break;
     }
     table_rows[(*tables)->table_index] = INVALID_ROW_INDEX;
     return r;
@@ -1127,6 +1275,7 @@ static const MSIVIEWOPS where_ops =
     WHERE_get_dimensions,
     WHERE_get_column_info,
     WHERE_modify,
+    NULL,
     WHERE_delete,
     NULL,
     NULL,
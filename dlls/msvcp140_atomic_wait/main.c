@@ -17,6 +17,7 @@
  */
 
 #include <stdarg.h>
+#include <stdlib.h>
 #include "windef.h"
 #include "winbase.h"
 #include "wine/debug.h"
@@ -31,36 +32,151 @@ unsigned int __stdcall __std_parallel_algorithms_hw_threads(void)
     return _Thrd_hardware_concurrency();
 }
 
+/* The parallel algorithms submit one callback per chunk of work and every
+ * callback claims chunks until none are left, so there is no point in running
+ * more callbacks concurrently than there are hardware threads. The work object
+ * keeps a count of requested callbacks and only queues as many threadpool
+ * callbacks as can run in parallel, each of them running the requested
+ * callbacks until the count drops to zero. */
+struct threadpool_work
+{
+    PTP_WORK work;
+    PTP_WORK_CALLBACK callback;
+    void *context;
+    PTP_SIMPLE_CALLBACK finalization;
+    PTP_CLEANUP_GROUP_CANCEL_CALLBACK group_cancel;
+    LONG pending;    /* requested callbacks not started yet */
+    LONG queued;     /* threadpool callbacks queued and not started yet */
+    LONG refcount;
+};
+
+static void release_threadpool_work(struct threadpool_work *work)
+{
+    if (!InterlockedDecrement(&work->refcount))
+        free(work);
+}
+
+static void CALLBACK threadpool_work_callback(PTP_CALLBACK_INSTANCE instance, void *context, PTP_WORK tp_work)
+{
+    struct threadpool_work *work = context;
+    LONG pending;
+
+    InterlockedDecrement(&work->queued);
+    while ((pending = *(volatile LONG *)&work->pending) > 0)
+    {
+        if (InterlockedCompareExchange(&work->pending, pending - 1, pending) != pending) continue;
+        work->callback(instance, work->context, (PTP_WORK)work);
+        /* the finalization callback has to run after each callback */
+        if (work->finalization) break;
+    }
+    release_threadpool_work(work);
+}
+
+static void CALLBACK threadpool_work_finalization(PTP_CALLBACK_INSTANCE instance, void *context)
+{
+    struct threadpool_work *work = context;
+
+    work->finalization(instance, work->context);
+}
+
+static void CALLBACK threadpool_work_group_cancel(void *object_context, void *cleanup_context)
+{
+    struct threadpool_work *work = object_context;
+
+    work->group_cancel(work->context, cleanup_context);
+}
+
+static void submit_threadpool_work(struct threadpool_work *work, size_t count)
+{
+    static unsigned int hw_threads;
+    size_t i;
+
+    if (!count) return;
+    if (!hw_threads) hw_threads = max(1, _Thrd_hardware_concurrency());
+
+    InterlockedExchangeAdd(&work->pending, count);
+    if (!work->finalization) count = min(count, hw_threads);
+    for (i = 0; i < count; i++)
+    {
+        InterlockedIncrement(&work->refcount);
+        InterlockedIncrement(&work->queued);
+        SubmitThreadpoolWork(work->work);
+    }
+}
+
 void __stdcall __std_bulk_submit_threadpool_work(PTP_WORK work, size_t count)
 {
     TRACE("(%p %Iu)\n", work, count);
-    while (count--)
-        SubmitThreadpoolWork(work);
+    submit_threadpool_work((struct threadpool_work *)work, count);
 }
 
-void __stdcall __std_close_threadpool_work(PTP_WORK work)
+void __stdcall __std_close_threadpool_work(PTP_WORK tp_work)
 {
+    struct threadpool_work *work = (struct threadpool_work *)tp_work;
+
     TRACE("(%p)\n", work);
-    return CloseThreadpoolWork(work);
+    CloseThreadpoolWork(work->work);
+    release_threadpool_work(work);
 }
 
 PTP_WORK __stdcall __std_create_threadpool_work(PTP_WORK_CALLBACK callback, void *context,
-                                                PTP_CALLBACK_ENVIRON environ)
+                                                PTP_CALLBACK_ENVIRON environment)
 {
-    TRACE("(%p %p %p)\n", callback, context, environ);
-    return CreateThreadpoolWork(callback, context, environ);
+    TP_CALLBACK_ENVIRON_V3 env;
+    struct threadpool_work *work;
+
+    TRACE("(%p %p %p)\n", callback, context, environment);
+
+    if (!(work = calloc(1, sizeof(*work))))
+    {
+        SetLastError(ERROR_OUTOFMEMORY);
+        return NULL;
+    }
+    work->callback = callback;
+    work->context = context;
+    work->refcount = 1;
+
+    /* the callbacks get our context, forward them with the caller's one */
+    if (environment && (environment->FinalizationCallback || environment->CleanupGroupCancelCallback))
+    {
+        memset(&env, 0, sizeof(env));
+        memcpy(&env, environment, environment->Version >= 3 ? sizeof(env) : sizeof(*environment));
+        if ((work->finalization = env.FinalizationCallback))
+            env.FinalizationCallback = threadpool_work_finalization;
+        if ((work->group_cancel = env.CleanupGroupCancelCallback))
+            env.CleanupGroupCancelCallback = threadpool_work_group_cancel;
+        environment = (PTP_CALLBACK_ENVIRON)&env;
+    }
+
+    if (!(work->work = CreateThreadpoolWork(threadpool_work_callback, work, environment)))
+    {
+        free(work);
+        return NULL;
+    }
+    return (PTP_WORK)work;
 }
 
 void __stdcall __std_submit_threadpool_work(PTP_WORK work)
 {
     TRACE("(%p)\n", work);
-    return SubmitThreadpoolWork(work);
+    submit_threadpool_work((struct threadpool_work *)work, 1);
 }
 
-void __stdcall __std_wait_for_threadpool_work_callbacks(PTP_WORK work, BOOL cancel)
+void __stdcall __std_wait_for_threadpool_work_callbacks(PTP_WORK tp_work, BOOL cancel)
 {
+    struct threadpool_work *work = (struct threadpool_work *)tp_work;
+    LONG queued;
+
     TRACE("(%p %d)\n", work, cancel);
-    return WaitForThreadpoolWorkCallbacks(work, cancel);
+
+    if (cancel) InterlockedExchange(&work->pending, 0);
+    WaitForThreadpoolWorkCallbacks(work->work, cancel);
+    if (cancel)
+    {
+        /* cancelled callbacks never run, drop their references */
+        queued = InterlockedExchange(&work->queued, 0);
+        InterlockedExchangeAdd(&work->refcount, -queued);
+    }
 }
 
 void __stdcall __std_atomic_notify_one_direct(void *addr)
@@ -120,6 +120,20 @@ static void test_threadpool_work(void)
     p___std_close_threadpool_work(work);
     ok(workcalled == 13, "expected work to be called 13 times, got %ld\n", workcalled);
 
+    workcalled = 0;
+    work = p___std_create_threadpool_work(threadpool_workcallback, &workcalled, NULL);
+    ok(!!work, "failed to create threadpool_work\n");
+    p___std_bulk_submit_threadpool_work(work, 1000);
+    p___std_bulk_submit_threadpool_work(work, 7);
+    p___std_submit_threadpool_work(work);
+    p___std_wait_for_threadpool_work_callbacks(work, FALSE);
+    ok(workcalled == 1008, "expected work to be called 1008 times, got %ld\n", workcalled);
+    ok(cb_work == work, "expected %p, got %p\n", work, cb_work);
+    p___std_bulk_submit_threadpool_work(work, 3);
+    p___std_wait_for_threadpool_work_callbacks(work, FALSE);
+    p___std_close_threadpool_work(work);
+    ok(workcalled == 1011, "expected work to be called 1011 times, got %ld\n", workcalled);
+
     workcalled = 0;
     work = p___std_create_threadpool_work(threadpool_workcallback, &workcalled, NULL);
     ok(!!work, "failed to create threadpool_work\n");
@@ -142,6 +156,18 @@ static void test_threadpool_work(void)
     ret = WaitForSingleObject(cb_event, 1000);
     ok(ret == WAIT_OBJECT_0, "expected finalization callback to be called\n");
     ok(workcalled == 2, "expected work to be called twice, got %ld\n", workcalled);
+
+    /* the finalization callback runs after every callback */
+    workcalled = 0;
+    ResetEvent(cb_event);
+    work = p___std_create_threadpool_work(threadpool_workcallback, &workcalled, &environment);
+    ok(!!work, "failed to create threadpool_work\n");
+    p___std_bulk_submit_threadpool_work(work, 5);
+    p___std_wait_for_threadpool_work_callbacks(work, FALSE);
+    p___std_close_threadpool_work(work);
+    ret = WaitForSingleObject(cb_event, 1000);
+    ok(ret == WAIT_OBJECT_0, "expected finalization callback to be called\n");
+    ok(workcalled == 10, "expected work to be called 10 times, got %ld\n", workcalled);
     CloseHandle(cb_event);
 
     /* test with environment version 3 */
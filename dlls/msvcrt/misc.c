@@ -258,6 +258,27 @@ static inline void swap(char *l, char *r, size_t size)
 {
     char tmp;
 
+    if(!(((size_t)l | (size_t)r | size) % sizeof(size_t))) {
+        size_t *lw = (size_t*)l, *rw = (size_t*)r, tmpw;
+
+        for(size /= sizeof(size_t); size--; lw++, rw++) {
+            tmpw = *lw;
+            *lw = *rw;
+            *rw = tmpw;
+        }
+        return;
+    }
+    if(!(((size_t)l | (size_t)r | size) % sizeof(unsigned int))) {
+        unsigned int *lw = (unsigned int*)l, *rw = (unsigned int*)r, tmpw;
+
+        for(size /= sizeof(unsigned int); size--; lw++, rw++) {
+            tmpw = *lw;
+            *lw = *rw;
+            *rw = tmpw;
+        }
+        return;
+    }
+
     while(size--) {
         tmp = *l;
         *l++ = *r;
@@ -361,6 +382,198 @@ static void quick_sort(void *base, size_t nmemb, size_t size,
 #undef X
 }
 
+/* arrays up to this size are sorted with the same comparisons as native */
+#define QUICK_SORT_MAX   1024
+/* partitions up to this size are finished with an insertion sort */
+#define INSERTION_SORT_MAX 16
+/* partitions above this size use the median of three medians as pivot */
+#define NINTHER_MIN      128
+
+/* Returns FALSE if more than max_moves elements had to be moved, the data
+ * is left partially sorted in that case. */
+static BOOL insertion_sort(char *base, size_t nmemb, size_t size, size_t max_moves,
+        int (CDECL *compar)(void *, const void *, const void *), void *context)
+{
+    char tmp[64], *p, *q;
+    size_t moves = 0;
+
+    for(p=base+size; p<base+nmemb*size; p+=size) {
+        if(size > sizeof(tmp)) {
+            for(q=p; q>base && compar(context, q-size, q) > 0; q-=size)
+                swap(q-size, q, size);
+        }else {
+            for(q=p; q>base && compar(context, q-size, p) > 0; q-=size);
+            if(q == p) continue;
+            memcpy(tmp, p, size);
+            memmove(q+size, q, p-q);
+            memcpy(q, tmp, size);
+        }
+
+        moves += (p-q)/size;
+        if(moves > max_moves) return FALSE;
+    }
+    return TRUE;
+}
+
+static void sift_down(char *base, size_t root, size_t nmemb, size_t size,
+        int (CDECL *compar)(void *, const void *, const void *), void *context)
+{
+    size_t child;
+
+#define X(i) (base+size*(i))
+    while((child = 2*root+1) < nmemb) {
+        if(child+1 < nmemb && compar(context, X(child), X(child+1)) < 0)
+            child++;
+        if(compar(context, X(root), X(child)) >= 0)
+            break;
+        swap(X(root), X(child), size);
+        root = child;
+    }
+#undef X
+}
+
+static void heap_sort(char *base, size_t nmemb, size_t size,
+        int (CDECL *compar)(void *, const void *, const void *), void *context)
+{
+    size_t i;
+
+    for(i=nmemb/2; i>0; i--)
+        sift_down(base, i-1, nmemb, size, compar, context);
+    for(i=nmemb-1; i>0; i--) {
+        swap(base, base+size*i, size);
+        sift_down(base, 0, i, size, compar, context);
+    }
+}
+
+static size_t med3(char *base, size_t size, size_t a, size_t b, size_t c,
+        int (CDECL *compar)(void *, const void *, const void *), void *context)
+{
+#define X(i) (base+size*(i))
+    if(compar(context, X(a), X(b)) < 0) {
+        if(compar(context, X(b), X(c)) < 0) return b;
+        return compar(context, X(a), X(c)) < 0 ? c : a;
+    }
+    if(compar(context, X(b), X(c)) > 0) return b;
+    return compar(context, X(a), X(c)) > 0 ? c : a;
+#undef X
+}
+
+/* Quick sort with median of three (or of three medians) pivot selection
+ * that falls back to heap sort when the partitions get too unbalanced. */
+static void intro_sort(void *base, size_t nmemb, size_t size,
+        int (CDECL *compar)(void *, const void *, const void *), void *context)
+{
+    size_t stack_lo[8*sizeof(size_t)], stack_hi[8*sizeof(size_t)];
+    unsigned int stack_depth[8*sizeof(size_t)], depth;
+    size_t beg, end, lo, hi, med, n, s;
+    BOOL swapped;
+    int stack_pos;
+
+    for(depth=0, n=nmemb; n>1; n>>=1) depth += 2;
+
+    stack_pos = 0;
+    stack_lo[stack_pos] = 0;
+    stack_hi[stack_pos] = nmemb-1;
+    stack_depth[stack_pos] = depth;
+
+#define X(i) ((char*)base+size*(i))
+    while(stack_pos >= 0) {
+        beg = stack_lo[stack_pos];
+        end = stack_hi[stack_pos];
+        depth = stack_depth[stack_pos--];
+        n = end-beg+1;
+
+        if(n <= INSERTION_SORT_MAX) {
+            insertion_sort(X(beg), n, size, ~(size_t)0, compar, context);
+            continue;
+        }
+        if(!depth--) {
+            heap_sort(X(beg), n, size, compar, context);
+            continue;
+        }
+
+        med = beg + n/2;
+        if(n > NINTHER_MIN) {
+            s = n/8;
+            lo = med3(base, size, beg, beg+s, beg+2*s, compar, context);
+            hi = med3(base, size, end-2*s, end-s, end, compar, context);
+            med = med3(base, size, med-s, med, med+s, compar, context);
+            med = med3(base, size, lo, med, hi, compar, context);
+        }else {
+            med = med3(base, size, beg, med, end, compar, context);
+        }
+        swap(X(beg), X(med), size);
+
+        /* everything before beg is not greater than the partition, if the
+         * previous element is equal to the pivot, the pivot is the minimum;
+         * group all the elements equal to it and only sort the rest */
+        if(beg && compar(context, X(beg-1), X(beg)) >= 0) {
+            lo = beg;
+            hi = end+1;
+            while(1) {
+                while(compar(context, X(beg), X(--hi)) < 0);
+                while(++lo < hi && compar(context, X(beg), X(lo)) >= 0);
+                if(lo >= hi)
+                    break;
+                swap(X(lo), X(hi), size);
+            }
+
+            if(end-hi > 1) {
+                stack_lo[++stack_pos] = hi+1;
+                stack_hi[stack_pos] = end;
+                stack_depth[stack_pos] = depth;
+            }
+            continue;
+        }
+
+        /* elements equal to the pivot stop both scans, which keeps the
+         * partitions balanced when there are many duplicates */
+        lo = beg;
+        hi = end+1;
+        swapped = FALSE;
+        while(1) {
+            while(compar(context, X(++lo), X(beg)) < 0 && lo < end);
+            while(compar(context, X(beg), X(--hi)) < 0);
+            if(lo >= hi)
+                break;
+            swap(X(lo), X(hi), size);
+            swapped = TRUE;
+        }
+        swap(X(beg), X(hi), size);
+
+        /* the data was already partitioned, it may be (nearly) sorted */
+        if(!swapped && insertion_sort(X(beg), hi-beg, size, 8, compar, context) &&
+                insertion_sort(X(hi+1), end-hi, size, 8, compar, context))
+            continue;
+
+        /* process the smaller partition first to bound the stack size */
+        if(hi-beg >= end-hi) {
+            if(hi-beg > 1) {
+                stack_lo[++stack_pos] = beg;
+                stack_hi[stack_pos] = hi-1;
+                stack_depth[stack_pos] = depth;
+            }
+            if(end-hi > 1) {
+                stack_lo[++stack_pos] = hi+1;
+                stack_hi[stack_pos] = end;
+                stack_depth[stack_pos] = depth;
+            }
+        }else {
+            if(end-hi > 1) {
+                stack_lo[++stack_pos] = hi+1;
+                stack_hi[stack_pos] = end;
+                stack_depth[stack_pos] = depth;
+            }
+            if(hi-beg > 1) {
+                stack_lo[++stack_pos] = beg;
+                stack_hi[stack_pos] = hi-1;
+                stack_depth[stack_pos] = depth;
+            }
+        }
+    }
+#undef X
+}
+
 /*********************************************************************
  * qsort_s (MSVCRT.@)
  *
@@ -379,7 +592,10 @@ void CDECL qsort_s(void *base, size_t nmemb, size_t size,
 
     if (nmemb < 2) return;
 
-    quick_sort(base, nmemb, size, compar, context);
+    if (nmemb <= QUICK_SORT_MAX)
+        quick_sort(base, nmemb, size, compar, context);
+    else
+        intro_sort(base, nmemb, size, compar, context);
 }
 
 /*********************************************************************
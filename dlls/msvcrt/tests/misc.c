@@ -527,6 +527,94 @@ static void test_qsort_s(void)
         ok(tab[i] == i, "data sorted incorrectly on position %d: %d\n", i, tab[i]);
 }
 
+static int __cdecl qsort_int_comp(const void *l, const void *r)
+{
+    int a = *(const int*)l, b = *(const int*)r;
+    return a < b ? -1 : a > b;
+}
+
+/* an int key followed by filler bytes, in records of an odd size */
+#define QSORT_RECORD_SIZE 13
+
+static int __cdecl qsort_record_comp(const void *l, const void *r)
+{
+    int a, b;
+
+    memcpy(&a, l, sizeof(a));
+    memcpy(&b, r, sizeof(b));
+    return qsort_int_comp(&a, &b);
+}
+
+static void fill_qsort_pattern(int *tab, int count, int pattern)
+{
+    int i;
+
+    for(i=0; i<count; i++) {
+        switch(pattern) {
+        case 0: tab[i] = rand(); break;           /* random */
+        case 1: tab[i] = i; break;                /* sorted */
+        case 2: tab[i] = count-i; break;          /* reversed */
+        case 3: tab[i] = 7; break;                /* all equal */
+        case 4: tab[i] = rand()%4; break;         /* few unique values */
+        case 5: tab[i] = i<count/2 ? i : count-i; break; /* organ pipe */
+        case 6: tab[i] = i%2 ? i : count+i; break; /* interleaved */
+        }
+    }
+}
+
+static void test_qsort_large(void)
+{
+    static const char *pattern_names[] = {"random", "sorted", "reversed", "equal",
+        "few unique", "organ pipe", "interleaved"};
+    int *tab, i, j, key, prev, count;
+    unsigned char *rec;
+    DWORD start;
+
+    count = 20000;
+    tab = malloc(count * sizeof(*tab));
+    srand(0);
+    for(i=0; i<ARRAY_SIZE(pattern_names); i++) {
+        fill_qsort_pattern(tab, count, i);
+        qsort(tab, count, sizeof(*tab), qsort_int_comp);
+        for(j=1; j<count; j++)
+            if(tab[j-1] > tab[j]) break;
+        ok(j == count, "%s data sorted incorrectly on position %d\n", pattern_names[i], j);
+    }
+    free(tab);
+
+    /* records that can't be swapped a word at a time */
+    rec = malloc(count * QSORT_RECORD_SIZE);
+    for(i=0; i<count; i++) {
+        key = rand()%1000;
+        memcpy(rec + i*QSORT_RECORD_SIZE, &key, sizeof(key));
+        memset(rec + i*QSORT_RECORD_SIZE + sizeof(key), key, QSORT_RECORD_SIZE - sizeof(key));
+    }
+    qsort(rec, count, QSORT_RECORD_SIZE, qsort_record_comp);
+    prev = -1;
+    for(i=0; i<count; i++) {
+        memcpy(&key, rec + i*QSORT_RECORD_SIZE, sizeof(key));
+        if(key < prev) break;
+        for(j=sizeof(key); j<QSORT_RECORD_SIZE; j++)
+            if(rec[i*QSORT_RECORD_SIZE + j] != (unsigned char)key) break;
+        if(j < QSORT_RECORD_SIZE) break;
+        prev = key;
+    }
+    ok(i == count, "records sorted incorrectly on position %d\n", i);
+    free(rec);
+
+    if(!winetest_interactive) return;
+
+    count = 1000000;
+    tab = malloc(count * sizeof(*tab));
+    for(i=0; i<ARRAY_SIZE(pattern_names); i++) {
+        fill_qsort_pattern(tab, count, i);
+        start = GetTickCount();
+        qsort(tab, count, sizeof(*tab), qsort_int_comp);
+        trace("%s: %d elements sorted in %lu ms\n", pattern_names[i], count, GetTickCount() - start);
+    }
+    free(tab);
+}
+
 static int eq_nan(UINT64 ai, double b)
 {
     UINT64 bi = *(UINT64*)&b;
@@ -767,6 +855,7 @@ START_TEST(misc)
     test__popen(arg_v[0]);
     test__invalid_parameter();
     test_qsort_s();
+    test_qsort_large();
     test_math_functions();
     test_thread_handle_close();
     test_thread_suspended();
@@ -666,21 +666,21 @@ NTSTATUS icmp_send_echo( void *args )
 
 static int get_timeout( LARGE_INTEGER start, UINT timeout )
 {
-    LARGE_INTEGER now, end;
+    LARGE_INTEGER now, end, freq;
 
-    end.QuadPart = start.QuadPart + (ULONGLONG)timeout * 10000;
-    NtQueryPerformanceCounter( &now, NULL );
+    NtQueryPerformanceCounter( &now, &freq );
+    end.QuadPart = start.QuadPart + (ULONGLONG)timeout * freq.QuadPart / 1000;
     if (now.QuadPart >= end.QuadPart) return 0;
 
-    return min( (end.QuadPart - now.QuadPart) / 10000, INT_MAX );
+    return min( (end.QuadPart - now.QuadPart) * 1000 / freq.QuadPart, INT_MAX );
 }
 
 static ULONG get_rtt( LARGE_INTEGER start )
 {
-    LARGE_INTEGER now;
+    LARGE_INTEGER now, freq;
 
-    NtQueryPerformanceCounter( &now, NULL );
-    return (now.QuadPart - start.QuadPart) / 10000;
+    NtQueryPerformanceCounter( &now, &freq );
+    return (now.QuadPart - start.QuadPart) * 1000 / freq.QuadPart;
 }
 
 static NTSTATUS recv_msg( struct icmp_data *data, struct icmp_listen_params *params )
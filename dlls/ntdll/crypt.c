@@ -98,6 +98,109 @@ static void SHA1Transform(ULONG State[5], UCHAR Buffer[64])
    a = b = c = d = e = 0;
 }
 
+#if defined(__i386__) || defined(__x86_64__)
+
+#include <intrin.h>
+#include <immintrin.h>
+
+static BOOL have_sha_ni(void)
+{
+   static int supported = -1;
+   int regs[4];
+
+   if (supported != -1) return supported;
+
+   __cpuid(regs, 0);
+   if (regs[0] < 7)
+      return supported = FALSE;
+   __cpuid(regs, 1);
+   /* SSSE3 and SSE4.1 */
+   if (!(regs[2] & (1 << 9)) || !(regs[2] & (1 << 19)))
+      return supported = FALSE;
+   __cpuidex(regs, 7, 0);
+   /* SHA extensions */
+   return supported = !!(regs[1] & (1 << 29));
+}
+
+/* Four rounds with the Intel SHA extensions. msg0 holds the words of
+ * these rounds, msg1-3 the ones of the rounds that follow. The message
+ * schedule of the rounds 16 ahead is computed in the same pass. */
+#define SHA1_QUAD(f, e_in, e_out, msg0, msg1, msg2, msg3) \
+   e_in = _mm_sha1nexte_epu32(e_in, msg0); \
+   e_out = abcd; \
+   abcd = _mm_sha1rnds4_epu32(abcd, e_in, f); \
+   msg0 = _mm_sha1msg2_epu32(_mm_xor_si128(_mm_sha1msg1_epu32(msg0, msg1), msg2), msg3);
+
+/* Hash whole 64-byte blocks straight from the caller's buffer. */
+static __attribute__((target("sha,ssse3,sse4.1"))) void SHA1TransformSHANI(ULONG State[5], const UCHAR *Buffer, UINT Count)
+{
+   const __m128i mask = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+   __m128i abcd, abcd_save, e0, e0_save, e1, msg0, msg1, msg2, msg3;
+
+   abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)State), 0x1b);
+   e0 = _mm_set_epi32(State[4], 0, 0, 0);
+
+   while (Count--)
+   {
+      abcd_save = abcd;
+      e0_save = e0;
+
+      msg0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(Buffer + 0)), mask);
+      msg1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(Buffer + 16)), mask);
+      msg2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(Buffer + 32)), mask);
+      msg3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(Buffer + 48)), mask);
+
+      /* rounds 0-3 take E from the state instead of the previous rounds */
+      e0 = _mm_add_epi32(e0, msg0);
+      e1 = abcd;
+      abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+      msg0 = _mm_sha1msg2_epu32(_mm_xor_si128(_mm_sha1msg1_epu32(msg0, msg1), msg2), msg3);
+
+      SHA1_QUAD(0, e1, e0, msg1, msg2, msg3, msg0);
+      SHA1_QUAD(0, e0, e1, msg2, msg3, msg0, msg1);
+      SHA1_QUAD(0, e1, e0, msg3, msg0, msg1, msg2);
+      SHA1_QUAD(0, e0, e1, msg0, msg1, msg2, msg3);
+      SHA1_QUAD(1, e1, e0, msg1, msg2, msg3, msg0);
+      SHA1_QUAD(1, e0, e1, msg2, msg3, msg0, msg1);
+      SHA1_QUAD(1, e1, e0, msg3, msg0, msg1, msg2);
+      SHA1_QUAD(1, e0, e1, msg0, msg1, msg2, msg3);
+      SHA1_QUAD(1, e1, e0, msg1, msg2, msg3, msg0);
+      SHA1_QUAD(2, e0, e1, msg2, msg3, msg0, msg1);
+      SHA1_QUAD(2, e1, e0, msg3, msg0, msg1, msg2);
+      SHA1_QUAD(2, e0, e1, msg0, msg1, msg2, msg3);
+      SHA1_QUAD(2, e1, e0, msg1, msg2, msg3, msg0);
+      SHA1_QUAD(2, e0, e1, msg2, msg3, msg0, msg1);
+      SHA1_QUAD(3, e1, e0, msg3, msg0, msg1, msg2);
+      SHA1_QUAD(3, e0, e1, msg0, msg1, msg2, msg3);
+      SHA1_QUAD(3, e1, e0, msg1, msg2, msg3, msg0);
+      SHA1_QUAD(3, e0, e1, msg2, msg3, msg0, msg1);
+      SHA1_QUAD(3, e1, e0, msg3, msg0, msg1, msg2);
+
+      e0 = _mm_sha1nexte_epu32(e0, e0_save);
+      abcd = _mm_add_epi32(abcd, abcd_save);
+      Buffer += 64;
+   }
+
+   _mm_storeu_si128((__m128i *)State, _mm_shuffle_epi32(abcd, 0x1b));
+   State[4] = _mm_extract_epi32(e0, 3);
+}
+
+static BOOL SHA1TransformBlocks(ULONG State[5], const UCHAR *Buffer, UINT Count)
+{
+   if (!have_sha_ni()) return FALSE;
+   SHA1TransformSHANI(State, Buffer, Count);
+   return TRUE;
+}
+
+#else
+
+static BOOL SHA1TransformBlocks(ULONG State[5], const UCHAR *Buffer, UINT Count)
+{
+   return FALSE;
+}
+
+#endif
+
 
 /******************************************************************************
  * A_SHAInit (ntdll.@)
@@ -154,6 +257,12 @@ void WINAPI A_SHAUpdate(PSHA_CTX Context, const unsigned char *Buffer, UINT Buff
    {
       while (BufferContentSize + BufferSize >= 64)
       {
+         if (!BufferContentSize && SHA1TransformBlocks(Context->State, Buffer, BufferSize / 64))
+         {
+            Buffer += BufferSize & ~63;
+            BufferSize &= 63;
+            break;
+         }
          RtlCopyMemory(Context->Buffer + BufferContentSize, Buffer,
                        64 - BufferContentSize);
          Buffer += 64 - BufferContentSize;
@@ -0,0 +1,844 @@
+/*
+ * Event Tracing for Windows providers
+ *
+ * Copyright 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/*
+ * There is no ETW session controller in Wine. Instead, providers are enabled
+ * per process with the WINEETW environment variable, or the "Providers" value
+ * of HKCU\Software\Wine\ETW. It holds a list of entries separated by ',' or
+ * ';' of the form
+ *
+ *   {provider guid}[:level[:keywords]]
+ *
+ * where the guid can be '*' to enable every provider, the level defaults to
+ * all levels and the keywords (in hex) default to all keywords.
+ *
+ * Events of enabled providers are written to WINEETWFILE (or the "TraceFile"
+ * registry value), where "%p" is replaced by the process id. It defaults to
+ * %TEMP%\wine-etw-%p.trace. tools/etwtrace2json converts the trace to the
+ * Chrome/Perfetto JSON format.
+ *
+ * The trace file starts with a struct etw_trace_header, followed by chunks
+ * made of a struct etw_chunk_header and the records it contains. Records are
+ * 8-byte aligned and start with a struct etw_record_header; a record with a
+ * zero size ends the chunk early.
+ */
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ntstatus.h"
+#define WIN32_NO_STATUS
+#include "wine/debug.h"
+#include "ntdll_misc.h"
+#include "wmistr.h"
+#include "evntrace.h"
+#include "evntprov.h"
+
+WINE_DEFAULT_DEBUG_CHANNEL(etw);
+
+#define ETW_TRACE_VERSION 1
+
+enum etw_record_type
+{
+    ETW_RECORD_PADDING  = 0,
+    ETW_RECORD_PROVIDER = 1,  /* GUID, followed by the nul-terminated UTF-8 provider name */
+    ETW_RECORD_EVENT    = 2,  /* struct etw_event_header, field sizes, field data */
+    ETW_RECORD_STRING   = 3,  /* same as ETW_RECORD_EVENT, with one nul-terminated UTF-16 field */
+};
+
+struct etw_trace_header
+{
+    char      magic[4];       /* "WETW" */
+    ULONG     version;
+    ULONGLONG frequency;      /* timestamp ticks per second */
+    ULONGLONG start;          /* timestamp when the trace was opened */
+    ULONG     pid;
+    ULONG     pointer_size;
+};
+
+struct etw_chunk_header
+{
+    char      magic[4];       /* "CHNK" */
+    ULONG     size;           /* size of the records following the header */
+};
+
+struct etw_record_header
+{
+    ULONG     size;           /* size of the record including the header */
+    USHORT    type;
+    USHORT    provider;
+    ULONG     tid;
+    ULONG     reserved;
+    ULONGLONG timestamp;
+};
+
+struct etw_event_header
+{
+    EVENT_DESCRIPTOR descriptor;
+    GUID             activity;
+    GUID             related;
+    ULONG            count;
+    ULONG            sizes[1];  /* followed by the field data */
+};
+
+/* provider handles hold the index of the provider in the table and its
+ * generation, which changes when it is unregistered. Unregistered providers
+ * are not freed but reused by later registrations, once the writers that
+ * still use them are done. */
+#define ETW_MAX_PROVIDERS 4096
+
+struct etw_provider
+{
+    LONG volatile    generation;
+    LONG volatile    refs;         /* number of callers using the provider */
+    BOOL             registered;
+    BOOL             reusable;     /* unregistered and no longer in use */
+    GUID             guid;
+    PENABLECALLBACK  callback;
+    void            *context;
+    USHORT           index;
+    LONG volatile    enabled;
+    UCHAR            level;
+    ULONGLONG        keywords;
+};
+
+struct etw_filter
+{
+    GUID             guid;
+    BOOL             any;
+    UCHAR            level;
+    ULONGLONG        keywords;
+};
+
+/* events are appended to the current buffer without taking any lock: writers
+ * reserve space by atomically bumping 'used' and publish it by adding to
+ * 'committed'. The writer whose reservation crosses the end of the buffer
+ * installs a new one and writes the old one out once everybody is done. */
+#define ETW_BUFFER_SIZE 0x20000
+
+struct etw_buffer
+{
+    SLIST_ENTRY             entry;
+    LONG volatile           used;
+    LONG volatile           committed;
+    struct etw_chunk_header header;
+    char                    data[ETW_BUFFER_SIZE];
+};
+
+static struct etw_provider * volatile provider_table[ETW_MAX_PROVIDERS];
+static unsigned int provider_count;
+static USHORT next_provider_index;
+static struct etw_filter *filters;
+static unsigned int filter_count;
+static WCHAR *trace_path;
+static RTL_RUN_ONCE init_once = RTL_RUN_ONCE_INIT;
+
+static HANDLE trace_file;
+static BOOL trace_failed;
+static struct etw_buffer * volatile current_buffer;
+static SLIST_HEADER free_buffers;
+
+DECLARE_CRITICAL_SECTION( etw_section );
+DECLARE_CRITICAL_SECTION( file_section );
+
+
+/***********************************************************************
+ *           parse_filters
+ *
+ * Parse a provider list, see the comment at the top of the file.
+ */
+static void parse_filters( const WCHAR *str )
+{
+    const WCHAR *p, *end;
+    unsigned int count = 1;
+    WCHAR buffer[39];
+
+    for (p = str; *p; p++) if (*p == ',' || *p == ';') count++;
+    if (!(filters = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, count * sizeof(*filters) ))) return;
+
+    for (p = str; *p; p = *end ? end + 1 : end)
+    {
+        struct etw_filter *filter = &filters[filter_count];
+        UNICODE_STRING guid_str;
+        WCHAR *next;
+        SIZE_T len;
+
+        while (*p == ' ') p++;
+        for (end = p; *end && *end != ',' && *end != ';'; end++);
+        for (len = 0; p + len < end && p[len] != ':'; len++);
+        if (!len) continue;
+
+        if (len == 1 && *p == '*') filter->any = TRUE;
+        else
+        {
+            if (*p == '{' && len < ARRAY_SIZE(buffer))
+            {
+                memcpy( buffer, p, len * sizeof(WCHAR) );
+                buffer[len] = 0;
+            }
+            else if (*p != '{' && len < ARRAY_SIZE(buffer) - 2)
+            {
+                buffer[0] = '{';
+                memcpy( buffer + 1, p, len * sizeof(WCHAR) );
+                buffer[len + 1] = '}';
+                buffer[len + 2] = 0;
+            }
+            else buffer[0] = 0;
+            RtlInitUnicodeString( &guid_str, buffer );
+            if (RtlGUIDFromString( &guid_str, &filter->guid ))
+            {
+                ERR( "invalid provider %s\n", debugstr_wn( p, end - p ));
+                continue;
+            }
+        }
+
+        filter->level = EVENT_LEVEL_MAX;
+        filter->keywords = ~(ULONGLONG)0;
+        p = wcschr( p, ':' );
+        if (p && p < end)
+        {
+            filter->level = min( wcstoul( p + 1, &next, 10 ), EVENT_LEVEL_MAX );
+            if (!filter->level) filter->level = EVENT_LEVEL_MAX;
+            if (*next == ':') filter->keywords = _wcstoui64( next + 1, NULL, 16 );
+        }
+        TRACE( "enabling %s level %u keywords %s\n", filter->any ? "*" : debugstr_guid( &filter->guid ),
+               filter->level, wine_dbgstr_longlong( filter->keywords ));
+        filter_count++;
+    }
+}
+
+/***********************************************************************
+ *           get_config_value
+ *
+ * Get a setting from the environment, or from the registry.
+ */
+static WCHAR *get_config_value( HANDLE hkey, const WCHAR *env, const WCHAR *value )
+{
+    char buffer[offsetof(KEY_VALUE_PARTIAL_INFORMATION, Data[MAX_PATH * sizeof(WCHAR)])];
+    KEY_VALUE_PARTIAL_INFORMATION *info = (KEY_VALUE_PARTIAL_INFORMATION *)buffer;
+    UNICODE_STRING name;
+    SIZE_T len = 0;
+    WCHAR *ret;
+    DWORD size;
+
+    if (RtlQueryEnvironmentVariable( NULL, env, wcslen(env), NULL, 0, &len ) == STATUS_BUFFER_TOO_SMALL)
+    {
+        if (!(ret = RtlAllocateHeap( GetProcessHeap(), 0, (len + 1) * sizeof(WCHAR) ))) return NULL;
+        if (!RtlQueryEnvironmentVariable( NULL, env, wcslen(env), ret, len + 1, &len )) return ret;
+        RtlFreeHeap( GetProcessHeap(), 0, ret );
+    }
+
+    if (!hkey) return NULL;
+    RtlInitUnicodeString( &name, value );
+    if (NtQueryValueKey( hkey, &name, KeyValuePartialInformation, buffer, sizeof(buffer) - sizeof(WCHAR), &size ))
+        return NULL;
+    if (info->Type != REG_SZ && info->Type != REG_EXPAND_SZ) return NULL;
+    if (!(ret = RtlAllocateHeap( GetProcessHeap(), 0, info->DataLength + sizeof(WCHAR) ))) return NULL;
+    memcpy( ret, info->Data, info->DataLength );
+    ret[info->DataLength / sizeof(WCHAR)] = 0;
+    return ret;
+}
+
+/***********************************************************************
+ *           init_config
+ */
+static DWORD WINAPI init_config( RTL_RUN_ONCE *once, void *param, void **context )
+{
+    OBJECT_ATTRIBUTES attr;
+    UNICODE_STRING name;
+    HANDLE root, hkey = 0;
+    WCHAR *str;
+
+    RtlOpenCurrentUser( KEY_ALL_ACCESS, &root );
+    attr.Length = sizeof(attr);
+    attr.RootDirectory = root;
+    attr.ObjectName = &name;
+    attr.Attributes = 0;
+    attr.SecurityDescriptor = NULL;
+    attr.SecurityQualityOfService = NULL;
+    RtlInitUnicodeString( &name, L"Software\\Wine\\ETW" );
+
+    /* @@ Wine registry key: HKCU\Software\Wine\ETW */
+    if (NtOpenKey( &hkey, KEY_READ, &attr )) hkey = 0;
+    NtClose( root );
+
+    if ((str = get_config_value( hkey, L"WINEETW", L"Providers" )))
+    {
+        parse_filters( str );
+        RtlFreeHeap( GetProcessHeap(), 0, str );
+    }
+    if (filter_count) trace_path = get_config_value( hkey, L"WINEETWFILE", L"TraceFile" );
+
+    if (hkey) NtClose( hkey );
+    return TRUE;
+}
+
+/***********************************************************************
+ *           find_filter
+ */
+static const struct etw_filter *find_filter( const GUID *guid )
+{
+    unsigned int i;
+
+    RtlRunOnceExecuteOnce( &init_once, init_config, NULL, NULL );
+    for (i = 0; i < filter_count; i++)
+        if (filters[i].any || IsEqualGUID( &filters[i].guid, guid )) return &filters[i];
+    return NULL;
+}
+
+/***********************************************************************
+ *           build_trace_path
+ *
+ * Build the NT path of the trace file, replacing %p with the process id.
+ */
+static BOOL build_trace_path( UNICODE_STRING *nt_name )
+{
+    WCHAR pid[11], temp[MAX_PATH], *path;
+    const WCHAR *template = trace_path, *p;
+    SIZE_T len = 0, temp_len;
+    NTSTATUS status;
+    WCHAR *dst;
+
+    if (!template)
+    {
+        if (RtlQueryEnvironmentVariable( NULL, L"TEMP", 4, temp, ARRAY_SIZE(temp) - 24, &temp_len ))
+            temp_len = 0;
+        wcscpy( temp + temp_len, temp_len ? L"\\wine-etw-%p.trace" : L"wine-etw-%p.trace" );
+        template = temp;
+    }
+    swprintf_s( pid, ARRAY_SIZE(pid), L"%u", HandleToULong( NtCurrentTeb()->ClientId.UniqueProcess ));
+
+    for (p = template; *p; p++) len += (p[0] == '%' && p[1] == 'p') ? wcslen( pid ) : 1;
+    if (!(path = RtlAllocateHeap( GetProcessHeap(), 0, (len + 1) * sizeof(WCHAR) ))) return FALSE;
+    for (p = template, dst = path; *p; p++)
+    {
+        if (p[0] == '%' && p[1] == 'p')
+        {
+            wcscpy( dst, pid );
+            dst += wcslen( pid );
+            p++;
+        }
+        else *dst++ = *p;
+    }
+    *dst = 0;
+
+    status = RtlDosPathNameToNtPathName_U_WithStatus( path, nt_name, NULL, NULL );
+    if (status) ERR( "invalid trace file %s\n", debugstr_w(path) );
+    else TRACE( "writing events to %s\n", debugstr_w(path) );
+    RtlFreeHeap( GetProcessHeap(), 0, path );
+    return !status;
+}
+
+/***********************************************************************
+ *           alloc_buffer
+ */
+static struct etw_buffer *alloc_buffer(void)
+{
+    struct etw_buffer *buffer;
+
+    if ((buffer = (struct etw_buffer *)RtlInterlockedPopEntrySList( &free_buffers ))) return buffer;
+    if (!(buffer = RtlAllocateHeap( GetProcessHeap(), 0, sizeof(*buffer) ))) return NULL;
+    buffer->used = buffer->committed = 0;
+    memcpy( buffer->header.magic, "CHNK", 4 );
+    return buffer;
+}
+
+/***********************************************************************
+ *           open_trace
+ *
+ * Create the trace file. Must be called with etw_section held.
+ */
+static BOOL open_trace(void)
+{
+    struct etw_trace_header header;
+    OBJECT_ATTRIBUTES attr;
+    UNICODE_STRING nt_name;
+    IO_STATUS_BLOCK io;
+    LARGE_INTEGER counter, frequency;
+    NTSTATUS status;
+    HANDLE file;
+
+    if (trace_file) return TRUE;
+    if (trace_failed) return FALSE;
+    trace_failed = TRUE;
+
+    RtlInitializeSListHead( &free_buffers );
+    if (!(current_buffer = alloc_buffer())) return FALSE;
+    if (!build_trace_path( &nt_name )) return FALSE;
+
+    InitializeObjectAttributes( &attr, &nt_name, OBJ_CASE_INSENSITIVE, 0, NULL );
+    status = NtCreateFile( &file, GENERIC_WRITE | SYNCHRONIZE, &attr, &io, NULL, FILE_ATTRIBUTE_NORMAL,
+                           FILE_SHARE_READ, FILE_OVERWRITE_IF,
+                           FILE_SYNCHRONOUS_IO_NONALERT | FILE_NON_DIRECTORY_FILE, NULL, 0 );
+    RtlFreeUnicodeString( &nt_name );
+    if (status)
+    {
+        ERR( "failed to create trace file, status %#x\n", status );
+        return FALSE;
+    }
+
+    RtlQueryPerformanceCounter( &counter );
+    RtlQueryPerformanceFrequency( &frequency );
+    memcpy( header.magic, "WETW", 4 );
+    header.version = ETW_TRACE_VERSION;
+    header.frequency = frequency.QuadPart;
+    header.start = counter.QuadPart;
+    header.pid = HandleToULong( NtCurrentTeb()->ClientId.UniqueProcess );
+    header.pointer_size = sizeof(void *);
+    if (NtWriteFile( file, 0, NULL, NULL, &io, &header, sizeof(header), NULL, NULL ))
+    {
+        NtClose( file );
+        return FALSE;
+    }
+
+    trace_file = file;
+    trace_failed = FALSE;
+    return TRUE;
+}
+
+/***********************************************************************
+ *           write_buffer
+ *
+ * Write out a retired buffer once all the writers that reserved space in
+ * it are done.
+ */
+static void write_buffer( struct etw_buffer *buffer, LONG end, BOOL shutdown )
+{
+    IO_STATUS_BLOCK io;
+    unsigned int spins = 0;
+
+    /* other threads may have been killed in the middle of an event on shutdown */
+    while (buffer->committed != end)
+    {
+        if (shutdown && ++spins > 1000) break;
+        NtYieldExecution();
+    }
+    MemoryBarrier();
+
+    if (!end) return;
+    buffer->header.size = end;
+    RtlEnterCriticalSection( &file_section );
+    if (trace_file)
+        NtWriteFile( trace_file, 0, NULL, NULL, &io, &buffer->header,
+                     offsetof(struct etw_buffer, data[end]) - offsetof(struct etw_buffer, header), NULL, NULL );
+    RtlLeaveCriticalSection( &file_section );
+}
+
+/***********************************************************************
+ *           retire_buffer
+ *
+ * Called by the writer whose reservation crossed the end of the buffer.
+ */
+static void retire_buffer( struct etw_buffer *buffer, LONG end, BOOL shutdown )
+{
+    struct etw_buffer *next = alloc_buffer();
+
+    if (next) InterlockedExchangePointer( (void **)&current_buffer, next );
+    write_buffer( buffer, end, shutdown );
+    memset( buffer->data, 0, end );
+    buffer->committed = 0;
+    InterlockedExchange( &buffer->used, 0 );
+    /* when out of memory, keep using the same buffer */
+    if (next) RtlInterlockedPushEntrySList( &free_buffers, &buffer->entry );
+}
+
+/***********************************************************************
+ *           reserve_record
+ */
+static struct etw_record_header *reserve_record( ULONG size, USHORT type, USHORT provider,
+                                                 struct etw_buffer **ret )
+{
+    struct etw_record_header *record;
+    LARGE_INTEGER counter;
+
+    for (;;)
+    {
+        struct etw_buffer *buffer = current_buffer;
+        LONG offset = InterlockedExchangeAdd( &buffer->used, size );
+
+        if (offset + size <= ETW_BUFFER_SIZE)
+        {
+            record = (struct etw_record_header *)(buffer->data + offset);
+            *ret = buffer;
+            break;
+        }
+        if (offset <= ETW_BUFFER_SIZE) retire_buffer( buffer, offset, FALSE );
+        else YieldProcessor();
+    }
+
+    RtlQueryPerformanceCounter( &counter );
+    record->size = size;
+    record->type = type;
+    record->provider = provider;
+    record->tid = HandleToULong( NtCurrentTeb()->ClientId.UniqueThread );
+    record->reserved = 0;
+    record->timestamp = counter.QuadPart;
+    return record;
+}
+
+static inline void commit_record( struct etw_buffer *buffer, ULONG size )
+{
+    InterlockedExchangeAdd( &buffer->committed, size );
+}
+
+/***********************************************************************
+ *           write_provider_record
+ */
+static void write_provider_record( const struct etw_provider *provider, const char *name, ULONG len )
+{
+    struct etw_record_header *record;
+    struct etw_buffer *buffer;
+    ULONG size = (sizeof(*record) + sizeof(GUID) + len + 1 + 7) & ~7;
+    char *ptr;
+
+    record = reserve_record( size, ETW_RECORD_PROVIDER, provider->index, &buffer );
+    ptr = (char *)(record + 1);
+    memcpy( ptr, &provider->guid, sizeof(GUID) );
+    memcpy( ptr + sizeof(GUID), name, len );
+    ptr[sizeof(GUID) + len] = 0;
+    commit_record( buffer, size );
+}
+
+/***********************************************************************
+ *           write_event
+ */
+static ULONG write_event( const struct etw_provider *provider, USHORT type, const EVENT_DESCRIPTOR *descriptor,
+                          const GUID *activity, const GUID *related, ULONG count,
+                          const EVENT_DATA_DESCRIPTOR *data )
+{
+    struct etw_record_header *record;
+    struct etw_event_header *event;
+    struct etw_buffer *buffer;
+    ULONGLONG size;
+    ULONG i;
+    char *ptr;
+
+    if (count > MAX_EVENT_DATA_DESCRIPTORS) return ERROR_INVALID_PARAMETER;
+    if (count && !data) return ERROR_INVALID_PARAMETER;
+
+    size = sizeof(*record) + offsetof( struct etw_event_header, sizes[count] );
+    for (i = 0; i < count; i++) size += data[i].Size;
+    size = (size + 7) & ~7;
+    if (size > ETW_BUFFER_SIZE) return ERROR_ARITHMETIC_OVERFLOW;
+
+    record = reserve_record( size, type, provider->index, &buffer );
+    event = (struct etw_event_header *)(record + 1);
+    event->descriptor = *descriptor;
+    if (activity) event->activity = *activity;
+    else memset( &event->activity, 0, sizeof(event->activity) );
+    if (related) event->related = *related;
+    else memset( &event->related, 0, sizeof(event->related) );
+    event->count = count;
+
+    ptr = (char *)&event->sizes[count];
+    for (i = 0; i < count; i++)
+    {
+        event->sizes[i] = data[i].Size;
+        memcpy( ptr, (const void *)(ULONG_PTR)data[i].Ptr, data[i].Size );
+        ptr += data[i].Size;
+    }
+    commit_record( buffer, size );
+    return ERROR_SUCCESS;
+}
+
+static inline REGHANDLE get_provider_handle( unsigned int slot, const struct etw_provider *provider )
+{
+    return ((ULONGLONG)(ULONG)provider->generation << 32) | (slot + 1);
+}
+
+/***********************************************************************
+ *           grab_provider
+ *
+ * Get the provider of a handle, keeping it from being reused until
+ * release_provider() is called.
+ */
+static struct etw_provider *grab_provider( REGHANDLE handle )
+{
+    ULONG slot = (ULONG)handle - 1;
+    struct etw_provider *provider;
+
+    if (slot >= ETW_MAX_PROVIDERS || !(provider = provider_table[slot])) return NULL;
+    InterlockedIncrement( &provider->refs );
+    if (provider->generation != (LONG)(handle >> 32) || !provider->registered)
+    {
+        InterlockedDecrement( &provider->refs );
+        return NULL;
+    }
+    return provider;
+}
+
+static inline void release_provider( struct etw_provider *provider )
+{
+    InterlockedDecrement( &provider->refs );
+}
+
+static inline BOOL is_event_enabled( const struct etw_provider *provider, UCHAR level, ULONGLONG keyword )
+{
+    if (!provider->enabled) return FALSE;
+    if (level > provider->level) return FALSE;
+    return !keyword || (keyword & provider->keywords);
+}
+
+/***********************************************************************
+ *           etw_shutdown
+ *
+ * Write out the remaining events on process exit.
+ */
+void etw_shutdown(void)
+{
+    struct etw_buffer *buffer;
+    LONG offset;
+
+    if (!trace_file) return;
+
+    buffer = current_buffer;
+    offset = InterlockedExchangeAdd( &buffer->used, ETW_BUFFER_SIZE + 1 );
+    if (offset <= ETW_BUFFER_SIZE) retire_buffer( buffer, offset, TRUE );
+
+    RtlEnterCriticalSection( &file_section );
+    NtClose( trace_file );
+    trace_file = 0;
+    RtlLeaveCriticalSection( &file_section );
+}
+
+/******************************************************************************
+ *                  EtwEventActivityIdControl (NTDLL.@)
+ */
+ULONG WINAPI EtwEventActivityIdControl(ULONG code, GUID *guid)
+{
+    static int once;
+
+    if (!once++) FIXME("0x%x, %p: stub\n", code, guid);
+    return ERROR_SUCCESS;
+}
+
+/******************************************************************************
+ *                  EtwEventProviderEnabled (NTDLL.@)
+ */
+BOOLEAN WINAPI EtwEventProviderEnabled( REGHANDLE handle, UCHAR level, ULONGLONG keyword )
+{
+    struct etw_provider *provider;
+    BOOLEAN ret;
+
+    TRACE("%s, %u, %s\n", wine_dbgstr_longlong(handle), level, wine_dbgstr_longlong(keyword));
+
+    if (!(provider = grab_provider( handle ))) return FALSE;
+    ret = is_event_enabled( provider, level, keyword );
+    release_provider( provider );
+    return ret;
+}
+
+/******************************************************************************
+ *                  EtwEventRegister (NTDLL.@)
+ */
+ULONG WINAPI EtwEventRegister( LPCGUID guid, PENABLECALLBACK callback, PVOID context,
+                PREGHANDLE handle )
+{
+    const struct etw_filter *filter;
+    struct etw_provider *provider = NULL;
+    unsigned int slot;
+    BOOL enabled;
+
+    TRACE("(%s, %p, %p, %p)\n", debugstr_guid(guid), callback, context, handle);
+
+    if (!guid || !handle) return ERROR_INVALID_PARAMETER;
+
+    filter = find_filter( guid );
+
+    RtlEnterCriticalSection( &etw_section );
+    for (slot = 0; slot < provider_count; slot++)
+        if ((provider = provider_table[slot])->reusable) break;
+    if (slot == provider_count)
+    {
+        if (slot == ETW_MAX_PROVIDERS ||
+            !(provider = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*provider) )))
+        {
+            RtlLeaveCriticalSection( &etw_section );
+            return ERROR_NOT_ENOUGH_MEMORY;
+        }
+        provider_table[provider_count++] = provider;
+    }
+    provider->reusable = FALSE;
+    provider->guid = *guid;
+    provider->callback = callback;
+    provider->context = context;
+    provider->index = ++next_provider_index;
+    provider->level = 0;
+    provider->keywords = 0;
+    provider->enabled = FALSE;
+    if (filter && open_trace())
+    {
+        provider->level = filter->level;
+        provider->keywords = filter->keywords;
+        write_provider_record( provider, "", 0 );
+        provider->enabled = TRUE;
+    }
+    enabled = provider->enabled;
+    *handle = get_provider_handle( slot, provider );
+    MemoryBarrier();
+    provider->registered = TRUE;
+    RtlLeaveCriticalSection( &etw_section );
+
+    if (enabled && callback)
+        callback( guid, EVENT_CONTROL_CODE_ENABLE_PROVIDER, filter->level, filter->keywords, 0, NULL, context );
+    return ERROR_SUCCESS;
+}
+
+/******************************************************************************
+ *                  EtwEventUnregister (NTDLL.@)
+ */
+ULONG WINAPI EtwEventUnregister( REGHANDLE handle )
+{
+    struct etw_provider *provider;
+
+    TRACE("(%s)\n", wine_dbgstr_longlong(handle));
+
+    RtlEnterCriticalSection( &etw_section );
+    if (!(provider = grab_provider( handle )))
+    {
+        RtlLeaveCriticalSection( &etw_section );
+        return ERROR_INVALID_HANDLE;
+    }
+    provider->registered = FALSE;
+    InterlockedExchange( &provider->enabled, FALSE );
+    /* from now on the handle is invalid, wait for the callers that still use it */
+    InterlockedIncrement( &provider->generation );
+    release_provider( provider );
+    RtlLeaveCriticalSection( &etw_section );
+
+    while (provider->refs) NtYieldExecution();
+
+    RtlEnterCriticalSection( &etw_section );
+    provider->reusable = TRUE;
+    RtlLeaveCriticalSection( &etw_section );
+    return ERROR_SUCCESS;
+}
+
+/*********************************************************************
+ *                  EtwEventSetInformation   (NTDLL.@)
+ */
+ULONG WINAPI EtwEventSetInformation( REGHANDLE handle, EVENT_INFO_CLASS class, void *info,
+                                     ULONG length )
+{
+    struct etw_provider *provider;
+    ULONG ret = ERROR_SUCCESS;
+
+    TRACE("(%s, %u, %p, %u)\n", wine_dbgstr_longlong(handle), class, info, length);
+
+    if (!(provider = grab_provider( handle ))) return ERROR_INVALID_HANDLE;
+
+    switch (class)
+    {
+    case EventProviderSetTraits:
+    {
+        /* the traits start with their total size, followed by the UTF-8 provider name */
+        const char *name = (const char *)info + sizeof(USHORT);
+        ULONG len = 0;
+
+        if (!info || length < sizeof(USHORT) || *(USHORT *)info > length) ret = ERROR_INVALID_PARAMETER;
+        else if (provider->enabled)
+        {
+            while (sizeof(USHORT) + len < *(USHORT *)info && name[len]) len++;
+            write_provider_record( provider, name, len );
+        }
+        break;
+    }
+    default:
+        FIXME("(%s, %u, %p, %u) stub\n", wine_dbgstr_longlong(handle), class, info, length);
+        break;
+    }
+    release_provider( provider );
+    return ret;
+}
+
+/******************************************************************************
+ *                  EtwEventWriteString   (NTDLL.@)
+ */
+ULONG WINAPI EtwEventWriteString( REGHANDLE handle, UCHAR level, ULONGLONG keyword, PCWSTR string )
+{
+    struct etw_provider *provider;
+    EVENT_DESCRIPTOR descriptor;
+    EVENT_DATA_DESCRIPTOR data;
+    ULONG ret = ERROR_SUCCESS;
+
+    TRACE("%s, %u, %s, %s\n", wine_dbgstr_longlong(handle), level,
+          wine_dbgstr_longlong(keyword), debugstr_w(string));
+
+    if (!(provider = grab_provider( handle ))) return ERROR_INVALID_HANDLE;
+    if (!string) ret = ERROR_INVALID_PARAMETER;
+    else if (is_event_enabled( provider, level, keyword ))
+    {
+        memset( &descriptor, 0, sizeof(descriptor) );
+        descriptor.Level = level;
+        descriptor.Keyword = keyword;
+        data.Ptr = (ULONG_PTR)string;
+        data.Size = (wcslen( string ) + 1) * sizeof(WCHAR);
+        data.Reserved = 0;
+        ret = write_event( provider, ETW_RECORD_STRING, &descriptor, NULL, NULL, 1, &data );
+    }
+    release_provider( provider );
+    return ret;
+}
+
+/******************************************************************************
+ *                  EtwEventWriteTransfer   (NTDLL.@)
+ */
+ULONG WINAPI EtwEventWriteTransfer( REGHANDLE handle, PCEVENT_DESCRIPTOR descriptor, LPCGUID activity,
+                                    LPCGUID related, ULONG count, PEVENT_DATA_DESCRIPTOR data )
+{
+    struct etw_provider *provider;
+    ULONG ret = ERROR_SUCCESS;
+
+    TRACE("%s, %p, %s, %s, %u, %p\n", wine_dbgstr_longlong(handle), descriptor,
+          debugstr_guid(activity), debugstr_guid(related), count, data);
+
+    if (!(provider = grab_provider( handle ))) return ERROR_INVALID_HANDLE;
+    if (!descriptor) ret = ERROR_INVALID_PARAMETER;
+    else if (is_event_enabled( provider, descriptor->Level, descriptor->Keyword ))
+        ret = write_event( provider, ETW_RECORD_EVENT, descriptor, activity, related, count, data );
+    release_provider( provider );
+    return ret;
+}
+
+/******************************************************************************
+ *                  EtwEventEnabled (NTDLL.@)
+ */
+BOOLEAN WINAPI EtwEventEnabled( REGHANDLE handle, const EVENT_DESCRIPTOR *descriptor )
+{
+    struct etw_provider *provider;
+    BOOLEAN ret;
+
+    TRACE("(%s, %p)\n", wine_dbgstr_longlong(handle), descriptor);
+
+    if (!descriptor || !(provider = grab_provider( handle ))) return FALSE;
+    ret = is_event_enabled( provider, descriptor->Level, descriptor->Keyword );
+    release_provider( provider );
+    return ret;
+}
+
+/******************************************************************************
+ *                  EtwEventWrite (NTDLL.@)
+ */
+ULONG WINAPI EtwEventWrite( REGHANDLE handle, const EVENT_DESCRIPTOR *descriptor, ULONG count,
+    EVENT_DATA_DESCRIPTOR *data )
+{
+    return EtwEventWriteTransfer( handle, descriptor, NULL, NULL, count, data );
+}
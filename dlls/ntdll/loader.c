@@ -3652,6 +3652,8 @@ void WINAPI LdrShutdownProcess(void)
         RtlProcessFlsData( NtCurrentTeb()->FlsSlots, 1 );
 
     process_detach();
+    if (TRACE_ON(relay)) RELAY_DumpProfile();
+    etw_shutdown();
 }
 
 
@@ -3716,6 +3718,8 @@ void WINAPI LdrShutdownThread(void)
     NtCurrentTeb()->FlsSlots = NULL;
     RtlFreeHeap( GetProcessHeap(), 0, NtCurrentTeb()->TlsExpansionSlots );
     NtCurrentTeb()->TlsExpansionSlots = NULL;
+    RtlFreeHeap( GetProcessHeap(), 0, NtCurrentTeb()->ReservedForPerf );  /* relay profile data */
+    NtCurrentTeb()->ReservedForPerf = NULL;
     RtlReleasePebLock();
 
     RtlLeaveCriticalSection( &loader_section );
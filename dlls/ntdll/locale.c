@@ -40,7 +40,9 @@ BYTE NlsMbCodePageTag = 0;
 BYTE NlsMbOemCodePageTag = 0;
 
 static NLSTABLEINFO nls_info = { { CP_UTF8 }, { CP_UTF8 } };
+static BOOL ansi_is_ascii, oem_is_ascii;  /* the code pages map ASCII to itself */
 static struct norm_table *norm_tables[16];
+static BOOL norm_ascii_stable[16];  /* ASCII chars other than null are left alone by the form */
 static const NLS_LOCALE_HEADER *locale_table;
 
 
@@ -50,6 +52,22 @@ static WCHAR casemap( USHORT *table, WCHAR ch )
 }
 
 
+static BOOL is_ascii_stable( const struct norm_table *info )
+{
+    unsigned int ch;
+
+    for (ch = 1; ch < 0x80; ch++) if (get_char_props( info, ch )) return FALSE;
+    return TRUE;
+}
+
+static void update_ascii_compat(void)
+{
+    ansi_is_ascii = nls_info.AnsiTableInfo.CodePage != CP_UTF8 &&
+                    cp_is_ascii_compatible( &nls_info.AnsiTableInfo );
+    oem_is_ascii = nls_info.OemTableInfo.CodePage != CP_UTF8 &&
+                   cp_is_ascii_compatible( &nls_info.OemTableInfo );
+}
+
 static NTSTATUS load_norm_table( ULONG form, const struct norm_table **info )
 {
     unsigned int i;
@@ -78,6 +96,8 @@ static NTSTATUS load_norm_table( ULONG form, const struct norm_table **info )
 
         if (InterlockedCompareExchangePointer( (void **)&norm_tables[form], data, NULL ))
             NtUnmapViewOfSection( GetCurrentProcess(), data );
+        else
+            norm_ascii_stable[form] = is_ascii_stable( norm_tables[form] );
     }
     *info = norm_tables[form];
     return STATUS_SUCCESS;
@@ -156,6 +176,7 @@ void locale_init(void)
     NlsAnsiCodePage     = nls_info.AnsiTableInfo.CodePage;
     NlsMbCodePageTag    = nls_info.AnsiTableInfo.DBCSCodePage;
     NlsMbOemCodePageTag = nls_info.OemTableInfo.DBCSCodePage;
+    update_ascii_compat();
 }
 
 
@@ -311,7 +332,9 @@ void WINAPI RtlResetRtlTranslations( const NLSTABLEINFO *info )
     NlsAnsiCodePage     = info->AnsiTableInfo.CodePage;
     NlsMbCodePageTag    = info->AnsiTableInfo.DBCSCodePage;
     NlsMbOemCodePageTag = info->OemTableInfo.DBCSCodePage;
+    ansi_is_ascii = oem_is_ascii = FALSE;
     nls_info = *info;
+    update_ascii_compat();
 }
 
 
@@ -456,7 +479,7 @@ NTSTATUS WINAPI RtlHashUnicodeString( const UNICODE_STRING *string, BOOLEAN case
 NTSTATUS WINAPI RtlCustomCPToUnicodeN( CPTABLEINFO *info, WCHAR *dst, DWORD dstlen, DWORD *reslen,
                                        const char *src, DWORD srclen )
 {
-    unsigned int ret = cp_mbstowcs( info, dst, dstlen / sizeof(WCHAR), src, srclen );
+    unsigned int ret = cp_mbstowcs( info, FALSE, dst, dstlen / sizeof(WCHAR), src, srclen );
     if (reslen) *reslen = ret * sizeof(WCHAR);
     return STATUS_SUCCESS;
 }
@@ -468,7 +491,7 @@ NTSTATUS WINAPI RtlCustomCPToUnicodeN( CPTABLEINFO *info, WCHAR *dst, DWORD dstl
 NTSTATUS WINAPI RtlUnicodeToCustomCPN( CPTABLEINFO *info, char *dst, DWORD dstlen, DWORD *reslen,
                                        const WCHAR *src, DWORD srclen )
 {
-    unsigned int ret = cp_wcstombs( info, dst, dstlen, src, srclen / sizeof(WCHAR) );
+    unsigned int ret = cp_wcstombs( info, FALSE, dst, dstlen, src, srclen / sizeof(WCHAR) );
     if (reslen) *reslen = ret;
     return STATUS_SUCCESS;
 }
@@ -483,7 +506,8 @@ NTSTATUS WINAPI RtlMultiByteToUnicodeN( WCHAR *dst, DWORD dstlen, DWORD *reslen,
     unsigned int ret;
 
     if (nls_info.AnsiTableInfo.CodePage != CP_UTF8)
-        ret = cp_mbstowcs( &nls_info.AnsiTableInfo, dst, dstlen / sizeof(WCHAR), src, srclen );
+        ret = cp_mbstowcs( &nls_info.AnsiTableInfo, ansi_is_ascii, dst, dstlen / sizeof(WCHAR),
+                           src, srclen );
     else
         utf8_mbstowcs( dst, dstlen / sizeof(WCHAR), &ret, src, srclen );
 
@@ -518,7 +542,8 @@ NTSTATUS WINAPI RtlOemToUnicodeN( WCHAR *dst, DWORD dstlen, DWORD *reslen,
     unsigned int ret;
 
     if (nls_info.OemTableInfo.CodePage != CP_UTF8)
-        ret = cp_mbstowcs( &nls_info.OemTableInfo, dst, dstlen / sizeof(WCHAR), src, srclen );
+        ret = cp_mbstowcs( &nls_info.OemTableInfo, oem_is_ascii, dst, dstlen / sizeof(WCHAR),
+                           src, srclen );
     else
         utf8_mbstowcs( dst, dstlen / sizeof(WCHAR), &ret, src, srclen );
 
@@ -570,7 +595,8 @@ NTSTATUS WINAPI RtlUnicodeToMultiByteN( char *dst, DWORD dstlen, DWORD *reslen,
     unsigned int ret;
 
     if (nls_info.AnsiTableInfo.CodePage != CP_UTF8)
-        ret = cp_wcstombs( &nls_info.AnsiTableInfo, dst, dstlen, src, srclen / sizeof(WCHAR) );
+        ret = cp_wcstombs( &nls_info.AnsiTableInfo, ansi_is_ascii, dst, dstlen,
+                           src, srclen / sizeof(WCHAR) );
     else
         utf8_wcstombs( dst, dstlen, &ret, src, srclen / sizeof(WCHAR) );
 
@@ -605,7 +631,8 @@ NTSTATUS WINAPI RtlUnicodeToOemN( char *dst, DWORD dstlen, DWORD *reslen,
     unsigned int ret;
 
     if (nls_info.OemTableInfo.CodePage != CP_UTF8)
-        ret = cp_wcstombs( &nls_info.OemTableInfo, dst, dstlen, src, srclen / sizeof(WCHAR) );
+        ret = cp_wcstombs( &nls_info.OemTableInfo, oem_is_ascii, dst, dstlen,
+                           src, srclen / sizeof(WCHAR) );
     else
         utf8_wcstombs( dst, dstlen, &ret, src, srclen / sizeof(WCHAR) );
 
@@ -946,6 +973,79 @@ NTSTATUS WINAPI RtlUnicodeToUTF8N( char *dst, DWORD dstlen, DWORD *reslen, const
 }
 
 
+/* return the length of the leading run of chars that the form leaves alone, that is starters
+ * without decomposition that never compose with the previous char, and a final null */
+static int get_stable_prefix( const struct norm_table *info, const WCHAR *str, int len )
+{
+    BOOL ascii = norm_ascii_stable[info->form];
+    int i = 0;
+    WCHAR ch;
+
+    while (i < len)
+    {
+#ifdef __SSE2__
+        if (ascii)
+        {
+            const __m128i mask = _mm_set1_epi16( 0xff80 ), zero = _mm_setzero_si128();
+
+            for ( ; i + 8 <= len; i += 8)
+            {
+                __m128i chars = _mm_loadu_si128( (const __m128i *)(str + i) );
+                __m128i is_ascii = _mm_cmpeq_epi16( _mm_and_si128( chars, mask ), zero );
+                __m128i is_null = _mm_cmpeq_epi16( chars, zero );
+                if (_mm_movemask_epi8( _mm_andnot_si128( is_null, is_ascii ) ) != 0xffff) break;
+            }
+            if (i == len) break;
+        }
+#endif
+        ch = str[i];
+        if (ascii && ch && ch < 0x80)
+        {
+            i++;
+            continue;
+        }
+        if (IS_HIGH_SURROGATE( ch ) || IS_LOW_SURROGATE( ch )) break;
+        /* Hangul jamo compose without being flagged in the tables */
+        if (ch >= HANGUL_LBASE && ch < HANGUL_LBASE + 0x100) break;
+        if (ch >= HANGUL_SBASE && ch < HANGUL_SBASE + 0x2c00) break;
+        if (get_char_props( info, ch ) && (ch || i != len - 1)) break;
+        i++;
+    }
+    return i;
+}
+
+
+/* decompose and, for the composed forms, recompose a string */
+static NTSTATUS normalize_string( const struct norm_table *info, const WCHAR *src, int src_len,
+                                  WCHAR *dst, int *dst_len )
+{
+    int buf_len;
+    WCHAR *buf = NULL;
+    NTSTATUS status;
+
+    if (!info->comp_size) return decompose_string( info, src, src_len, dst, dst_len );
+
+    buf_len = src_len * 4;
+    for (;;)
+    {
+        buf = RtlAllocateHeap( GetProcessHeap(), 0, buf_len * sizeof(WCHAR) );
+        if (!buf) return STATUS_NO_MEMORY;
+        status = decompose_string( info, src, src_len, buf, &buf_len );
+        if (status != STATUS_BUFFER_TOO_SMALL) break;
+        RtlFreeHeap( GetProcessHeap(), 0, buf );
+    }
+    if (!status)
+    {
+        buf_len = compose_string( info, buf, buf_len );
+        if (*dst_len >= buf_len) memcpy( dst, buf, buf_len * sizeof(WCHAR) );
+        else status = STATUS_BUFFER_TOO_SMALL;
+    }
+    RtlFreeHeap( GetProcessHeap(), 0, buf );
+    *dst_len = buf_len;
+    return status;
+}
+
+
 /******************************************************************************
  *      RtlIsNormalizedString   (NTDLL.@)
  */
@@ -961,7 +1061,7 @@ NTSTATUS WINAPI RtlIsNormalizedString( ULONG form, const WCHAR *str, INT len, BO
 
     if (len == -1) len = wcslen( str );
 
-    for (i = 0; i < len && result; i += r)
+    for (i = get_stable_prefix( info, str, len ); i < len && result; i += r)
     {
         if (!(r = get_utf16( str + i, len - i, &ch ))) return STATUS_NO_UNICODE_TRANSLATION;
         if (info->comp_size)
@@ -1023,10 +1123,9 @@ NTSTATUS WINAPI RtlIsNormalizedString( ULONG form, const WCHAR *str, INT len, BO
  */
 NTSTATUS WINAPI RtlNormalizeString( ULONG form, const WCHAR *src, INT src_len, WCHAR *dst, INT *dst_len )
 {
-    int buf_len;
-    WCHAR *buf = NULL;
     const struct norm_table *info;
     NTSTATUS status = STATUS_SUCCESS;
+    int stable;
 
     TRACE( "%x %s %d %p %d\n", form, debugstr_wn(src, src_len), src_len, dst, *dst_len );
 
@@ -1046,26 +1145,30 @@ NTSTATUS WINAPI RtlNormalizeString( ULONG form, const WCHAR *src, INT src_len, W
         return STATUS_SUCCESS;
     }
 
-    if (!info->comp_size) return decompose_string( info, src, src_len, dst, dst_len );
-
-    buf_len = src_len * 4;
-    for (;;)
+    stable = get_stable_prefix( info, src, src_len );
+    if (stable == src_len && *dst_len >= src_len)
     {
-        buf = RtlAllocateHeap( GetProcessHeap(), 0, buf_len * sizeof(WCHAR) );
-        if (!buf) return STATUS_NO_MEMORY;
-        status = decompose_string( info, src, src_len, buf, &buf_len );
-        if (status != STATUS_BUFFER_TOO_SMALL) break;
-        RtlFreeHeap( GetProcessHeap(), 0, buf );
+        memcpy( dst, src, src_len * sizeof(WCHAR) );
+        *dst_len = src_len;
+        return STATUS_SUCCESS;
     }
-    if (!status)
+
+    /* the last stable char may still compose with the chars that follow it */
+    if (stable && (stable == src_len || info->comp_size)) stable--;
+    if (stable && stable <= *dst_len)
     {
-        buf_len = compose_string( info, buf, buf_len );
-        if (*dst_len >= buf_len) memcpy( dst, buf, buf_len * sizeof(WCHAR) );
-        else status = STATUS_BUFFER_TOO_SMALL;
+        int len = *dst_len - stable;
+
+        status = normalize_string( info, src + stable, src_len - stable, dst + stable, &len );
+        /* let the full string determine the estimated length */
+        if (status != STATUS_BUFFER_TOO_SMALL)
+        {
+            memcpy( dst, src, stable * sizeof(WCHAR) );
+            *dst_len = stable + len;
+            return status;
+        }
     }
-    RtlFreeHeap( GetProcessHeap(), 0, buf );
-    *dst_len = buf_len;
-    return status;
+    return normalize_string( info, src, src_len, dst, dst_len );
 }
 
 
@@ -25,6 +25,10 @@
 #include "winbase.h"
 #include "winnls.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 /* NLS codepage file format:
  *
  * header:
@@ -188,6 +192,103 @@ static inline unsigned int decode_utf8_char( unsigned char ch, const char **str,
 }
 
 
+/* length of the leading run of 7-bit ASCII chars */
+static inline unsigned int get_ascii_len( const char *src, unsigned int srclen )
+{
+    unsigned int i = 0;
+
+#ifdef __SSE2__
+    for ( ; i + 16 <= srclen; i += 16)
+        if (_mm_movemask_epi8( _mm_loadu_si128( (const __m128i *)(src + i) ))) break;
+#endif
+    while (i < srclen && !(src[i] & 0x80)) i++;
+    return i;
+}
+
+
+/* length of the leading run of 7-bit ASCII chars */
+static inline unsigned int get_ascii_lenW( const WCHAR *src, unsigned int srclen )
+{
+    unsigned int i = 0;
+
+#ifdef __SSE2__
+    const __m128i mask = _mm_set1_epi16( 0xff80 ), zero = _mm_setzero_si128();
+
+    for ( ; i + 16 <= srclen; i += 16)
+    {
+        __m128i chars = _mm_or_si128( _mm_loadu_si128( (const __m128i *)(src + i) ),
+                                      _mm_loadu_si128( (const __m128i *)(src + i + 8) ));
+        if (_mm_movemask_epi8( _mm_cmpeq_epi16( _mm_and_si128( chars, mask ), zero )) != 0xffff) break;
+    }
+#endif
+    while (i < srclen && src[i] < 0x80) i++;
+    return i;
+}
+
+
+/* convert the leading run of 7-bit ASCII chars, return its length */
+static inline unsigned int ascii_mbstowcs( WCHAR *dst, const char *src, unsigned int len )
+{
+    unsigned int i = 0;
+
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+
+    for ( ; i + 16 <= len; i += 16)
+    {
+        __m128i chars = _mm_loadu_si128( (const __m128i *)(src + i) );
+        if (_mm_movemask_epi8( chars )) break;
+        _mm_storeu_si128( (__m128i *)(dst + i), _mm_unpacklo_epi8( chars, zero ));
+        _mm_storeu_si128( (__m128i *)(dst + i + 8), _mm_unpackhi_epi8( chars, zero ));
+    }
+#endif
+    for ( ; i < len && !(src[i] & 0x80); i++) dst[i] = src[i];
+    return i;
+}
+
+
+/* convert the leading run of 7-bit ASCII chars, return its length */
+static inline unsigned int ascii_wcstombs( char *dst, const WCHAR *src, unsigned int len )
+{
+    unsigned int i = 0;
+
+#ifdef __SSE2__
+    const __m128i mask = _mm_set1_epi16( 0xff80 ), zero = _mm_setzero_si128();
+
+    for ( ; i + 16 <= len; i += 16)
+    {
+        __m128i lo = _mm_loadu_si128( (const __m128i *)(src + i) );
+        __m128i hi = _mm_loadu_si128( (const __m128i *)(src + i + 8) );
+        __m128i high_bits = _mm_and_si128( _mm_or_si128( lo, hi ), mask );
+        if (_mm_movemask_epi8( _mm_cmpeq_epi16( high_bits, zero )) != 0xffff) break;
+        _mm_storeu_si128( (__m128i *)(dst + i), _mm_packus_epi16( lo, hi ));
+    }
+#endif
+    for ( ; i < len && src[i] < 0x80; i++) dst[i] = src[i];
+    return i;
+}
+
+
+/* check whether a code page table maps 7-bit ASCII to itself both ways, so that
+ * runs of ASCII chars can be converted without table lookups */
+static inline BOOL cp_is_ascii_compatible( const CPTABLEINFO *info )
+{
+    unsigned int i;
+
+    for (i = 0; i < 0x80; i++)
+    {
+        if (info->MultiByteTable[i] != i) return FALSE;
+        if (info->DBCSOffsets && info->DBCSOffsets[i]) return FALSE;
+        if (info->DBCSCodePage)
+        {
+            if (((const WCHAR *)info->WideCharTable)[i] != i) return FALSE;
+        }
+        else if (((const unsigned char *)info->WideCharTable)[i] != i) return FALSE;
+    }
+    return TRUE;
+}
+
+
 static inline void init_codepage_table( USHORT *ptr, CPTABLEINFO *info )
 {
     USHORT hdr_size = ptr[0];
@@ -316,7 +417,13 @@ static inline NTSTATUS utf8_wcstombs_size( const WCHAR *src, unsigned int srclen
 
     for (len = 0; srclen; srclen--, src++)
     {
-        if (*src < 0x80) len++;  /* 0x00-0x7f: 1 byte */
+        if (*src < 0x80)  /* 0x00-0x7f: 1 byte */
+        {
+            val = get_ascii_lenW( src, srclen );
+            len += val;
+            src += val - 1;
+            srclen -= val - 1;
+        }
         else if (*src < 0x800) len += 2;  /* 0x80-0x7ff: 2 bytes */
         else
         {
@@ -348,7 +455,13 @@ static inline NTSTATUS utf8_mbstowcs_size( const char *src, unsigned int srclen,
     for (len = 0; src < srcend; len++)
     {
         unsigned char ch = *src++;
-        if (ch < 0x80) continue;
+        if (ch < 0x80)
+        {
+            res = get_ascii_len( src, srcend - src );
+            src += res;
+            len += res;
+            continue;
+        }
         if ((res = decode_utf8_char( ch, &src, srcend )) > 0x10ffff)
             status = STATUS_SOME_NOT_MAPPED;
         else
@@ -359,17 +472,26 @@ static inline NTSTATUS utf8_mbstowcs_size( const char *src, unsigned int srclen,
 }
 
 
-static inline unsigned int cp_mbstowcs( const CPTABLEINFO *info, WCHAR *dst, unsigned int dstlen,
+/* ascii is set when the table maps ASCII to itself, see cp_is_ascii_compatible() */
+static inline unsigned int cp_mbstowcs( const CPTABLEINFO *info, BOOL ascii, WCHAR *dst, unsigned int dstlen,
                                         const char *src, unsigned int srclen )
 {
-    unsigned int i, ret;
+    unsigned int i, len, ret;
 
     if (info->DBCSOffsets)
     {
         for (i = dstlen; srclen && i; i--, srclen--, src++, dst++)
         {
             USHORT off = info->DBCSOffsets[(unsigned char)*src];
-            if (off && srclen > 1)
+            if (ascii && !(*src & 0x80))
+            {
+                len = ascii_mbstowcs( dst, src, min( srclen, i ) ) - 1;
+                i -= len;
+                srclen -= len;
+                src += len;
+                dst += len;
+            }
+            else if (off && srclen > 1)
             {
                 src++;
                 srclen--;
@@ -382,16 +504,21 @@ static inline unsigned int cp_mbstowcs( const CPTABLEINFO *info, WCHAR *dst, uns
     else
     {
         ret = min( srclen, dstlen );
-        for (i = 0; i < ret; i++) dst[i] = info->MultiByteTable[(unsigned char)src[i]];
+        for (i = 0; i < ret; i++)
+        {
+            if (ascii && !(src[i] & 0x80)) i += ascii_mbstowcs( dst + i, src + i, ret - i ) - 1;
+            else dst[i] = info->MultiByteTable[(unsigned char)src[i]];
+        }
     }
     return ret;
 }
 
 
-static inline unsigned int cp_wcstombs( const CPTABLEINFO *info, char *dst, unsigned int dstlen,
+/* ascii is set when the table maps ASCII to itself, see cp_is_ascii_compatible() */
+static inline unsigned int cp_wcstombs( const CPTABLEINFO *info, BOOL ascii, char *dst, unsigned int dstlen,
                                         const WCHAR *src, unsigned int srclen )
 {
-    unsigned int i, ret;
+    unsigned int i, len, ret;
 
     if (info->DBCSCodePage)
     {
@@ -399,6 +526,16 @@ static inline unsigned int cp_wcstombs( const CPTABLEINFO *info, char *dst, unsi
 
         for (i = dstlen; srclen && i; i--, srclen--, src++)
         {
+            if (ascii && *src < 0x80)
+            {
+                len = ascii_wcstombs( dst, src, min( srclen, i ));
+                dst += len;
+                len--;
+                i -= len;
+                srclen -= len;
+                src += len;
+                continue;
+            }
             if (uni2cp[*src] & 0xff00)
             {
                 if (i == 1) break;  /* do not output a partial char */
@@ -413,7 +550,11 @@ static inline unsigned int cp_wcstombs( const CPTABLEINFO *info, char *dst, unsi
     {
         const char *uni2cp = info->WideCharTable;
         ret = min( srclen, dstlen );
-        for (i = 0; i < ret; i++) dst[i] = uni2cp[src[i]];
+        for (i = 0; i < ret; i++)
+        {
+            if (ascii && src[i] < 0x80) i += ascii_wcstombs( dst + i, src + i, ret - i ) - 1;
+            else dst[i] = uni2cp[src[i]];
+        }
     }
     return ret;
 }
@@ -429,12 +570,15 @@ static inline NTSTATUS utf8_mbstowcs( WCHAR *dst, unsigned int dstlen, unsigned
 
     while ((dst < dstend) && (src < srcend))
     {
-        unsigned char ch = *src++;
+        unsigned char ch = *src;
         if (ch < 0x80)  /* special fast case for 7-bit ASCII */
         {
-            *dst++ = ch;
+            res = ascii_mbstowcs( dst, src, min( srcend - src, dstend - dst ));
+            src += res;
+            dst += res;
             continue;
         }
+        src++;
         if ((res = decode_utf8_char( ch, &src, srcend )) <= 0xffff)
         {
             *dst++ = res;
@@ -472,7 +616,10 @@ static inline NTSTATUS utf8_wcstombs( char *dst, unsigned int dstlen, unsigned i
         if (ch < 0x80)  /* 0x00-0x7f: 1 byte */
         {
             if (dst > end - 1) break;
-            *dst++ = ch;
+            val = ascii_wcstombs( dst, src, min( srclen, end - dst ));
+            dst += val;
+            src += val - 1;
+            srclen -= val - 1;
             continue;
         }
         if (ch < 0x800)  /* 0x80-0x7ff: 2 bytes */
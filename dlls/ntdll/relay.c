@@ -23,6 +23,7 @@
 #include <string.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -63,10 +64,40 @@ struct relay_entry_point
     const char *name;         /* function name (if any) */
 };
 
+/* profile data, see RelayProfile and RelaySampleRate below */
+
+#define RELAY_HISTOGRAM_SIZE 20  /* log2 of the call duration in microseconds */
+#define RELAY_MAX_DEPTH      64
+
+struct relay_stats
+{
+    LONG64   calls;                             /* number of calls */
+    LONG64   timed;                             /* number of sampled calls that returned */
+    LONGLONG time;                              /* cumulative time of the timed calls */
+    LONG64   histogram[RELAY_HISTOGRAM_SIZE];   /* timed calls by duration */
+};
+
+struct relay_frame
+{
+    ULONG_PTR retaddr;                          /* return address of the call */
+    LONGLONG  start;                            /* counter at entry */
+    BOOL      sampled;                          /* whether the call is traced or timed */
+};
+
+struct relay_thread_data  /* stored in TEB->ReservedForPerf */
+{
+    unsigned int       depth;                   /* number of pending relayed calls */
+    unsigned int       count;                   /* calls since the last sampled one */
+    struct relay_frame frames[RELAY_MAX_DEPTH];
+};
+
 struct relay_private_data
 {
     HMODULE                  module;            /* module handle of this dll */
     unsigned int             base;              /* ordinal base */
+    unsigned int             count;             /* number of entry points */
+    struct relay_stats      *stats;             /* per entry point profile data */
+    struct relay_private_data *next;            /* next dll in the profile list */
     char                     dllname[40];       /* dll name (without .dll extension) */
     struct relay_entry_point entry_points[1];   /* list of dll entry points */
 };
@@ -82,6 +113,10 @@ static const WCHAR **debug_from_snoop_includelist;
 
 static RTL_RUN_ONCE init_once = RTL_RUN_ONCE_INIT;
 
+static BOOL relay_profile;                      /* collect statistics instead of tracing calls */
+static DWORD relay_sample_rate;                 /* only trace or time one call out of N */
+static struct relay_private_data *profile_dlls;
+
 /* compare an ASCII and a Unicode string without depending on the current codepage */
 static inline int strcmpAW( const char *strA, const WCHAR *strW )
 {
@@ -157,6 +192,27 @@ static const WCHAR **load_list( HKEY hkey, const WCHAR *value )
     return list;
 }
 
+/***********************************************************************
+ *           load_dword
+ *
+ * Load a numeric option from a registry value.
+ */
+static DWORD load_dword( HKEY hkey, const WCHAR *value )
+{
+    char buffer[offsetof(KEY_VALUE_PARTIAL_INFORMATION, Data[32 * sizeof(WCHAR)])];
+    KEY_VALUE_PARTIAL_INFORMATION *info = (KEY_VALUE_PARTIAL_INFORMATION *)buffer;
+    UNICODE_STRING name;
+    DWORD count;
+
+    RtlInitUnicodeString( &name, value );
+    if (NtQueryValueKey( hkey, &name, KeyValuePartialInformation, buffer, sizeof(buffer) - sizeof(WCHAR), &count ))
+        return 0;
+    if (info->Type == REG_DWORD && info->DataLength == sizeof(DWORD)) return *(DWORD *)info->Data;
+    if (info->Type != REG_SZ) return 0;
+    ((WCHAR *)info->Data)[info->DataLength / sizeof(WCHAR)] = 0;
+    return wcstoul( (WCHAR *)info->Data, NULL, 10 );
+}
+
 /***********************************************************************
  *           init_debug_lists
  *
@@ -190,6 +246,10 @@ static DWORD WINAPI init_debug_lists( RTL_RUN_ONCE *once, void *param, void **co
     debug_from_relay_excludelist = load_list( hkey, L"RelayFromExclude" );
     debug_from_snoop_includelist = load_list( hkey, L"SnoopFromInclude" );
     debug_from_snoop_excludelist = load_list( hkey, L"SnoopFromExclude" );
+    relay_profile = load_dword( hkey, L"RelayProfile" ) != 0;
+    relay_sample_rate = load_dword( hkey, L"RelaySampleRate" );
+    if (relay_profile || relay_sample_rate > 1)
+        TRACE( "profile %u sample rate %u\n", relay_profile, relay_sample_rate );
 
     NtClose( hkey );
     return TRUE;
@@ -291,6 +351,104 @@ static const char *func_name( struct relay_private_data *data, unsigned int ordi
         return wine_dbg_sprintf( "%s.%u", data->dllname, data->base + ordinal );
 }
 
+static struct relay_thread_data *get_relay_thread_data(void)
+{
+    struct relay_thread_data *thread_data = NtCurrentTeb()->ReservedForPerf;
+
+    /* calls from inside ntdll don't go through the relay thunks, so this can't recurse */
+    if (!thread_data)
+        NtCurrentTeb()->ReservedForPerf = thread_data = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                                                         sizeof(*thread_data) );
+    return thread_data;
+}
+
+/***********************************************************************
+ *           relay_sample
+ *
+ * Count a call and decide whether it should be traced or timed.
+ */
+static BOOL relay_sample( struct relay_private_data *data, unsigned int ordinal )
+{
+    struct relay_thread_data *thread_data;
+
+    if (data->stats) InterlockedIncrement64( &data->stats[ordinal].calls );
+    if (relay_sample_rate <= 1) return TRUE;
+    if (!(thread_data = get_relay_thread_data())) return FALSE;
+    if (++thread_data->count < relay_sample_rate) return FALSE;
+    thread_data->count = 0;
+    return TRUE;
+}
+
+/***********************************************************************
+ *           relay_push_frame
+ *
+ * Remember a call until it returns, right before calling the entry point.
+ */
+static void relay_push_frame( BOOL sampled, ULONG_PTR retaddr )
+{
+    struct relay_thread_data *thread_data;
+    struct relay_frame *frame;
+    LARGE_INTEGER counter;
+
+    if (!relay_profile && relay_sample_rate <= 1) return;
+    if (!(thread_data = get_relay_thread_data())) return;
+    if (thread_data->depth++ >= RELAY_MAX_DEPTH) return;
+
+    frame = &thread_data->frames[thread_data->depth - 1];
+    frame->retaddr = retaddr;
+    frame->sampled = sampled;
+    if (relay_profile && sampled)
+    {
+        RtlQueryPerformanceCounter( &counter );
+        frame->start = counter.QuadPart;
+    }
+}
+
+/***********************************************************************
+ *           relay_pop_frame
+ *
+ * Account for a returning call and tell whether it should be traced.
+ */
+static BOOL relay_pop_frame( struct relay_private_data *data, unsigned int ordinal, ULONG_PTR retaddr )
+{
+    struct relay_thread_data *thread_data = NtCurrentTeb()->ReservedForPerf;
+    struct relay_stats *stats;
+    struct relay_frame *frame;
+    LARGE_INTEGER counter, frequency;
+    LONGLONG elapsed, usecs;
+    unsigned int bucket;
+
+    if (!relay_profile && relay_sample_rate <= 1) return TRUE;
+    if (!thread_data || !thread_data->depth) return FALSE;
+    if (thread_data->depth > RELAY_MAX_DEPTH)
+    {
+        thread_data->depth--;
+        return FALSE;
+    }
+
+    /* frames above the matching one have been unwound by an exception */
+    for (frame = &thread_data->frames[thread_data->depth - 1]; frame >= thread_data->frames; frame--)
+        if (frame->retaddr == retaddr) break;
+    if (frame < thread_data->frames) return FALSE;
+    thread_data->depth = frame - thread_data->frames;
+
+    if (!frame->sampled) return FALSE;
+    if (!relay_profile) return TRUE;
+    if (!data->stats) return FALSE;
+
+    RtlQueryPerformanceCounter( &counter );
+    RtlQueryPerformanceFrequency( &frequency );
+    elapsed = counter.QuadPart - frame->start;
+    usecs = elapsed * 1000000 / frequency.QuadPart;
+    for (bucket = 0; bucket < RELAY_HISTOGRAM_SIZE - 1 && usecs >> bucket; bucket++);
+
+    stats = &data->stats[ordinal];
+    InterlockedIncrement64( &stats->timed );
+    InterlockedExchangeAdd64( &stats->time, elapsed );
+    InterlockedIncrement64( &stats->histogram[bucket] );
+    return FALSE;
+}
+
 static void trace_string_a( INT_PTR ptr )
 {
     if (!IS_INTARG( ptr )) TRACE( "%08Ix %s", ptr, debugstr_a( (char *)ptr ));
@@ -316,40 +474,45 @@ DECLSPEC_HIDDEN void * WINAPI relay_trace_entry( struct relay_descr *descr, unsi
     struct relay_private_data *data = descr->private;
     struct relay_entry_point *entry_point = data->entry_points + ordinal;
     unsigned int i, pos;
+    BOOL sampled = relay_sample( data, ordinal ), trace = sampled && !relay_profile;
 
-    TRACE( "\1Call %s(", func_name( data, ordinal ));
+    if (trace) TRACE( "\1Call %s(", func_name( data, ordinal ));
 
     for (i = pos = 0; !is_ret_val( arg_types[i] ); i++)
     {
         switch (arg_types[i])
         {
         case 'j': /* int64 */
-            TRACE( "%x%08x", stack[pos+1], stack[pos] );
+            if (trace) TRACE( "%x%08x", stack[pos+1], stack[pos] );
             pos += 2;
             break;
         case 'k': /* int128 */
-            TRACE( "{%08x,%08x,%08x,%08x}", stack[pos], stack[pos+1], stack[pos+2], stack[pos+3] );
+            if (trace) TRACE( "{%08x,%08x,%08x,%08x}", stack[pos], stack[pos+1], stack[pos+2], stack[pos+3] );
             pos += 4;
             break;
         case 's': /* str */
-            trace_string_a( stack[pos++] );
+            if (trace) trace_string_a( stack[pos] );
+            pos++;
             break;
         case 'w': /* wstr */
-            trace_string_w( stack[pos++] );
+            if (trace) trace_string_w( stack[pos] );
+            pos++;
             break;
         case 'f': /* float */
-            TRACE( "%g", *(const float *)&stack[pos++] );
+            if (trace) TRACE( "%g", *(const float *)&stack[pos] );
+            pos++;
             break;
         case 'd': /* double */
-            TRACE( "%g", *(const double *)&stack[pos] );
+            if (trace) TRACE( "%g", *(const double *)&stack[pos] );
             pos += 2;
             break;
         case 'i': /* long */
         default:
-            TRACE( "%08x", stack[pos++] );
+            if (trace) TRACE( "%08x", stack[pos] );
+            pos++;
             break;
         }
-        if (!is_ret_val( arg_types[i+1] )) TRACE( "," );
+        if (trace && !is_ret_val( arg_types[i+1] )) TRACE( "," );
     }
     *nb_args = pos;
     if (arg_types[0] == 't')
@@ -357,7 +520,8 @@ DECLSPEC_HIDDEN void * WINAPI relay_trace_entry( struct relay_descr *descr, unsi
         *nb_args |= 0x80000000;  /* thiscall/fastcall */
         if (arg_types[1] == 't') *nb_args |= 0x40000000;  /* fastcall */
     }
-    TRACE( ") ret=%08x\n", stack[-1] );
+    if (trace) TRACE( ") ret=%08x\n", stack[-1] );
+    relay_push_frame( sampled, stack[-1] );
     return entry_point->orig_func;
 }
 
@@ -369,6 +533,8 @@ DECLSPEC_HIDDEN void WINAPI relay_trace_exit( struct relay_descr *descr, unsigne
 {
     const char *arg_types = descr->args_string + HIWORD(idx);
 
+    if (!relay_pop_frame( descr->private, LOWORD(idx), (ULONG_PTR)retaddr )) return;
+
     TRACE( "\1Ret  %s()", func_name( descr->private, LOWORD(idx) ));
 
     while (!is_ret_val( *arg_types )) arg_types++;
@@ -455,12 +621,13 @@ DECLSPEC_HIDDEN void * WINAPI relay_trace_entry( struct relay_descr *descr, unsi
     struct relay_private_data *data = descr->private;
     struct relay_entry_point *entry_point = data->entry_points + ordinal;
     unsigned int i, pos;
+    BOOL sampled = relay_sample( data, ordinal ), trace = sampled && !relay_profile;
 #ifndef __SOFTFP__
     unsigned int float_pos = 0, double_pos = 0;
     const union fpregs { float s[16]; double d[8]; } *fpstack = (const union fpregs *)stack - 1;
 #endif
 
-    TRACE( "\1Call %s(", func_name( data, ordinal ));
+    if (trace) TRACE( "\1Call %s(", func_name( data, ordinal ));
 
     for (i = pos = 0; !is_ret_val( arg_types[i] ); i++)
     {
@@ -468,49 +635,55 @@ DECLSPEC_HIDDEN void * WINAPI relay_trace_entry( struct relay_descr *descr, unsi
         {
         case 'j': /* int64 */
             pos = (pos + 1) & ~1;
-            TRACE( "%x%08x", stack[pos+1], stack[pos] );
+            if (trace) TRACE( "%x%08x", stack[pos+1], stack[pos] );
             pos += 2;
             break;
         case 'k': /* int128 */
-            TRACE( "{%08x,%08x,%08x,%08x}", stack[pos], stack[pos+1], stack[pos+2], stack[pos+3] );
+            if (trace) TRACE( "{%08x,%08x,%08x,%08x}", stack[pos], stack[pos+1], stack[pos+2], stack[pos+3] );
             pos += 4;
             break;
         case 's': /* str */
-            trace_string_a( stack[pos++] );
+            if (trace) trace_string_a( stack[pos] );
+            pos++;
             break;
         case 'w': /* wstr */
-            trace_string_w( stack[pos++] );
+            if (trace) trace_string_w( stack[pos] );
+            pos++;
             break;
         case 'f': /* float */
 #ifndef __SOFTFP__
             if (!(float_pos % 2)) float_pos = max( float_pos, double_pos * 2 );
             if (float_pos < 16)
             {
-                TRACE( "%g", fpstack->s[float_pos++] );
+                if (trace) TRACE( "%g", fpstack->s[float_pos] );
+                float_pos++;
                 break;
             }
 #endif
-            TRACE( "%g", *(const float *)&stack[pos++] );
+            if (trace) TRACE( "%g", *(const float *)&stack[pos] );
+            pos++;
             break;
         case 'd': /* double */
 #ifndef __SOFTFP__
             double_pos = max( (float_pos + 1) / 2, double_pos );
             if (double_pos < 8)
             {
-                TRACE( "%g", fpstack->d[double_pos++] );
+                if (trace) TRACE( "%g", fpstack->d[double_pos] );
+                double_pos++;
                 break;
             }
 #endif
             pos = (pos + 1) & ~1;
-            TRACE( "%g", *(const double *)&stack[pos] );
+            if (trace) TRACE( "%g", *(const double *)&stack[pos] );
             pos += 2;
             break;
         case 'i': /* long */
         default:
-            TRACE( "%08x", stack[pos++] );
+            if (trace) TRACE( "%08x", stack[pos] );
+            pos++;
             break;
         }
-        if (!is_ret_val( arg_types[i+1] )) TRACE( "," );
+        if (trace && !is_ret_val( arg_types[i+1] )) TRACE( "," );
     }
 
 #ifndef __SOFTFP__
@@ -521,7 +694,8 @@ DECLSPEC_HIDDEN void * WINAPI relay_trace_entry( struct relay_descr *descr, unsi
     }
 #endif
     *nb_args = pos;
-    TRACE( ") ret=%08x\n", stack[-1] );
+    if (trace) TRACE( ") ret=%08x\n", stack[-1] );
+    relay_push_frame( sampled, stack[-1] );
     return entry_point->orig_func;
 }
 
@@ -533,6 +707,8 @@ DECLSPEC_HIDDEN void WINAPI relay_trace_exit( struct relay_descr *descr, unsigne
 {
     const char *arg_types = descr->args_string + HIWORD(idx);
 
+    if (!relay_pop_frame( descr->private, LOWORD(idx), (ULONG_PTR)retaddr )) return;
+
     TRACE( "\1Ret  %s()", func_name( descr->private, LOWORD(idx) ));
 
     while (!is_ret_val( *arg_types )) arg_types++;
@@ -609,28 +785,30 @@ DECLSPEC_HIDDEN void * WINAPI relay_trace_entry( struct relay_descr *descr, unsi
     struct relay_private_data *data = descr->private;
     struct relay_entry_point *entry_point = data->entry_points + ordinal;
     unsigned int i;
+    BOOL sampled = relay_sample( data, ordinal ), trace = sampled && !relay_profile;
 
-    TRACE( "\1Call %s(", func_name( data, ordinal ));
+    if (trace) TRACE( "\1Call %s(", func_name( data, ordinal ));
 
     for (i = 0; !is_ret_val( arg_types[i] ); i++)
     {
         switch (arg_types[i])
         {
         case 's': /* str */
-            trace_string_a( stack[i] );
+            if (trace) trace_string_a( stack[i] );
             break;
         case 'w': /* wstr */
-            trace_string_w( stack[i] );
+            if (trace) trace_string_w( stack[i] );
             break;
         case 'i': /* long */
         default:
-            TRACE( "%08zx", stack[i] );
+            if (trace) TRACE( "%08zx", stack[i] );
             break;
         }
-        if (!is_ret_val( arg_types[i + 1] )) TRACE( "," );
+        if (trace && !is_ret_val( arg_types[i + 1] )) TRACE( "," );
     }
     *nb_args = i;
-    TRACE( ") ret=%08zx\n", stack[-1] );
+    if (trace) TRACE( ") ret=%08zx\n", stack[-1] );
+    relay_push_frame( sampled, stack[-1] );
     return entry_point->orig_func;
 }
 
@@ -640,6 +818,8 @@ DECLSPEC_HIDDEN void * WINAPI relay_trace_entry( struct relay_descr *descr, unsi
 DECLSPEC_HIDDEN void WINAPI relay_trace_exit( struct relay_descr *descr, unsigned int idx,
                                               INT_PTR retaddr, INT_PTR retval )
 {
+    if (!relay_pop_frame( descr->private, LOWORD(idx), retaddr )) return;
+
     TRACE( "\1Ret  %s() retval=%08zx ret=%08zx\n",
            func_name( descr->private, LOWORD(idx) ), retval, retaddr );
 }
@@ -709,34 +889,36 @@ DECLSPEC_HIDDEN void * WINAPI relay_trace_entry( struct relay_descr *descr, unsi
     struct relay_private_data *data = descr->private;
     struct relay_entry_point *entry_point = data->entry_points + ordinal;
     unsigned int i;
+    BOOL sampled = relay_sample( data, ordinal ), trace = sampled && !relay_profile;
 
-    TRACE( "\1Call %s(", func_name( data, ordinal ));
+    if (trace) TRACE( "\1Call %s(", func_name( data, ordinal ));
 
     for (i = 0; !is_ret_val( arg_types[i] ); i++)
     {
         switch (arg_types[i])
         {
         case 's': /* str */
-            trace_string_a( stack[i] );
+            if (trace) trace_string_a( stack[i] );
             break;
         case 'w': /* wstr */
-            trace_string_w( stack[i] );
+            if (trace) trace_string_w( stack[i] );
             break;
         case 'f': /* float */
-            TRACE( "%g", *(const float *)&stack[i] );
+            if (trace) TRACE( "%g", *(const float *)&stack[i] );
             break;
         case 'd': /* double */
-            TRACE( "%g", *(const double *)&stack[i] );
+            if (trace) TRACE( "%g", *(const double *)&stack[i] );
             break;
         case 'i': /* long */
         default:
-            TRACE( "%08zx", stack[i] );
+            if (trace) TRACE( "%08zx", stack[i] );
             break;
         }
-        if (!is_ret_val( arg_types[i+1] )) TRACE( "," );
+        if (trace && !is_ret_val( arg_types[i+1] )) TRACE( "," );
     }
     *nb_args = i;
-    TRACE( ") ret=%08zx\n", stack[-1] );
+    if (trace) TRACE( ") ret=%08zx\n", stack[-1] );
+    relay_push_frame( sampled, stack[-1] );
     return entry_point->orig_func;
 }
 
@@ -746,6 +928,8 @@ DECLSPEC_HIDDEN void * WINAPI relay_trace_entry( struct relay_descr *descr, unsi
 DECLSPEC_HIDDEN void WINAPI relay_trace_exit( struct relay_descr *descr, unsigned int idx,
                                               INT_PTR retaddr, INT_PTR retval )
 {
+    if (!relay_pop_frame( descr->private, LOWORD(idx), retaddr )) return;
+
     TRACE( "\1Ret  %s() retval=%08zx ret=%08zx\n",
            func_name( descr->private, LOWORD(idx) ), retval, retaddr );
 }
@@ -895,6 +1079,15 @@ void RELAY_SetupDLL( HMODULE module )
 
     data->module = module;
     data->base   = exports->Base;
+    data->count  = exports->NumberOfFunctions;
+    if (relay_profile &&
+        (data->stats = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                        exports->NumberOfFunctions * sizeof(*data->stats) )))
+    {
+        /* the loader lock is held here */
+        data->next = profile_dlls;
+        profile_dlls = data;
+    }
     len = strlen( (char *)module + exports->Name );
     if (len > 4 && !_stricmp( (char *)module + exports->Name + len - 4, ".dll" )) len -= 4;
     len = min( len, sizeof(data->dllname) - 1 );
@@ -932,6 +1125,83 @@ void RELAY_SetupDLL( HMODULE module )
         NtProtectVirtualMemory( NtCurrentProcess(), &func_base, &func_size, old_prot, &old_prot );
 }
 
+
+struct relay_profile_entry
+{
+    struct relay_private_data *data;
+    unsigned int               ordinal;
+};
+
+static int __cdecl compare_profile_entries( const void *ptr1, const void *ptr2 )
+{
+    const struct relay_profile_entry *entry1 = ptr1, *entry2 = ptr2;
+    const struct relay_stats *stats1 = &entry1->data->stats[entry1->ordinal];
+    const struct relay_stats *stats2 = &entry2->data->stats[entry2->ordinal];
+
+    if (stats1->time != stats2->time) return stats1->time < stats2->time ? 1 : -1;
+    if (stats1->calls != stats2->calls) return stats1->calls < stats2->calls ? 1 : -1;
+    return 0;
+}
+
+/***********************************************************************
+ *           RELAY_DumpProfile
+ *
+ * Print the statistics collected with RelayProfile, most expensive calls first.
+ */
+void RELAY_DumpProfile(void)
+{
+    struct relay_profile_entry *entries;
+    struct relay_private_data *data;
+    LDR_DATA_TABLE_ENTRY *mod;
+    LARGE_INTEGER frequency;
+    unsigned int i, j, count = 0;
+    char histogram[RELAY_HISTOGRAM_SIZE * 32], *p;
+
+    if (!relay_profile || !profile_dlls) return;
+
+    for (data = profile_dlls; data; data = data->next)
+        for (i = 0; i < data->count; i++) if (data->stats[i].calls) count++;
+    if (!count) return;
+    if (!(entries = RtlAllocateHeap( GetProcessHeap(), 0, count * sizeof(*entries) ))) return;
+
+    count = 0;
+    for (data = profile_dlls; data; data = data->next)
+    {
+        /* names are stored in the module itself, don't use them once it's unloaded */
+        if (LdrFindEntryForAddress( data->module, &mod ) || mod->DllBase != data->module)
+            for (i = 0; i < data->count; i++) data->entry_points[i].name = NULL;
+
+        for (i = 0; i < data->count; i++)
+        {
+            if (!data->stats[i].calls) continue;
+            entries[count].data = data;
+            entries[count].ordinal = i;
+            count++;
+        }
+    }
+    qsort( entries, count, sizeof(*entries), compare_profile_entries );
+
+    RtlQueryPerformanceFrequency( &frequency );
+    MESSAGE( "wine: relay profile for process %04x\n", HandleToULong( NtCurrentTeb()->ClientId.UniqueProcess ));
+    MESSAGE( "      calls      timed   total ms    avg us  function  [histogram: <us:count]\n" );
+    for (i = 0; i < count; i++)
+    {
+        const struct relay_stats *stats = &entries[i].data->stats[entries[i].ordinal];
+        ULONGLONG total = stats->time * 1000000 / frequency.QuadPart;  /* in microseconds */
+
+        p = histogram;
+        for (j = 0; j < RELAY_HISTOGRAM_SIZE; j++)
+            if (stats->histogram[j]) p += sprintf( p, " %u:%I64d", 1u << j, stats->histogram[j] );
+        *p = 0;
+
+        /* ntdll's printf doesn't support floating point */
+        MESSAGE( "%11I64d %10I64d %6I64u.%03u %9I64u  %s %s\n", stats->calls, stats->timed,
+                 total / 1000, (UINT)(total % 1000), stats->timed ? total / stats->timed : 0,
+                 func_name( entries[i].data, entries[i].ordinal ), histogram );
+    }
+    RtlFreeHeap( GetProcessHeap(), 0, entries );
+}
+
 #else  /* __i386__ || __x86_64__ || __arm__ || __aarch64__ */
 
 FARPROC RELAY_GetProcAddress( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
@@ -944,6 +1214,10 @@ void RELAY_SetupDLL( HMODULE module )
 {
 }
 
+void RELAY_DumpProfile(void)
+{
+}
+
 #endif  /* __i386__ || __x86_64__ || __arm__ || __aarch64__ */
 
 
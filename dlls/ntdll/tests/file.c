@@ -5052,6 +5052,72 @@ static void test_ioctl(void)
     CloseHandle(file);
 }
 
+static void test_duplicate_extents(void)
+{
+    static const DWORD size = 0x10000;
+    char path[MAX_PATH], src_name[MAX_PATH], dst_name[MAX_PATH], *data, *buffer;
+    DUPLICATE_EXTENTS_DATA extents;
+    IO_STATUS_BLOCK io;
+    HANDLE src, dst;
+    NTSTATUS status;
+    DWORD i, len;
+    BOOL ret;
+
+    GetTempPathA(MAX_PATH, path);
+    GetTempFileNameA(path, "foo", 0, src_name);
+    GetTempFileNameA(path, "foo", 0, dst_name);
+    src = CreateFileA(src_name, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, 0, 0);
+    ok(src != INVALID_HANDLE_VALUE, "failed to create temp file, error %lu.\n", GetLastError());
+    dst = CreateFileA(dst_name, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, 0);
+    ok(dst != INVALID_HANDLE_VALUE, "failed to create temp file, error %lu.\n", GetLastError());
+
+    data = HeapAlloc(GetProcessHeap(), 0, size);
+    buffer = HeapAlloc(GetProcessHeap(), 0, size);
+    for (i = 0; i < size; i++) data[i] = i * 7 + (i >> 8);
+    ret = WriteFile(src, data, size, &len, NULL);
+    ok(ret && len == size, "WriteFile failed, error %lu.\n", GetLastError());
+
+    /* the target range has to exist already */
+    SetFilePointer(dst, size, NULL, FILE_BEGIN);
+    ret = SetEndOfFile(dst);
+    ok(ret, "SetEndOfFile failed, error %lu.\n", GetLastError());
+
+    memset(&extents, 0, sizeof(extents));
+    extents.FileHandle = src;
+    extents.ByteCount.QuadPart = size;
+    status = pNtFsControlFile(dst, NULL, NULL, NULL, &io, FSCTL_DUPLICATE_EXTENTS_TO_FILE,
+                              &extents, sizeof(extents), NULL, 0);
+    if (status == STATUS_INVALID_DEVICE_REQUEST || status == STATUS_NOT_SUPPORTED)
+    {
+        skip("FSCTL_DUPLICATE_EXTENTS_TO_FILE is not supported, status %#lx.\n", status);
+        goto done;
+    }
+    ok(status == STATUS_SUCCESS, "got %#lx.\n", status);
+    ok(io.Status == STATUS_SUCCESS, "got io.Status %#lx.\n", io.Status);
+
+    SetFilePointer(dst, 0, NULL, FILE_BEGIN);
+    ret = ReadFile(dst, buffer, size, &len, NULL);
+    ok(ret && len == size, "ReadFile failed, error %lu.\n", GetLastError());
+    ok(!memcmp(buffer, data, size), "got wrong data.\n");
+
+    status = pNtFsControlFile(dst, NULL, NULL, NULL, &io, FSCTL_DUPLICATE_EXTENTS_TO_FILE,
+                              &extents, sizeof(extents) - 1, NULL, 0);
+    ok(status == STATUS_INVALID_PARAMETER, "got %#lx.\n", status);
+
+    extents.FileHandle = (HANDLE)0xdeadbeef;
+    status = pNtFsControlFile(dst, NULL, NULL, NULL, &io, FSCTL_DUPLICATE_EXTENTS_TO_FILE,
+                              &extents, sizeof(extents), NULL, 0);
+    ok(status == STATUS_INVALID_HANDLE, "got %#lx.\n", status);
+
+done:
+    HeapFree(GetProcessHeap(), 0, buffer);
+    HeapFree(GetProcessHeap(), 0, data);
+    CloseHandle(dst);
+    CloseHandle(src);
+    DeleteFileA(dst_name);
+    DeleteFileA(src_name);
+}
+
 static void test_flush_buffers_file(void)
 {
     char path[MAX_PATH], buffer[MAX_PATH];
@@ -5320,6 +5386,7 @@ START_TEST(file)
     test_query_volume_information_file();
     test_query_attribute_information_file();
     test_ioctl();
+    test_duplicate_extents();
     test_flush_buffers_file();
     test_mailslot_name();
 }
@@ -216,6 +216,87 @@ static void test_RtlQueryPerformanceCounter(void)
 }
 #endif
 
+static LONG64 qpc_latest;
+static LONG qpc_errors;
+
+static DWORD WINAPI qpc_monotonic_thread( void *arg )
+{
+    LARGE_INTEGER counter, prev;
+    LONG64 latest;
+    unsigned int i;
+
+    pRtlQueryPerformanceCounter( &prev );
+    for (i = 0; i < 100000; i++)
+    {
+        /* a value published by another thread must never be ahead of ours */
+        latest = InterlockedCompareExchange64( &qpc_latest, 0, 0 );
+        pRtlQueryPerformanceCounter( &counter );
+        if (counter.QuadPart < prev.QuadPart || counter.QuadPart < latest) InterlockedIncrement( &qpc_errors );
+        prev = counter;
+
+        while (latest < counter.QuadPart)
+        {
+            LONG64 old = InterlockedCompareExchange64( &qpc_latest, counter.QuadPart, latest );
+            if (old == latest) break;
+            latest = old;
+        }
+    }
+    return 0;
+}
+
+static void test_RtlQueryPerformanceCounter_monotonic(void)
+{
+    LARGE_INTEGER frequency, nt_frequency, counter0, counter1, nt_counter0, nt_counter1;
+    double elapsed, nt_elapsed;
+    HANDLE threads[8];
+    SYSTEM_INFO info;
+    unsigned int i, count;
+
+    if (!pRtlQueryPerformanceCounter || !pRtlQueryPerformanceFrequency)
+    {
+        win_skip( "RtlQueryPerformanceCounter/Frequency not available, skipping tests\n" );
+        return;
+    }
+
+    /* spread the threads over the processors to catch unsynchronized counters */
+    GetSystemInfo( &info );
+    count = min( ARRAY_SIZE(threads), max( info.dwNumberOfProcessors, 2 ) );
+    for (i = 0; i < count; i++)
+    {
+        threads[i] = CreateThread( NULL, 0, qpc_monotonic_thread, NULL, CREATE_SUSPENDED, NULL );
+        ok( threads[i] != NULL, "CreateThread failed, error %lu\n", GetLastError() );
+        SetThreadAffinityMask( threads[i], (DWORD_PTR)1 << (i % min( info.dwNumberOfProcessors, sizeof(DWORD_PTR) * 8 )) );
+        ResumeThread( threads[i] );
+    }
+    WaitForMultipleObjects( count, threads, TRUE, INFINITE );
+    for (i = 0; i < count; i++) CloseHandle( threads[i] );
+    ok( !qpc_errors, "RtlQueryPerformanceCounter went backwards %ld times\n", qpc_errors );
+
+    /* the counter must advance at the advertised frequency */
+    pRtlQueryPerformanceFrequency( &frequency );
+    pNtQueryPerformanceCounter( &nt_counter0, &nt_frequency );
+    pRtlQueryPerformanceCounter( &counter0 );
+    Sleep( 200 );
+    pRtlQueryPerformanceCounter( &counter1 );
+    pNtQueryPerformanceCounter( &nt_counter1, &nt_frequency );
+
+    elapsed = (double)(counter1.QuadPart - counter0.QuadPart) / frequency.QuadPart;
+    nt_elapsed = (double)(nt_counter1.QuadPart - nt_counter0.QuadPart) / nt_frequency.QuadPart;
+    ok( elapsed > nt_elapsed * 0.99 && elapsed < nt_elapsed * 1.01,
+        "RtlQueryPerformanceCounter measured %f s, NtQueryPerformanceCounter %f s\n", elapsed, nt_elapsed );
+
+    /* both counters use the same timebase, values from one can be compared to the other */
+    ok( frequency.QuadPart == nt_frequency.QuadPart,
+        "RtlQueryPerformanceFrequency returned %I64d, NtQueryPerformanceCounter %I64d\n",
+        frequency.QuadPart, nt_frequency.QuadPart );
+    pNtQueryPerformanceCounter( &nt_counter0, NULL );
+    pRtlQueryPerformanceCounter( &counter0 );
+    pNtQueryPerformanceCounter( &nt_counter1, NULL );
+    ok( nt_counter0.QuadPart <= counter0.QuadPart && counter0.QuadPart <= nt_counter1.QuadPart,
+        "RtlQueryPerformanceCounter %I64d not between NtQueryPerformanceCounter %I64d and %I64d\n",
+        counter0.QuadPart, nt_counter0.QuadPart, nt_counter1.QuadPart );
+}
+
 #define TIMER_LEEWAY 10
 #define CHECK_CURRENT_TIMER(expected) \
     do { \
@@ -499,5 +580,6 @@ START_TEST(time)
 #if defined(__i386__) || defined(__x86_64__)
     test_RtlQueryPerformanceCounter();
 #endif
+    test_RtlQueryPerformanceCounter_monotonic();
     test_TimerResolution();
 }
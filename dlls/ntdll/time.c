@@ -380,6 +380,25 @@ LONGLONG WINAPI RtlGetSystemTimePrecise( void )
  */
 BOOL WINAPI DECLSPEC_HOTPATCH RtlQueryPerformanceCounter( LARGE_INTEGER *counter )
 {
+#if defined(__i386__) || defined(__x86_64__)
+    UCHAR flags = user_shared_data->u3.QpcBypassEnabled;
+    ULONG low, high, aux;
+
+    /* the TSC is invariant and calibrated by wineboot, avoid the system call */
+    if (flags & SHARED_GLOBAL_FLAGS_QPC_BYPASS_ENABLED)
+    {
+        if (flags & SHARED_GLOBAL_FLAGS_QPC_BYPASS_USE_RDTSCP)
+            __asm__ __volatile__( "rdtscp" : "=a" (low), "=d" (high), "=c" (aux) );
+        else
+        {
+            if (flags & SHARED_GLOBAL_FLAGS_QPC_BYPASS_USE_LFENCE) __asm__ __volatile__( "lfence" : : : "memory" );
+            if (flags & SHARED_GLOBAL_FLAGS_QPC_BYPASS_USE_MFENCE) __asm__ __volatile__( "mfence" : : : "memory" );
+            __asm__ __volatile__( "rdtsc" : "=a" (low), "=d" (high) );
+        }
+        counter->QuadPart = (((ULONGLONG)high << 32 | low) + user_shared_data->QpcBias) >> user_shared_data->u3.QpcShift;
+        return TRUE;
+    }
+#endif
     NtQueryPerformanceCounter( counter, NULL );
     return TRUE;
 }
@@ -389,6 +408,13 @@ BOOL WINAPI DECLSPEC_HOTPATCH RtlQueryPerformanceCounter( LARGE_INTEGER *counter
  */
 BOOL WINAPI DECLSPEC_HOTPATCH RtlQueryPerformanceFrequency( LARGE_INTEGER *frequency )
 {
+#if defined(__i386__) || defined(__x86_64__)
+    if (user_shared_data->u3.QpcBypassEnabled & SHARED_GLOBAL_FLAGS_QPC_BYPASS_ENABLED)
+    {
+        frequency->QuadPart = user_shared_data->QpcFrequency;
+        return TRUE;
+    }
+#endif
     frequency->QuadPart = TICKSPERSEC;
     return TRUE;
 }
@@ -25,13 +25,19 @@
 #include "config.h"
 
 #include <assert.h>
+#include <errno.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <signal.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include "ntstatus.h"
@@ -42,6 +48,8 @@
 #include "unix_private.h"
 #include "wine/debug.h"
 
+WINE_DECLARE_DEBUG_CHANNEL(async);
+WINE_DECLARE_DEBUG_CHANNEL(binlog);
 WINE_DECLARE_DEBUG_CHANNEL(pid);
 WINE_DECLARE_DEBUG_CHANNEL(timestamp);
 WINE_DEFAULT_DEBUG_CHANNEL(ntdll);
@@ -65,6 +73,39 @@ static struct __wine_debug_channel *debug_options;
 
 static const char * const debug_classes[] = { "fixme", "err", "warn", "trace" };
 
+/* with +async or +binlog, lines are queued in a ring buffer shared by all threads
+ * and written out by a background thread. Writers reserve space by moving the head
+ * forward, and publish a record by setting its size once it has been filled. */
+#define RING_SIZE      0x400000  /* must be a power of two */
+#define DRAIN_SIZE     0x10000
+#define STALL_TIMEOUT  1         /* in seconds */
+
+struct ring_record
+{
+    unsigned int size;    /* size of the record including the header, zero until complete */
+    unsigned int len;     /* length of the data following the header */
+};
+
+/* with +binlog, each line is preceded by this header, see tools/winedbglog */
+#define BINLOG_MAGIC   0x474c4257  /* "WBLG" */
+
+struct binlog_header
+{
+    unsigned int magic;
+    unsigned int len;     /* length of the text following the header */
+    unsigned int pid;
+    unsigned int tid;
+    ULONGLONG    time;    /* monotonic time in nanoseconds */
+};
+
+static char *ring;
+static unsigned int ring_head;  /* end of the reserved space */
+static unsigned int ring_tail;  /* start of the records not written out yet */
+static int ring_sleeping;
+static int ring_stalled;  /* a writer never completed its record, lines are written directly */
+static int ring_pipe[2] = { -1, -1 };  /* wakes up the background thread, writable from signal handlers */
+static pthread_mutex_t drain_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 /* get the debug info pointer for the current thread */
 static inline struct debug_info *get_info(void)
 {
@@ -81,6 +122,7 @@ static int append_output( struct debug_info *info, const char *str, size_t len )
 {
     if (len >= sizeof(info->output) - info->out_pos)
     {
+        dbg_flush();
        fprintf( stderr, "wine_dbg_output: debugstr buffer overflow (contents: '%s')\n", info->output );
        info->out_pos = 0;
        abort();
@@ -128,6 +170,22 @@ static void add_option( const char *name, unsigned char set, unsigned char clear
     nb_debug_options++;
 }
 
+/* add a disabled option for a channel, unless it was explicitly specified */
+static void add_explicit_option( const char *name )
+{
+    int min = 0, max = nb_debug_options - 1, pos, res;
+
+    while (min <= max)
+    {
+        pos = (min + max) / 2;
+        res = strcmp( name, debug_options[pos].name );
+        if (!res) return;
+        if (res < 0) max = pos - 1;
+        else min = pos + 1;
+    }
+    add_option( name, 0, ~0 );
+}
+
 /* parse a set of debugging option specifications and add them to the option list */
 static void parse_options( const char *str )
 {
@@ -185,7 +243,9 @@ static void debug_usage(void)
         "  WINEDEBUG=[class]+xxx,[class]-yyy,...\n\n"
         "Example: WINEDEBUG=+relay,warn-heap\n"
         "    turns on relay traces, disable heap warnings\n"
-        "Available message classes: err, warn, fixme, trace\n";
+        "Available message classes: err, warn, fixme, trace\n"
+        "Output modes: +async writes messages from a background thread,\n"
+        "    +binlog writes binary records to be decoded by tools/winedbglog\n";
     write( 2, usage, sizeof(usage) - 1 );
     exit(1);
 }
@@ -209,6 +269,250 @@ static void init_options(void)
     if (!wine_debug) return;
     if (!strcmp( wine_debug, "help" )) debug_usage();
     parse_options( wine_debug );
+
+    /* the output modes change the log format, don't let "all" turn them on */
+    add_explicit_option( "async" );
+    add_explicit_option( "binlog" );
+}
+
+/* write a block of data to stderr */
+static void write_all( const char *data, size_t len )
+{
+    ssize_t ret;
+
+    while (len)
+    {
+        if ((ret = write( 2, data, len )) < 0)
+        {
+            if (errno == EINTR) continue;
+            return;
+        }
+        data += ret;
+        len -= ret;
+    }
+}
+
+/* copy data into the ring buffer, wrapping around at the end */
+static void ring_copy_to( unsigned int pos, const void *data, unsigned int len )
+{
+    unsigned int offset = pos & (RING_SIZE - 1), count = min( len, RING_SIZE - offset );
+
+    memcpy( ring + offset, data, count );
+    memcpy( ring, (const char *)data + count, len - count );
+}
+
+/* copy data out of the ring buffer, or clear it for the next records if data is NULL */
+static void ring_copy_from( unsigned int pos, void *data, unsigned int len )
+{
+    unsigned int offset = pos & (RING_SIZE - 1), count = min( len, RING_SIZE - offset );
+
+    if (data)
+    {
+        memcpy( data, ring + offset, count );
+        memcpy( (char *)data + count, ring, len - count );
+    }
+    else
+    {
+        memset( ring + offset, 0, count );
+        memset( ring, 0, len - count );
+    }
+}
+
+static inline struct ring_record *get_ring_record( unsigned int pos )
+{
+    return (struct ring_record *)(ring + (pos & (RING_SIZE - 1)));
+}
+
+/* write out all the complete records; must be called with drain_mutex held */
+static unsigned int ring_drain(void)
+{
+    static char buffer[DRAIN_SIZE];
+    unsigned int tail = ring_tail, pos = 0, count = 0;
+    struct ring_record *record;
+    unsigned int size;
+
+    while ((size = __atomic_load_n( &(record = get_ring_record( tail ))->size, __ATOMIC_ACQUIRE )))
+    {
+        unsigned int len = record->len;
+
+        if (pos + len > sizeof(buffer))
+        {
+            write_all( buffer, pos );
+            pos = 0;
+        }
+        ring_copy_from( tail + sizeof(*record), buffer + pos, len );
+        ring_copy_from( tail, NULL, size );
+        pos += len;
+        tail += size;
+        __atomic_store_n( &ring_tail, tail, __ATOMIC_RELEASE );
+        count++;
+    }
+    write_all( buffer, pos );
+    return count;
+}
+
+/* turn off the binary log once lines can't be queued anymore, so that
+ * the line headers include the thread ids again */
+static void disable_binlog(void)
+{
+    int i;
+
+    for (i = 0; i < nb_debug_options; i++)
+    {
+        if (strcmp( debug_options[i].name, "binlog" )) continue;
+        __atomic_store_n( &debug_options[i].flags, 0, __ATOMIC_RELEASE );
+        break;
+    }
+}
+
+/* background thread writing out the queued lines */
+static void *ring_thread( void *arg )
+{
+    struct pollfd pfd = { ring_pipe[0], POLLIN };
+    struct timespec now, stall_time = { 0 };
+    unsigned int stall_tail = 0;
+    char buf[64];
+
+    for (;;)
+    {
+        unsigned int tail;
+
+        pthread_mutex_lock( &drain_mutex );
+        ring_drain();
+        pthread_mutex_unlock( &drain_mutex );
+
+        /* a writer killed before completing its record would block the ring forever,
+         * so once the oldest reservation stays incomplete for too long, stop queueing */
+        tail = __atomic_load_n( &ring_tail, __ATOMIC_ACQUIRE );
+        clock_gettime( CLOCK_MONOTONIC, &now );
+        if (tail == __atomic_load_n( &ring_head, __ATOMIC_ACQUIRE ) || tail != stall_tail)
+        {
+            stall_tail = tail;
+            stall_time = now;
+        }
+        else if (now.tv_sec - stall_time.tv_sec > STALL_TIMEOUT &&
+                 !__atomic_load_n( &ring_stalled, __ATOMIC_ACQUIRE ))
+        {
+            __atomic_store_n( &ring_stalled, 1, __ATOMIC_RELEASE );
+            disable_binlog();
+        }
+
+        __atomic_store_n( &ring_sleeping, 1, __ATOMIC_SEQ_CST );
+        if (!__atomic_load_n( &get_ring_record( ring_tail )->size, __ATOMIC_SEQ_CST ))
+            poll( &pfd, 1, 50 );
+        __atomic_store_n( &ring_sleeping, 0, __ATOMIC_SEQ_CST );
+        while (read( ring_pipe[0], buf, sizeof(buf) ) > 0) /* nothing */;
+    }
+    return NULL;
+}
+
+/* only uses async-signal-safe calls, debug output is also written from signal handlers */
+static void wake_ring_thread(void)
+{
+    int err = errno;
+    char c = 0;
+
+    write( ring_pipe[1], &c, 1 );  /* if the pipe is full, the thread is being woken up already */
+    errno = err;
+}
+
+/* set up the ring buffer and its thread, called once at startup */
+static void init_ring(void)
+{
+    sigset_t block_set, old_set;
+    pthread_t thread;
+
+#ifdef HAVE_PIPE2
+    if (pipe2( ring_pipe, O_CLOEXEC | O_NONBLOCK ) == -1)
+#endif
+    {
+        if (pipe( ring_pipe ) == -1) return;
+        fcntl( ring_pipe[0], F_SETFD, FD_CLOEXEC );
+        fcntl( ring_pipe[1], F_SETFD, FD_CLOEXEC );
+        fcntl( ring_pipe[0], F_SETFL, O_NONBLOCK );
+        fcntl( ring_pipe[1], F_SETFL, O_NONBLOCK );
+    }
+    if (!(ring = calloc( 1, RING_SIZE ))) goto failed;
+
+    /* the writer thread is not a Win32 thread, it must not get any of our signals */
+    sigfillset( &block_set );
+    pthread_sigmask( SIG_SETMASK, &block_set, &old_set );
+    if (!pthread_create( &thread, NULL, ring_thread, NULL ))
+    {
+        pthread_detach( thread );
+        pthread_sigmask( SIG_SETMASK, &old_set, NULL );
+        return;
+    }
+    pthread_sigmask( SIG_SETMASK, &old_set, NULL );
+    free( ring );
+    ring = NULL;
+
+failed:
+    close( ring_pipe[0] );
+    close( ring_pipe[1] );
+    ring_pipe[0] = ring_pipe[1] = -1;
+}
+
+/* queue a line for the background thread */
+static BOOL ring_write( const char *str, unsigned int len, BOOL with_header )
+{
+    struct binlog_header binlog;
+    struct ring_record *record;
+    unsigned int extra = with_header ? sizeof(binlog) : 0;
+    unsigned int size = (sizeof(*record) + extra + len + 7) & ~7;
+    unsigned int head;
+
+    if (__atomic_load_n( &ring_stalled, __ATOMIC_ACQUIRE )) return FALSE;
+
+    if (extra)
+    {
+        struct timespec ts;
+
+        clock_gettime( CLOCK_MONOTONIC, &ts );
+        binlog.magic = BINLOG_MAGIC;
+        binlog.len   = len;
+        binlog.pid   = GetCurrentProcessId();
+        binlog.tid   = GetCurrentThreadId();
+        binlog.time  = ts.tv_sec * (ULONGLONG)1000000000 + ts.tv_nsec;
+    }
+
+    head = __atomic_load_n( &ring_head, __ATOMIC_RELAXED );
+    for (;;)
+    {
+        if (head + size - __atomic_load_n( &ring_tail, __ATOMIC_ACQUIRE ) > RING_SIZE)
+        {
+            /* full, wait for the background thread to catch up */
+            if (__atomic_load_n( &ring_stalled, __ATOMIC_ACQUIRE )) return FALSE;
+            wake_ring_thread();
+            sched_yield();
+            head = __atomic_load_n( &ring_head, __ATOMIC_RELAXED );
+            continue;
+        }
+        if (__atomic_compare_exchange_n( &ring_head, &head, head + size, TRUE,
+                                         __ATOMIC_ACQUIRE, __ATOMIC_RELAXED )) break;
+    }
+
+    record = get_ring_record( head );
+    record->len = extra + len;
+    if (extra) ring_copy_to( head + sizeof(*record), &binlog, extra );
+    ring_copy_to( head + sizeof(*record) + extra, str, len );
+    __atomic_store_n( &record->size, size, __ATOMIC_SEQ_CST );
+
+    if (__atomic_load_n( &ring_sleeping, __ATOMIC_SEQ_CST )) wake_ring_thread();
+    return TRUE;
+}
+
+/***********************************************************************
+ *		dbg_flush
+ *
+ * Write out the queued lines before the process exits.
+ */
+void dbg_flush(void)
+{
+    if (!ring) return;
+    pthread_mutex_lock( &drain_mutex );
+    ring_drain();
+    pthread_mutex_unlock( &drain_mutex );
 }
 
 /***********************************************************************
@@ -252,11 +556,38 @@ const char * __cdecl __wine_dbg_strdup( const char *str )
     return memcpy( info->strings + pos, str, n );
 }
 
+/* write a line directly that was formatted without the thread ids for the binary log */
+static int write_with_ids( const char *str, unsigned int len )
+{
+    char prefix[32];
+    struct iovec iov[2];
+    int ret, pos = 0;
+
+    if (TRACE_ON(pid)) pos += sprintf( prefix + pos, "%04x:", GetCurrentProcessId() );
+    pos += sprintf( prefix + pos, "%04x:", GetCurrentThreadId() );
+    iov[0].iov_base = prefix;
+    iov[0].iov_len  = pos;
+    iov[1].iov_base = (void *)str;
+    iov[1].iov_len  = len;
+    if ((ret = writev( 2, iov, 2 )) < 0) return ret;
+    return max( ret - pos, 0 );
+}
+
 /***********************************************************************
  *		__wine_dbg_write  (NTDLL.@)
  */
 int WINAPI __wine_dbg_write( const char *str, unsigned int len )
 {
+    BOOL binlog;
+
+    if (!init_done || !ring) return write( 2, str, len );
+    binlog = TRACE_ON(binlog);
+    if (!binlog && !TRACE_ON(async)) return write( 2, str, len );
+    /* only parts of overlong lines can be this large, they don't have a header anyway */
+    if (len > DRAIN_SIZE - sizeof(struct binlog_header)) return write( 2, str, len );
+    if (ring_write( str, len, binlog )) return len;
+    /* the header was left out because the line was meant for the ring */
+    if (binlog) return write_with_ids( str, len );
     return write( 2, str, len );
 }
 
@@ -295,7 +626,9 @@ int __cdecl __wine_dbg_header( enum __wine_debug_class cls, struct __wine_debug_
     /* only print header if we are at the beginning of the line */
     if (info->out_pos) return 0;
 
-    if (init_done)
+    /* the binary log header already contains the timestamp and ids; binlog is
+     * turned off again when lines can't be queued, see disable_binlog() */
+    if (init_done && !(ring && TRACE_ON(binlog)))
     {
         if (TRACE_ON(timestamp))
         {
@@ -330,6 +663,10 @@ void dbg_init(void)
     debug_options = options;
     options[nb_debug_options] = default_option;
     init_done = TRUE;
+
+    /* not done lazily, the first lines may be written from a signal handler */
+    if (TRACE_ON(async) || TRACE_ON(binlog)) init_ring();
+    if (!ring) disable_binlog();
 }
 
 
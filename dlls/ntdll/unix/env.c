@@ -84,6 +84,7 @@ const WCHAR system_dir[] = {'\\','?','?','\\','C',':','\\','w','i','n','d','o','
                             's','y','s','t','e','m','3','2','\\',0};
 
 static CPTABLEINFO unix_cp = { CP_UTF8, 4, '?', 0xfffd, '?', '?' };
+static BOOL unix_cp_is_ascii;  /* the Unix code page maps ASCII to itself */
 
 static char *get_nls_file_path( ULONG type, ULONG id )
 {
@@ -306,7 +307,11 @@ static void init_unix_codepage(void)
                 void *data;
 
                 sprintf( buffer, "c_%03u.nls", charset_names[pos].cp );
-                if ((data = read_nls_file( buffer ))) init_codepage_table( data, &unix_cp );
+                if ((data = read_nls_file( buffer )))
+                {
+                    init_codepage_table( data, &unix_cp );
+                    unix_cp_is_ascii = cp_is_ascii_compatible( &unix_cp );
+                }
             }
             return;
         }
@@ -377,7 +382,8 @@ DWORD ntdll_umbstowcs( const char *src, DWORD srclen, WCHAR *dst, DWORD dstlen )
 {
     unsigned int reslen;
 
-    if (unix_cp.CodePage != CP_UTF8) return cp_mbstowcs( &unix_cp, dst, dstlen, src, srclen );
+    if (unix_cp.CodePage != CP_UTF8)
+        return cp_mbstowcs( &unix_cp, unix_cp_is_ascii, dst, dstlen, src, srclen );
 
     utf8_mbstowcs( dst, dstlen, &reslen, src, srclen );
 #ifdef __APPLE__  /* work around broken Mac OS X filesystem that enforces NFD */
@@ -425,7 +431,7 @@ int ntdll_wcstoumbs( const WCHAR *src, DWORD srclen, char *dst, DWORD dstlen, BO
                         return -1;
             }
         }
-        reslen = cp_wcstombs( &unix_cp, dst, dstlen, src, srclen );
+        reslen = cp_wcstombs( &unix_cp, unix_cp_is_ascii, dst, dstlen, src, srclen );
     }
     else
     {
@@ -2315,7 +2321,7 @@ void WINAPI RtlInitCodePageTable( USHORT *ptr, CPTABLEINFO *info )
 NTSTATUS WINAPI RtlCustomCPToUnicodeN( CPTABLEINFO *info, WCHAR *dst, DWORD dstlen, DWORD *reslen,
                                        const char *src, DWORD srclen )
 {
-    unsigned int ret = cp_mbstowcs( info, dst, dstlen / sizeof(WCHAR), src, srclen );
+    unsigned int ret = cp_mbstowcs( info, FALSE, dst, dstlen / sizeof(WCHAR), src, srclen );
     if (reslen) *reslen = ret * sizeof(WCHAR);
     return STATUS_SUCCESS;
 }
@@ -2326,7 +2332,7 @@ NTSTATUS WINAPI RtlCustomCPToUnicodeN( CPTABLEINFO *info, WCHAR *dst, DWORD dstl
 NTSTATUS WINAPI RtlUnicodeToCustomCPN( CPTABLEINFO *info, char *dst, DWORD dstlen, DWORD *reslen,
                                        const WCHAR *src, DWORD srclen )
 {
-    unsigned int ret = cp_wcstombs( info, dst, dstlen, src, srclen / sizeof(WCHAR) );
+    unsigned int ret = cp_wcstombs( info, FALSE, dst, dstlen, src, srclen / sizeof(WCHAR) );
     if (reslen) *reslen = ret;
     return STATUS_SUCCESS;
 }
@@ -156,6 +156,18 @@ typedef struct
 #define AT_NO_AUTOMOUNT 0x800
 #endif
 
+/* Define the btrfs/xfs ioctl to share extents between files */
+#ifndef FICLONERANGE
+struct file_clone_range
+{
+    LONGLONG  src_fd;
+    ULONGLONG src_offset;
+    ULONGLONG src_length;
+    ULONGLONG dest_offset;
+};
+#define FICLONERANGE _IOW(0x94, 13, struct file_clone_range)
+#endif
+
 #endif  /* linux */
 
 #define IS_SEPARATOR(ch)   ((ch) == '\\' || (ch) == '/')
@@ -5756,6 +5768,46 @@ NTSTATUS WINAPI NtDeviceIoControlFile( HANDLE handle, HANDLE event, PIO_APC_ROUT
 }
 
 
+/* share the extents of a file range with another file, or copy them in the kernel */
+static NTSTATUS duplicate_extents( int src_fd, int dst_fd, const DUPLICATE_EXTENTS_DATA *data )
+{
+#ifdef linux
+    struct file_clone_range range;
+    LONGLONG src_offset = data->SourceFileOffset.QuadPart;
+    LONGLONG dst_offset = data->TargetFileOffset.QuadPart;
+    ULONGLONG count = data->ByteCount.QuadPart;
+
+    range.src_fd      = src_fd;
+    range.src_offset  = src_offset;
+    range.src_length  = count;
+    range.dest_offset = dst_offset;
+    if (!ioctl( dst_fd, FICLONERANGE, &range ))
+    {
+        TRACE( "cloned %s bytes\n", wine_dbgstr_longlong(count) );
+        return STATUS_SUCCESS;
+    }
+    TRACE( "FICLONERANGE failed: %s\n", strerror(errno) );
+
+#ifdef __NR_copy_file_range
+    /* copy_file_range() also shares extents on filesystems supporting it,
+     * and otherwise at least avoids copying the data through user space */
+    while (count)
+    {
+        ssize_t ret = syscall( __NR_copy_file_range, src_fd, &src_offset, dst_fd, &dst_offset, count, 0 );
+        if (ret <= 0)
+        {
+            TRACE( "copy_file_range failed: %s\n", ret ? strerror(errno) : "unexpected end of file" );
+            return STATUS_NOT_SUPPORTED;
+        }
+        count -= ret;
+    }
+    return STATUS_SUCCESS;
+#endif
+#endif
+    return STATUS_NOT_SUPPORTED;
+}
+
+
 /* Tell Valgrind to ignore any holes in structs we will be passing to the
  * server */
 static void ignore_server_ioctl_struct_holes( ULONG code, const void *in_buffer, ULONG in_size )
@@ -5862,6 +5914,27 @@ NTSTATUS WINAPI NtFsControlFile( HANDLE handle, HANDLE event, PIO_APC_ROUTINE ap
         break;
     }
 
+    case FSCTL_DUPLICATE_EXTENTS_TO_FILE:
+    {
+        const DUPLICATE_EXTENTS_DATA *data = in_buffer;
+        int fd, src_fd, needs_close, src_needs_close;
+
+        io->Information = 0;
+        if (in_size < sizeof(*data))
+        {
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+        if ((status = server_get_unix_fd( handle, FILE_WRITE_DATA, &fd, &needs_close, NULL, NULL ))) break;
+        if (!(status = server_get_unix_fd( data->FileHandle, FILE_READ_DATA, &src_fd, &src_needs_close, NULL, NULL )))
+        {
+            status = duplicate_extents( src_fd, fd, data );
+            if (src_needs_close) close( src_fd );
+        }
+        if (needs_close) close( fd );
+        break;
+    }
+
     case FSCTL_SET_SPARSE:
         TRACE("FSCTL_SET_SPARSE: Ignoring request\n");
         io->Information = 0;
@@ -655,13 +655,7 @@ unsigned int server_wait( const select_op_t *select_op, data_size_t size, UINT f
     unsigned int ret;
     user_apc_t apc;
 
-    if (abs_timeout < 0)
-    {
-        LARGE_INTEGER now;
-
-        NtQueryPerformanceCounter( &now, NULL );
-        abs_timeout -= now.QuadPart;
-    }
+    if (abs_timeout < 0) abs_timeout -= monotonic_counter();
 
     ret = server_select( select_op, size, flags, abs_timeout, NULL, &apc );
     if (ret == STATUS_USER_APC) return invoke_user_apc( NULL, &apc, ret );
@@ -1403,6 +1397,7 @@ static int init_thread_pipe(void)
  */
 void process_exit_wrapper( int status )
 {
+    dbg_flush();
     close( fd_socket );
     exit( status );
 }
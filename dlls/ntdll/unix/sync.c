@@ -76,7 +76,7 @@ static const char *debugstr_timeout( const LARGE_INTEGER *timeout )
 }
 
 /* return a monotonic time counter, in Win32 ticks */
-static inline ULONGLONG monotonic_counter(void)
+ULONGLONG monotonic_counter(void)
 {
     struct timeval now;
 #ifdef __APPLE__
@@ -1393,7 +1393,7 @@ NTSTATUS WINAPI NtQueryTimer( HANDLE handle, TIMER_INFORMATION_CLASS class,
         if (basic_info->RemainingTime.QuadPart > 0) NtQuerySystemTime( &now );
         else
         {
-            NtQueryPerformanceCounter( &now, NULL );
+            now.QuadPart = monotonic_counter();
             basic_info->RemainingTime.QuadPart = -basic_info->RemainingTime.QuadPart;
         }
 
@@ -1518,6 +1518,26 @@ NTSTATUS WINAPI NtDelayExecution( BOOLEAN alertable, const LARGE_INTEGER *timeou
  */
 NTSTATUS WINAPI NtQueryPerformanceCounter( LARGE_INTEGER *counter, LARGE_INTEGER *frequency )
 {
+#if defined(__i386__) || defined(__x86_64__)
+    UCHAR flags = user_shared_data->u3.QpcBypassEnabled;
+    ULONG low, high, aux;
+
+    /* use the same timebase as the RtlQueryPerformanceCounter fast path */
+    if (flags & SHARED_GLOBAL_FLAGS_QPC_BYPASS_ENABLED)
+    {
+        if (flags & SHARED_GLOBAL_FLAGS_QPC_BYPASS_USE_RDTSCP)
+            __asm__ __volatile__( "rdtscp" : "=a" (low), "=d" (high), "=c" (aux) );
+        else
+        {
+            if (flags & SHARED_GLOBAL_FLAGS_QPC_BYPASS_USE_LFENCE) __asm__ __volatile__( "lfence" : : : "memory" );
+            if (flags & SHARED_GLOBAL_FLAGS_QPC_BYPASS_USE_MFENCE) __asm__ __volatile__( "mfence" : : : "memory" );
+            __asm__ __volatile__( "rdtsc" : "=a" (low), "=d" (high) );
+        }
+        counter->QuadPart = (((ULONGLONG)high << 32 | low) + user_shared_data->QpcBias) >> user_shared_data->u3.QpcShift;
+        if (frequency) frequency->QuadPart = user_shared_data->QpcFrequency;
+        return STATUS_SUCCESS;
+    }
+#endif
     counter->QuadPart = monotonic_counter();
     if (frequency) frequency->QuadPart = TICKSPERSEC;
     return STATUS_SUCCESS;
@@ -831,10 +831,12 @@ static void test_TypeInfo(void)
     static WCHAR wszBogus[] = { 'b','o','g','u','s',0 };
     static WCHAR wszGetTypeInfo[] = { 'G','e','t','T','y','p','e','I','n','f','o',0 };
     static WCHAR wszClone[] = {'C','l','o','n','e',0};
+    static WCHAR wszcLoNE[] = {'c','L','o','N','E',0};
     static WCHAR wszTestDll[] = {'t','e','s','t','.','d','l','l',0};
     OLECHAR* bogus = wszBogus;
     OLECHAR* pwszGetTypeInfo = wszGetTypeInfo;
     OLECHAR* pwszClone = wszClone;
+    OLECHAR* pwszcLoNE = wszcLoNE;
     DISPID dispidMember;
     DISPPARAMS dispparams;
     GUID bogusguid = {0x806afb4f,0x13f7,0x42d2,{0x89,0x2c,0x6c,0x97,0xc3,0x6a,0x36,0xc1}};
@@ -908,6 +910,11 @@ static void test_TypeInfo(void)
     hr = ITypeInfo_GetIDsOfNames(pTypeInfo, &pwszClone, 1, &dispidMember);
     ok_ole_success(hr, ITypeInfo_GetIDsOfNames);
 
+    /* member names are matched case insensitively */
+    hr = ITypeInfo_GetIDsOfNames(pTypeInfo, &pwszcLoNE, 1, &l);
+    ok_ole_success(hr, ITypeInfo_GetIDsOfNames);
+    ok(l == dispidMember, "got dispid %ld, expected %ld\n", l, dispidMember);
+
     /* correct member id -- wrong flags -- cNamedArgs not bigger than cArgs */
     dispparams.cNamedArgs = 0;
     hr = ITypeInfo_Invoke(pTypeInfo, (void *)0xdeadbeef, dispidMember, DISPATCH_PROPERTYGET, &dispparams, NULL, NULL, NULL);
@@ -1104,6 +1104,17 @@ typedef struct tagITypeLibImpl
     struct list ref_list;       /* list of ref types in this typelib */
     HREFTYPE dispatch_href;     /* reference to IDispatch, -1 if unused */
 
+    /* the MSFT image stays mapped so that type info members can be read on
+     * first use, the string indexes are sorted by offset in the image */
+    IUnknown *image_file;
+    void *image;
+    DWORD image_length;
+    MSFT_SegDir image_segdir;
+    TLBString **name_index;
+    TLBString **string_index;
+    UINT name_count;
+    UINT string_count;
+
 
     /* typelibs are cached, keyed by path and index, so store the linked list info within them */
     struct list entry;
@@ -1136,7 +1147,7 @@ static inline ITypeLibImpl *impl_from_ICreateTypeLib2( ICreateTypeLib2 *iface )
 }
 
 /* ITypeLib methods */
-static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength);
+static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength, IUnknown *pFile);
 static ITypeLib2* ITypeLib2_Constructor_SLTG(LPVOID pLib, DWORD dwTLBLength);
 
 /*======================= ITypeInfo implementation =======================*/
@@ -1243,6 +1254,13 @@ typedef struct tagITypeInfoImpl
 
     struct list *pcustdata_list;
     struct list custdata_list;
+
+    /* functions and variables of MSFT type infos are read on first use */
+    INIT_ONCE members_once;
+    BOOL members_pending;
+    int memoffset;
+
+    struct tagTLBNameHash *name_hash;   /* member lookup table for GetIDsOfNames */
 } ITypeInfoImpl;
 
 static inline ITypeInfoImpl *info_impl_from_ITypeComp( ITypeComp *iface )
@@ -1271,6 +1289,7 @@ static const ICreateTypeInfo2Vtbl CreateTypeInfo2Vtbl;
 
 static ITypeInfoImpl* ITypeInfoImpl_Constructor(void);
 static void ITypeInfoImpl_Destroy(ITypeInfoImpl *This);
+static void TLB_load_members(ITypeInfoImpl *info);
 
 typedef struct tagTLBContext
 {
@@ -1547,9 +1566,14 @@ static void dump_TypeInfo(const ITypeInfoImpl * pty)
     TRACE("wTypeFlags: 0x%04x\n", pty->typeattr.wTypeFlags);
     TRACE("parent tlb:%p index in TLB:%u\n",pty->pTypeLib, pty->index);
     if (pty->typeattr.typekind == TKIND_MODULE) TRACE("dllname:%s\n", debugstr_w(TLB_get_bstr(pty->DllName)));
-    if (TRACE_ON(ole))
-        dump_TLBFuncDesc(pty->funcdescs, pty->typeattr.cFuncs);
-    dump_TLBVarDesc(pty->vardescs, pty->typeattr.cVars);
+    if (pty->members_pending)
+        TRACE("members not loaded yet\n");
+    else
+    {
+        if (TRACE_ON(ole))
+            dump_TLBFuncDesc(pty->funcdescs, pty->typeattr.cFuncs);
+        dump_TLBVarDesc(pty->vardescs, pty->typeattr.cVars);
+    }
     dump_TLBImplType(pty->impltypes, pty->typeattr.cImplTypes);
 }
 
@@ -1660,6 +1684,8 @@ static inline TLBFuncDesc *TLB_get_funcdesc_by_memberid(ITypeInfoImpl *typeinfo,
 {
     int i;
 
+    TLB_load_members(typeinfo);
+
     for (i = 0; i < typeinfo->typeattr.cFuncs; ++i)
     {
         if (typeinfo->funcdescs[i].funcdesc.memid == memid)
@@ -1673,6 +1699,8 @@ static inline TLBFuncDesc *TLB_get_funcdesc_by_memberid_invkind(ITypeInfoImpl *t
 {
     int i;
 
+    TLB_load_members(typeinfo);
+
     for (i = 0; i < typeinfo->typeattr.cFuncs; ++i)
     {
         if (typeinfo->funcdescs[i].funcdesc.memid == memid && typeinfo->funcdescs[i].funcdesc.invkind == invkind)
@@ -1686,6 +1714,8 @@ static inline TLBVarDesc *TLB_get_vardesc_by_memberid(ITypeInfoImpl *typeinfo, M
 {
     int i;
 
+    TLB_load_members(typeinfo);
+
     for (i = 0; i < typeinfo->typeattr.cVars; ++i)
     {
         if (typeinfo->vardescs[i].vardesc.memid == memid)
@@ -1699,6 +1729,8 @@ static inline TLBVarDesc *TLB_get_vardesc_by_name(ITypeInfoImpl *typeinfo, const
 {
     int i;
 
+    TLB_load_members(typeinfo);
+
     for (i = 0; i < typeinfo->typeattr.cVars; ++i)
     {
         if (!lstrcmpiW(TLB_get_bstr(typeinfo->vardescs[i].Name), name))
@@ -2175,34 +2207,57 @@ static HRESULT MSFT_ReadAllNames(TLBContext *pcx)
     }
 }
 
-static TLBString *MSFT_ReadName( TLBContext *pcx, int offset)
+/* the lists are filled in file order, so the index is sorted by offset */
+static TLBString **MSFT_IndexStrings(struct list *string_list, UINT *count)
 {
-    TLBString *tlbstr;
+    TLBString **index, *tlbstr;
+    UINT i = 0;
 
-    LIST_FOR_EACH_ENTRY(tlbstr, &pcx->pLibInfo->name_list, TLBString, entry) {
-        if (tlbstr->offset == offset) {
-            TRACE_(typelib)("%s\n", debugstr_w(tlbstr->str));
-            return tlbstr;
-        }
+    *count = list_count(string_list);
+    if (!*count || !(index = heap_alloc(*count * sizeof(*index))))
+    {
+        *count = 0;
+        return NULL;
     }
-
-    return NULL;
+    LIST_FOR_EACH_ENTRY(tlbstr, string_list, TLBString, entry)
+        index[i++] = tlbstr;
+    return index;
 }
 
-static TLBString *MSFT_ReadString( TLBContext *pcx, int offset)
+static TLBString *MSFT_FindString(TLBString **index, UINT count, int offset)
 {
-    TLBString *tlbstr;
+    UINT min = 0, max = count;
 
-    LIST_FOR_EACH_ENTRY(tlbstr, &pcx->pLibInfo->string_list, TLBString, entry) {
-        if (tlbstr->offset == offset) {
-            TRACE_(typelib)("%s\n", debugstr_w(tlbstr->str));
-            return tlbstr;
+    while (min < max)
+    {
+        UINT pos = (min + max) / 2;
+
+        if (index[pos]->offset == offset)
+        {
+            TRACE_(typelib)("%s\n", debugstr_w(index[pos]->str));
+            return index[pos];
         }
+        if (index[pos]->offset < offset) min = pos + 1;
+        else max = pos;
     }
 
     return NULL;
 }
 
+static TLBString *MSFT_ReadName( TLBContext *pcx, int offset)
+{
+    ITypeLibImpl *lib = pcx->pLibInfo;
+
+    return MSFT_FindString(lib->name_index, lib->name_count, offset);
+}
+
+static TLBString *MSFT_ReadString( TLBContext *pcx, int offset)
+{
+    ITypeLibImpl *lib = pcx->pLibInfo;
+
+    return MSFT_FindString(lib->string_index, lib->string_count, offset);
+}
+
 /*
  * read a value and fill a VARIANT structure
  */
@@ -2713,16 +2768,12 @@ static ITypeInfoImpl * MSFT_DoTypeInfo(
 /* note: InfoType's Help file and HelpStringDll come from the containing
  * library. Further HelpString and Docstring appear to be the same thing :(
  */
-    /* functions */
-    if(ptiRet->typeattr.cFuncs >0 )
-        MSFT_DoFuncs(pcx, ptiRet, ptiRet->typeattr.cFuncs,
-		    ptiRet->typeattr.cVars,
-		    tiBase.memoffset, &ptiRet->funcdescs);
-    /* variables */
-    if(ptiRet->typeattr.cVars >0 )
-        MSFT_DoVars(pcx, ptiRet, ptiRet->typeattr.cFuncs,
-		   ptiRet->typeattr.cVars,
-		   tiBase.memoffset, &ptiRet->vardescs);
+    /* functions and variables are read by TLB_load_members */
+    if (ptiRet->typeattr.cFuncs > 0 || ptiRet->typeattr.cVars > 0)
+    {
+        ptiRet->memoffset = tiBase.memoffset;
+        ptiRet->members_pending = TRUE;
+    }
     if(ptiRet->typeattr.cImplTypes >0 ) {
         switch(ptiRet->typeattr.typekind)
         {
@@ -2761,6 +2812,50 @@ static ITypeInfoImpl * MSFT_DoTypeInfo(
     return ptiRet;
 }
 
+static BOOL WINAPI MSFT_LoadMembers(INIT_ONCE *once, void *param, void **context)
+{
+    ITypeInfoImpl *info = param;
+    ITypeLibImpl *lib = info->pTypeLib;
+    TLBContext cx;
+
+    if (!info->members_pending) return TRUE;
+
+    TRACE_(typelib)("loading members of %s\n", debugstr_w(TLB_get_bstr(info->Name)));
+
+    cx.oStart = 0;
+    cx.pos = 0;
+    cx.length = lib->image_length;
+    cx.mapping = lib->image;
+    cx.pTblDir = &lib->image_segdir;
+    cx.pLibInfo = lib;
+
+    if (info->typeattr.cFuncs > 0)
+        MSFT_DoFuncs(&cx, info, info->typeattr.cFuncs, info->typeattr.cVars,
+                     info->memoffset, &info->funcdescs);
+    if (info->typeattr.cVars > 0)
+        MSFT_DoVars(&cx, info, info->typeattr.cFuncs, info->typeattr.cVars,
+                    info->memoffset, &info->vardescs);
+    info->members_pending = FALSE;
+
+    if (TRACE_ON(typelib))
+      dump_TypeInfo(info);
+    return TRUE;
+}
+
+/* make sure that the functions and variables of a type info are available */
+static void TLB_load_members(ITypeInfoImpl *info)
+{
+    InitOnceExecuteOnce(&info->members_once, MSFT_LoadMembers, info, NULL);
+}
+
+/* called before the functions or variables of a type info are modified */
+static void TLB_prepare_members_update(ITypeInfoImpl *info)
+{
+    TLB_load_members(info);
+    heap_free(info->name_hash);
+    info->name_hash = NULL;
+}
+
 static HRESULT MSFT_ReadAllStrings(TLBContext *pcx)
 {
     char *string;
@@ -3364,7 +3459,7 @@ static HRESULT TLB_ReadTypeLib(LPCWSTR pszFileName, LPWSTR pszPath, UINT cchPath
         {
             DWORD dwSignature = FromLEDWord(*((DWORD*) pBase));
             if (dwSignature == MSFT_SIGNATURE)
-                *ppTypeLib = ITypeLib2_Constructor_MSFT(pBase, dwTLBLength);
+                *ppTypeLib = ITypeLib2_Constructor_MSFT(pBase, dwTLBLength, pFile);
             else if (dwSignature == SLTG_SIGNATURE)
                 *ppTypeLib = ITypeLib2_Constructor_SLTG(pBase, dwTLBLength);
             else
@@ -3433,9 +3528,10 @@ static ITypeLibImpl* TypeLibImpl_Constructor(void)
 /****************************************************************************
  *	ITypeLib2_Constructor_MSFT
  *
- * loading an MSFT typelib from an in-memory image
+ * loading an MSFT typelib from an in-memory image, pFile keeps the image
+ * alive until the members of all the type infos have been read
  */
-static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength)
+static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength, IUnknown *pFile)
 {
     TLBContext cx;
     LONG lPSegDir;
@@ -3487,6 +3583,14 @@ static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength)
     MSFT_ReadAllNames(&cx);
     MSFT_ReadAllStrings(&cx);
     MSFT_ReadAllGuids(&cx);
+    pTypeLibImpl->name_index = MSFT_IndexStrings(&pTypeLibImpl->name_list, &pTypeLibImpl->name_count);
+    pTypeLibImpl->string_index = MSFT_IndexStrings(&pTypeLibImpl->string_list, &pTypeLibImpl->string_count);
+
+    pTypeLibImpl->image_file = pFile;
+    IUnknown_AddRef(pFile);
+    pTypeLibImpl->image = pLib;
+    pTypeLibImpl->image_length = dwTLBLength;
+    pTypeLibImpl->image_segdir = tlbSegDir;
 
     /* now fill our internal data */
     /* TLIBATTR fields */
@@ -4786,6 +4890,9 @@ static ULONG WINAPI ITypeLib2_fnRelease( ITypeLib2 *iface)
           ITypeInfoImpl_Destroy(This->typeinfos[i]);
       }
       heap_free(This->typeinfos);
+      heap_free(This->name_index);
+      heap_free(This->string_index);
+      if (This->image_file) IUnknown_Release(This->image_file);
       heap_free(This);
       return 0;
     }
@@ -5040,6 +5147,7 @@ static HRESULT WINAPI ITypeLib2_fnIsName(
     for(tic = 0; tic < This->TypeInfoCount; ++tic){
         ITypeInfoImpl *pTInfo = This->typeinfos[tic];
         if(!TLB_str_memcmp(szNameBuf, pTInfo->Name, nNameBufLen)) goto ITypeLib2_fnIsName_exit;
+        TLB_load_members(pTInfo);
         for(fdc = 0; fdc < pTInfo->typeattr.cFuncs; ++fdc) {
             TLBFuncDesc *pFInfo = &pTInfo->funcdescs[fdc];
             int pc;
@@ -5099,6 +5207,7 @@ static HRESULT WINAPI ITypeLib2_fnFindName(
             goto ITypeLib2_fnFindName_exit;
         }
 
+        TLB_load_members(pTInfo);
         for(fdc = 0; fdc < pTInfo->typeattr.cFuncs; ++fdc) {
             TLBFuncDesc *func = &pTInfo->funcdescs[fdc];
 
@@ -5605,13 +5714,15 @@ static void ITypeInfoImpl_Destroy(ITypeInfoImpl *This)
 
     TRACE("destroying ITypeInfo(%p)\n",This);
 
-    for (i = 0; i < This->typeattr.cFuncs; ++i)
+    heap_free(This->name_hash);
+
+    for (i = 0; This->funcdescs && i < This->typeattr.cFuncs; ++i)
     {
         typeinfo_release_funcdesc(&This->funcdescs[i]);
     }
     heap_free(This->funcdescs);
 
-    for(i = 0; i < This->typeattr.cVars; ++i)
+    for(i = 0; This->vardescs && i < This->typeattr.cVars; ++i)
     {
         TLBVarDesc *pVInfo = &This->vardescs[i];
         if (pVInfo->vardesc_create) {
@@ -5918,6 +6029,7 @@ static HRESULT ITypeInfoImpl_GetInternalDispatchFuncDesc( ITypeInfo *iface,
     if (index >= This->typeattr.cFuncs)
         return TYPE_E_ELEMENTNOTFOUND;
 
+    TLB_load_members(This);
     *ppFuncDesc = &This->funcdescs[index];
     return S_OK;
 }
@@ -5932,6 +6044,7 @@ static HRESULT ITypeInfoImpl_GetInternalFuncDesc( ITypeInfo *iface, UINT index,
     if (index >= This->typeattr.cFuncs)
         return TYPE_E_ELEMENTNOTFOUND;
 
+    TLB_load_members(This);
     *func_desc = &This->funcdescs[index];
     return S_OK;
 }
@@ -6071,7 +6184,6 @@ static HRESULT WINAPI ITypeInfo_fnGetVarDesc( ITypeInfo2 *iface, UINT index,
         LPVARDESC  *ppVarDesc)
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
-    const TLBVarDesc *pVDesc = &This->vardescs[index];
 
     TRACE("(%p) index %d\n", This, index);
 
@@ -6081,7 +6193,8 @@ static HRESULT WINAPI ITypeInfo_fnGetVarDesc( ITypeInfo2 *iface, UINT index,
     if (This->needs_layout)
         ICreateTypeInfo2_LayOut(&This->ICreateTypeInfo2_iface);
 
-    return TLB_AllocAndInitVarDesc(&pVDesc->vardesc, ppVarDesc);
+    TLB_load_members(This);
+    return TLB_AllocAndInitVarDesc(&This->vardescs[index].vardesc, ppVarDesc);
 }
 
 /* internal function to make the inherited interfaces' methods appear
@@ -6266,6 +6379,117 @@ static HRESULT WINAPI ITypeInfo_fnGetImplTypeFlags( ITypeInfo2 *iface,
     return S_OK;
 }
 
+/* case insensitive table of the member names, keyed by LHashValOfNameSys */
+typedef struct tagTLBNameHash
+{
+    BOOL scan;              /* some names can't be hashed, compare all of them */
+    UINT mask;
+    struct
+    {
+        ULONG hash;
+        const TLBString *name;
+        int index;          /* function index, or cFuncs + variable index, -1 for free entries */
+    } entries[1];
+} TLBNameHash;
+
+/* only ASCII names are hashed, lstrcmpiW could match other names that hash differently */
+static BOOL TLB_hash_name(const ITypeInfoImpl *info, const OLECHAR *name, ULONG *hash)
+{
+    char buffer[256];
+    UINT i;
+
+    if (!name) return FALSE;
+    for (i = 0; name[i]; i++)
+    {
+        if (name[i] >= 0x80 || i == ARRAY_SIZE(buffer) - 1) return FALSE;
+        buffer[i] = name[i];
+    }
+    buffer[i] = 0;
+    *hash = LHashValOfNameSysA(info->pTypeLib->syskind, info->pTypeLib->lcid, buffer);
+    return TRUE;
+}
+
+static TLBNameHash *TLB_build_name_hash(ITypeInfoImpl *info)
+{
+    UINT i, pos, funcs = info->typeattr.cFuncs, count = funcs + info->typeattr.cVars, size = 16;
+    const TLBString *name;
+    TLBNameHash *table;
+    ULONG hash;
+
+    while (size < count * 2) size *= 2;
+    if (!(table = heap_alloc(offsetof(TLBNameHash, entries[size])))) return NULL;
+    table->scan = FALSE;
+    table->mask = size - 1;
+    for (i = 0; i < size; i++) table->entries[i].index = -1;
+
+    for (i = 0; i < count; i++)
+    {
+        name = i < funcs ? info->funcdescs[i].Name : info->vardescs[i - funcs].Name;
+        if (!name) continue;
+        if (!TLB_hash_name(info, name->str, &hash))
+        {
+            table->scan = TRUE;
+            break;
+        }
+        for (pos = hash & table->mask; table->entries[pos].index != -1; pos = (pos + 1) & table->mask)
+            if (table->entries[pos].hash == hash && !lstrcmpiW(table->entries[pos].name->str, name->str)) break;
+        if (table->entries[pos].index != -1) continue;  /* the first member with that name wins */
+        table->entries[pos].hash = hash;
+        table->entries[pos].name = name;
+        table->entries[pos].index = i;
+    }
+
+    TRACE("%s: %u members in %u entries%s\n", debugstr_w(TLB_get_bstr(info->Name)), count, size,
+          table->scan ? ", not hashed" : "");
+    return table;
+}
+
+/* find the first function, or else the first variable, with the given name */
+static void TLB_get_member_by_name(ITypeInfoImpl *info, const OLECHAR *name,
+                                   const TLBFuncDesc **func, const TLBVarDesc **var)
+{
+    TLBNameHash *table;
+    ULONG hash;
+    UINT i;
+
+    *func = NULL;
+    *var = NULL;
+    TLB_load_members(info);
+
+    if (!(table = info->name_hash) && (table = TLB_build_name_hash(info)))
+    {
+        if (InterlockedCompareExchangePointer((void **)&info->name_hash, table, NULL))
+        {
+            heap_free(table);
+            table = info->name_hash;
+        }
+    }
+
+    if (table && !table->scan && TLB_hash_name(info, name, &hash))
+    {
+        for (i = hash & table->mask; table->entries[i].index != -1; i = (i + 1) & table->mask)
+        {
+            if (table->entries[i].hash != hash || lstrcmpiW(name, table->entries[i].name->str)) continue;
+            if (table->entries[i].index < info->typeattr.cFuncs)
+                *func = &info->funcdescs[table->entries[i].index];
+            else
+                *var = &info->vardescs[table->entries[i].index - info->typeattr.cFuncs];
+            break;
+        }
+        return;
+    }
+
+    for (i = 0; i < info->typeattr.cFuncs; ++i)
+    {
+        if (!lstrcmpiW(name, TLB_get_bstr(info->funcdescs[i].Name)))
+        {
+            *func = &info->funcdescs[i];
+            return;
+        }
+    }
+    *var = TLB_get_vardesc_by_name(info, name);
+}
+
 /* GetIDsOfNames
  * Maps between member names and member IDs, and parameter names and
  * parameter IDs.
@@ -6274,9 +6498,10 @@ static HRESULT WINAPI ITypeInfo_fnGetIDsOfNames( ITypeInfo2 *iface,
         LPOLESTR  *rgszNames, UINT cNames, MEMBERID  *pMemId)
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
+    const TLBFuncDesc *pFDesc;
     const TLBVarDesc *pVDesc;
     HRESULT ret=S_OK;
-    UINT i, fdc;
+    UINT i;
 
     TRACE("%p, %s, %d.\n", iface, debugstr_w(*rgszNames), cNames);
 
@@ -6284,25 +6509,22 @@ static HRESULT WINAPI ITypeInfo_fnGetIDsOfNames( ITypeInfo2 *iface,
     for (i = 0; i < cNames; i++)
         pMemId[i] = MEMBERID_NIL;
 
-    for (fdc = 0; fdc < This->typeattr.cFuncs; ++fdc) {
+    TLB_get_member_by_name(This, *rgszNames, &pFDesc, &pVDesc);
+    if (pFDesc) {
         int j;
-        const TLBFuncDesc *pFDesc = &This->funcdescs[fdc];
-        if(!lstrcmpiW(*rgszNames, TLB_get_bstr(pFDesc->Name))) {
-            if(cNames) *pMemId=pFDesc->funcdesc.memid;
-            for(i=1; i < cNames; i++){
-                for(j=0; j<pFDesc->funcdesc.cParams; j++)
-                    if(!lstrcmpiW(rgszNames[i],TLB_get_bstr(pFDesc->pParamDesc[j].Name)))
-                            break;
-                if( j<pFDesc->funcdesc.cParams)
-                    pMemId[i]=j;
-                else
-                   ret=DISP_E_UNKNOWNNAME;
-            };
-            TRACE("-- %#lx.\n", ret);
-            return ret;
-        }
+        if(cNames) *pMemId=pFDesc->funcdesc.memid;
+        for(i=1; i < cNames; i++){
+            for(j=0; j<pFDesc->funcdesc.cParams; j++)
+                if(!lstrcmpiW(rgszNames[i],TLB_get_bstr(pFDesc->pParamDesc[j].Name)))
+                        break;
+            if( j<pFDesc->funcdesc.cParams)
+                pMemId[i]=j;
+            else
+               ret=DISP_E_UNKNOWNNAME;
+        };
+        TRACE("-- %#lx.\n", ret);
+        return ret;
     }
-    pVDesc = TLB_get_vardesc_by_name(This, *rgszNames);
     if(pVDesc){
         if(cNames)
             *pMemId = pVDesc->vardesc.memid;
@@ -7231,6 +7453,7 @@ static HRESULT WINAPI ITypeInfo_fnInvoke(
 
     /* we do this instead of using GetFuncDesc since it will return a fake
      * FUNCDESC for dispinterfaces and we want the real function description */
+    TLB_load_members(This);
     for (fdc = 0; fdc < This->typeattr.cFuncs; ++fdc){
         pFuncInfo = &This->funcdescs[fdc];
         if ((memid == pFuncInfo->funcdesc.memid) &&
@@ -8260,6 +8483,7 @@ static HRESULT WINAPI ITypeInfo2_fnGetFuncIndexOfMemId( ITypeInfo2 * iface,
     UINT fdc;
     HRESULT result;
 
+    TLB_load_members(This);
     for (fdc = 0; fdc < This->typeattr.cFuncs; ++fdc){
         const TLBFuncDesc *pFuncInfo = &This->funcdescs[fdc];
         if(memid == pFuncInfo->funcdesc.memid && (invKind & pFuncInfo->funcdesc.invkind))
@@ -8404,14 +8628,14 @@ static HRESULT WINAPI ITypeInfo2_fnGetVarCustData(
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
     TLBCustData *pCData;
-    TLBVarDesc *pVDesc = &This->vardescs[index];
 
     TRACE("%p %s %p\n", This, debugstr_guid(guid), pVarVal);
 
     if(index >= This->typeattr.cVars)
         return TYPE_E_ELEMENTNOTFOUND;
 
-    pCData = TLB_get_custdata_by_guid(&pVDesc->custdata_list, guid);
+    TLB_load_members(This);
+    pCData = TLB_get_custdata_by_guid(&This->vardescs[index].custdata_list, guid);
     if(!pCData)
         return TYPE_E_ELEMENTNOTFOUND;
 
@@ -8585,14 +8809,14 @@ static HRESULT WINAPI ITypeInfo2_fnGetAllVarCustData( ITypeInfo2 * iface,
     UINT index, CUSTDATA *pCustData)
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
-    TLBVarDesc * pVDesc = &This->vardescs[index];
 
     TRACE("%p %u %p\n", This, index, pCustData);
 
     if(index >= This->typeattr.cVars)
         return TYPE_E_ELEMENTNOTFOUND;
 
-    return TLB_copy_all_custdata(&pVDesc->custdata_list, pCustData);
+    TLB_load_members(This);
+    return TLB_copy_all_custdata(&This->vardescs[index].custdata_list, pCustData);
 }
 
 /* ITypeInfo2::GetAllImplCustData
@@ -8825,6 +9049,7 @@ static HRESULT WINAPI ITypeComp_fnBind(
     pBindPtr->lpfuncdesc = NULL;
     *ppTInfo = NULL;
 
+    TLB_load_members(This);
     for(fdc = 0; fdc < This->typeattr.cFuncs; ++fdc){
         pFDesc = &This->funcdescs[fdc];
         if (!lstrcmpiW(TLB_get_bstr(pFDesc->Name), szName)) {
@@ -9599,6 +9824,8 @@ static DWORD WMSFT_compile_typeinfo_aux(ITypeInfoImpl *info,
     MEMBERID *memid;
     DWORD *name, *offsets, offs;
 
+    TLB_load_members(info);
+
     for(i = 0; i < info->typeattr.cFuncs; ++i){
         TLBFuncDesc *desc = &info->funcdescs[i];
 
@@ -10702,6 +10929,8 @@ static HRESULT WINAPI ICreateTypeInfo2_fnAddFuncDesc(ICreateTypeInfo2 *iface,
 
     TRACE("%p %u %p\n", This, index, funcDesc);
 
+    TLB_prepare_members_update(This);
+
     if (!funcDesc || funcDesc->oVft & 3)
         return E_INVALIDARG;
 
@@ -10939,6 +11168,8 @@ static HRESULT WINAPI ICreateTypeInfo2_fnAddVarDesc(ICreateTypeInfo2 *iface,
 
     TRACE("%p %u %p\n", This, index, varDesc);
 
+    TLB_prepare_members_update(This);
+
     if (This->vardescs){
         UINT i;
 
@@ -10977,11 +11208,14 @@ static HRESULT WINAPI ICreateTypeInfo2_fnSetFuncAndParamNames(ICreateTypeInfo2 *
         UINT index, LPOLESTR *names, UINT numNames)
 {
     ITypeInfoImpl *This = info_impl_from_ICreateTypeInfo2(iface);
-    TLBFuncDesc *func_desc = &This->funcdescs[index];
+    TLBFuncDesc *func_desc;
     int i;
 
     TRACE("%p %u %p %u\n", This, index, names, numNames);
 
+    TLB_prepare_members_update(This);
+    func_desc = &This->funcdescs[index];
+
     if (!names)
         return E_INVALIDARG;
 
@@ -11023,6 +11257,8 @@ static HRESULT WINAPI ICreateTypeInfo2_fnSetVarName(ICreateTypeInfo2 *iface,
 
     TRACE("%p %u %s\n", This, index, wine_dbgstr_w(name));
 
+    TLB_prepare_members_update(This);
+
     if(!name)
         return E_INVALIDARG;
 
@@ -11070,10 +11306,13 @@ static HRESULT WINAPI ICreateTypeInfo2_fnSetFuncDocString(ICreateTypeInfo2 *ifac
         UINT index, LPOLESTR docString)
 {
     ITypeInfoImpl *This = info_impl_from_ICreateTypeInfo2(iface);
-    TLBFuncDesc *func_desc = &This->funcdescs[index];
+    TLBFuncDesc *func_desc;
 
     TRACE("%p %u %s\n", This, index, wine_dbgstr_w(docString));
 
+    TLB_prepare_members_update(This);
+    func_desc = &This->funcdescs[index];
+
     if(!docString)
         return E_INVALIDARG;
 
@@ -11089,10 +11328,13 @@ static HRESULT WINAPI ICreateTypeInfo2_fnSetVarDocString(ICreateTypeInfo2 *iface
         UINT index, LPOLESTR docString)
 {
     ITypeInfoImpl *This = info_impl_from_ICreateTypeInfo2(iface);
-    TLBVarDesc *var_desc = &This->vardescs[index];
+    TLBVarDesc *var_desc;
 
     TRACE("%p %u %s\n", This, index, wine_dbgstr_w(docString));
 
+    TLB_prepare_members_update(This);
+    var_desc = &This->vardescs[index];
+
     if(!docString)
         return E_INVALIDARG;
 
@@ -11108,10 +11350,13 @@ static HRESULT WINAPI ICreateTypeInfo2_fnSetFuncHelpContext(ICreateTypeInfo2 *if
         UINT index, DWORD helpContext)
 {
     ITypeInfoImpl *This = info_impl_from_ICreateTypeInfo2(iface);
-    TLBFuncDesc *func_desc = &This->funcdescs[index];
+    TLBFuncDesc *func_desc;
 
     TRACE("%p, %u, %ld.\n", iface, index, helpContext);
 
+    TLB_prepare_members_update(This);
+    func_desc = &This->funcdescs[index];
+
     if(index >= This->typeattr.cFuncs)
         return TYPE_E_ELEMENTNOTFOUND;
 
@@ -11124,10 +11369,13 @@ static HRESULT WINAPI ICreateTypeInfo2_fnSetVarHelpContext(ICreateTypeInfo2 *ifa
         UINT index, DWORD helpContext)
 {
     ITypeInfoImpl *This = info_impl_from_ICreateTypeInfo2(iface);
-    TLBVarDesc *var_desc = &This->vardescs[index];
+    TLBVarDesc *var_desc;
 
     TRACE("%p, %u, %ld.\n", iface, index, helpContext);
 
+    TLB_prepare_members_update(This);
+    var_desc = &This->vardescs[index];
+
     if(index >= This->typeattr.cVars)
         return TYPE_E_ELEMENTNOTFOUND;
 
@@ -11170,6 +11418,8 @@ static HRESULT WINAPI ICreateTypeInfo2_fnLayOut(ICreateTypeInfo2 *iface)
 
     TRACE("%p\n", This);
 
+    TLB_prepare_members_update(This);
+
     This->needs_layout = FALSE;
 
     if (This->typeattr.typekind == TKIND_INTERFACE) {
@@ -11301,6 +11551,8 @@ static HRESULT WINAPI ICreateTypeInfo2_fnDeleteFuncDesc(ICreateTypeInfo2 *iface,
 
     TRACE("%p %u\n", This, index);
 
+    TLB_prepare_members_update(This);
+
     if (index >= This->typeattr.cFuncs)
         return TYPE_E_ELEMENTNOTFOUND;
 
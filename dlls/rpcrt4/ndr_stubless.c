@@ -541,6 +541,299 @@ void client_do_args( PMIDL_STUB_MESSAGE pStubMsg, PFORMAT_STRING pFormat, enum s
     }
 }
 
+/* Procedures with an -Oicf format are compiled on first use: the parameter
+ * descriptions are flattened into a list of operations with the type format
+ * and the NDR routines resolved, and the buffer size is computed once for
+ * the procedures where all the parameters have a fixed wire size. */
+
+struct ndr_param_op
+{
+    PARAM_ATTRIBUTES attr;
+    unsigned short stack_offset;
+    BOOL deref;                     /* the stack holds a pointer to the data */
+    PFORMAT_STRING format;
+    unsigned char saved_format[4];  /* type format bytes the op was compiled from */
+    unsigned int saved_len;
+    NDR_BUFFERSIZE sizer;
+    NDR_MARSHALL marshaller;
+    NDR_UNMARSHALL unmarshaller;
+    NDR_FREE freer;
+};
+
+struct ndr_proc
+{
+    struct ndr_proc *next;
+    const MIDL_STUB_DESC *stub_desc;
+    PFORMAT_STRING format_types;
+    const NDR_PARAM_OIF *params;
+    NDR_PARAM_OIF *saved_params;    /* in case another module is loaded at the same address */
+    unsigned int count;
+    ULONG in_size;                  /* buffer size of the [in] parameters, ~0u if not fixed */
+    ULONG out_size;                 /* same for the [out] parameters and the return value */
+    struct ndr_param_op ops[1];
+};
+
+#define NDR_PROC_HASH_SIZE 256
+
+static struct ndr_proc *ndr_proc_cache[NDR_PROC_HASH_SIZE];
+
+/* returns the alignment of the wire data, or 0 if its size isn't fixed */
+static unsigned int get_fixed_wire_size( const NDR_PARAM_OIF *param, PFORMAT_STRING format, ULONG *size )
+{
+    if (!param->attr.IsBasetype)
+    {
+        if (format[0] != FC_STRUCT) return 0;
+        *size = *(const WORD *)(format + 2);
+        return format[1] + 1;
+    }
+
+    switch (format[0])
+    {
+    case FC_BYTE:
+    case FC_CHAR:
+    case FC_SMALL:
+    case FC_USMALL:
+        *size = 1;
+        return 1;
+    case FC_WCHAR:
+    case FC_SHORT:
+    case FC_USHORT:
+    case FC_ENUM16:
+        *size = 2;
+        return 2;
+    case FC_LONG:
+    case FC_ULONG:
+    case FC_ENUM32:
+    case FC_INT3264:
+    case FC_UINT3264:
+    case FC_FLOAT:
+    case FC_ERROR_STATUS_T:
+        *size = 4;
+        return 4;
+    case FC_HYPER:
+    case FC_DOUBLE:
+        *size = 8;
+        return 8;
+    case FC_IGNORE:
+        *size = 0;
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+static void add_fixed_size( ULONG *total, unsigned int align, ULONG size )
+{
+    if (*total == ~0u) return;
+    if (!align) *total = ~0u;
+    else *total = ((*total + align - 1) & ~(align - 1)) + size;
+}
+
+static struct ndr_proc *compile_proc( const MIDL_STUB_DESC *stub_desc, const NDR_PARAM_OIF *params,
+                                      unsigned int count )
+{
+    struct ndr_proc *proc;
+    unsigned int i, align;
+    ULONG size = 0;
+
+    if (!(proc = HeapAlloc( GetProcessHeap(), 0, FIELD_OFFSET( struct ndr_proc, ops[count] ) + count * sizeof(*params) )))
+        return NULL;
+
+    proc->stub_desc = stub_desc;
+    proc->format_types = stub_desc->pFormatTypes;
+    proc->params = params;
+    proc->saved_params = (NDR_PARAM_OIF *)&proc->ops[count];
+    memcpy( proc->saved_params, params, count * sizeof(*params) );
+    proc->count = count;
+    proc->in_size = proc->out_size = 0;
+
+    for (i = 0; i < count; i++)
+    {
+        struct ndr_param_op *op = &proc->ops[i];
+
+        op->attr = params[i].attr;
+        op->stack_offset = params[i].stack_offset;
+        if (params[i].attr.IsBasetype)
+        {
+            op->format = &params[i].u.type_format_char;
+            op->deref = params[i].attr.IsSimpleRef;
+            op->saved_len = 0;  /* part of the saved parameters */
+        }
+        else
+        {
+            op->format = &stub_desc->pFormatTypes[params[i].u.type_offset];
+            op->deref = !params[i].attr.IsByValue;
+            /* the type and, for the fixed size, the alignment and size of a simple structure */
+            op->saved_len = op->format[0] == FC_STRUCT ? 4 : 1;
+            memcpy( op->saved_format, op->format, op->saved_len );
+        }
+        op->sizer = NdrBufferSizer[op->format[0] & NDR_TABLE_MASK];
+        op->marshaller = NdrMarshaller[op->format[0] & NDR_TABLE_MASK];
+        op->unmarshaller = NdrUnmarshaller[op->format[0] & NDR_TABLE_MASK];
+        op->freer = NdrFreer[op->format[0] & NDR_TABLE_MASK];
+
+        align = get_fixed_wire_size( &params[i], op->format, &size );
+        if (op->attr.IsIn) add_fixed_size( &proc->in_size, align, size );
+        if (op->attr.IsOut || op->attr.IsReturn) add_fixed_size( &proc->out_size, align, size );
+    }
+
+    TRACE( "%p: %u params, in size %#lx, out size %#lx\n", params, count, proc->in_size, proc->out_size );
+    return proc;
+}
+
+/* a module loaded at the address of an unloaded one may have different formats,
+ * so compare everything the ops were compiled from; the rest of the type format
+ * is read through the format pointers when the procedure is called */
+static BOOL is_same_proc( const struct ndr_proc *proc, const MIDL_STUB_DESC *stub_desc,
+                          const NDR_PARAM_OIF *params, unsigned int count )
+{
+    unsigned int i;
+
+    if (proc->params != params || proc->stub_desc != stub_desc || proc->count != count ||
+        proc->format_types != stub_desc->pFormatTypes ||
+        memcmp( proc->saved_params, params, count * sizeof(*params) ))
+        return FALSE;
+
+    for (i = 0; i < count; i++)
+        if (memcmp( proc->ops[i].format, proc->ops[i].saved_format, proc->ops[i].saved_len ))
+            return FALSE;
+    return TRUE;
+}
+
+static const struct ndr_proc *get_compiled_proc( const MIDL_STUB_DESC *stub_desc, PFORMAT_STRING format,
+                                                 unsigned int count )
+{
+    const NDR_PARAM_OIF *params = (const NDR_PARAM_OIF *)format;
+    unsigned int hash = ((ULONG_PTR)params ^ ((ULONG_PTR)params >> 8)) % NDR_PROC_HASH_SIZE;
+    struct ndr_proc *proc, *head;
+
+    for (proc = ndr_proc_cache[hash]; proc; proc = proc->next)
+        if (is_same_proc( proc, stub_desc, params, count )) return proc;
+
+    if (!(proc = compile_proc( stub_desc, params, count ))) return NULL;
+
+    /* entries are never removed, a thread losing the race just adds a duplicate */
+    do
+    {
+        head = ndr_proc_cache[hash];
+        proc->next = head;
+    } while (InterlockedCompareExchangePointer( (void **)&ndr_proc_cache[hash], proc, head ) != head);
+
+    return proc;
+}
+
+static inline void op_buffer_size( MIDL_STUB_MESSAGE *stub_msg, unsigned char *memory,
+                                   const struct ndr_param_op *op )
+{
+    if (op->deref) memory = *(unsigned char **)memory;
+    if (op->sizer) op->sizer( stub_msg, memory, op->format );
+    else
+    {
+        FIXME( "format type 0x%x not implemented\n", op->format[0] );
+        RpcRaiseException( RPC_X_BAD_STUB_DATA );
+    }
+}
+
+static inline void op_marshall( MIDL_STUB_MESSAGE *stub_msg, unsigned char *memory,
+                                const struct ndr_param_op *op )
+{
+    if (op->deref) memory = *(unsigned char **)memory;
+    if (op->marshaller) op->marshaller( stub_msg, memory, op->format );
+    else
+    {
+        FIXME( "format type 0x%x not implemented\n", op->format[0] );
+        RpcRaiseException( RPC_X_BAD_STUB_DATA );
+    }
+}
+
+static inline void op_unmarshall( MIDL_STUB_MESSAGE *stub_msg, unsigned char **memory,
+                                  const struct ndr_param_op *op )
+{
+    if (op->deref) memory = (unsigned char **)*memory;
+    if (op->unmarshaller) op->unmarshaller( stub_msg, memory, op->format, 0 );
+    else
+    {
+        FIXME( "format type 0x%x not implemented\n", op->format[0] );
+        RpcRaiseException( RPC_X_BAD_STUB_DATA );
+    }
+}
+
+static inline void op_free( MIDL_STUB_MESSAGE *stub_msg, unsigned char *memory,
+                            const struct ndr_param_op *op )
+{
+    if (op->attr.IsBasetype) return;  /* nothing to do */
+    if (op->deref) memory = *(unsigned char **)memory;
+    if (op->freer) op->freer( stub_msg, memory, op->format );
+}
+
+/* same as client_do_args, for compiled procedures */
+static void client_do_ops( MIDL_STUB_MESSAGE *stub_msg, const struct ndr_proc *proc, enum stubless_phase phase,
+                           void **fpu_args, unsigned char *retval )
+{
+    unsigned int i;
+
+    if (phase == STUBLESS_CALCSIZE && proc->in_size != ~0u && !stub_msg->BufferLength)
+    {
+        for (i = 0; i < proc->count; i++)
+            if (proc->ops[i].attr.IsSimpleRef && !*(unsigned char **)(stub_msg->StackTop + proc->ops[i].stack_offset))
+                RpcRaiseException( RPC_X_NULL_REF_POINTER );
+        stub_msg->BufferLength = proc->in_size;
+        return;
+    }
+
+    for (i = 0; i < proc->count; i++)
+    {
+        const struct ndr_param_op *op = &proc->ops[i];
+        unsigned char *arg = stub_msg->StackTop + op->stack_offset;
+
+#ifdef __x86_64__  /* floats are passed as doubles through varargs functions */
+        float f;
+
+        if (op->attr.IsBasetype && op->format[0] == FC_FLOAT && !op->attr.IsSimpleRef && !fpu_args)
+        {
+            f = *(double *)arg;
+            arg = (unsigned char *)&f;
+        }
+#endif
+
+        TRACE( "param[%d]: %p type %02x %s\n", i, arg, op->format[0], debugstr_PROC_PF( op->attr ));
+
+        switch (phase)
+        {
+        case STUBLESS_INITOUT:
+            if (*(unsigned char **)arg)
+            {
+                if (param_needs_alloc( op->attr ))
+                    memset( *(unsigned char **)arg, 0, calc_arg_size( stub_msg, op->format ));
+                else if (param_is_out_basetype( op->attr ))
+                    memset( *(unsigned char **)arg, 0, basetype_arg_size( op->format[0] ));
+            }
+            break;
+        case STUBLESS_CALCSIZE:
+            if (op->attr.IsSimpleRef && !*(unsigned char **)arg)
+                RpcRaiseException( RPC_X_NULL_REF_POINTER );
+            if (op->attr.IsIn) op_buffer_size( stub_msg, arg, op );
+            break;
+        case STUBLESS_MARSHAL:
+            if (op->attr.IsIn) op_marshall( stub_msg, arg, op );
+            break;
+        case STUBLESS_UNMARSHAL:
+            if (op->attr.IsOut)
+            {
+                if (op->attr.IsReturn && retval) arg = retval;
+                op_unmarshall( stub_msg, &arg, op );
+            }
+            break;
+        case STUBLESS_FREE:
+            if (!op->attr.IsBasetype && op->attr.IsOut && !op->attr.IsByValue)
+                NdrClearOutParameters( stub_msg, op->format, *(unsigned char **)arg );
+            break;
+        default:
+            RpcRaiseException( RPC_S_INTERNAL_ERROR );
+        }
+    }
+}
+
 static unsigned int type_stack_size(unsigned char fc)
 {
     switch (fc)
@@ -705,7 +998,8 @@ static void CALLBACK ndr_client_call_finally(BOOL normal, void *arg)
 static LONG_PTR do_ndr_client_call( const MIDL_STUB_DESC *stub_desc, const PFORMAT_STRING format,
         const PFORMAT_STRING handle_format, void **stack_top, void **fpu_stack, MIDL_STUB_MESSAGE *stub_msg,
         unsigned short procedure_number, unsigned short stack_size, unsigned int number_of_params,
-        INTERPRETER_OPT_FLAGS Oif_flags, INTERPRETER_OPT_FLAGS2 ext_flags, const NDR_PROC_HEADER *proc_header )
+        INTERPRETER_OPT_FLAGS Oif_flags, INTERPRETER_OPT_FLAGS2 ext_flags, const NDR_PROC_HEADER *proc_header,
+        const struct ndr_proc *proc )
 {
     struct ndr_client_call_ctx finally_ctx;
     RPC_MESSAGE rpc_msg;
@@ -789,14 +1083,20 @@ static LONG_PTR do_ndr_client_call( const MIDL_STUB_DESC *stub_desc, const PFORM
         if (proc_header->Oi_flags & Oi_OBJECT_PROC)
         {
             TRACE( "INITOUT\n" );
-            client_do_args(stub_msg, format, STUBLESS_INITOUT, fpu_stack,
-                           number_of_params, (unsigned char *)&retval);
+            if (proc)
+                client_do_ops(stub_msg, proc, STUBLESS_INITOUT, fpu_stack, (unsigned char *)&retval);
+            else
+                client_do_args(stub_msg, format, STUBLESS_INITOUT, fpu_stack,
+                               number_of_params, (unsigned char *)&retval);
         }
 
         /* 2. CALCSIZE */
         TRACE( "CALCSIZE\n" );
-        client_do_args(stub_msg, format, STUBLESS_CALCSIZE, fpu_stack,
-                       number_of_params, (unsigned char *)&retval);
+        if (proc)
+            client_do_ops(stub_msg, proc, STUBLESS_CALCSIZE, fpu_stack, (unsigned char *)&retval);
+        else
+            client_do_args(stub_msg, format, STUBLESS_CALCSIZE, fpu_stack,
+                           number_of_params, (unsigned char *)&retval);
 
         /* 3. GETBUFFER */
         TRACE( "GETBUFFER\n" );
@@ -815,8 +1115,11 @@ static LONG_PTR do_ndr_client_call( const MIDL_STUB_DESC *stub_desc, const PFORM
 
         /* 4. MARSHAL */
         TRACE( "MARSHAL\n" );
-        client_do_args(stub_msg, format, STUBLESS_MARSHAL, fpu_stack,
-                       number_of_params, (unsigned char *)&retval);
+        if (proc)
+            client_do_ops(stub_msg, proc, STUBLESS_MARSHAL, fpu_stack, (unsigned char *)&retval);
+        else
+            client_do_args(stub_msg, format, STUBLESS_MARSHAL, fpu_stack,
+                           number_of_params, (unsigned char *)&retval);
 
         /* 5. SENDRECEIVE */
         TRACE( "SENDRECEIVE\n" );
@@ -841,8 +1144,11 @@ static LONG_PTR do_ndr_client_call( const MIDL_STUB_DESC *stub_desc, const PFORM
 
         /* 6. UNMARSHAL */
         TRACE( "UNMARSHAL\n" );
-        client_do_args(stub_msg, format, STUBLESS_UNMARSHAL, fpu_stack,
-                       number_of_params, (unsigned char *)&retval);
+        if (proc)
+            client_do_ops(stub_msg, proc, STUBLESS_UNMARSHAL, fpu_stack, (unsigned char *)&retval);
+        else
+            client_do_args(stub_msg, format, STUBLESS_UNMARSHAL, fpu_stack,
+                           number_of_params, (unsigned char *)&retval);
     }
     __FINALLY_CTX(ndr_client_call_finally, &finally_ctx)
 
@@ -870,6 +1176,8 @@ LONG_PTR CDECL DECLSPEC_HIDDEN ndr_client_call( PMIDL_STUB_DESC pStubDesc, PFORM
     LONG_PTR RetVal = 0;
     PFORMAT_STRING pHandleFormat;
     NDR_PARAM_OIF old_args[256];
+    /* compiled parameters, for -Oicf formats */
+    const struct ndr_proc *proc = NULL;
 
     TRACE("pStubDesc %p, pFormat %p, ...\n", pStubDesc, pFormat);
 
@@ -930,6 +1238,8 @@ LONG_PTR CDECL DECLSPEC_HIDDEN ndr_client_call( PMIDL_STUB_DESC pStubDesc, PFORM
             }
 #endif
         }
+
+        proc = get_compiled_proc(pStubDesc, pFormat, number_of_params);
     }
     else
     {
@@ -944,14 +1254,17 @@ LONG_PTR CDECL DECLSPEC_HIDDEN ndr_client_call( PMIDL_STUB_DESC pStubDesc, PFORM
         {
             RetVal = do_ndr_client_call(pStubDesc, pFormat, pHandleFormat,
                     stack_top, fpu_stack, &stubMsg, procedure_number, stack_size,
-                    number_of_params, Oif_flags, ext_flags, pProcHeader);
+                    number_of_params, Oif_flags, ext_flags, pProcHeader, proc);
         }
         __EXCEPT_ALL
         {
             /* 7. FREE */
             TRACE( "FREE\n" );
-            client_do_args(&stubMsg, pFormat, STUBLESS_FREE, fpu_stack,
-                           number_of_params, (unsigned char *)&RetVal);
+            if (proc)
+                client_do_ops(&stubMsg, proc, STUBLESS_FREE, fpu_stack, (unsigned char *)&RetVal);
+            else
+                client_do_args(&stubMsg, pFormat, STUBLESS_FREE, fpu_stack,
+                               number_of_params, (unsigned char *)&RetVal);
             RetVal = NdrProxyErrorHandler(GetExceptionCode());
         }
         __ENDTRY
@@ -962,7 +1275,7 @@ LONG_PTR CDECL DECLSPEC_HIDDEN ndr_client_call( PMIDL_STUB_DESC pStubDesc, PFORM
         {
             RetVal = do_ndr_client_call(pStubDesc, pFormat, pHandleFormat,
                     stack_top, fpu_stack, &stubMsg, procedure_number, stack_size,
-                    number_of_params, Oif_flags, ext_flags, pProcHeader);
+                    number_of_params, Oif_flags, ext_flags, pProcHeader, proc);
         }
         __EXCEPT_ALL
         {
@@ -995,7 +1308,7 @@ LONG_PTR CDECL DECLSPEC_HIDDEN ndr_client_call( PMIDL_STUB_DESC pStubDesc, PFORM
     {
         RetVal = do_ndr_client_call(pStubDesc, pFormat, pHandleFormat,
                 stack_top, fpu_stack, &stubMsg, procedure_number, stack_size,
-                number_of_params, Oif_flags, ext_flags, pProcHeader);
+                number_of_params, Oif_flags, ext_flags, pProcHeader, proc);
     }
 
     TRACE("RetVal = 0x%Ix\n", RetVal);
@@ -1295,6 +1608,89 @@ static LONG_PTR *stub_do_args(MIDL_STUB_MESSAGE *pStubMsg,
     return retval_ptr;
 }
 
+/* same as stub_do_args, for compiled procedures */
+static LONG_PTR *stub_do_ops(MIDL_STUB_MESSAGE *pStubMsg, const struct ndr_proc *proc,
+                             enum stubless_phase phase)
+{
+    LONG_PTR *retval_ptr = NULL;
+    unsigned int i;
+
+    if (phase == STUBLESS_CALCSIZE && proc->out_size != ~0u && !pStubMsg->BufferLength)
+    {
+        pStubMsg->BufferLength = proc->out_size;
+        return NULL;
+    }
+
+    for (i = 0; i < proc->count; i++)
+    {
+        const struct ndr_param_op *op = &proc->ops[i];
+        unsigned char *pArg = pStubMsg->StackTop + op->stack_offset;
+
+        TRACE("param[%d]: %p -> %p type %02x %s\n", i, pArg, *(unsigned char **)pArg,
+              op->format[0], debugstr_PROC_PF( op->attr ));
+
+        switch (phase)
+        {
+        case STUBLESS_MARSHAL:
+            if (op->attr.IsOut || op->attr.IsReturn)
+                op_marshall(pStubMsg, pArg, op);
+            break;
+        case STUBLESS_MUSTFREE:
+            if (op->attr.MustFree)
+                op_free(pStubMsg, pArg, op);
+            break;
+        case STUBLESS_FREE:
+            if (op->attr.ServerAllocSize)
+            {
+                HeapFree(GetProcessHeap(), 0, *(void **)pArg);
+            }
+            else if (param_needs_alloc(op->attr) &&
+                     (!op->attr.MustFree || op->attr.IsSimpleRef))
+            {
+                if (op->format[0] != FC_BIND_CONTEXT) pStubMsg->pfnFree(*(void **)pArg);
+            }
+            break;
+        case STUBLESS_INITOUT:
+            if (param_needs_alloc(op->attr) && !op->attr.ServerAllocSize)
+            {
+                if (op->format[0] == FC_BIND_CONTEXT)
+                {
+                    NDR_SCONTEXT ctxt = NdrContextHandleInitialize(pStubMsg, op->format);
+                    *(void **)pArg = NDRSContextValue(ctxt);
+                    if (op->attr.IsReturn) retval_ptr = (LONG_PTR *)NDRSContextValue(ctxt);
+                }
+                else
+                {
+                    DWORD size = calc_arg_size(pStubMsg, op->format);
+                    if (size)
+                    {
+                        *(void **)pArg = NdrAllocate(pStubMsg, size);
+                        memset(*(void **)pArg, 0, size);
+                    }
+                }
+            }
+            if (!retval_ptr && op->attr.IsReturn) retval_ptr = (LONG_PTR *)pArg;
+            break;
+        case STUBLESS_UNMARSHAL:
+            if (op->attr.ServerAllocSize)
+                *(void **)pArg = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                           op->attr.ServerAllocSize * 8);
+
+            if (op->attr.IsIn)
+                op_unmarshall(pStubMsg, &pArg, op);
+            break;
+        case STUBLESS_CALCSIZE:
+            if (op->attr.IsOut || op->attr.IsReturn)
+                op_buffer_size(pStubMsg, pArg, op);
+            break;
+        default:
+            RpcRaiseException(RPC_S_INTERNAL_ERROR);
+        }
+        TRACE("\tmemory addr (after): %p -> %p\n", pArg, *(unsigned char **)pArg);
+    }
+    return retval_ptr;
+}
+
 /***********************************************************************
  *            NdrStubCall2 [RPCRT4.@]
  *
@@ -1332,6 +1728,8 @@ LONG WINAPI NdrStubCall2(
     LONG_PTR *retval_ptr = NULL;
     /* correlation cache */
     ULONG_PTR NdrCorrCache[256];
+    /* compiled parameters, for -Oicf formats */
+    const struct ndr_proc *proc = NULL;
 
     TRACE("pThis %p, pChannel %p, pRpcMsg %p, pdwStubPhase %p\n", pThis, pChannel, pRpcMsg, pdwStubPhase);
 
@@ -1455,6 +1853,8 @@ LONG WINAPI NdrStubCall2(
             if (ext_flags.Unused & 0x2) /* has range on conformance */
                 stubMsg.CorrDespIncrement = 12;
         }
+
+        proc = get_compiled_proc(pStubDesc, pFormat, number_of_params);
     }
     else
     {
@@ -1528,7 +1928,10 @@ LONG WINAPI NdrStubCall2(
         case STUBLESS_MARSHAL:
         case STUBLESS_MUSTFREE:
         case STUBLESS_FREE:
-            retval_ptr = stub_do_args(&stubMsg, pFormat, phase, number_of_params);
+            if (proc)
+                retval_ptr = stub_do_ops(&stubMsg, proc, phase);
+            else
+                retval_ptr = stub_do_args(&stubMsg, pFormat, phase, number_of_params);
             break;
         default:
             ERR("shouldn't reach here. phase %d\n", phase);
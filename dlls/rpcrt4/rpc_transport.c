@@ -56,6 +56,7 @@
 WINE_DEFAULT_DEBUG_CHANNEL(rpc);
 
 static RpcConnection *rpcrt4_spawn_connection(RpcConnection *old_connection);
+static RPC_STATUS rpcrt4_ncalrpc_connect(RpcConnection *conn);
 
 /**** ncacn_np support ****/
 
@@ -178,8 +179,8 @@ static char *ncalrpc_pipe_name(const char *endpoint)
   static const char prefix[] = "\\\\.\\pipe\\lrpc\\";
   char *pipe_name;
 
-  /* protseq=ncalrpc: supposed to use NT LPC ports,
-   * but we'll implement it with named pipes for now */
+  /* protseq=ncalrpc: supposed to use NT LPC ports, we use a named pipe
+   * to set up a shared memory channel, see rpcrt4_ncalrpc_connect */
   pipe_name = I_RpcAllocate(sizeof(prefix) + strlen(endpoint));
   strcat(strcpy(pipe_name, prefix), endpoint);
   return pipe_name;
@@ -198,7 +199,15 @@ static RPC_STATUS rpcrt4_ncalrpc_open(RpcConnection* Connection)
   pname = ncalrpc_pipe_name(Connection->Endpoint);
   r = rpcrt4_conn_open_pipe(Connection, pname, TRUE);
   I_RpcFree(pname);
+  if (r != RPC_S_OK)
+    return r;
 
+  r = rpcrt4_ncalrpc_connect(Connection);
+  if (r != RPC_S_OK)
+  {
+    CloseHandle(npc->pipe);
+    npc->pipe = 0;
+  }
   return r;
 }
 
@@ -468,6 +477,409 @@ static int rpcrt4_conn_np_wait_for_incoming_data(RpcConnection *conn)
     return rpcrt4_conn_np_read(conn, NULL, 0);
 }
 
+/**** ncalrpc shared memory support ****/
+
+/* The ncalrpc pipe is only used to set up the connection and to identify
+ * and impersonate the client. The client then creates a section holding a
+ * ring buffer for each direction, the server duplicates it from the client
+ * process and the packets are copied through the rings from then on. A side
+ * only signals the events of its peer when the peer announced that it is
+ * about to sleep, so a busy connection doesn't need any server call. */
+
+#define LRPC_MAGIC      0x4350524c  /* "LRPC" */
+#define LRPC_RING_SIZE  0x10000
+#define LRPC_SPIN_COUNT 4000
+
+struct lrpc_ring
+{
+    volatile LONG head;             /* total bytes written, only changed by the writer */
+    volatile LONG reader_waiting;
+    BYTE pad1[56];
+    volatile LONG tail;             /* total bytes read, only changed by the reader */
+    volatile LONG writer_waiting;
+    volatile LONG closed;
+    BYTE pad2[52];
+    BYTE data[LRPC_RING_SIZE];
+};
+
+/* ring 0 goes from the client to the server, ring 1 the other way */
+struct lrpc_shared
+{
+    struct lrpc_ring ring[2];
+};
+
+/* handshake sent by the client as the first message on the pipe,
+ * handles are values in the client process */
+struct lrpc_connect_request
+{
+    DWORD magic;
+    DWORD section;                  /* 0 to keep using the pipe */
+    DWORD events[4];                /* data and space events of ring 0 and ring 1 */
+};
+
+struct lrpc_connect_reply
+{
+    DWORD magic;
+    DWORD use_section;
+};
+
+typedef struct _RpcConnection_lrpc
+{
+    RpcConnection_np np;
+    BOOL negotiated;
+    struct lrpc_shared *shared;     /* NULL if the pipe is used for the data */
+    struct lrpc_ring *in;
+    struct lrpc_ring *out;
+    HANDLE in_data_event;
+    HANDLE in_space_event;
+    HANDLE out_data_event;
+    HANDLE out_space_event;
+    HANDLE peer;                    /* peer process, to notice when it goes away */
+    HANDLE cancel_event;
+    SRWLOCK write_lock;
+} RpcConnection_lrpc;
+
+static RpcConnection *rpcrt4_conn_lrpc_alloc(void)
+{
+    RpcConnection_lrpc *lrpc = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*lrpc));
+    if (!lrpc) return NULL;
+    InitializeSRWLock(&lrpc->write_lock);
+    return &lrpc->np.common;
+}
+
+static BOOL lrpc_map_section(RpcConnection_lrpc *lrpc, HANDLE section, HANDLE *events, HANDLE peer)
+{
+    struct lrpc_shared *shared;
+    int in = lrpc->np.common.server ? 0 : 1;
+    int out = 1 - in;
+
+    if (!(shared = MapViewOfFile(section, FILE_MAP_WRITE, 0, 0, sizeof(*shared))))
+    {
+        WARN("failed to map the section, error %lu\n", GetLastError());
+        return FALSE;
+    }
+    if (!(lrpc->cancel_event = CreateEventW(NULL, TRUE, FALSE, NULL)))
+    {
+        UnmapViewOfFile(shared);
+        return FALSE;
+    }
+    CloseHandle(section);
+
+    lrpc->shared = shared;
+    lrpc->in = &shared->ring[in];
+    lrpc->out = &shared->ring[out];
+    lrpc->in_data_event = events[2 * in];
+    lrpc->in_space_event = events[2 * in + 1];
+    lrpc->out_data_event = events[2 * out];
+    lrpc->out_space_event = events[2 * out + 1];
+    lrpc->peer = peer;
+    return TRUE;
+}
+
+static void lrpc_close_handles(HANDLE section, HANDLE *events, HANDLE peer)
+{
+    unsigned int i;
+
+    if (section) CloseHandle(section);
+    for (i = 0; i < 4; i++)
+        if (events[i]) CloseHandle(events[i]);
+    if (peer) CloseHandle(peer);
+}
+
+static RPC_STATUS rpcrt4_ncalrpc_connect(RpcConnection *conn)
+{
+    RpcConnection_lrpc *lrpc = (RpcConnection_lrpc *)conn;
+    struct lrpc_connect_request request;
+    struct lrpc_connect_reply reply;
+    HANDLE section = 0, events[4] = { 0 }, peer = 0;
+    ULONG server_pid;
+    unsigned int i;
+
+    /* WINELRPCPIPE makes the client keep using the pipe, to test the fallback */
+    if (!GetEnvironmentVariableW(L"WINELRPCPIPE", NULL, 0))
+        section = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, sizeof(struct lrpc_shared), NULL);
+    for (i = 0; section && i < 4; i++)
+        if (!(events[i] = CreateEventW(NULL, FALSE, FALSE, NULL))) break;
+    if (section && i == 4 && GetNamedPipeServerProcessId(lrpc->np.pipe, &server_pid))
+        peer = OpenProcess(SYNCHRONIZE, FALSE, server_pid);
+
+    memset(&request, 0, sizeof(request));
+    request.magic = LRPC_MAGIC;
+    if (peer)
+    {
+        request.section = HandleToULong(section);
+        for (i = 0; i < 4; i++) request.events[i] = HandleToULong(events[i]);
+    }
+    else WARN("using the pipe for the data\n");
+
+    if (rpcrt4_conn_np_write(conn, &request, sizeof(request)) != sizeof(request) ||
+        rpcrt4_conn_np_read(conn, &reply, sizeof(reply)) != sizeof(reply) ||
+        reply.magic != LRPC_MAGIC)
+    {
+        WARN("handshake failed\n");
+        lrpc_close_handles(section, events, peer);
+        return RPC_S_PROTOCOL_ERROR;
+    }
+
+    lrpc->negotiated = TRUE;
+    if (peer && reply.use_section && lrpc_map_section(lrpc, section, events, peer))
+    {
+        TRACE("using shared memory for %s\n", debugstr_a(conn->Endpoint));
+        return RPC_S_OK;
+    }
+
+    if (peer && reply.use_section)
+    {
+        ERR("server accepted a section that can't be mapped\n");
+        lrpc_close_handles(section, events, peer);
+        return RPC_S_OUT_OF_RESOURCES;
+    }
+    lrpc_close_handles(section, events, peer);
+    return RPC_S_OK;
+}
+
+static BOOL lrpc_accept_section(RpcConnection_lrpc *lrpc, const struct lrpc_connect_request *request)
+{
+    HANDLE section = 0, events[4] = { 0 }, peer, process = GetCurrentProcess();
+    ULONG client_pid;
+    unsigned int i;
+
+    if (!request->section) return FALSE;
+    if (!GetNamedPipeClientProcessId(lrpc->np.pipe, &client_pid)) return FALSE;
+    if (!(peer = OpenProcess(PROCESS_DUP_HANDLE | SYNCHRONIZE, FALSE, client_pid)))
+    {
+        WARN("can't open client process %04lx, error %lu\n", client_pid, GetLastError());
+        return FALSE;
+    }
+
+    /* the handles are taken from the client process, so that a client can't
+     * make us use any of our own handles */
+    if (!DuplicateHandle(peer, ULongToHandle(request->section), process, &section,
+                         SECTION_MAP_READ | SECTION_MAP_WRITE, FALSE, 0))
+        section = 0;
+    for (i = 0; section && i < 4; i++)
+        if (!DuplicateHandle(peer, ULongToHandle(request->events[i]), process, &events[i],
+                             SYNCHRONIZE | EVENT_MODIFY_STATE, FALSE, 0))
+            break;
+
+    if (!section || i < 4 || !lrpc_map_section(lrpc, section, events, peer))
+    {
+        WARN("failed to set up shared memory for client %04lx\n", client_pid);
+        lrpc_close_handles(section, events, peer);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* the server side of the handshake, done by the thread serving the connection */
+static BOOL lrpc_accept(RpcConnection_lrpc *lrpc)
+{
+    struct lrpc_connect_request request;
+    struct lrpc_connect_reply reply;
+
+    if (rpcrt4_conn_np_read(&lrpc->np.common, &request, sizeof(request)) != sizeof(request) ||
+        request.magic != LRPC_MAGIC)
+    {
+        WARN("invalid handshake\n");
+        return FALSE;
+    }
+
+    reply.magic = LRPC_MAGIC;
+    reply.use_section = lrpc_accept_section(lrpc, &request);
+    if (rpcrt4_conn_np_write(&lrpc->np.common, &reply, sizeof(reply)) != sizeof(reply))
+        return FALSE;
+
+    TRACE("using %s for %s\n", reply.use_section ? "shared memory" : "the pipe",
+          debugstr_a(lrpc->np.common.Endpoint));
+    lrpc->negotiated = TRUE;
+    return TRUE;
+}
+
+/* wait until the peer changes *value, or until the connection is closed */
+static BOOL lrpc_wait(RpcConnection_lrpc *lrpc, volatile LONG *waiting, volatile LONG *value,
+                      LONG old_value, HANDLE event, BOOL cancellable)
+{
+    HANDLE handles[3];
+    DWORD ret, count = 0;
+    unsigned int i;
+
+    for (i = 0; i < LRPC_SPIN_COUNT; i++)
+    {
+        if (*value != old_value) return TRUE;
+        YieldProcessor();
+    }
+
+    InterlockedExchange(waiting, 1);
+    if (*value != old_value || lrpc->in->closed || lrpc->out->closed)
+    {
+        InterlockedExchange(waiting, 0);
+        return TRUE;
+    }
+
+    handles[count++] = event;
+    handles[count++] = lrpc->peer;
+    if (cancellable) handles[count++] = lrpc->cancel_event;
+    ret = WaitForMultipleObjects(count, handles, FALSE, INFINITE);
+    InterlockedExchange(waiting, 0);
+
+    if (ret == WAIT_OBJECT_0) return TRUE;
+    if (ret == WAIT_OBJECT_0 + 1) TRACE("peer process is gone\n");
+    return FALSE;
+}
+
+static int rpcrt4_conn_lrpc_read(RpcConnection *conn, void *buffer, unsigned int count)
+{
+    RpcConnection_lrpc *lrpc = (RpcConnection_lrpc *)conn;
+    struct lrpc_ring *ring;
+    unsigned int done = 0;
+
+    if (!lrpc->negotiated && (!conn->server || !lrpc_accept(lrpc)))
+        return -1;
+    if (!lrpc->shared)
+        return rpcrt4_conn_np_read(conn, buffer, count);
+
+    ring = lrpc->in;
+    ResetEvent(lrpc->cancel_event);
+    for (;;)
+    {
+        LONG tail = ring->tail;
+        ULONG avail = (ULONG)ring->head - (ULONG)tail, pos, len;
+
+        if (avail > LRPC_RING_SIZE)
+        {
+            ERR("corrupted ring, head %lx tail %lx\n", ring->head, tail);
+            return -1;
+        }
+        if (avail)
+        {
+            /* only waiting for data */
+            if (!count) return 0;
+
+            MemoryBarrier();
+            len = min(avail, count - done);
+            pos = tail & (LRPC_RING_SIZE - 1);
+            if (len > LRPC_RING_SIZE - pos)
+            {
+                memcpy((char *)buffer + done, ring->data + pos, LRPC_RING_SIZE - pos);
+                memcpy((char *)buffer + done + LRPC_RING_SIZE - pos, ring->data, len - (LRPC_RING_SIZE - pos));
+            }
+            else memcpy((char *)buffer + done, ring->data + pos, len);
+            done += len;
+
+            InterlockedExchangeAdd(&ring->tail, len);
+            if (InterlockedExchange(&ring->writer_waiting, 0))
+                SetEvent(lrpc->in_space_event);
+            if (done == count) return count;
+            continue;
+        }
+
+        if (ring->closed || lrpc->np.read_closed) return -1;
+        if (!lrpc_wait(lrpc, &ring->reader_waiting, &ring->head, tail, lrpc->in_data_event, TRUE))
+            return -1;
+        if (lrpc->np.read_closed) return -1;
+    }
+}
+
+static int rpcrt4_conn_lrpc_write(RpcConnection *conn, const void *buffer, unsigned int count)
+{
+    RpcConnection_lrpc *lrpc = (RpcConnection_lrpc *)conn;
+    struct lrpc_ring *ring;
+    unsigned int done = 0;
+
+    if (!lrpc->shared)
+        return rpcrt4_conn_np_write(conn, buffer, count);
+
+    ring = lrpc->out;
+
+    /* worker threads can send responses on the same connection */
+    AcquireSRWLockExclusive(&lrpc->write_lock);
+    while (done < count)
+    {
+        LONG head = ring->head, tail = ring->tail;
+        ULONG used = (ULONG)head - (ULONG)tail, space, pos, len;
+
+        if (used > LRPC_RING_SIZE || ring->closed)
+            break;
+        space = LRPC_RING_SIZE - used;
+        if (!space)
+        {
+            if (!lrpc_wait(lrpc, &ring->writer_waiting, &ring->tail, tail, lrpc->out_space_event, FALSE))
+                break;
+            continue;
+        }
+
+        MemoryBarrier();
+        len = min(space, count - done);
+        pos = head & (LRPC_RING_SIZE - 1);
+        if (len > LRPC_RING_SIZE - pos)
+        {
+            memcpy(ring->data + pos, (const char *)buffer + done, LRPC_RING_SIZE - pos);
+            memcpy(ring->data, (const char *)buffer + done + LRPC_RING_SIZE - pos, len - (LRPC_RING_SIZE - pos));
+        }
+        else memcpy(ring->data + pos, (const char *)buffer + done, len);
+        done += len;
+
+        InterlockedExchangeAdd(&ring->head, len);
+        if (InterlockedExchange(&ring->reader_waiting, 0))
+            SetEvent(lrpc->out_data_event);
+    }
+    ReleaseSRWLockExclusive(&lrpc->write_lock);
+
+    return done == count ? count : -1;
+}
+
+static int rpcrt4_conn_lrpc_close(RpcConnection *conn)
+{
+    RpcConnection_lrpc *lrpc = (RpcConnection_lrpc *)conn;
+
+    if (lrpc->shared)
+    {
+        /* wake up the peer, both when it's reading and when it's writing */
+        InterlockedExchange(&lrpc->out->closed, 1);
+        InterlockedExchange(&lrpc->in->closed, 1);
+        SetEvent(lrpc->out_data_event);
+        SetEvent(lrpc->in_space_event);
+
+        UnmapViewOfFile(lrpc->shared);
+        lrpc->shared = NULL;
+        lrpc->in = lrpc->out = NULL;
+        CloseHandle(lrpc->in_data_event);
+        CloseHandle(lrpc->in_space_event);
+        CloseHandle(lrpc->out_data_event);
+        CloseHandle(lrpc->out_space_event);
+        CloseHandle(lrpc->peer);
+        lrpc->peer = 0;
+    }
+    if (lrpc->cancel_event)
+    {
+        CloseHandle(lrpc->cancel_event);
+        lrpc->cancel_event = 0;
+    }
+    lrpc->negotiated = FALSE;
+    return rpcrt4_conn_np_close(conn);
+}
+
+static void rpcrt4_conn_lrpc_close_read(RpcConnection *conn)
+{
+    RpcConnection_lrpc *lrpc = (RpcConnection_lrpc *)conn;
+
+    rpcrt4_conn_np_close_read(conn);
+    if (lrpc->cancel_event) SetEvent(lrpc->cancel_event);
+}
+
+static void rpcrt4_conn_lrpc_cancel_call(RpcConnection *conn)
+{
+    RpcConnection_lrpc *lrpc = (RpcConnection_lrpc *)conn;
+
+    if (lrpc->shared) SetEvent(lrpc->cancel_event);
+    else rpcrt4_conn_np_cancel_call(conn);
+}
+
+static int rpcrt4_conn_lrpc_wait_for_incoming_data(RpcConnection *conn)
+{
+    return rpcrt4_conn_lrpc_read(conn, NULL, 0);
+}
+
 static size_t rpcrt4_ncacn_np_get_top_of_tower(unsigned char *tower_data,
                                                const char *networkaddr,
                                                const char *endpoint)
@@ -3145,16 +3557,16 @@ static const struct connection_ops conn_protseq_list[] = {
   },
   { "ncalrpc",
     { EPM_PROTOCOL_NCALRPC, EPM_PROTOCOL_PIPE },
-    rpcrt4_conn_np_alloc,
+    rpcrt4_conn_lrpc_alloc,
     rpcrt4_ncalrpc_open,
     rpcrt4_ncalrpc_handoff,
-    rpcrt4_conn_np_read,
-    rpcrt4_conn_np_write,
-    rpcrt4_conn_np_close,
-    rpcrt4_conn_np_close_read,
-    rpcrt4_conn_np_cancel_call,
+    rpcrt4_conn_lrpc_read,
+    rpcrt4_conn_lrpc_write,
+    rpcrt4_conn_lrpc_close,
+    rpcrt4_conn_lrpc_close_read,
+    rpcrt4_conn_lrpc_cancel_call,
     rpcrt4_ncalrpc_np_is_server_listening,
-    rpcrt4_conn_np_wait_for_incoming_data,
+    rpcrt4_conn_lrpc_wait_for_incoming_data,
     rpcrt4_ncalrpc_get_top_of_tower,
     rpcrt4_ncalrpc_parse_top_of_tower,
     NULL,
@@ -84,6 +84,7 @@ static double (__cdecl *square_sun)(sun_t *su);
 static int (__cdecl *test_list_length)(test_list_t *ls);
 static int (__cdecl *sum_fixed_int_3d)(int m[2][3][4]);
 static int (__cdecl *sum_conf_array)(int x[], int n);
+static void (__cdecl *negate_conf_array)(int x[], int n);
 static int (__cdecl *sum_conf_ptr_by_conf_ptr)(int n1, int *n2_then_x1, int *x2);
 static int (__cdecl *sum_unique_conf_array)(int x[], int n);
 static int (__cdecl *sum_unique_conf_ptr)(int *x, int n);
@@ -179,6 +180,7 @@ static void (__cdecl *test_I_RpcBindingInqLocalClientPID)(unsigned int protseq,
     X(test_list_length) \
     X(sum_fixed_int_3d) \
     X(sum_conf_array) \
+    X(negate_conf_array) \
     X(sum_conf_ptr_by_conf_ptr) \
     X(sum_unique_conf_array) \
     X(sum_unique_conf_ptr) \
@@ -471,6 +473,14 @@ int __cdecl s_sum_conf_array(int x[], int n)
   return sum;
 }
 
+void __cdecl s_negate_conf_array(int x[], int n)
+{
+  int i;
+
+  for (i = 0; i < n; i++)
+    x[i] = -x[i];
+}
+
 int __cdecl s_sum_conf_ptr_by_conf_ptr(int n1, int *n2_then_x1, int *x2)
 {
   int i;
@@ -1974,6 +1984,89 @@ static void test_handle_return(void)
     test_handle(handle2);
 }
 
+static void bench_report(const char *shape, unsigned int count, DWORD start)
+{
+    trace("%s %s: %u calls in %lu ms\n", is_interp ? "interp" : "mixed", shape, count, GetTickCount() - start);
+}
+
+/* common procedure shapes, to compare the cost of the marshalling */
+static void bench_tests(void)
+{
+    static const unsigned int count = 1000;
+    static char string[] = "I am a string";
+    int c[] = {1, 2, 3, 4, 5};
+    vector_t v = {1, 2, 3};
+    unsigned int i;
+    DWORD start;
+    int x = 0;
+
+    start = GetTickCount();
+    for (i = 0; i < count; i++) x = sum(i, 1);
+    bench_report("base types", count, start);
+    ok(x == count, "RPC sum got %d\n", x);
+
+    start = GetTickCount();
+    for (i = 0; i < count; i++) square_out(i, &x);
+    bench_report("out pointer", count, start);
+    ok(x == (count - 1) * (count - 1), "RPC square_out got %d\n", x);
+
+    start = GetTickCount();
+    for (i = 0; i < count; i++) x = dot_self(&v);
+    bench_report("simple struct", count, start);
+    ok(x == 14, "RPC dot_self got %d\n", x);
+
+    start = GetTickCount();
+    for (i = 0; i < count; i++) x = str_length(string);
+    bench_report("string", count, start);
+    ok(x == strlen(string), "RPC str_length got %d\n", x);
+
+    start = GetTickCount();
+    for (i = 0; i < count; i++) x = sum_conf_array(c, ARRAY_SIZE(c));
+    bench_report("conformant array", count, start);
+    ok(x == 15, "RPC sum_conf_array got %d\n", x);
+}
+
+/* the first call of a procedure compiles its parameters, later calls use the cached ones */
+static void repeated_call_tests(void)
+{
+    static char string[] = "I am a string";
+    int c[] = {1, 2, 3, 4, 5};
+    vector_t v = {1, 2, 3};
+    unsigned int i;
+    int x;
+
+    for (i = 0; i < 3; i++)
+    {
+        ok(sum(i, 1) == i + 1, "RPC sum failed\n");
+        square_out(i, &x);
+        ok(x == i * i, "RPC square_out got %d\n", x);
+        ok(dot_self(&v) == 14, "RPC dot_self failed\n");
+        ok(str_length(string) == strlen(string), "RPC str_length failed\n");
+        ok(sum_conf_array(c, ARRAY_SIZE(c)) == 15, "RPC sum_conf_array failed\n");
+    }
+}
+
+/* larger than the 64K ncalrpc shared memory rings, so that the packets wrap around */
+static void large_message_tests(void)
+{
+    static const int sizes[] = {20000, 40000, 70001};
+    unsigned int i;
+    int *x, j, n, total;
+
+    x = HeapAlloc(GetProcessHeap(), 0, sizes[ARRAY_SIZE(sizes) - 1] * sizeof(*x));
+    for (i = 0; i < ARRAY_SIZE(sizes); i++)
+    {
+        n = sizes[i];
+        for (j = 0, total = 0; j < n; j++) total += x[j] = j % 100;
+        ok(sum_conf_array(x, n) == total, "RPC sum_conf_array failed for %d elements\n", n);
+
+        negate_conf_array(x, n);
+        for (j = 0; j < n; j++) if (x[j] != -(j % 100)) break;
+        ok(j == n, "RPC negate_conf_array failed at element %d of %d\n", j, n);
+    }
+    HeapFree(GetProcessHeap(), 0, x);
+}
+
 static void
 run_tests(void)
 {
@@ -1983,6 +2076,9 @@ run_tests(void)
   array_tests();
   context_handle_test();
   test_handle_return();
+  repeated_call_tests();
+  large_message_tests();
+  if (winetest_interactive) bench_tests();
 }
 
 static void
@@ -2104,6 +2200,18 @@ client(const char *test)
     ok(RPC_S_OK == RpcStringFreeA(&binding), "RpcStringFree\n");
     ok(RPC_S_OK == RpcBindingFree(&IMixedServer_IfHandle), "RpcBindingFree\n");
   }
+  else if (strcmp(test, "ncalrpc_pipe") == 0)
+  {
+    ok(RPC_S_OK == RpcStringBindingComposeA(NULL, ncalrpc, NULL, guid, NULL, &binding), "RpcStringBindingCompose\n");
+    ok(RPC_S_OK == RpcBindingFromStringBindingA(binding, &IMixedServer_IfHandle), "RpcBindingFromStringBinding\n");
+
+    run_tests();
+    test_I_RpcBindingInqLocalClientPID(RPC_PROTSEQ_LRPC, IMixedServer_IfHandle);
+    test_is_server_listening(IMixedServer_IfHandle, RPC_S_OK);
+
+    ok(RPC_S_OK == RpcStringFreeA(&binding), "RpcStringFree\n");
+    ok(RPC_S_OK == RpcBindingFree(&IMixedServer_IfHandle), "RpcBindingFree\n");
+  }
   else if (strcmp(test, "np_basic") == 0)
   {
     ok(RPC_S_OK == RpcStringBindingComposeA(NULL, np, address_np, pipe, NULL, &binding), "RpcStringBindingCompose\n");
@@ -2202,6 +2310,11 @@ server(void)
 
     /* we don't need to register RPC_C_AUTHN_WINNT for ncalrpc */
     run_client("ncalrpc_secure");
+
+    /* Wine sets up shared memory for ncalrpc, make the client fall back to the pipe */
+    SetEnvironmentVariableA("WINELRPCPIPE", "1");
+    run_client("ncalrpc_pipe");
+    SetEnvironmentVariableA("WINELRPCPIPE", NULL);
   }
   else
     skip("lrpc tests skipped due to earlier failure\n");
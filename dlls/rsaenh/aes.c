@@ -934,6 +934,176 @@ static ulong32 setup_mix(ulong32 temp)
           (Te4_0[byte(temp, 3)]);
 }
 
+#if defined(__i386__) || defined(__x86_64__)
+
+#include <intrin.h>
+#include <immintrin.h>
+
+#define AESNI_TARGET __attribute__((target("aes,sse2")))
+
+static int have_aesni(void)
+{
+    static int supported = -1;
+    int regs[4];
+
+    if (supported == -1) {
+        __cpuid(regs, 1);
+        supported = !!(regs[2] & (1 << 25));
+    }
+    return supported;
+}
+
+/* The round keys computed by aes_setup() are the ones AES-NI uses, dK being
+ * the equivalent inverse cipher schedule that aesdec expects. Only their byte
+ * order differs. */
+static void aesni_convert_key(ulong32 *rk, int count)
+{
+    ulong32 temp;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        temp = rk[i];
+        STORE32H(temp, (unsigned char *)&rk[i]);
+    }
+}
+
+static inline AESNI_TARGET __m128i aesni_encrypt(__m128i b, const __m128i *rk, int Nr)
+{
+    int r;
+
+    b = _mm_xor_si128(b, _mm_loadu_si128(rk));
+    for (r = 1; r < Nr; r++)
+        b = _mm_aesenc_si128(b, _mm_loadu_si128(rk + r));
+    return _mm_aesenclast_si128(b, _mm_loadu_si128(rk + Nr));
+}
+
+static inline AESNI_TARGET __m128i aesni_decrypt(__m128i b, const __m128i *rk, int Nr)
+{
+    int r;
+
+    b = _mm_xor_si128(b, _mm_loadu_si128(rk));
+    for (r = 1; r < Nr; r++)
+        b = _mm_aesdec_si128(b, _mm_loadu_si128(rk + r));
+    return _mm_aesdeclast_si128(b, _mm_loadu_si128(rk + Nr));
+}
+
+/* Four independent blocks at a time keep the AES units busy; this is used
+ * for everything but CBC encryption, where each block depends on the last. */
+static AESNI_TARGET void aesni_ecb(const unsigned char *in, unsigned char *out, unsigned long blocks,
+                                   const aes_key *skey, int enc)
+{
+    const __m128i *rk = (const __m128i *)(enc ? skey->eK : skey->dK);
+    __m128i b0, b1, b2, b3, k;
+    int r, Nr = skey->Nr;
+
+    for (; blocks >= 4; blocks -= 4, in += 64, out += 64) {
+        k  = _mm_loadu_si128(rk);
+        b0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)in), k);
+        b1 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(in + 16)), k);
+        b2 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(in + 32)), k);
+        b3 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(in + 48)), k);
+        if (enc) {
+            for (r = 1; r < Nr; r++) {
+                k  = _mm_loadu_si128(rk + r);
+                b0 = _mm_aesenc_si128(b0, k);
+                b1 = _mm_aesenc_si128(b1, k);
+                b2 = _mm_aesenc_si128(b2, k);
+                b3 = _mm_aesenc_si128(b3, k);
+            }
+            k  = _mm_loadu_si128(rk + Nr);
+            b0 = _mm_aesenclast_si128(b0, k);
+            b1 = _mm_aesenclast_si128(b1, k);
+            b2 = _mm_aesenclast_si128(b2, k);
+            b3 = _mm_aesenclast_si128(b3, k);
+        } else {
+            for (r = 1; r < Nr; r++) {
+                k  = _mm_loadu_si128(rk + r);
+                b0 = _mm_aesdec_si128(b0, k);
+                b1 = _mm_aesdec_si128(b1, k);
+                b2 = _mm_aesdec_si128(b2, k);
+                b3 = _mm_aesdec_si128(b3, k);
+            }
+            k  = _mm_loadu_si128(rk + Nr);
+            b0 = _mm_aesdeclast_si128(b0, k);
+            b1 = _mm_aesdeclast_si128(b1, k);
+            b2 = _mm_aesdeclast_si128(b2, k);
+            b3 = _mm_aesdeclast_si128(b3, k);
+        }
+        _mm_storeu_si128((__m128i *)out, b0);
+        _mm_storeu_si128((__m128i *)(out + 16), b1);
+        _mm_storeu_si128((__m128i *)(out + 32), b2);
+        _mm_storeu_si128((__m128i *)(out + 48), b3);
+    }
+    for (; blocks; blocks--, in += 16, out += 16) {
+        b0 = _mm_loadu_si128((const __m128i *)in);
+        b0 = enc ? aesni_encrypt(b0, rk, Nr) : aesni_decrypt(b0, rk, Nr);
+        _mm_storeu_si128((__m128i *)out, b0);
+    }
+}
+
+static AESNI_TARGET void aesni_cbc_encrypt(const unsigned char *pt, unsigned char *ct, unsigned long blocks,
+                                           unsigned char *iv, const aes_key *skey)
+{
+    const __m128i *rk = (const __m128i *)skey->eK;
+    __m128i chain = _mm_loadu_si128((const __m128i *)iv);
+
+    for (; blocks; blocks--, pt += 16, ct += 16) {
+        chain = _mm_xor_si128(chain, _mm_loadu_si128((const __m128i *)pt));
+        chain = aesni_encrypt(chain, rk, skey->Nr);
+        _mm_storeu_si128((__m128i *)ct, chain);
+    }
+    _mm_storeu_si128((__m128i *)iv, chain);
+}
+
+static AESNI_TARGET void aesni_cbc_decrypt(const unsigned char *ct, unsigned char *pt, unsigned long blocks,
+                                           unsigned char *iv, const aes_key *skey)
+{
+    const __m128i *rk = (const __m128i *)skey->dK;
+    __m128i chain = _mm_loadu_si128((const __m128i *)iv);
+    __m128i c0, c1, c2, c3, b0, b1, b2, b3, k;
+    int r, Nr = skey->Nr;
+
+    /* all ciphertext blocks are loaded before anything is stored, so the
+     * data may be decrypted in place */
+    for (; blocks >= 4; blocks -= 4, ct += 64, pt += 64) {
+        c0 = _mm_loadu_si128((const __m128i *)ct);
+        c1 = _mm_loadu_si128((const __m128i *)(ct + 16));
+        c2 = _mm_loadu_si128((const __m128i *)(ct + 32));
+        c3 = _mm_loadu_si128((const __m128i *)(ct + 48));
+        k  = _mm_loadu_si128(rk);
+        b0 = _mm_xor_si128(c0, k);
+        b1 = _mm_xor_si128(c1, k);
+        b2 = _mm_xor_si128(c2, k);
+        b3 = _mm_xor_si128(c3, k);
+        for (r = 1; r < Nr; r++) {
+            k  = _mm_loadu_si128(rk + r);
+            b0 = _mm_aesdec_si128(b0, k);
+            b1 = _mm_aesdec_si128(b1, k);
+            b2 = _mm_aesdec_si128(b2, k);
+            b3 = _mm_aesdec_si128(b3, k);
+        }
+        k  = _mm_loadu_si128(rk + Nr);
+        b0 = _mm_xor_si128(_mm_aesdeclast_si128(b0, k), chain);
+        b1 = _mm_xor_si128(_mm_aesdeclast_si128(b1, k), c0);
+        b2 = _mm_xor_si128(_mm_aesdeclast_si128(b2, k), c1);
+        b3 = _mm_xor_si128(_mm_aesdeclast_si128(b3, k), c2);
+        chain = c3;
+        _mm_storeu_si128((__m128i *)pt, b0);
+        _mm_storeu_si128((__m128i *)(pt + 16), b1);
+        _mm_storeu_si128((__m128i *)(pt + 32), b2);
+        _mm_storeu_si128((__m128i *)(pt + 48), b3);
+    }
+    for (; blocks; blocks--, ct += 16, pt += 16) {
+        c0 = _mm_loadu_si128((const __m128i *)ct);
+        b0 = _mm_xor_si128(aesni_decrypt(c0, rk, Nr), chain);
+        chain = c0;
+        _mm_storeu_si128((__m128i *)pt, b0);
+    }
+    _mm_storeu_si128((__m128i *)iv, chain);
+}
+
+#endif
+
 int aes_setup(const unsigned char *key, int keylen, int rounds, aes_key *skey)
 {
     int i, j;
@@ -1058,6 +1228,15 @@ int aes_setup(const unsigned char *key, int keylen, int rounds, aes_key *skey)
     *rk++ = *rrk++;
     *rk   = *rrk;
 
+    skey->aesni = 0;
+#if defined(__i386__) || defined(__x86_64__)
+    if (have_aesni()) {
+        aesni_convert_key(skey->eK, 4 * (skey->Nr + 1));
+        aesni_convert_key(skey->dK, 4 * (skey->Nr + 1));
+        skey->aesni = 1;
+    }
+#endif
+
     return CRYPT_OK;
 }
 
@@ -1066,6 +1245,13 @@ void aes_ecb_encrypt(const unsigned char *pt, unsigned char *ct, aes_key *skey)
     ulong32 s0, s1, s2, s3, t0, t1, t2, t3, *rk;
     int Nr, r;
 
+#if defined(__i386__) || defined(__x86_64__)
+    if (skey->aesni) {
+        aesni_ecb(pt, ct, 1, skey, 1);
+        return;
+    }
+#endif
+
     Nr = skey->Nr;
     rk = skey->eK;
 
@@ -1167,6 +1353,13 @@ void aes_ecb_decrypt(const unsigned char *ct, unsigned char *pt, aes_key *skey)
     ulong32 s0, s1, s2, s3, t0, t1, t2, t3, *rk;
     int Nr, r;
 
+#if defined(__i386__) || defined(__x86_64__)
+    if (skey->aesni) {
+        aesni_ecb(ct, pt, 1, skey, 0);
+        return;
+    }
+#endif
+
     Nr = skey->Nr;
     rk = skey->dK;
 
@@ -1264,3 +1457,65 @@ void aes_ecb_decrypt(const unsigned char *ct, unsigned char *pt, aes_key *skey)
         rk[3];
     STORE32H(s3, pt+12);
 }
+
+void aes_ecb_encrypt_blocks(const unsigned char *pt, unsigned char *ct, unsigned long blocks, aes_key *skey)
+{
+#if defined(__i386__) || defined(__x86_64__)
+    if (skey->aesni) {
+        aesni_ecb(pt, ct, blocks, skey, 1);
+        return;
+    }
+#endif
+    for (; blocks; blocks--, pt += 16, ct += 16)
+        aes_ecb_encrypt(pt, ct, skey);
+}
+
+void aes_ecb_decrypt_blocks(const unsigned char *ct, unsigned char *pt, unsigned long blocks, aes_key *skey)
+{
+#if defined(__i386__) || defined(__x86_64__)
+    if (skey->aesni) {
+        aesni_ecb(ct, pt, blocks, skey, 0);
+        return;
+    }
+#endif
+    for (; blocks; blocks--, ct += 16, pt += 16)
+        aes_ecb_decrypt(ct, pt, skey);
+}
+
+/* iv is updated with the last ciphertext block, pt and ct may be equal */
+void aes_cbc_encrypt(const unsigned char *pt, unsigned char *ct, unsigned long blocks, unsigned char *iv, aes_key *skey)
+{
+    unsigned char buf[16];
+    int i;
+
+#if defined(__i386__) || defined(__x86_64__)
+    if (skey->aesni) {
+        aesni_cbc_encrypt(pt, ct, blocks, iv, skey);
+        return;
+    }
+#endif
+    for (; blocks; blocks--, pt += 16, ct += 16) {
+        for (i = 0; i < 16; i++) buf[i] = pt[i] ^ iv[i];
+        aes_ecb_encrypt(buf, ct, skey);
+        memcpy(iv, ct, 16);
+    }
+}
+
+void aes_cbc_decrypt(const unsigned char *ct, unsigned char *pt, unsigned long blocks, unsigned char *iv, aes_key *skey)
+{
+    unsigned char buf[16];
+    int i;
+
+#if defined(__i386__) || defined(__x86_64__)
+    if (skey->aesni) {
+        aesni_cbc_decrypt(ct, pt, blocks, iv, skey);
+        return;
+    }
+#endif
+    for (; blocks; blocks--, ct += 16, pt += 16) {
+        aes_ecb_decrypt(ct, buf, skey);
+        for (i = 0; i < 16; i++) buf[i] ^= iv[i];
+        memcpy(iv, ct, 16);
+        memcpy(pt, buf, 16);
+    }
+}
@@ -298,6 +298,39 @@ BOOL encrypt_block_impl(ALG_ID aiAlgid, DWORD dwKeySpec, KEY_CONTEXT *pKeyContex
     return TRUE;
 }
 
+/* Processes a run of whole blocks in ECB or CBC mode in one go, updating the
+ * chaining vector. Returns FALSE without touching anything if the algorithm
+ * or mode has no multi-block implementation, in which case the caller has to
+ * fall back to encrypt_block_impl. */
+BOOL encrypt_blocks_impl(ALG_ID aiAlgid, KEY_CONTEXT *pKeyContext, DWORD dwMode, BYTE *pbChainVector,
+                         BYTE *pbInOut, DWORD dwBlocks, DWORD enc)
+{
+    switch (aiAlgid) {
+        case CALG_AES:
+        case CALG_AES_128:
+        case CALG_AES_192:
+        case CALG_AES_256:
+            switch (dwMode) {
+                case CRYPT_MODE_ECB:
+                    if (enc)
+                        aes_ecb_encrypt_blocks(pbInOut, pbInOut, dwBlocks, &pKeyContext->aes);
+                    else
+                        aes_ecb_decrypt_blocks(pbInOut, pbInOut, dwBlocks, &pKeyContext->aes);
+                    return TRUE;
+
+                case CRYPT_MODE_CBC:
+                    if (enc)
+                        aes_cbc_encrypt(pbInOut, pbInOut, dwBlocks, pbChainVector, &pKeyContext->aes);
+                    else
+                        aes_cbc_decrypt(pbInOut, pbInOut, dwBlocks, pbChainVector, &pKeyContext->aes);
+                    return TRUE;
+            }
+            break;
+    }
+
+    return FALSE;
+}
+
 BOOL encrypt_stream_impl(ALG_ID aiAlgid, KEY_CONTEXT *pKeyContext, BYTE *stream, DWORD dwLen)
 {
     switch (aiAlgid) {
@@ -1252,6 +1252,127 @@ static void test_aes(int keylen)
     ok(result, "%08lx\n", GetLastError());
 }
 
+static void test_aes_bulk(void)
+{
+    static const BYTE nist_key[16] = {
+        0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
+    static const BYTE nist_plain[64] = {
+        0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+        0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+        0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+        0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10 };
+    /* NIST SP 800-38A F.2.1 CBC-AES128 */
+    static const BYTE nist_cbc[64] = {
+        0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46, 0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d,
+        0x50, 0x86, 0xcb, 0x9b, 0x50, 0x72, 0x19, 0xee, 0x95, 0xdb, 0x11, 0x3a, 0x91, 0x76, 0x78, 0xb2,
+        0x73, 0xbe, 0xd6, 0xb8, 0xe3, 0xc1, 0x74, 0x3b, 0x71, 0x16, 0xe6, 0x9e, 0x22, 0x22, 0x95, 0x16,
+        0x3f, 0xf1, 0xca, 0xa1, 0x68, 0x1f, 0xac, 0x09, 0x12, 0x0e, 0xca, 0x30, 0x75, 0x86, 0xe1, 0xa7 };
+    static const DWORD size = 1024 * 1024;
+    struct
+    {
+        BLOBHEADER h;
+        DWORD key_size;
+        BYTE key[16];
+    } blob;
+    BYTE iv[16], data[64], *plain, *bulk, *chunked;
+    DWORD len, offset, chunk, start, time, i;
+    HCRYPTKEY hKey;
+    BOOL result;
+
+    blob.h.bType = PLAINTEXTKEYBLOB;
+    blob.h.bVersion = CUR_BLOB_VERSION;
+    blob.h.reserved = 0;
+    blob.h.aiKeyAlg = CALG_AES_128;
+    blob.key_size = sizeof(blob.key);
+    memcpy(blob.key, nist_key, sizeof(blob.key));
+    result = CryptImportKey(hProv, (BYTE *)&blob, sizeof(blob), 0, 0, &hKey);
+    ok(result, "CryptImportKey failed, error %#lx.\n", GetLastError());
+    if (!result) return;
+
+    for (i = 0; i < sizeof(iv); i++) iv[i] = i;
+    result = CryptSetKeyParam(hKey, KP_IV, iv, 0);
+    ok(result, "CryptSetKeyParam failed, error %#lx.\n", GetLastError());
+
+    /* four blocks, so the pipelined decryption path is taken as a whole */
+    memcpy(data, nist_plain, sizeof(data));
+    len = sizeof(data);
+    result = CryptEncrypt(hKey, 0, FALSE, 0, data, &len, sizeof(data));
+    ok(result, "CryptEncrypt failed, error %#lx.\n", GetLastError());
+    ok(len == sizeof(data), "Unexpected length %lu.\n", len);
+    ok(!memcmp(data, nist_cbc, sizeof(nist_cbc)), "Unexpected ciphertext.\n");
+
+    result = CryptSetKeyParam(hKey, KP_IV, iv, 0);
+    ok(result, "CryptSetKeyParam failed, error %#lx.\n", GetLastError());
+    result = CryptDecrypt(hKey, 0, FALSE, 0, data, &len);
+    ok(result, "CryptDecrypt failed, error %#lx.\n", GetLastError());
+    ok(!memcmp(data, nist_plain, sizeof(nist_plain)), "Unexpected plaintext.\n");
+
+    plain = malloc(size);
+    bulk = malloc(size);
+    chunked = malloc(size);
+    for (i = 0; i < size; i++) plain[i] = i * 7 + (i >> 11);
+
+    /* one call must give the same result as many calls of varying size */
+    CryptSetKeyParam(hKey, KP_IV, iv, 0);
+    memcpy(bulk, plain, size);
+    len = size;
+    result = CryptEncrypt(hKey, 0, FALSE, 0, bulk, &len, size);
+    ok(result, "CryptEncrypt failed, error %#lx.\n", GetLastError());
+
+    CryptSetKeyParam(hKey, KP_IV, iv, 0);
+    memcpy(chunked, plain, size);
+    for (offset = 0, chunk = 16; offset < size; offset += len, chunk = chunk % 112 + 16)
+    {
+        len = min(chunk, size - offset);
+        result = CryptEncrypt(hKey, 0, FALSE, 0, chunked + offset, &len, len);
+        if (!result) break;
+    }
+    ok(result, "CryptEncrypt failed, error %#lx.\n", GetLastError());
+    ok(!memcmp(bulk, chunked, size), "Chunked encryption differs.\n");
+
+    CryptSetKeyParam(hKey, KP_IV, iv, 0);
+    for (offset = 0, chunk = 16; offset < size; offset += len, chunk = chunk % 112 + 16)
+    {
+        len = min(chunk, size - offset);
+        result = CryptDecrypt(hKey, 0, FALSE, 0, chunked + offset, &len);
+        if (!result) break;
+    }
+    ok(result, "CryptDecrypt failed, error %#lx.\n", GetLastError());
+    ok(!memcmp(plain, chunked, size), "Chunked decryption differs.\n");
+
+    CryptSetKeyParam(hKey, KP_IV, iv, 0);
+    len = size;
+    result = CryptDecrypt(hKey, 0, FALSE, 0, bulk, &len);
+    ok(result, "CryptDecrypt failed, error %#lx.\n", GetLastError());
+    ok(!memcmp(plain, bulk, size), "Decryption differs.\n");
+
+    if (winetest_interactive)
+    {
+        start = GetTickCount();
+        for (i = 0; i < 16; i++)
+        {
+            len = size;
+            CryptEncrypt(hKey, 0, FALSE, 0, bulk, &len, size);
+        }
+        time = GetTickCount() - start;
+        trace("CryptEncrypt AES-128 CBC: %lu MB in %lu ms.\n", 16 * size >> 20, time);
+
+        start = GetTickCount();
+        for (i = 0; i < 16; i++)
+        {
+            len = size;
+            CryptDecrypt(hKey, 0, FALSE, 0, bulk, &len);
+        }
+        time = GetTickCount() - start;
+        trace("CryptDecrypt AES-128 CBC: %lu MB in %lu ms.\n", 16 * size >> 20, time);
+    }
+
+    free(chunked);
+    free(bulk);
+    free(plain);
+    CryptDestroyKey(hKey);
+}
+
 static void test_sha2(void)
 {
     static const unsigned char sha256hash[32] = {
@@ -4246,6 +4367,7 @@ START_TEST(rsaenh)
     test_aes(128);
     test_aes(192);
     test_aes(256);
+    test_aes_bulk();
     test_sha2();
     test_key_derivation("AES");
     test_rc2_import();
@@ -33,6 +33,7 @@
 #include "winuser.h"
 #include "winnt.h"
 #include "winternl.h"
+#include "winioctl.h"
 #include "wine/debug.h"
 #include "wine/list.h"
 #include "ole2.h"
@@ -66,11 +67,31 @@ static const unsigned int max_dll_name_len = 64;
 
 static void *file_buffer;
 static SIZE_T file_buffer_size;
+static SIZE_T file_size;
 static unsigned int handled_count;
 static unsigned int handled_total;
 static WCHAR **handled_dlls;
 static IRegistrar *registrar;
 
+/* how the contents of builtin dlls are installed into the prefix */
+enum install_mode
+{
+    INSTALL_COPY,      /* write a copy of the data */
+    INSTALL_CLONE,     /* share the file extents if the filesystem supports it */
+    INSTALL_HARDLINK,  /* create a hard link to the builtin dll */
+};
+
+static enum install_mode install_mode = -1;
+
+static struct
+{
+    DWORD        start_time;
+    unsigned int copied;
+    unsigned int cloned;
+    unsigned int linked;
+    ULONGLONG    bytes;
+} install_stats;
+
 struct dll_info
 {
     HANDLE            handle;
@@ -219,7 +240,7 @@ static int read_file( const WCHAR *name, void **data, SIZE_T *size )
 
     if ((fd = _wopen( name, O_RDONLY | O_BINARY )) == -1) return 0;
     if (fstat( fd, &st ) == -1) goto done;
-    *size = st.st_size;
+    *size = file_size = st.st_size;
     if (!file_buffer || st.st_size > file_buffer_size)
     {
         VirtualFree( file_buffer, 0, MEM_RELEASE );
@@ -414,8 +435,8 @@ static const WCHAR *enum_load_path( unsigned int idx )
     return _wgetenv( buffer );
 }
 
-/* try to load a pre-compiled fake dll */
-static void *load_fake_dll( const WCHAR *name, SIZE_T *size )
+/* try to load a pre-compiled fake dll, the file name is returned in path */
+static void *load_fake_dll( const WCHAR *name, SIZE_T *size, WCHAR **path_ret )
 {
     const WCHAR *build_dir = _wgetenv( L"WINEBUILDDIR" );
     const WCHAR *path;
@@ -473,11 +494,100 @@ static void *load_fake_dll( const WCHAR *name, SIZE_T *size )
     }
 
 done:
+    if (res == 1)
+    {
+        memmove( file, ptr, (lstrlenW( ptr ) + 1) * sizeof(WCHAR) );
+        if (file[0] == '\\' && file[1] == '?' && file[2] == '?') file[1] = '\\';  /* change \??\ to \\?\ */
+        *path_ret = file;
+        return data;
+    }
     HeapFree( GetProcessHeap(), 0, file );
-    if (res == 1) return data;
     return NULL;
 }
 
+/* check if a file has other names, i.e. was installed as a hard link */
+static BOOL is_hard_link( HANDLE h )
+{
+    BY_HANDLE_FILE_INFORMATION info;
+
+    return GetFileInformationByHandle( h, &info ) && info.nNumberOfLinks > 1;
+}
+
+static enum install_mode get_install_mode(void)
+{
+    WCHAR buffer[16];
+
+    if (install_mode != -1) return install_mode;
+
+    install_mode = INSTALL_CLONE;
+    if (GetEnvironmentVariableW( L"WINE_FAKEDLL_MODE", buffer, ARRAY_SIZE(buffer) ))
+    {
+        if (!wcsicmp( buffer, L"copy" )) install_mode = INSTALL_COPY;
+        else if (!wcsicmp( buffer, L"hardlink" )) install_mode = INSTALL_HARDLINK;
+        else if (wcsicmp( buffer, L"clone" )) WARN( "unknown mode %s\n", debugstr_w(buffer) );
+    }
+    TRACE( "using mode %u\n", install_mode );
+    return install_mode;
+}
+
+/* install the source file without copying its data, if possible */
+static BOOL link_dest_file( HANDLE *h, const WCHAR *dest, const WCHAR *src, SIZE_T size )
+{
+    DUPLICATE_EXTENTS_DATA extents;
+    HANDLE src_handle;
+    DWORD returned;
+    BOOL ret;
+
+    if (get_install_mode() == INSTALL_HARDLINK)
+    {
+        CloseHandle( *h );
+        DeleteFileW( dest );
+        if (CreateHardLinkW( dest, src, NULL ))
+        {
+            *h = 0;
+            install_stats.linked++;
+            return TRUE;
+        }
+        TRACE( "failed to link %s to %s (error=%lu)\n", debugstr_w(dest), debugstr_w(src), GetLastError() );
+        *h = CreateFileW( dest, GENERIC_WRITE, 0, NULL, CREATE_NEW, 0, NULL );
+        if (*h == INVALID_HANDLE_VALUE) *h = 0;
+        return FALSE;
+    }
+
+    src_handle = CreateFileW( src, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, 0, 0 );
+    if (src_handle == INVALID_HANDLE_VALUE) return FALSE;
+
+    extents.FileHandle = src_handle;
+    extents.SourceFileOffset.QuadPart = 0;
+    extents.TargetFileOffset.QuadPart = 0;
+    extents.ByteCount.QuadPart = size;
+    ret = DeviceIoControl( *h, FSCTL_DUPLICATE_EXTENTS_TO_FILE, &extents, sizeof(extents), NULL, 0, &returned, NULL );
+    CloseHandle( src_handle );
+    if (ret) install_stats.cloned++;
+    return ret;
+}
+
+/* write the contents of a fake dll to the destination file */
+static BOOL write_dest_file( HANDLE *h, const WCHAR *dest, const WCHAR *src, const void *data, SIZE_T size )
+{
+    DWORD written;
+    BOOL ret;
+
+    if (!install_stats.start_time) install_stats.start_time = GetTickCount();
+    install_stats.bytes += size;
+
+    /* the file data can only be shared if it is used unmodified */
+    if (src && data == file_buffer && size == file_size && get_install_mode() != INSTALL_COPY &&
+        link_dest_file( h, dest, src, size ))
+        return TRUE;
+    if (!*h) return FALSE;
+
+    ret = (WriteFile( *h, data, size, &written, NULL ) && written == size);
+    if (ret) install_stats.copied++;
+    else ERR( "failed to write to %s (error=%lu)\n", debugstr_w(dest), GetLastError() );
+    return ret;
+}
+
 /* create the fake dll destination file */
 static HANDLE create_dest_file( const WCHAR *name, BOOL delete )
 {
@@ -497,6 +607,16 @@ static HANDLE create_dest_file( const WCHAR *name, BOOL delete )
             DeleteFileW( name );
             return INVALID_HANDLE_VALUE;
         }
+        if (is_hard_link( h ))
+        {
+            /* truncating it would also truncate the builtin dll */
+            CloseHandle( h );
+            DeleteFileW( name );
+            h = CreateFileW( name, GENERIC_WRITE, 0, NULL, CREATE_NEW, 0, NULL );
+            if (h == INVALID_HANDLE_VALUE)
+                ERR( "failed to create %s (error=%lu)\n", debugstr_w(name), GetLastError() );
+            return h;
+        }
         /* truncate the file */
         SetFilePointer( h, 0, NULL, FILE_BEGIN );
         SetEndOfFile( h );
@@ -888,7 +1008,6 @@ static int install_fake_dll( WCHAR *dest, WCHAR *file, BOOL delete, struct list
     int ret;
     SIZE_T size;
     void *data;
-    DWORD written;
     WCHAR *destname = dest + lstrlenW(dest);
     WCHAR *name = wcsrchr( file, '\\' ) + 1;
     WCHAR *end = name + lstrlenW(name);
@@ -913,9 +1032,8 @@ static int install_fake_dll( WCHAR *dest, WCHAR *file, BOOL delete, struct list
         {
             TRACE( "%s -> %s\n", debugstr_w(file), debugstr_w(dest) );
 
-            ret = (WriteFile( h, data, size, &written, NULL ) && written == size);
-            if (!ret) ERR( "failed to write to %s (error=%lu)\n", debugstr_w(dest), GetLastError() );
-            CloseHandle( h );
+            ret = write_dest_file( &h, dest, file, data, size );
+            if (h) CloseHandle( h );
             if (ret) register_fake_dll( dest, data, size, delay_copy );
             else DeleteFileW( dest );
         }
@@ -928,7 +1046,6 @@ static int install_fake_dll( WCHAR *dest, WCHAR *file, BOOL delete, struct list
 static void delay_copy_files( struct list *delay_copy )
 {
     struct delay_copy *copy, *next;
-    DWORD written;
     SIZE_T size;
     void *data;
     HANDLE h;
@@ -947,9 +1064,8 @@ static void delay_copy_files( struct list *delay_copy )
         h = create_dest_file( copy->dest, FALSE );
         if (h && h != INVALID_HANDLE_VALUE)
         {
-            ret = (WriteFile( h, data, size, &written, NULL ) && written == size);
-            if (!ret) ERR( "failed to write to %s (error=%lu)\n", debugstr_w(copy->dest), GetLastError() );
-            CloseHandle( h );
+            ret = write_dest_file( &h, copy->dest, copy->src, data, size );
+            if (h) CloseHandle( h );
             if (!ret) DeleteFileW( copy->dest );
         }
         HeapFree( GetProcessHeap(), 0, copy );
@@ -1045,6 +1161,7 @@ BOOL create_fake_dll( const WCHAR *name, const WCHAR *source )
     BOOL ret;
     SIZE_T size;
     const WCHAR *filename;
+    WCHAR *path;
     void *buffer;
     BOOL delete = !wcscmp( source, L"-" );  /* '-' source means delete the file */
 
@@ -1064,13 +1181,11 @@ BOOL create_fake_dll( const WCHAR *name, const WCHAR *source )
     if (!(h = create_dest_file( name, delete ))) return TRUE;  /* not a fake dll */
     if (h == INVALID_HANDLE_VALUE) return FALSE;
 
-    if ((buffer = load_fake_dll( source, &size )))
+    if ((buffer = load_fake_dll( source, &size, &path )))
     {
-        DWORD written;
-
-        ret = (WriteFile( h, buffer, size, &written, NULL ) && written == size);
+        ret = write_dest_file( &h, name, path, buffer, size );
         if (ret) register_fake_dll( name, buffer, size, &delay_copy );
-        else ERR( "failed to write to %s (error=%lu)\n", debugstr_w(name), GetLastError() );
+        HeapFree( GetProcessHeap(), 0, path );
     }
     else
     {
@@ -1078,7 +1193,7 @@ BOOL create_fake_dll( const WCHAR *name, const WCHAR *source )
         ret = build_fake_dll( h, name );
     }
 
-    CloseHandle( h );
+    if (h) CloseHandle( h );
     if (!ret) DeleteFileW( name );
 
     delay_copy_files( &delay_copy );
@@ -1091,6 +1206,11 @@ BOOL create_fake_dll( const WCHAR *name, const WCHAR *source )
  */
 void cleanup_fake_dlls(void)
 {
+    if (install_stats.start_time)
+        TRACE( "installed %s bytes in %u copied, %u cloned and %u linked files in %lu ms\n",
+               wine_dbgstr_longlong(install_stats.bytes), install_stats.copied, install_stats.cloned,
+               install_stats.linked, GetTickCount() - install_stats.start_time );
+    memset( &install_stats, 0, sizeof(install_stats) );
     if (file_buffer) VirtualFree( file_buffer, 0, MEM_RELEASE );
     file_buffer = NULL;
     HeapFree( GetProcessHeap(), 0, handled_dlls );
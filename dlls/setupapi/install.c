@@ -66,6 +66,10 @@ struct register_dll_info
     int                 modules_size;
     int                 modules_count;
     HMODULE            *modules;
+    int                 jobs;         /* number of worker processes, 0 to register in-process */
+    int                 batch_size;
+    int                 batch_count;
+    WCHAR             **batch;        /* dlls deferred to the worker processes */
 };
 
 typedef BOOL (*iterate_fields_func)( HINF hinf, PCWSTR field, void *arg );
@@ -656,6 +660,272 @@ done:
 }
 
 
+/***********************************************************************
+ *            get_register_jobs
+ *
+ * Number of worker processes to use for dll registration. wineboot sets
+ * __WINE_REGISTER_DLL_JOBS for the processes installing wine.inf during a
+ * prefix update; it is removed from the environment so that the worker
+ * processes and anything they start register dlls in-process as usual.
+ * If the variable isn't set, dlls are registered in-process one after the
+ * other.
+ */
+static int get_register_jobs(void)
+{
+    static int jobs = -1;
+    WCHAR buffer[16];
+
+    if (jobs != -1) return jobs;
+    if (GetEnvironmentVariableW( L"__WINE_REGISTER_DLL_JOBS", buffer, ARRAY_SIZE(buffer) ))
+    {
+        jobs = min( max( wcstol( buffer, NULL, 10 ), 0 ), MAXIMUM_WAIT_OBJECTS );
+        SetEnvironmentVariableW( L"__WINE_REGISTER_DLL_JOBS", NULL );
+    }
+    else jobs = 0;
+    return jobs;
+}
+
+
+/***********************************************************************
+ *            is_pe_dll
+ *
+ * Check the PE header of a file for the dll flag, without loading it.
+ */
+static BOOL is_pe_dll( const WCHAR *path )
+{
+    IMAGE_DOS_HEADER dos;
+    IMAGE_FILE_HEADER file_header;
+    DWORD signature, size;
+    BOOL ret = FALSE;
+    HANDLE file;
+
+    file = CreateFileW( path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, 0, 0 );
+    if (file == INVALID_HANDLE_VALUE) return FALSE;
+
+    if (ReadFile( file, &dos, sizeof(dos), &size, NULL ) && size == sizeof(dos) &&
+        dos.e_magic == IMAGE_DOS_SIGNATURE &&
+        SetFilePointer( file, dos.e_lfanew, NULL, FILE_BEGIN ) != INVALID_SET_FILE_POINTER &&
+        ReadFile( file, &signature, sizeof(signature), &size, NULL ) && size == sizeof(signature) &&
+        signature == IMAGE_NT_SIGNATURE &&
+        ReadFile( file, &file_header, sizeof(file_header), &size, NULL ) && size == sizeof(file_header))
+        ret = !!(file_header.Characteristics & IMAGE_FILE_DLL);
+
+    CloseHandle( file );
+    return ret;
+}
+
+
+/***********************************************************************
+ *            add_to_register_batch
+ *
+ * Defer registration of a dll to the worker processes. Takes ownership of path.
+ */
+static BOOL add_to_register_batch( struct register_dll_info *info, WCHAR *path )
+{
+    if (info->batch_count >= info->batch_size)
+    {
+        int new_size = max( 64, info->batch_size * 2 );
+        WCHAR **new = info->batch ?
+            HeapReAlloc( GetProcessHeap(), 0, info->batch, new_size * sizeof(*new) ) :
+            HeapAlloc( GetProcessHeap(), 0, new_size * sizeof(*new) );
+        if (!new) return FALSE;
+        info->batch_size = new_size;
+        info->batch = new;
+    }
+    info->batch[info->batch_count++] = path;
+    return TRUE;
+}
+
+
+/***********************************************************************
+ *            find_batch_entry
+ *
+ * Find the deferred dll with a given file name.
+ */
+static int find_batch_entry( struct register_dll_info *info, const char *name )
+{
+    WCHAR nameW[MAX_PATH];
+    const WCHAR *file;
+    int i;
+
+    if (!MultiByteToWideChar( CP_ACP, 0, name, -1, nameW, ARRAY_SIZE(nameW) )) return -1;
+    for (i = 0; i < info->batch_count; i++)
+    {
+        if ((file = wcsrchr( info->batch[i], '\\' ))) file++;
+        else file = info->batch[i];
+        if (!wcsicmp( file, nameW )) return i;
+    }
+    return -1;
+}
+
+
+/***********************************************************************
+ *            get_batch_dependencies
+ *
+ * Mark the deferred dlls that a deferred dll imports, directly or through
+ * delay imports. Its registration code may use the classes and type
+ * libraries registered by these, so it is only started once they are
+ * registered; dlls that don't import each other are independent and can
+ * be registered at the same time.
+ */
+static void get_batch_dependencies( struct register_dll_info *info, int index, BYTE *deps )
+{
+    const IMAGE_IMPORT_DESCRIPTOR *imports;
+    const IMAGE_DELAYLOAD_DESCRIPTOR *delay;
+    HMODULE module;
+    BYTE *base;
+    ULONG size;
+    int dep;
+
+    if (!(module = LoadLibraryExW( info->batch[index], 0, LOAD_LIBRARY_AS_IMAGE_RESOURCE ))) return;
+    base = (BYTE *)((ULONG_PTR)module & ~(ULONG_PTR)3);
+
+    if ((imports = RtlImageDirectoryEntryToData( (HMODULE)base, TRUE, IMAGE_DIRECTORY_ENTRY_IMPORT, &size )))
+    {
+        for (; imports->Name; imports++)
+            if ((dep = find_batch_entry( info, (const char *)base + imports->Name )) != -1) deps[dep] = 1;
+    }
+    if ((delay = RtlImageDirectoryEntryToData( (HMODULE)base, TRUE, IMAGE_DIRECTORY_ENTRY_DELAY_IMPORT, &size )))
+    {
+        for (; delay->DllNameRVA; delay++)
+            if (delay->Attributes.RvaBased &&
+                (dep = find_batch_entry( info, (const char *)base + delay->DllNameRVA )) != -1) deps[dep] = 1;
+    }
+    deps[index] = 0;
+    FreeLibrary( module );
+}
+
+
+/***********************************************************************
+ *            start_register_process
+ *
+ * Start a regsvr32 process registering a single dll.
+ */
+static HANDLE start_register_process( const WCHAR *regsvr32, const WCHAR *path )
+{
+    STARTUPINFOW si;
+    PROCESS_INFORMATION pi;
+    WCHAR *cmdline;
+    size_t len;
+
+    len = lstrlenW( regsvr32 ) + lstrlenW( path ) + ARRAY_SIZE(L"\"\" /s \"\"");
+    if (!(cmdline = HeapAlloc( GetProcessHeap(), 0, len * sizeof(WCHAR) ))) return 0;
+    swprintf( cmdline, len, L"\"%s\" /s \"%s\"", regsvr32, path );
+    TRACE( "starting %s\n", debugstr_w(cmdline) );
+
+    memset( &si, 0, sizeof(si) );
+    si.cb = sizeof(si);
+    if (CreateProcessW( regsvr32, cmdline, NULL, NULL, FALSE, CREATE_NO_WINDOW, NULL, NULL, &si, &pi ))
+        CloseHandle( pi.hThread );
+    else
+        pi.hProcess = 0;
+
+    HeapFree( GetProcessHeap(), 0, cmdline );
+    return pi.hProcess;
+}
+
+
+/***********************************************************************
+ *            register_dll_batch
+ *
+ * Register the deferred dlls, each in its own regsvr32 process, running
+ * up to info->jobs processes at a time. A dll is started once the dlls it
+ * depends on are registered. Dlls that fail to register in a worker
+ * process are registered again in-process, so that the failure is
+ * reported the same way as without worker processes.
+ */
+static BOOL register_dll_batch( struct register_dll_info *info )
+{
+    enum { BATCH_PENDING, BATCH_RUNNING, BATCH_DONE };
+    HANDLE processes[MAXIMUM_WAIT_OBJECTS];
+    int running[MAXIMUM_WAIT_OBJECTS];
+    WCHAR regsvr32[MAX_PATH];
+    int i, j, n = info->batch_count, count = 0, done = 0;
+    BYTE *deps, *state;
+    BOOL ret = TRUE;
+    DWORD res, code;
+
+    if (!n) return TRUE;
+
+    GetSystemDirectoryW( regsvr32, MAX_PATH - ARRAY_SIZE(L"\\regsvr32.exe") );
+    lstrcatW( regsvr32, L"\\regsvr32.exe" );
+
+    deps = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, n * n );
+    state = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, n );
+    if (!deps || !state)
+    {
+        for (i = 0; i < n; i++) do_register_dll( info, info->batch[i], FLG_REGSVR_DLLREGISTER, 60, NULL );
+        done = n;
+    }
+    else for (i = 0; i < n; i++) get_batch_dependencies( info, i, deps + i * n );
+
+    while (done < n)
+    {
+        while (count < info->jobs && done + count < n)
+        {
+            for (i = 0; i < n; i++)
+            {
+                if (state[i] != BATCH_PENDING) continue;
+                for (j = 0; j < n; j++) if (deps[i * n + j] && state[j] != BATCH_DONE) break;
+                if (j == n) break;
+            }
+            if (i == n)
+            {
+                if (count) break;
+                /* the remaining dlls depend on each other, start the first one */
+                for (i = 0; state[i] != BATCH_PENDING; i++) ;
+            }
+
+            if ((processes[count] = start_register_process( regsvr32, info->batch[i] )))
+            {
+                running[count++] = i;
+                state[i] = BATCH_RUNNING;
+            }
+            else
+            {
+                WARN( "failed to start regsvr32 for %s, registering in-process\n", debugstr_w(info->batch[i]) );
+                do_register_dll( info, info->batch[i], FLG_REGSVR_DLLREGISTER, 60, NULL );
+                state[i] = BATCH_DONE;
+                done++;
+            }
+        }
+        if (!count) continue;
+
+        res = WaitForMultipleObjects( count, processes, FALSE, INFINITE );
+        if (res >= WAIT_OBJECT_0 + count)
+        {
+            ERR( "failed to wait for regsvr32 processes, error %lu\n", GetLastError() );
+            ret = FALSE;
+            break;
+        }
+        j = res - WAIT_OBJECT_0;
+        i = running[j];
+        if (!GetExitCodeProcess( processes[j], &code ) || code)
+        {
+            WARN( "regsvr32 failed to register %s, code %#lx, registering in-process\n",
+                  debugstr_w(info->batch[i]), code );
+            do_register_dll( info, info->batch[i], FLG_REGSVR_DLLREGISTER, 60, NULL );
+        }
+        CloseHandle( processes[j] );
+        processes[j] = processes[--count];
+        running[j] = running[count];
+        state[i] = BATCH_DONE;
+        done++;
+    }
+
+    if (count) WaitForMultipleObjects( count, processes, TRUE, INFINITE );
+    for (i = 0; i < count; i++) CloseHandle( processes[i] );
+
+    HeapFree( GetProcessHeap(), 0, deps );
+    HeapFree( GetProcessHeap(), 0, state );
+    for (i = 0; i < n; i++) HeapFree( GetProcessHeap(), 0, info->batch[i] );
+    HeapFree( GetProcessHeap(), 0, info->batch );
+    info->batch = NULL;
+    info->batch_count = info->batch_size = 0;
+    return ret;
+}
+
+
 /***********************************************************************
  *            register_dlls_callback
  *
@@ -698,6 +968,14 @@ static BOOL register_dlls_callback( HINF hinf, PCWSTR field, void *arg )
         if (SetupGetStringFieldW( &context, 6, buffer, ARRAY_SIZE( buffer ), NULL ))
             args = buffer;
 
+        /* plain DllRegisterServer calls can run in a worker process */
+        if (info->jobs && flags == FLG_REGSVR_DLLREGISTER && !args && is_pe_dll( path ) &&
+            add_to_register_batch( info, path ))
+        {
+            path = NULL;
+            continue;
+        }
+
         ret = do_register_dll( info, path, flags, timeout, args );
 
     done:
@@ -1123,10 +1401,15 @@ BOOL WINAPI SetupInstallFromInfSectionW( HWND owner, HINF hinf, PCWSTR section,
             info.callback         = callback;
             info.callback_context = context;
         }
+        /* the callback expects to be notified about each dll in turn */
+        else info.jobs = get_register_jobs();
 
         hr = CoInitialize(NULL);
 
         ret = iterate_section_fields( hinf, section, L"RegisterDlls", register_dlls_callback, &info );
+        if (ret) ret = register_dll_batch( &info );
+        for (i = 0; i < info.batch_count; i++) HeapFree( GetProcessHeap(), 0, info.batch[i] );
+        HeapFree( GetProcessHeap(), 0, info.batch );
         for (i = 0; i < info.modules_count; i++) FreeLibrary( info.modules[i] );
 
         if (SUCCEEDED(hr))
@@ -13087,6 +13087,62 @@ done:
     flush_events();
 }
 
+static DWORD CALLBACK post_thread_message_proc(void *arg)
+{
+    BOOL ret = PostThreadMessageA(PtrToUlong(arg), WM_USER, 0, 0);
+    ok(ret, "PostThreadMessage failed, error %lu\n", GetLastError());
+    return 0;
+}
+
+static void post_thread_message_from_thread(void)
+{
+    HANDLE thread;
+
+    thread = CreateThread(NULL, 0, post_thread_message_proc, ULongToPtr(GetCurrentThreadId()), 0, NULL);
+    ok(thread != NULL, "CreateThread failed, error %lu\n", GetLastError());
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+}
+
+/* messages posted by other threads must be seen after the queue was found empty */
+static void test_queue_status_other_thread(void)
+{
+    DWORD status, ret;
+    unsigned int i;
+    MSG msg;
+
+    flush_events();
+    for (i = 0; i < 10; i++)
+    {
+        ret = PeekMessageA(&msg, NULL, 0, 0, PM_REMOVE);
+        ok(!ret, "got message %#x\n", msg.message);
+    }
+    status = GetQueueStatus(QS_POSTMESSAGE);
+    ok(!status, "GetQueueStatus returned %#lx\n", status);
+
+    post_thread_message_from_thread();
+    status = GetQueueStatus(QS_POSTMESSAGE);
+    ok(status == MAKELONG(QS_POSTMESSAGE, QS_POSTMESSAGE), "GetQueueStatus returned %#lx\n", status);
+    ret = PeekMessageA(&msg, NULL, 0, 0, PM_REMOVE);
+    ok(ret && msg.message == WM_USER, "expected WM_USER, got %#x\n", ret ? msg.message : 0);
+
+    for (i = 0; i < 10; i++)
+    {
+        ret = PeekMessageA(&msg, NULL, 0, 0, PM_REMOVE);
+        ok(!ret, "got message %#x\n", msg.message);
+    }
+    ret = MsgWaitForMultipleObjects(0, NULL, FALSE, 0, QS_POSTMESSAGE);
+    ok(ret == WAIT_TIMEOUT, "MsgWaitForMultipleObjects returned %#lx\n", ret);
+
+    post_thread_message_from_thread();
+    ret = MsgWaitForMultipleObjects(0, NULL, FALSE, 0, QS_POSTMESSAGE);
+    ok(ret == WAIT_OBJECT_0, "MsgWaitForMultipleObjects returned %#lx\n", ret);
+    ret = PeekMessageA(&msg, NULL, 0, 0, PM_REMOVE);
+    ok(ret && msg.message == WM_USER, "expected WM_USER, got %#x\n", ret ? msg.message : 0);
+    ret = PeekMessageA(&msg, NULL, 0, 0, PM_REMOVE);
+    ok(!ret, "got message %#x\n", msg.message);
+}
+
 static void test_PeekMessage3(void)
 {
     HWND hwnd;
@@ -19044,6 +19100,7 @@ START_TEST(msg)
     test_PeekMessage();
     test_PeekMessage2();
     test_PeekMessage3();
+    test_queue_status_other_thread();
     test_WaitForInputIdle( test_argv[0] );
     test_scrollwindowex();
     test_messages();
@@ -335,6 +335,42 @@ static HRESULT push_instr_uint_bstr(compile_ctx_t *ctx, vbsop_t op, unsigned arg
     return S_OK;
 }
 
+/*
+ * Binds an identifier to a local variable slot of the function being compiled.
+ * Non-negative refs index declared variables, negative refs index arguments.
+ * Only variables declared before the reference are bound, everything else is
+ * still looked up by name at run time.
+ */
+static BOOL bind_local(compile_ctx_t *ctx, const WCHAR *name, int *ref)
+{
+    dim_decl_t *dim_decl;
+    unsigned i;
+
+    if(!ctx->func || ctx->func->type == FUNC_GLOBAL)
+        return FALSE;
+
+    /* Function name refers to its return value. */
+    if((ctx->func->type == FUNC_FUNCTION || ctx->func->type == FUNC_PROPGET)
+       && !wcsicmp(name, ctx->func->name))
+        return FALSE;
+
+    for(dim_decl = ctx->dim_decls, i = 0; dim_decl; dim_decl = dim_decl->next, i++) {
+        if(!wcsicmp(dim_decl->name, name)) {
+            *ref = i;
+            return TRUE;
+        }
+    }
+
+    for(i = 0; i < ctx->func->arg_cnt; i++) {
+        if(!wcsicmp(ctx->func->args[i].name, name)) {
+            *ref = -(int)i - 1;
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
 #define LABEL_FLAG 0x80000000
 
 static unsigned alloc_label(compile_ctx_t *ctx)
@@ -475,6 +511,7 @@ static HRESULT compile_member_call_expression(compile_ctx_t *ctx, member_express
 static HRESULT compile_member_expression(compile_ctx_t *ctx, member_expression_t *expr)
 {
     expression_t *const_expr;
+    int local_ref;
 
     if (expr->obj_expr) /* FIXME: we should probably have a dedicated opcode as well */
         return compile_member_call_expression(ctx, expr, 0, TRUE);
@@ -483,6 +520,9 @@ static HRESULT compile_member_expression(compile_ctx_t *ctx, member_expression_t
     if(const_expr)
         return compile_expression(ctx, const_expr);
 
+    if(bind_local(ctx, expr->identifier, &local_ref))
+        return push_instr_int(ctx, OP_local, local_ref);
+
     return push_instr_bstr(ctx, OP_ident, expr->identifier);
 }
 
@@ -840,23 +880,32 @@ static HRESULT compile_forto_statement(compile_ctx_t *ctx, forto_statement_t *st
 {
     statement_ctx_t loop_ctx = {2};
     unsigned step_instr, instr;
-    BSTR identifier;
+    BSTR identifier = NULL;
+    BOOL is_local;
+    int local_ref;
     HRESULT hres;
 
-    identifier = alloc_bstr_arg(ctx, stat->identifier);
-    if(!identifier)
-        return E_OUTOFMEMORY;
+    is_local = bind_local(ctx, stat->identifier, &local_ref);
+    if(!is_local) {
+        identifier = alloc_bstr_arg(ctx, stat->identifier);
+        if(!identifier)
+            return E_OUTOFMEMORY;
+    }
 
     hres = compile_expression(ctx, stat->from_expr);
     if(FAILED(hres))
         return hres;
 
     /* FIXME: Assign should happen after both expressions evaluation. */
-    instr = push_instr(ctx, OP_assign_ident);
+    instr = push_instr(ctx, is_local ? OP_assign_local : OP_assign_ident);
     if(!instr)
         return E_OUTOFMEMORY;
-    instr_ptr(ctx, instr)->arg1.bstr = identifier;
-    instr_ptr(ctx, instr)->arg2.uint = 0;
+    if(is_local) {
+        instr_ptr(ctx, instr)->arg1.lng = local_ref;
+    }else {
+        instr_ptr(ctx, instr)->arg1.bstr = identifier;
+        instr_ptr(ctx, instr)->arg2.uint = 0;
+    }
 
     hres = compile_expression(ctx, stat->to_expr);
     if(FAILED(hres))
@@ -882,10 +931,13 @@ static HRESULT compile_forto_statement(compile_ctx_t *ctx, forto_statement_t *st
     if(!loop_ctx.for_end_label)
         return E_OUTOFMEMORY;
 
-    step_instr = push_instr(ctx, OP_step);
+    step_instr = push_instr(ctx, is_local ? OP_step_local : OP_step);
     if(!step_instr)
         return E_OUTOFMEMORY;
-    instr_ptr(ctx, step_instr)->arg2.bstr = identifier;
+    if(is_local)
+        instr_ptr(ctx, step_instr)->arg2.lng = local_ref;
+    else
+        instr_ptr(ctx, step_instr)->arg2.bstr = identifier;
     instr_ptr(ctx, step_instr)->arg1.uint = loop_ctx.for_end_label;
 
     if(!emit_catch(ctx, 2))
@@ -896,10 +948,13 @@ static HRESULT compile_forto_statement(compile_ctx_t *ctx, forto_statement_t *st
         return hres;
 
     /* FIXME: Error handling can't be done compatible with native using OP_incc here. */
-    instr = push_instr(ctx, OP_incc);
+    instr = push_instr(ctx, is_local ? OP_incc_local : OP_incc);
     if(!instr)
         return E_OUTOFMEMORY;
-    instr_ptr(ctx, instr)->arg1.bstr = identifier;
+    if(is_local)
+        instr_ptr(ctx, instr)->arg1.lng = local_ref;
+    else
+        instr_ptr(ctx, instr)->arg1.bstr = identifier;
 
     hres = push_instr_addr(ctx, OP_jmp, step_instr);
     if(FAILED(hres))
@@ -1038,6 +1093,7 @@ static HRESULT compile_assignment(compile_ctx_t *ctx, expression_t *left, expres
     call_expression_t *call_expr = NULL;
     member_expression_t *member_expr;
     unsigned args_cnt = 0;
+    int local_ref;
     vbsop_t op;
     HRESULT hres;
 
@@ -1075,7 +1131,10 @@ static HRESULT compile_assignment(compile_ctx_t *ctx, expression_t *left, expres
             return hres;
     }
 
-    hres = push_instr_bstr_uint(ctx, op, member_expr->identifier, args_cnt);
+    if(!call_expr && !member_expr->obj_expr && bind_local(ctx, member_expr->identifier, &local_ref))
+        hres = push_instr_int(ctx, is_set ? OP_set_local : OP_assign_local, local_ref);
+    else
+        hres = push_instr_bstr_uint(ctx, op, member_expr->identifier, args_cnt);
     if(FAILED(hres))
         return hres;
 
@@ -17,6 +17,8 @@
  */
 
 #include <assert.h>
+#include <limits.h>
+#include <math.h>
 
 #include "vbscript.h"
 
@@ -96,18 +98,16 @@ static BOOL lookup_dynamic_vars(dynamic_var_t *var, const WCHAR *name, ref_t *re
 
 static BOOL lookup_global_vars(ScriptDisp *script, const WCHAR *name, ref_t *ref)
 {
-    dynamic_var_t **vars = script->global_vars;
-    size_t i, cnt = script->global_vars_cnt;
+    dynamic_var_t *var;
+    size_t i;
 
-    for(i = 0; i < cnt; i++) {
-        if(!wcsicmp(vars[i]->name, name)) {
-            ref->type = vars[i]->is_const ? REF_CONST : REF_VAR;
-            ref->u.v = &vars[i]->v;
-            return TRUE;
-        }
-    }
+    if(!find_global_var(script, name, &i))
+        return FALSE;
 
-    return FALSE;
+    var = script->global_vars[i];
+    ref->type = var->is_const ? REF_CONST : REF_VAR;
+    ref->u.v = &var->v;
+    return TRUE;
 }
 
 static BOOL lookup_global_funcs(ScriptDisp *script, const WCHAR *name, ref_t *ref)
@@ -385,6 +385,135 @@ static HRESULT stack_pop_val(exec_ctx_t *ctx, variant_val_t *r)
     return S_OK;
 }
 
+/*
+ * Fast paths for the operand types that dominate script arithmetic. They give
+ * the same results as oleaut32 and return FALSE, leaving the work to it, for
+ * any other type combination or when an integer result would overflow.
+ */
+static inline BOOL get_num_operand(const VARIANT *v, LONG *i, double *d)
+{
+    switch(V_VT(v)) {
+    case VT_I2:
+        *d = *i = V_I2(v);
+        return TRUE;
+    case VT_I4:
+        *d = *i = V_I4(v);
+        return TRUE;
+    case VT_R8:
+        *d = V_R8(v);
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
+static BOOL fast_arith(vbsop_t op, const VARIANT *l, const VARIANT *r, VARIANT *res)
+{
+    double ld, rd;
+    LONGLONG n;
+    LONG li, ri;
+
+    if(!get_num_operand(l, &li, &ld) || !get_num_operand(r, &ri, &rd))
+        return FALSE;
+
+    if(V_VT(l) == VT_R8 || V_VT(r) == VT_R8) {
+        V_VT(res) = VT_R8;
+        switch(op) {
+        case OP_add: V_R8(res) = ld + rd; break;
+        case OP_sub: V_R8(res) = ld - rd; break;
+        case OP_mul: V_R8(res) = ld * rd; break;
+        DEFAULT_UNREACHABLE;
+        }
+        return TRUE;
+    }
+
+    switch(op) {
+    case OP_add: n = (LONGLONG)li + ri; break;
+    case OP_sub: n = (LONGLONG)li - ri; break;
+    case OP_mul: n = (LONGLONG)li * ri; break;
+    DEFAULT_UNREACHABLE;
+    }
+
+    if(V_VT(l) == VT_I2 && V_VT(r) == VT_I2) {
+        if(n < SHRT_MIN || n > SHRT_MAX)
+            return FALSE;
+        V_VT(res) = VT_I2;
+        V_I2(res) = n;
+    }else {
+        if(n < INT_MIN || n > INT_MAX)
+            return FALSE;
+        V_VT(res) = VT_I4;
+        V_I4(res) = n;
+    }
+    return TRUE;
+}
+
+static BOOL fast_cmp(const VARIANT *l, const VARIANT *r, HRESULT *ret)
+{
+    double ld, rd;
+    LONG li, ri;
+
+    if(V_VT(l) == VT_BSTR && V_VT(r) == VT_BSTR) {
+        UINT len = SysStringLen(V_BSTR(l));
+
+        /* Only binary equal strings, anything else needs a locale aware compare. */
+        if(len != SysStringLen(V_BSTR(r)) || (len && memcmp(V_BSTR(l), V_BSTR(r), len * sizeof(WCHAR))))
+            return FALSE;
+        *ret = VARCMP_EQ;
+        return TRUE;
+    }
+
+    if(!get_num_operand(l, &li, &ld) || !get_num_operand(r, &ri, &rd))
+        return FALSE;
+
+    if(V_VT(l) == VT_R8 || V_VT(r) == VT_R8) {
+        if(isnan(ld) || isnan(rd))
+            return FALSE;
+        *ret = ld < rd ? VARCMP_LT : ld > rd ? VARCMP_GT : VARCMP_EQ;
+    }else {
+        *ret = li < ri ? VARCMP_LT : li > ri ? VARCMP_GT : VARCMP_EQ;
+    }
+    return TRUE;
+}
+
+static HRESULT var_cmp(exec_ctx_t *ctx, VARIANT *l, VARIANT *r)
+{
+    HRESULT hres;
+
+    TRACE("%s %s\n", debugstr_variant(l), debugstr_variant(r));
+
+    if(fast_cmp(l, r, &hres))
+        return hres;
+
+    /* FIXME: Fix comparing string to number */
+
+    return VarCmp(l, r, ctx->script->lcid, 0);
+}
+
+static BOOL fast_concat(const VARIANT *l, const VARIANT *r, VARIANT *res)
+{
+    UINT llen, rlen;
+    BSTR str;
+
+    if(V_VT(l) != VT_BSTR || V_VT(r) != VT_BSTR)
+        return FALSE;
+
+    llen = SysStringLen(V_BSTR(l));
+    rlen = SysStringLen(V_BSTR(r));
+    str = SysAllocStringLen(NULL, llen + rlen);
+    if(!str)
+        return FALSE;
+
+    if(llen)
+        memcpy(str, V_BSTR(l), llen * sizeof(WCHAR));
+    if(rlen)
+        memcpy(str + llen, V_BSTR(r), rlen * sizeof(WCHAR));
+
+    V_VT(res) = VT_BSTR;
+    V_BSTR(res) = str;
+    return TRUE;
+}
+
 static HRESULT stack_assume_val(exec_ctx_t *ctx, unsigned n)
 {
     VARIANT *v = stack_top(ctx, n);
@@ -822,6 +951,30 @@ static HRESULT interp_ident(exec_ctx_t *ctx)
     return stack_push(ctx, &v);
 }
 
+static inline VARIANT *get_local_var(exec_ctx_t *ctx, int ref)
+{
+    if(ref < 0) {
+        assert(-ref-1 < ctx->func->arg_cnt);
+        return ctx->args - ref - 1;
+    }
+
+    assert(ref < ctx->func->var_cnt);
+    return ctx->vars + ref;
+}
+
+static HRESULT interp_local(exec_ctx_t *ctx)
+{
+    const int ref = ctx->instr->arg1.lng;
+    VARIANT *var, v;
+
+    TRACE("%d\n", ref);
+
+    var = get_local_var(ctx, ref);
+    V_VT(&v) = VT_BYREF|VT_VARIANT;
+    V_BYREF(&v) = V_VT(var) == (VT_VARIANT|VT_BYREF) ? V_VARIANTREF(var) : var;
+    return stack_push(ctx, &v);
+}
+
 static HRESULT assign_value(exec_ctx_t *ctx, VARIANT *dst, VARIANT *src, WORD flags)
 {
     VARIANT value;
@@ -979,6 +1132,50 @@ static HRESULT interp_set_ident(exec_ctx_t *ctx)
     return S_OK;
 }
 
+static HRESULT assign_local(exec_ctx_t *ctx, int ref, WORD flags)
+{
+    VARIANT *v = get_local_var(ctx, ref);
+    HRESULT hres;
+
+    if(V_VT(v) == (VT_VARIANT|VT_BYREF))
+        v = V_VARIANTREF(v);
+
+    if(V_VT(v) == (VT_ARRAY|VT_BYREF|VT_VARIANT)) {
+        FIXME("non-array assign\n");
+        return E_NOTIMPL;
+    }
+
+    hres = assign_value(ctx, v, stack_top(ctx, 0), flags);
+    if(FAILED(hres))
+        return hres;
+
+    stack_popn(ctx, 1);
+    return S_OK;
+}
+
+static HRESULT interp_assign_local(exec_ctx_t *ctx)
+{
+    const int ref = ctx->instr->arg1.lng;
+
+    TRACE("%d\n", ref);
+
+    return assign_local(ctx, ref, DISPATCH_PROPERTYPUT);
+}
+
+static HRESULT interp_set_local(exec_ctx_t *ctx)
+{
+    const int ref = ctx->instr->arg1.lng;
+    HRESULT hres;
+
+    TRACE("%d\n", ref);
+
+    hres = stack_assume_disp(ctx, 0, NULL);
+    if(FAILED(hres))
+        return hres;
+
+    return assign_local(ctx, ref, DISPATCH_PROPERTYPUTREF);
+}
+
 static HRESULT interp_assign_member(exec_ctx_t *ctx)
 {
     BSTR identifier = ctx->instr->arg1.bstr;
@@ -1204,12 +1401,11 @@ static HRESULT interp_dim(exec_ctx_t *ctx)
     assert(array_id < ctx->func->array_cnt);
 
     if(ctx->func->type == FUNC_GLOBAL) {
-        unsigned i;
-        for(i = 0; i < script_obj->global_vars_cnt; i++) {
-            if(!wcsicmp(script_obj->global_vars[i]->name, ident))
-                break;
-        }
-        assert(i < script_obj->global_vars_cnt);
+        size_t i;
+        BOOL found;
+
+        found = find_global_var(script_obj, ident, &i);
+        assert(found);
         v = &script_obj->global_vars[i]->v;
         array_ref = &script_obj->global_vars[i]->array;
     }else {
@@ -1375,34 +1571,24 @@ static HRESULT interp_redim_preserve(exec_ctx_t *ctx)
     }
 }
 
-static HRESULT interp_step(exec_ctx_t *ctx)
+static HRESULT do_step(exec_ctx_t *ctx, VARIANT *var)
 {
-    const BSTR ident = ctx->instr->arg2.bstr;
     BOOL gteq_zero;
     VARIANT zero;
-    ref_t ref;
     HRESULT hres;
 
-    TRACE("%s\n", debugstr_w(ident));
+    if(V_VT(var) == (VT_VARIANT|VT_BYREF))
+        var = V_VARIANTREF(var);
 
     V_VT(&zero) = VT_I2;
     V_I2(&zero) = 0;
-    hres = VarCmp(stack_top(ctx, 0), &zero, ctx->script->lcid, 0);
+    hres = var_cmp(ctx, stack_top(ctx, 0), &zero);
     if(FAILED(hres))
         return hres;
 
     gteq_zero = hres == VARCMP_GT || hres == VARCMP_EQ;
 
-    hres = lookup_identifier(ctx, ident, VBDISP_ANY, &ref);
-    if(FAILED(hres))
-        return hres;
-
-    if(ref.type != REF_VAR) {
-        FIXME("%s is not REF_VAR\n", debugstr_w(ident));
-        return E_FAIL;
-    }
-
-    hres = VarCmp(ref.u.v, stack_top(ctx, 1), ctx->script->lcid, 0);
+    hres = var_cmp(ctx, var, stack_top(ctx, 1));
     if(FAILED(hres))
         return hres;
 
@@ -1415,6 +1601,35 @@ static HRESULT interp_step(exec_ctx_t *ctx)
     return S_OK;
 }
 
+static HRESULT interp_step(exec_ctx_t *ctx)
+{
+    const BSTR ident = ctx->instr->arg2.bstr;
+    ref_t ref;
+    HRESULT hres;
+
+    TRACE("%s\n", debugstr_w(ident));
+
+    hres = lookup_identifier(ctx, ident, VBDISP_ANY, &ref);
+    if(FAILED(hres))
+        return hres;
+
+    if(ref.type != REF_VAR) {
+        FIXME("%s is not REF_VAR\n", debugstr_w(ident));
+        return E_FAIL;
+    }
+
+    return do_step(ctx, ref.u.v);
+}
+
+static HRESULT interp_step_local(exec_ctx_t *ctx)
+{
+    const int ref = ctx->instr->arg2.lng;
+
+    TRACE("%d\n", ref);
+
+    return do_step(ctx, get_local_var(ctx, ref));
+}
+
 static HRESULT interp_newenum(exec_ctx_t *ctx)
 {
     variant_val_t v;
@@ -1892,15 +2107,6 @@ static HRESULT interp_imp(exec_ctx_t *ctx)
     return stack_push(ctx, &v);
 }
 
-static HRESULT var_cmp(exec_ctx_t *ctx, VARIANT *l, VARIANT *r)
-{
-    TRACE("%s %s\n", debugstr_variant(l), debugstr_variant(r));
-
-    /* FIXME: Fix comparing string to number */
-
-    return VarCmp(l, r, ctx->script->lcid, 0);
- }
-
 static HRESULT cmp_oper(exec_ctx_t *ctx)
 {
     variant_val_t l, r;
@@ -2122,7 +2328,8 @@ static HRESULT interp_concat(exec_ctx_t *ctx)
 
     hres = stack_pop_val(ctx, &l);
     if(SUCCEEDED(hres)) {
-        hres = VarCat(l.v, r.v, &v);
+        if(!fast_concat(l.v, r.v, &v))
+            hres = VarCat(l.v, r.v, &v);
         release_val(&l);
     }
     release_val(&r);
@@ -2146,7 +2353,8 @@ static HRESULT interp_add(exec_ctx_t *ctx)
 
     hres = stack_pop_val(ctx, &l);
     if(SUCCEEDED(hres)) {
-        hres = VarAdd(l.v, r.v, &v);
+        if(!fast_arith(OP_add, l.v, r.v, &v) && !fast_concat(l.v, r.v, &v))
+            hres = VarAdd(l.v, r.v, &v);
         release_val(&l);
     }
     release_val(&r);
@@ -2170,7 +2378,8 @@ static HRESULT interp_sub(exec_ctx_t *ctx)
 
     hres = stack_pop_val(ctx, &l);
     if(SUCCEEDED(hres)) {
-        hres = VarSub(l.v, r.v, &v);
+        if(!fast_arith(OP_sub, l.v, r.v, &v))
+            hres = VarSub(l.v, r.v, &v);
         release_val(&l);
     }
     release_val(&r);
@@ -2266,7 +2475,8 @@ static HRESULT interp_mul(exec_ctx_t *ctx)
 
     hres = stack_pop_val(ctx, &l);
     if(SUCCEEDED(hres)) {
-        hres = VarMul(l.v, r.v, &v);
+        if(!fast_arith(OP_mul, l.v, r.v, &v))
+            hres = VarMul(l.v, r.v, &v);
         release_val(&l);
     }
     release_val(&r);
@@ -2318,10 +2528,28 @@ static HRESULT interp_neg(exec_ctx_t *ctx)
     return stack_push(ctx, &v);
 }
 
+static HRESULT do_incc(exec_ctx_t *ctx, VARIANT *var)
+{
+    VARIANT v;
+    HRESULT hres;
+
+    if(V_VT(var) == (VT_VARIANT|VT_BYREF))
+        var = V_VARIANTREF(var);
+
+    if(!fast_arith(OP_add, stack_top(ctx, 0), var, &v)) {
+        hres = VarAdd(stack_top(ctx, 0), var, &v);
+        if(FAILED(hres))
+            return hres;
+    }
+
+    VariantClear(var);
+    *var = v;
+    return S_OK;
+}
+
 static HRESULT interp_incc(exec_ctx_t *ctx)
 {
     const BSTR ident = ctx->instr->arg1.bstr;
-    VARIANT v;
     ref_t ref;
     HRESULT hres;
 
@@ -2336,13 +2564,16 @@ static HRESULT interp_incc(exec_ctx_t *ctx)
         return E_FAIL;
     }
 
-    hres = VarAdd(stack_top(ctx, 0), ref.u.v, &v);
-    if(FAILED(hres))
-        return hres;
+    return do_incc(ctx, ref.u.v);
+}
 
-    VariantClear(ref.u.v);
-    *ref.u.v = v;
-    return S_OK;
+static HRESULT interp_incc_local(exec_ctx_t *ctx)
+{
+    const int ref = ctx->instr->arg1.lng;
+
+    TRACE("%d\n", ref);
+
+    return do_incc(ctx, get_local_var(ctx, ref));
 }
 
 static HRESULT interp_catch(exec_ctx_t *ctx)
@@ -2938,6 +2938,49 @@ static void run_from_res(const char *name)
     test_name = "";
 }
 
+static void run_benchmark(const char *name)
+{
+    const char *data;
+    DWORD size, len;
+    ULONG start, end;
+    BSTR str;
+    HRSRC src;
+    HRESULT hres;
+
+    strict_dispid_check = FALSE;
+    test_name = name;
+
+    src = FindResourceA(NULL, name, (LPCSTR)40);
+    ok(src != NULL, "Could not find resource %s\n", name);
+    if(!src)
+        return;
+
+    size = SizeofResource(NULL, src);
+    data = LoadResource(NULL, src);
+
+    len = MultiByteToWideChar(CP_ACP, 0, data, size, NULL, 0);
+    str = SysAllocStringLen(NULL, len);
+    MultiByteToWideChar(CP_ACP, 0, data, size, str, len);
+
+    start = GetTickCount();
+    hres = parse_script(SCRIPTITEM_GLOBALMEMBERS, str, NULL);
+    end = GetTickCount();
+    ok(hres == S_OK, "%s: parse_script failed: %08lx\n", name, hres);
+
+    trace("%s ran in %lu ms\n", name, end-start);
+    SysFreeString(str);
+    test_name = "";
+}
+
+static void run_benchmarks(void)
+{
+    trace("Running benchmarks...\n");
+
+    run_benchmark("micro-arith.vbs");
+    run_benchmark("micro-locals.vbs");
+    run_benchmark("micro-strings.vbs");
+}
+
 static void run_tests(void)
 {
     HRESULT hres;
@@ -3251,6 +3294,9 @@ START_TEST(run)
         run_from_file(argv[2]);
     }else {
         run_tests();
+
+        if(winetest_interactive)
+            run_benchmarks();
     }
 
     CoUninitialize();
@@ -1267,6 +1267,7 @@ static ULONG WINAPI ScriptDisp_Release(IDispatchEx *iface)
             release_dynamic_var(This->global_vars[i]);
 
         heap_pool_free(&This->heap);
+        heap_free(This->global_vars_hash);
         heap_free(This->global_vars);
         heap_free(This->global_funcs);
         heap_free(This);
@@ -1376,6 +1377,7 @@ static HRESULT WINAPI ScriptDisp_Invoke(IDispatchEx *iface, DISPID dispIdMember,
 static HRESULT WINAPI ScriptDisp_GetDispID(IDispatchEx *iface, BSTR bstrName, DWORD grfdex, DISPID *pid)
 {
     ScriptDisp *This = ScriptDisp_from_IDispatchEx(iface);
+    size_t var_idx;
     unsigned i;
 
     TRACE("(%p)->(%s %lx %p)\n", This, debugstr_w(bstrName), grfdex, pid);
@@ -1383,11 +1385,9 @@ static HRESULT WINAPI ScriptDisp_GetDispID(IDispatchEx *iface, BSTR bstrName, DW
     if(!This->ctx)
         return E_UNEXPECTED;
 
-    for(i = 0; i < This->global_vars_cnt; i++) {
-        if(!wcsicmp(This->global_vars[i]->name, bstrName)) {
-            *pid = i + 1;
-            return S_OK;
-        }
+    if(find_global_var(This, bstrName, &var_idx)) {
+        *pid = var_idx + 1;
+        return S_OK;
     }
 
     for(i = 0; i < This->global_funcs_cnt; i++) {
@@ -1504,6 +1504,82 @@ static IDispatchExVtbl ScriptDispVtbl = {
     ScriptDisp_GetNameSpaceParent
 };
 
+static unsigned hash_var_name(const WCHAR *name)
+{
+    unsigned h = 0;
+
+    while(*name)
+        h = h * 31 + towlower(*name++);
+    return h;
+}
+
+static BOOL index_global_vars(ScriptDisp *obj)
+{
+    size_t i, mask;
+
+    if(obj->global_vars_cnt * 2 > obj->global_vars_hash_size) {
+        size_t size = obj->global_vars_hash_size ? obj->global_vars_hash_size : 64;
+        unsigned *hash;
+
+        while(size < obj->global_vars_cnt * 2)
+            size *= 2;
+
+        hash = heap_alloc_zero(size * sizeof(*hash));
+        if(!hash)
+            return FALSE;
+
+        heap_free(obj->global_vars_hash);
+        obj->global_vars_hash = hash;
+        obj->global_vars_hash_size = size;
+        obj->global_vars_hashed = 0;
+    }
+
+    mask = obj->global_vars_hash_size - 1;
+    for(i = obj->global_vars_hashed; i < obj->global_vars_cnt; i++) {
+        const WCHAR *name = obj->global_vars[i]->name;
+        size_t pos = hash_var_name(name) & mask;
+
+        /* The first variable of a given name wins, like in a linear lookup. */
+        while(obj->global_vars_hash[pos]) {
+            if(!wcsicmp(obj->global_vars[obj->global_vars_hash[pos] - 1]->name, name))
+                break;
+            pos = (pos + 1) & mask;
+        }
+        if(!obj->global_vars_hash[pos])
+            obj->global_vars_hash[pos] = i + 1;
+    }
+
+    obj->global_vars_hashed = obj->global_vars_cnt;
+    return TRUE;
+}
+
+BOOL find_global_var(ScriptDisp *obj, const WCHAR *name, size_t *ret)
+{
+    size_t i, pos, mask;
+
+    /* Global variables are only ever appended, so the index is brought up to date lazily. */
+    if(obj->global_vars_cnt < 16 || !index_global_vars(obj)) {
+        for(i = 0; i < obj->global_vars_cnt; i++) {
+            if(!wcsicmp(obj->global_vars[i]->name, name)) {
+                *ret = i;
+                return TRUE;
+            }
+        }
+        return FALSE;
+    }
+
+    mask = obj->global_vars_hash_size - 1;
+    for(pos = hash_var_name(name) & mask; obj->global_vars_hash[pos]; pos = (pos + 1) & mask) {
+        i = obj->global_vars_hash[pos] - 1;
+        if(!wcsicmp(obj->global_vars[i]->name, name)) {
+            *ret = i;
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
 HRESULT create_script_disp(script_ctx_t *ctx, ScriptDisp **ret)
 {
     ScriptDisp *script_disp;
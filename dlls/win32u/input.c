@@ -216,22 +216,37 @@ BOOL WINAPI NtUserSetCursorPos( INT x, INT y )
  */
 BOOL get_cursor_pos( POINT *pt )
 {
+    const desktop_shm_t *shm;
     BOOL ret;
     DWORD last_change;
     UINT dpi;
 
     if (!pt) return FALSE;
 
-    SERVER_START_REQ( set_cursor )
+    if ((shm = get_desktop_shared_memory()))
     {
-        if ((ret = !wine_server_call( req )))
+        SHARED_READ_BEGIN( shm )
         {
-            pt->x = reply->new_x;
-            pt->y = reply->new_y;
-            last_change = reply->last_change;
+            pt->x = shm->cursor_x;
+            pt->y = shm->cursor_y;
+            last_change = shm->cursor_last_change;
         }
+        SHARED_READ_END( shm );
+        ret = TRUE;
+    }
+    else
+    {
+        SERVER_START_REQ( set_cursor )
+        {
+            if ((ret = !wine_server_call( req )))
+            {
+                pt->x = reply->new_x;
+                pt->y = reply->new_y;
+                last_change = reply->last_change;
+            }
+        }
+        SERVER_END_REQ;
     }
-    SERVER_END_REQ;
 
     /* query new position from graphics driver if we haven't updated recently */
     if (ret && NtGetTickCount() - last_change > 100) ret = user_driver->pGetCursorPos( pt );
@@ -280,13 +295,25 @@ SHORT WINAPI NtUserGetAsyncKeyState( INT key )
 {
     struct user_key_state_info *key_state_info = get_user_thread_info()->key_state;
     INT counter = global_key_state_counter;
-    BYTE prev_key_state;
+    const desktop_shm_t *shm;
+    BYTE prev_key_state, state;
     SHORT ret;
 
     if (key < 0 || key >= 256) return 0;
 
     check_for_events( QS_INPUT );
 
+    if ((shm = get_desktop_shared_memory()))
+    {
+        SHARED_READ_BEGIN( shm )
+        {
+            state = shm->keystate[key];
+        }
+        SHARED_READ_END( shm );
+        /* the server has to clear the "pressed since last call" bit */
+        if (!(state & 0x40)) return (state & 0x80) ? 0x8000 : 0;
+    }
+
     if (key_state_info && !(key_state_info->state[key] & 0xc0) &&
         key_state_info->counter == counter && NtGetTickCount() - key_state_info->time < 50)
     {
@@ -336,6 +363,8 @@ SHORT WINAPI NtUserGetAsyncKeyState( INT key )
  */
 DWORD WINAPI NtUserGetQueueStatus( UINT flags )
 {
+    const queue_shm_t *shm;
+    UINT wake_bits, changed_bits;
     DWORD ret;
 
     if (flags & ~(QS_ALLINPUT | QS_ALLPOSTMESSAGE | QS_SMRESULT))
@@ -346,6 +375,18 @@ DWORD WINAPI NtUserGetQueueStatus( UINT flags )
 
     check_for_events( flags );
 
+    if ((shm = get_queue_shared_memory()))
+    {
+        SHARED_READ_BEGIN( shm )
+        {
+            wake_bits = shm->wake_bits;
+            changed_bits = shm->changed_bits;
+        }
+        SHARED_READ_END( shm );
+        /* the server has to clear the changed bits */
+        if (!(changed_bits & flags)) return MAKELONG( 0, wake_bits & flags );
+    }
+
     SERVER_START_REQ( get_queue_status )
     {
         req->clear_bits = flags;
@@ -361,10 +402,21 @@ DWORD WINAPI NtUserGetQueueStatus( UINT flags )
  */
 DWORD get_input_state(void)
 {
+    const queue_shm_t *shm;
     DWORD ret;
 
     check_for_events( QS_INPUT );
 
+    if ((shm = get_queue_shared_memory()))
+    {
+        SHARED_READ_BEGIN( shm )
+        {
+            ret = shm->wake_bits & (QS_KEY | QS_MOUSEBUTTON);
+        }
+        SHARED_READ_END( shm );
+        return ret;
+    }
+
     SERVER_START_REQ( get_queue_status )
     {
         req->clear_bits = 0;
@@ -438,8 +490,39 @@ HKL WINAPI NtUserGetKeyboardLayout( DWORD thread_id )
  */
 SHORT WINAPI NtUserGetKeyState( INT vkey )
 {
+    const desktop_shm_t *desktop_shm;
+    const input_shm_t *shm;
+    BYTE state, desktop_state;
     SHORT retval = 0;
 
+    if (vkey >= 0 && (shm = get_input_shared_memory()) && (desktop_shm = get_desktop_shared_memory()))
+    {
+        BOOL synced;
+
+        SHARED_READ_BEGIN( shm )
+        {
+            synced = shm->keystate_lock != 0;
+            state = shm->keystate[vkey & 0xff];
+            desktop_state = shm->desktop_keystate[vkey & 0xff];
+        }
+        SHARED_READ_END( shm );
+        if (!synced)
+        {
+            SHARED_READ_BEGIN( desktop_shm )
+            {
+                synced = desktop_shm->keystate[vkey & 0xff] == desktop_state;
+            }
+            SHARED_READ_END( desktop_shm );
+        }
+        /* otherwise the server has to synchronize the thread key state with the desktop first */
+        if (synced)
+        {
+            retval = (signed char)(state & 0x81);
+            TRACE("key (0x%x) -> %x\n", vkey, retval);
+            return retval;
+        }
+    }
+
     SERVER_START_REQ( get_key_state )
     {
         req->key = vkey;
@@ -455,11 +538,22 @@ SHORT WINAPI NtUserGetKeyState( INT vkey )
  */
 BOOL WINAPI NtUserGetKeyboardState( BYTE *state )
 {
+    const input_shm_t *shm;
     BOOL ret;
     UINT i;
 
     TRACE("(%p)\n", state);
 
+    if ((shm = get_input_shared_memory()))
+    {
+        SHARED_READ_BEGIN( shm )
+        {
+            for (i = 0; i < 256; i++) state[i] = shm->keystate[i] & 0x81;
+        }
+        SHARED_READ_END( shm );
+        return TRUE;
+    }
+
     memset( state, 0, 256 );
     SERVER_START_REQ( get_key_state )
     {
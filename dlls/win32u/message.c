@@ -1294,6 +1294,7 @@ static LRESULT handle_internal_message( HWND hwnd, UINT msg, WPARAM wparam, LPAR
  */
 BOOL WINAPI NtUserGetGUIThreadInfo( DWORD id, GUITHREADINFO *info )
 {
+    const input_shm_t *shm;
     BOOL ret;
 
     if (info->cbSize != sizeof(*info))
@@ -1302,6 +1303,29 @@ BOOL WINAPI NtUserGetGUIThreadInfo( DWORD id, GUITHREADINFO *info )
         return FALSE;
     }
 
+    if (id == GetCurrentThreadId() && (shm = get_input_shared_memory()))
+    {
+        SHARED_READ_BEGIN( shm )
+        {
+            info->hwndActive     = wine_server_ptr_handle( shm->active );
+            info->hwndFocus      = wine_server_ptr_handle( shm->focus );
+            info->hwndCapture    = wine_server_ptr_handle( shm->capture );
+            info->hwndMenuOwner  = wine_server_ptr_handle( shm->menu_owner );
+            info->hwndMoveSize   = wine_server_ptr_handle( shm->move_size );
+            info->hwndCaret      = wine_server_ptr_handle( shm->caret );
+            info->rcCaret.left   = shm->caret_rect.left;
+            info->rcCaret.top    = shm->caret_rect.top;
+            info->rcCaret.right  = shm->caret_rect.right;
+            info->rcCaret.bottom = shm->caret_rect.bottom;
+        }
+        SHARED_READ_END( shm );
+        info->flags = 0;
+        if (info->hwndMenuOwner) info->flags |= GUI_INMENUMODE;
+        if (info->hwndMoveSize) info->flags |= GUI_INMOVESIZE;
+        if (info->hwndCaret) info->flags |= GUI_CARETBLINKING;
+        return TRUE;
+    }
+
     SERVER_START_REQ( get_thread_input )
     {
         req->tid = id;
@@ -1777,6 +1801,36 @@ static BOOL process_hardware_message( MSG *msg, UINT hw_id, const struct hardwar
     return ret;
 }
 
+/* check from the queue shared memory whether get_message would find nothing and leave the queue
+ * unchanged; the server considers a queue hung after 5 seconds, so call it regularly anyway */
+static BOOL check_queue_bits( HWND hwnd, UINT first, UINT last, UINT flags, UINT wake_mask, UINT changed_mask )
+{
+    UINT filter = flags >> 16, clear_bits = 0;
+    const queue_shm_t *shm;
+    BOOL skip = FALSE;
+
+    if (hwnd || !(shm = get_queue_shared_memory())) return FALSE;
+
+    if (!filter) filter = QS_ALLINPUT;
+    if (filter & QS_POSTMESSAGE)
+    {
+        clear_bits |= QS_POSTMESSAGE | QS_HOTKEY | QS_TIMER;
+        if (first == 0 && last == ~0U) clear_bits |= QS_ALLPOSTMESSAGE;
+    }
+    if (filter & QS_INPUT) clear_bits |= QS_INPUT;
+    if (filter & QS_PAINT) clear_bits |= QS_PAINT;
+
+    SHARED_READ_BEGIN( shm )
+    {
+        skip = NtGetTickCount() - shm->last_get_msg < 3000 &&
+               shm->wake_mask == wake_mask && shm->changed_mask == changed_mask &&
+               !(shm->wake_bits & (filter | QS_SENDMESSAGE)) &&
+               !(shm->changed_bits & clear_bits);
+    }
+    SHARED_READ_END( shm );
+    return skip;
+}
+
 /***********************************************************************
  *           peek_message
  *
@@ -1794,11 +1848,19 @@ static int peek_message( MSG *msg, HWND hwnd, UINT first, UINT last, UINT flags,
     void *buffer;
     size_t buffer_size = 1024;
 
-    if (!(buffer = malloc( buffer_size ))) return -1;
-
     if (!first && !last) last = ~0;
     if (hwnd == HWND_BROADCAST) hwnd = HWND_TOPMOST;
 
+    if (check_queue_bits( hwnd, first, last, flags, changed_mask & (QS_SENDMESSAGE | QS_SMRESULT),
+                          changed_mask ))
+    {
+        thread_info->wake_mask = changed_mask & (QS_SENDMESSAGE | QS_SMRESULT);
+        thread_info->changed_mask = changed_mask;
+        return 0;
+    }
+
+    if (!(buffer = malloc( buffer_size ))) return -1;
+
     for (;;)
     {
         NTSTATUS res;
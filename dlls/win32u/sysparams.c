@@ -4917,6 +4917,7 @@ static void thread_detach(void)
     free( thread_info->key_state );
     thread_info->key_state = 0;
     free( thread_info->rawinput );
+    free_user_shared_memory();
 
     destroy_thread_windows();
     cleanup_imm_thread();
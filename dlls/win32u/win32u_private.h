@@ -404,6 +404,26 @@ extern BOOL show_owned_popups( HWND owner, BOOL show ) DECLSPEC_HIDDEN;
 extern void update_window_state( HWND hwnd ) DECLSPEC_HIDDEN;
 extern HWND window_from_point( HWND hwnd, POINT pt, INT *hittest ) DECLSPEC_HIDDEN;
 
+/* winstation.c */
+extern const desktop_shm_t *get_desktop_shared_memory(void) DECLSPEC_HIDDEN;
+extern const queue_shm_t *get_queue_shared_memory(void) DECLSPEC_HIDDEN;
+extern const input_shm_t *get_input_shared_memory(void) DECLSPEC_HIDDEN;
+extern void free_user_shared_memory(void) DECLSPEC_HIDDEN;
+
+/* read a consistent snapshot of server shared memory, the block is retried if
+ * the server updated the memory concurrently, so it must not have side effects */
+#define SHARED_READ_BEGIN( shm ) \
+    do { \
+        int __seq; \
+        do { \
+            while ((__seq = (shm)->seq) & 1) YieldProcessor(); \
+            MemoryBarrier();
+
+#define SHARED_READ_END( shm ) \
+            MemoryBarrier(); \
+        } while (__seq != (shm)->seq); \
+    } while (0)
+
 /* to release pointers retrieved by win_get_ptr */
 static inline void release_win_ptr( struct tagWND *ptr )
 {
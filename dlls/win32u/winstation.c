@@ -221,6 +221,116 @@ HDESK WINAPI NtUserGetThreadDesktop( DWORD thread )
     return ret;
 }
 
+struct user_shared_memory
+{
+    const desktop_shm_t *desktop;   /* desktop cursor and key state */
+    const queue_shm_t   *queue;     /* message queue state */
+    const input_shm_t   *input;     /* thread input state */
+    unsigned int         input_id;  /* id of the mapped thread input */
+    BOOL                 disabled;  /* mapping failed, always use server requests */
+};
+
+static struct user_shared_memory *get_user_shared_memory_info(void)
+{
+    struct user_thread_info *thread_info = get_user_thread_info();
+
+    if (!thread_info->shared_memory)
+        thread_info->shared_memory = calloc( 1, sizeof(*thread_info->shared_memory) );
+    if (thread_info->shared_memory && thread_info->shared_memory->disabled) return NULL;
+    return thread_info->shared_memory;
+}
+
+static const void *map_user_shared_memory( struct user_shared_memory *info, int type,
+                                           unsigned int *input_id )
+{
+    HANDLE handle = 0;
+    SIZE_T size = 0;
+    void *ptr = NULL;
+    NTSTATUS status;
+
+    SERVER_START_REQ( get_user_shared_memory )
+    {
+        req->type = type;
+        if (!wine_server_call( req ))
+        {
+            handle = wine_server_ptr_handle( reply->handle );
+            if (input_id) *input_id = reply->input_id;
+        }
+    }
+    SERVER_END_REQ;
+
+    if (!handle) status = STATUS_UNSUCCESSFUL;
+    else
+    {
+        status = NtMapViewOfSection( handle, GetCurrentProcess(), &ptr, 0, 0, NULL, &size,
+                                     ViewShare, 0, PAGE_READONLY );
+        NtClose( handle );
+    }
+    if (status)
+    {
+        WARN( "failed to map shared memory type %d, status %#x\n", type, status );
+        info->disabled = TRUE;
+        return NULL;
+    }
+    return ptr;
+}
+
+static void unmap_user_shared_memory( const volatile void *ptr )
+{
+    if (ptr) NtUnmapViewOfSection( GetCurrentProcess(), (void *)ptr );
+}
+
+/* get the shared memory of the thread input desktop */
+const desktop_shm_t *get_desktop_shared_memory(void)
+{
+    struct user_shared_memory *info = get_user_shared_memory_info();
+
+    if (!info) return NULL;
+    if (!info->desktop) info->desktop = map_user_shared_memory( info, USER_SHM_DESKTOP, NULL );
+    return info->desktop;
+}
+
+/* get the shared memory of the thread message queue */
+const queue_shm_t *get_queue_shared_memory(void)
+{
+    struct user_shared_memory *info;
+
+    /* don't create a server queue only to read its state */
+    if (!get_user_thread_info()->server_queue) return NULL;
+    if (!(info = get_user_shared_memory_info())) return NULL;
+    if (!info->queue) info->queue = map_user_shared_memory( info, USER_SHM_QUEUE, NULL );
+    return info->queue;
+}
+
+/* get the shared memory of the thread input, which changes when threads are attached */
+const input_shm_t *get_input_shared_memory(void)
+{
+    struct user_shared_memory *info;
+    const queue_shm_t *queue;
+
+    if (!(queue = get_queue_shared_memory())) return NULL;
+    info = get_user_thread_info()->shared_memory;
+    if (info->input && info->input_id == queue->input_id) return info->input;
+
+    unmap_user_shared_memory( info->input );
+    info->input = map_user_shared_memory( info, USER_SHM_INPUT, &info->input_id );
+    return info->input;
+}
+
+/* unmap the shared memory of the current thread */
+void free_user_shared_memory(void)
+{
+    struct user_thread_info *thread_info = get_user_thread_info();
+    struct user_shared_memory *info = thread_info->shared_memory;
+
+    if (!info) return;
+    unmap_user_shared_memory( info->desktop );
+    unmap_user_shared_memory( info->queue );
+    unmap_user_shared_memory( info->input );
+    free( info );
+    thread_info->shared_memory = NULL;
+}
+
 /***********************************************************************
  *           NtUserSetThreadDesktop   (win32u.@)
  */
@@ -242,6 +352,11 @@ BOOL WINAPI NtUserSetThreadDesktop( HDESK handle )
         thread_info->client_info.top_window = 0;
         thread_info->client_info.msg_window = 0;
         if (key_state_info) key_state_info->time = 0;
+        if (thread_info->shared_memory)
+        {
+            unmap_user_shared_memory( thread_info->shared_memory->desktop );
+            thread_info->shared_memory->desktop = NULL;
+        }
     }
     return ret;
 }
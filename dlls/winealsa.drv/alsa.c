@@ -1608,14 +1608,17 @@ static NTSTATUS alsa_timer_loop(void *args)
 {
     struct timer_loop_params *params = args;
     struct alsa_stream *stream = handle_get_stream(params->stream);
-    LARGE_INTEGER delay, next;
+    LARGE_INTEGER delay, next, freq;
+    LONGLONG period;
     int adjust;
 
     alsa_lock(stream);
 
+    /* the performance counter doesn't necessarily count in 100 ns units */
     delay.QuadPart = -stream->mmdev_period_rt;
-    NtQueryPerformanceCounter(&stream->last_period_time, NULL);
-    next.QuadPart = stream->last_period_time.QuadPart + stream->mmdev_period_rt;
+    NtQueryPerformanceCounter(&stream->last_period_time, &freq);
+    period = stream->mmdev_period_rt * freq.QuadPart / 10000000;
+    next.QuadPart = stream->last_period_time.QuadPart + period;
 
     while(!stream->please_quit){
         if(stream->flow == eRender)
@@ -1628,13 +1631,13 @@ static NTSTATUS alsa_timer_loop(void *args)
 
         alsa_lock(stream);
         NtQueryPerformanceCounter(&stream->last_period_time, NULL);
-        adjust = next.QuadPart - stream->last_period_time.QuadPart;
+        adjust = (next.QuadPart - stream->last_period_time.QuadPart) * 10000000 / freq.QuadPart;
         if(adjust > stream->mmdev_period_rt / 2)
             adjust = stream->mmdev_period_rt / 2;
         else if(adjust < -stream->mmdev_period_rt / 2)
             adjust = -stream->mmdev_period_rt / 2;
         delay.QuadPart = -(stream->mmdev_period_rt + adjust);
-        next.QuadPart += stream->mmdev_period_rt;
+        next.QuadPart += period;
     }
 
     alsa_unlock(stream);
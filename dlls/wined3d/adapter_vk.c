@@ -19,6 +19,7 @@
 #include "wined3d_private.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(d3d);
+WINE_DECLARE_DEBUG_CHANNEL(d3d_perf);
 
 static const struct wined3d_state_entry_template misc_state_template_vk[] =
 {
@@ -376,6 +377,150 @@ static const struct wined3d_allocator_ops wined3d_allocator_vk_ops =
     .allocator_destroy_chunk = wined3d_allocator_vk_destroy_chunk,
 };
 
+static double wined3d_ticks_to_ms(LONGLONG ticks)
+{
+    LARGE_INTEGER freq;
+
+    QueryPerformanceFrequency(&freq);
+    return ticks * 1000.0 / freq.QuadPart;
+}
+
+VkResult wined3d_device_vk_create_graphics_pipeline(struct wined3d_device_vk *device_vk,
+        const VkGraphicsPipelineCreateInfo *desc, bool async, VkPipeline *vk_pipeline)
+{
+    const struct wined3d_vk_info *vk_info = &device_vk->vk_info;
+    LARGE_INTEGER start, end;
+    LONGLONG ticks;
+    VkResult vr;
+
+    QueryPerformanceCounter(&start);
+    vr = VK_CALL(vkCreateGraphicsPipelines(device_vk->vk_device,
+            device_vk->vk_pipeline_cache, 1, desc, NULL, vk_pipeline));
+    QueryPerformanceCounter(&end);
+    ticks = end.QuadPart - start.QuadPart;
+
+    InterlockedIncrement(&device_vk->pipeline_stats.graphics_count);
+    if (async)
+    {
+        InterlockedIncrement(&device_vk->pipeline_stats.async_count);
+        InterlockedExchangeAdd64(&device_vk->pipeline_stats.async_time, ticks);
+    }
+    else
+    {
+        InterlockedExchangeAdd64(&device_vk->pipeline_stats.stall_time, ticks);
+    }
+    TRACE_(d3d_perf)("Created %sgraphics pipeline in %.3f ms.\n", async ? "asynchronous " : "",
+            wined3d_ticks_to_ms(ticks));
+
+    return vr;
+}
+
+VkResult wined3d_device_vk_create_compute_pipeline(struct wined3d_device_vk *device_vk,
+        const VkComputePipelineCreateInfo *desc, VkPipeline *vk_pipeline)
+{
+    const struct wined3d_vk_info *vk_info = &device_vk->vk_info;
+    LARGE_INTEGER start, end;
+    LONGLONG ticks;
+    VkResult vr;
+
+    QueryPerformanceCounter(&start);
+    vr = VK_CALL(vkCreateComputePipelines(device_vk->vk_device,
+            device_vk->vk_pipeline_cache, 1, desc, NULL, vk_pipeline));
+    QueryPerformanceCounter(&end);
+    ticks = end.QuadPart - start.QuadPart;
+
+    InterlockedIncrement(&device_vk->pipeline_stats.compute_count);
+    InterlockedExchangeAdd64(&device_vk->pipeline_stats.stall_time, ticks);
+    TRACE_(d3d_perf)("Created compute pipeline in %.3f ms.\n", wined3d_ticks_to_ms(ticks));
+
+    return vr;
+}
+
+void wined3d_device_vk_wait_pipeline_compiles(struct wined3d_device_vk *device_vk)
+{
+    AcquireSRWLockExclusive(&device_vk->pipeline_compile_lock);
+    while (device_vk->pending_pipeline_compiles)
+        SleepConditionVariableSRW(&device_vk->pipeline_compile_cv, &device_vk->pipeline_compile_lock, INFINITE, 0);
+    ReleaseSRWLockExclusive(&device_vk->pipeline_compile_lock);
+}
+
+static void wined3d_device_vk_create_pipeline_cache(struct wined3d_device_vk *device_vk,
+        const struct wined3d_adapter_vk *adapter_vk)
+{
+    const struct wined3d_vk_info *vk_info = &device_vk->vk_info;
+    VkPipelineCacheCreateInfo cache_desc;
+    VkPhysicalDeviceProperties properties;
+    char app_name[MAX_PATH];
+    void *data = NULL;
+    size_t size = 0;
+    VkResult vr;
+
+    /* The driver validates the cache header itself, but keying on the
+     * device and driver avoids loading data that is known to be useless. */
+    VK_CALL(vkGetPhysicalDeviceProperties(adapter_vk->physical_device, &properties));
+    wined3d_shader_cache_key_init(&device_vk->pipeline_cache_key, "vk pipeline cache");
+    if (wined3d_get_app_name(app_name, ARRAY_SIZE(app_name)))
+        wined3d_shader_cache_key_update(&device_vk->pipeline_cache_key, app_name, strlen(app_name));
+    wined3d_shader_cache_key_update(&device_vk->pipeline_cache_key, &properties.vendorID, sizeof(properties.vendorID));
+    wined3d_shader_cache_key_update(&device_vk->pipeline_cache_key, &properties.deviceID, sizeof(properties.deviceID));
+    wined3d_shader_cache_key_update(&device_vk->pipeline_cache_key,
+            &properties.driverVersion, sizeof(properties.driverVersion));
+    wined3d_shader_cache_key_update(&device_vk->pipeline_cache_key,
+            properties.pipelineCacheUUID, sizeof(properties.pipelineCacheUUID));
+
+    if (wined3d_shader_cache_get(&device_vk->pipeline_cache_key, &data, &size))
+        TRACE("Loaded %lu bytes of pipeline cache data.\n", (unsigned long)size);
+
+    cache_desc.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cache_desc.pNext = NULL;
+    cache_desc.flags = 0;
+    cache_desc.initialDataSize = size;
+    cache_desc.pInitialData = data;
+    if ((vr = VK_CALL(vkCreatePipelineCache(device_vk->vk_device, &cache_desc, NULL,
+            &device_vk->vk_pipeline_cache))) < 0 && data)
+    {
+        WARN("Failed to create pipeline cache from cached data, vr %s.\n", wined3d_debug_vkresult(vr));
+        cache_desc.initialDataSize = 0;
+        cache_desc.pInitialData = NULL;
+        vr = VK_CALL(vkCreatePipelineCache(device_vk->vk_device, &cache_desc, NULL, &device_vk->vk_pipeline_cache));
+    }
+    if (vr < 0)
+    {
+        WARN("Failed to create pipeline cache, vr %s.\n", wined3d_debug_vkresult(vr));
+        device_vk->vk_pipeline_cache = VK_NULL_HANDLE;
+    }
+    heap_free(data);
+}
+
+static void wined3d_device_vk_destroy_pipeline_cache(struct wined3d_device_vk *device_vk)
+{
+    const struct wined3d_pipeline_stats_vk *stats = &device_vk->pipeline_stats;
+    const struct wined3d_vk_info *vk_info = &device_vk->vk_info;
+    void *data;
+    size_t size;
+
+    TRACE_(d3d_perf)("Created %d graphics pipelines (%d asynchronously) and %d compute pipelines.\n",
+            stats->graphics_count, stats->async_count, stats->compute_count);
+    TRACE_(d3d_perf)("Pipeline creation stalled for %.3f ms; %.3f ms spent in asynchronous compilation, "
+            "%d draws skipped.\n", wined3d_ticks_to_ms(stats->stall_time), wined3d_ticks_to_ms(stats->async_time),
+            stats->skipped_draw_count);
+
+    if (!device_vk->vk_pipeline_cache)
+        return;
+
+    /* Only write the cache back if it may have changed. */
+    if ((stats->graphics_count || stats->compute_count) && wined3d_shader_cache_enabled()
+            && VK_CALL(vkGetPipelineCacheData(device_vk->vk_device, device_vk->vk_pipeline_cache, &size, NULL)) >= 0
+            && size && (data = heap_alloc(size)))
+    {
+        if (VK_CALL(vkGetPipelineCacheData(device_vk->vk_device, device_vk->vk_pipeline_cache, &size, data)) >= 0)
+            wined3d_shader_cache_put(&device_vk->pipeline_cache_key, data, size);
+        heap_free(data);
+    }
+
+    VK_CALL(vkDestroyPipelineCache(device_vk->vk_device, device_vk->vk_pipeline_cache, NULL));
+}
+
 static HRESULT adapter_vk_create_device(struct wined3d *wined3d, const struct wined3d_adapter *adapter,
         enum wined3d_device_type device_type, HWND focus_window, unsigned int flags, BYTE surface_alignment,
         const enum wined3d_feature_level *levels, unsigned int level_count,
@@ -484,6 +629,10 @@ static HRESULT adapter_vk_create_device(struct wined3d *wined3d, const struct wi
 #undef VK_DEVICE_EXT_PFN
 #undef VK_DEVICE_PFN
 
+    InitializeSRWLock(&device_vk->pipeline_compile_lock);
+    InitializeConditionVariable(&device_vk->pipeline_compile_cv);
+    wined3d_device_vk_create_pipeline_cache(device_vk, adapter_vk);
+
     if (!wined3d_allocator_init(&device_vk->allocator,
             adapter_vk->memory_properties.memoryTypeCount, &wined3d_allocator_vk_ops))
     {
@@ -507,6 +656,12 @@ static HRESULT adapter_vk_create_device(struct wined3d *wined3d, const struct wi
     return WINED3D_OK;
 
 fail:
+    if (device_vk->vk_pipeline_cache)
+    {
+        /* Device functions are only loaded into the device's copy. */
+        vk_info = &device_vk->vk_info;
+        VK_CALL(vkDestroyPipelineCache(vk_device, device_vk->vk_pipeline_cache, NULL));
+    }
     VK_CALL(vkDestroyDevice(vk_device, NULL));
     heap_free(device_vk);
     return hr;
@@ -522,6 +677,9 @@ static void adapter_vk_destroy_device(struct wined3d_device *device)
 
     wined3d_lock_cleanup(&device_vk->allocator_cs);
 
+    wined3d_device_vk_wait_pipeline_compiles(device_vk);
+    wined3d_device_vk_destroy_pipeline_cache(device_vk);
+
     VK_CALL(vkDestroyDevice(device_vk->vk_device, NULL));
     heap_free(device_vk);
 }
@@ -1786,6 +1944,15 @@ static void adapter_vk_draw_primitive(struct wined3d_device *device,
         return;
     }
 
+    if (!context_vk->graphics.vk_pipeline)
+    {
+        /* The pipeline is still being compiled in the background. */
+        TRACE("Skipping draw.\n");
+        InterlockedIncrement(&wined3d_device_vk(device)->pipeline_stats.skipped_draw_count);
+        context_release(&context_vk->c);
+        return;
+    }
+
     if (context_vk->c.transform_feedback_active)
     {
         if (!context_vk->vk_so_counter_bo.vk_buffer)
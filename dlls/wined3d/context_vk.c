@@ -1697,6 +1697,7 @@ void wined3d_context_vk_cleanup(struct wined3d_context_vk *context_vk)
     heap_free(context_vk->retired.objects);
 
     wined3d_shader_descriptor_writes_vk_cleanup(&context_vk->descriptor_writes);
+    wined3d_device_vk_wait_pipeline_compiles(device_vk);
     wine_rb_destroy(&context_vk->graphics_pipelines, wined3d_context_vk_destroy_graphics_pipeline, context_vk);
     wine_rb_destroy(&context_vk->pipeline_layouts, wined3d_context_vk_destroy_pipeline_layout, context_vk);
     wine_rb_destroy(&context_vk->render_passes, wined3d_context_vk_destroy_render_pass, context_vk);
@@ -3267,32 +3268,160 @@ fail:
     return NULL;
 }
 
-static VkPipeline wined3d_context_vk_get_graphics_pipeline(struct wined3d_context_vk *context_vk)
+static void wined3d_graphics_pipeline_key_vk_copy(struct wined3d_graphics_pipeline_key_vk *dst,
+        const struct wined3d_graphics_pipeline_key_vk *src)
+{
+    *dst = *src;
+
+    /* Point the copied create info at the copied state. */
+    dst->input_desc.pVertexBindingDescriptions = dst->bindings;
+    dst->input_desc.pVertexAttributeDescriptions = dst->attributes;
+    if (src->input_desc.pNext)
+        dst->input_desc.pNext = &dst->divisor_desc;
+    dst->divisor_desc.pVertexBindingDivisors = dst->divisors;
+    dst->vp_desc.pViewports = &dst->viewport;
+    dst->vp_desc.pScissors = &dst->scissor;
+    dst->ms_desc.pSampleMask = &dst->sample_mask;
+    dst->blend_desc.pAttachments = dst->blend_attachments;
+
+    dst->pipeline_desc.pStages = dst->stages;
+    dst->pipeline_desc.pVertexInputState = &dst->input_desc;
+    dst->pipeline_desc.pInputAssemblyState = &dst->ia_desc;
+    dst->pipeline_desc.pTessellationState = &dst->ts_desc;
+    dst->pipeline_desc.pViewportState = &dst->vp_desc;
+    dst->pipeline_desc.pRasterizationState = &dst->rs_desc;
+    dst->pipeline_desc.pMultisampleState = &dst->ms_desc;
+    dst->pipeline_desc.pDepthStencilState = &dst->ds_desc;
+    dst->pipeline_desc.pColorBlendState = &dst->blend_desc;
+    dst->pipeline_desc.pDynamicState = &dst->dynamic_desc;
+}
+
+struct wined3d_graphics_pipeline_compile_vk
+{
+    struct wined3d_device_vk *device_vk;
+    struct wined3d_graphics_pipeline_vk *pipeline_vk;
+};
+
+static DWORD WINAPI wined3d_graphics_pipeline_vk_compile(void *ctx)
+{
+    struct wined3d_graphics_pipeline_compile_vk *compile = ctx;
+    struct wined3d_graphics_pipeline_vk *pipeline_vk = compile->pipeline_vk;
+    struct wined3d_device_vk *device_vk = compile->device_vk;
+    VkResult vr;
+
+    if ((vr = wined3d_device_vk_create_graphics_pipeline(device_vk,
+            &pipeline_vk->key.pipeline_desc, true, &pipeline_vk->vk_pipeline)) < 0)
+    {
+        WARN("Failed to create graphics pipeline, vr %s.\n", wined3d_debug_vkresult(vr));
+        pipeline_vk->vk_pipeline = VK_NULL_HANDLE;
+    }
+    InterlockedExchange(&pipeline_vk->pending, 0);
+    heap_free(compile);
+
+    AcquireSRWLockExclusive(&device_vk->pipeline_compile_lock);
+    if (!--device_vk->pending_pipeline_compiles)
+        WakeAllConditionVariable(&device_vk->pipeline_compile_cv);
+    ReleaseSRWLockExclusive(&device_vk->pipeline_compile_lock);
+
+    return 0;
+}
+
+static bool wined3d_context_vk_compile_graphics_pipeline_async(struct wined3d_context_vk *context_vk,
+        struct wined3d_graphics_pipeline_vk *pipeline_vk)
+{
+    struct wined3d_device_vk *device_vk = wined3d_device_vk(context_vk->c.device);
+    struct wined3d_graphics_pipeline_compile_vk *compile;
+
+    if (!(compile = heap_alloc(sizeof(*compile))))
+        return false;
+    compile->device_vk = device_vk;
+    compile->pipeline_vk = pipeline_vk;
+
+    pipeline_vk->pending = 1;
+    AcquireSRWLockExclusive(&device_vk->pipeline_compile_lock);
+    ++device_vk->pending_pipeline_compiles;
+    ReleaseSRWLockExclusive(&device_vk->pipeline_compile_lock);
+
+    if (!QueueUserWorkItem(wined3d_graphics_pipeline_vk_compile, compile, WT_EXECUTEDEFAULT))
+    {
+        WARN("Failed to queue pipeline compilation.\n");
+        AcquireSRWLockExclusive(&device_vk->pipeline_compile_lock);
+        if (!--device_vk->pending_pipeline_compiles)
+            WakeAllConditionVariable(&device_vk->pipeline_compile_cv);
+        ReleaseSRWLockExclusive(&device_vk->pipeline_compile_lock);
+        pipeline_vk->pending = 0;
+        heap_free(compile);
+        return false;
+    }
+
+    return true;
+}
+
+/* With asynchronous pipeline compilation, this may return VK_NULL_HANDLE with
+ * "pending" set while the pipeline is compiled in the background. Draws
+ * using the pipeline are skipped until it becomes available. */
+static VkPipeline wined3d_context_vk_get_graphics_pipeline(struct wined3d_context_vk *context_vk, bool *pending)
 {
     struct wined3d_device_vk *device_vk = wined3d_device_vk(context_vk->c.device);
-    const struct wined3d_vk_info *vk_info = context_vk->vk_info;
     struct wined3d_graphics_pipeline_vk *pipeline_vk;
     struct wined3d_graphics_pipeline_key_vk *key;
     struct wine_rb_entry *entry;
     VkResult vr;
 
+    *pending = false;
+
     key = &context_vk->graphics.pipeline_key_vk;
     if ((entry = wine_rb_get(&context_vk->graphics_pipelines, key)))
-        return WINE_RB_ENTRY_VALUE(entry, struct wined3d_graphics_pipeline_vk, entry)->vk_pipeline;
+    {
+        pipeline_vk = WINE_RB_ENTRY_VALUE(entry, struct wined3d_graphics_pipeline_vk, entry);
+        if (InterlockedCompareExchange(&pipeline_vk->pending, 0, 0))
+        {
+            *pending = true;
+            return VK_NULL_HANDLE;
+        }
+        /* Asynchronous compilation failed; try again synchronously. */
+        if (!pipeline_vk->vk_pipeline && (vr = wined3d_device_vk_create_graphics_pipeline(device_vk,
+                &pipeline_vk->key.pipeline_desc, false, &pipeline_vk->vk_pipeline)) < 0)
+        {
+            WARN("Failed to create graphics pipeline, vr %s.\n", wined3d_debug_vkresult(vr));
+            pipeline_vk->vk_pipeline = VK_NULL_HANDLE;
+        }
+        return pipeline_vk->vk_pipeline;
+    }
 
     if (!(pipeline_vk = heap_alloc(sizeof(*pipeline_vk))))
         return VK_NULL_HANDLE;
-    pipeline_vk->key = *key;
+    wined3d_graphics_pipeline_key_vk_copy(&pipeline_vk->key, key);
+    pipeline_vk->vk_pipeline = VK_NULL_HANDLE;
+    pipeline_vk->pending = 0;
+
+    if (wined3d_settings.async_pipeline_compile)
+    {
+        if (wine_rb_put(&context_vk->graphics_pipelines, &pipeline_vk->key, &pipeline_vk->entry) == -1)
+        {
+            ERR("Failed to insert pipeline.\n");
+            heap_free(pipeline_vk);
+            return VK_NULL_HANDLE;
+        }
+        if (wined3d_context_vk_compile_graphics_pipeline_async(context_vk, pipeline_vk))
+        {
+            *pending = true;
+            return VK_NULL_HANDLE;
+        }
+    }
 
-    if ((vr = VK_CALL(vkCreateGraphicsPipelines(device_vk->vk_device,
-            VK_NULL_HANDLE, 1, &key->pipeline_desc, NULL, &pipeline_vk->vk_pipeline))) < 0)
+    if ((vr = wined3d_device_vk_create_graphics_pipeline(device_vk,
+            &pipeline_vk->key.pipeline_desc, false, &pipeline_vk->vk_pipeline)) < 0)
     {
         WARN("Failed to create graphics pipeline, vr %s.\n", wined3d_debug_vkresult(vr));
-        heap_free(pipeline_vk);
+        pipeline_vk->vk_pipeline = VK_NULL_HANDLE;
+        if (!wined3d_settings.async_pipeline_compile)
+            heap_free(pipeline_vk);
         return VK_NULL_HANDLE;
     }
 
-    if (wine_rb_put(&context_vk->graphics_pipelines, &pipeline_vk->key, &pipeline_vk->entry) == -1)
+    if (!wined3d_settings.async_pipeline_compile
+            && wine_rb_put(&context_vk->graphics_pipelines, &pipeline_vk->key, &pipeline_vk->entry) == -1)
         ERR("Failed to insert pipeline.\n");
 
     return pipeline_vk->vk_pipeline;
@@ -3431,6 +3560,7 @@ VkCommandBuffer wined3d_context_vk_apply_draw_state(struct wined3d_context_vk *c
     struct wined3d_buffer *buffer;
     uint32_t null_buffer_binding;
     bool invalidate_ds = false;
+    bool pending;
 
     if (wined3d_context_is_graphics_state_dirty(&context_vk->c, STATE_SHADER(WINED3D_SHADER_TYPE_PIXEL))
             || wined3d_context_is_graphics_state_dirty(&context_vk->c, STATE_FRAMEBUFFER))
@@ -3587,19 +3717,21 @@ VkCommandBuffer wined3d_context_vk_apply_draw_state(struct wined3d_context_vk *c
     if (wined3d_context_vk_update_graphics_pipeline_key(context_vk, state, context_vk->graphics.vk_pipeline_layout,
             &null_buffer_binding) || !context_vk->graphics.vk_pipeline)
     {
-        if (!(context_vk->graphics.vk_pipeline = wined3d_context_vk_get_graphics_pipeline(context_vk)))
+        if ((context_vk->graphics.vk_pipeline = wined3d_context_vk_get_graphics_pipeline(context_vk, &pending)))
         {
-            ERR("Failed to get graphics pipeline.\n");
-            return VK_NULL_HANDLE;
+            VK_CALL(vkCmdBindPipeline(vk_command_buffer,
+                    VK_PIPELINE_BIND_POINT_GRAPHICS, context_vk->graphics.vk_pipeline));
+            if (null_buffer_binding != ~0u)
+            {
+                VkDeviceSize offset = 0;
+                VK_CALL(vkCmdBindVertexBuffers(vk_command_buffer, null_buffer_binding, 1,
+                        &device_vk->null_resources_vk.buffer_info.buffer, &offset));
+            }
         }
-
-        VK_CALL(vkCmdBindPipeline(vk_command_buffer,
-                VK_PIPELINE_BIND_POINT_GRAPHICS, context_vk->graphics.vk_pipeline));
-        if (null_buffer_binding != ~0u)
+        else if (!pending)
         {
-            VkDeviceSize offset = 0;
-            VK_CALL(vkCmdBindVertexBuffers(vk_command_buffer, null_buffer_binding, 1,
-                    &device_vk->null_resources_vk.buffer_info.buffer, &offset));
+            ERR("Failed to get graphics pipeline.\n");
+            return VK_NULL_HANDLE;
         }
     }
 
@@ -3109,6 +3109,48 @@ static const struct wined3d_device_context_ops wined3d_cs_st_ops =
     wined3d_cs_reference_command_list,
 };
 
+static LONGLONG wined3d_cs_perf_counter(void)
+{
+    LARGE_INTEGER counter;
+
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+}
+
+static void wined3d_cs_perf_add_stall(struct wined3d_cs *cs, LONGLONG start)
+{
+    InterlockedExchangeAdd64(&cs->perf.stall_time, wined3d_cs_perf_counter() - start);
+}
+
+static void wined3d_cs_perf_report(struct wined3d_cs *cs)
+{
+    struct wined3d_cs_perf_stats *perf = &cs->perf;
+    LONGLONG now = wined3d_cs_perf_counter();
+    LONGLONG stall_time;
+    double scale;
+
+    if (now - perf->last_report < perf->frequency)
+        return;
+
+    stall_time = InterlockedExchangeAdd64(&perf->stall_time, 0);
+    InterlockedExchangeAdd64(&perf->stall_time, -stall_time);
+
+    scale = 1000.0 / perf->frequency;
+    TRACE_(d3d_perf)("%u packets in %.1f ms, queue occupancy average %lu, maximum %u bytes.\n",
+            perf->packet_count, (now - perf->last_report) * scale,
+            perf->packet_count ? (unsigned long)(perf->occupancy_sum / perf->packet_count) : 0ul,
+            perf->occupancy_max);
+    TRACE_(d3d_perf)("Producers stalled for %.3f ms, CS thread spun for %.3f ms and waited for %.3f ms.\n",
+            stall_time * scale, perf->spin_time * scale, perf->wait_time * scale);
+
+    perf->last_report = now;
+    perf->spin_time = 0;
+    perf->wait_time = 0;
+    perf->occupancy_sum = 0;
+    perf->occupancy_max = 0;
+    perf->packet_count = 0;
+}
+
 static BOOL wined3d_cs_queue_is_empty(const struct wined3d_cs *cs, const struct wined3d_cs_queue *queue)
 {
     wined3d_from_cs(cs);
@@ -3145,6 +3187,7 @@ static void *wined3d_cs_queue_require_space(struct wined3d_cs_queue *queue, size
     size_t header_size, packet_size, remaining;
     struct wined3d_cs_packet *packet;
     ULONG head = queue->head & WINED3D_CS_QUEUE_MASK;
+    LONGLONG stall_start = 0;
 
     header_size = FIELD_OFFSET(struct wined3d_cs_packet, data[0]);
     packet_size = FIELD_OFFSET(struct wined3d_cs_packet, data[size]);
@@ -3193,10 +3236,16 @@ static void *wined3d_cs_queue_require_space(struct wined3d_cs_queue *queue, size
         if (new_pos < tail && new_pos)
             break;
 
+        if (cs->perf.enabled && !stall_start)
+            stall_start = wined3d_cs_perf_counter();
+
         TRACE("Waiting for free space. Head %u, tail %u, packet size %lu.\n",
                 head, tail, (unsigned long)packet_size);
     }
 
+    if (stall_start)
+        wined3d_cs_perf_add_stall(cs, stall_start);
+
     packet = (struct wined3d_cs_packet *)&queue->data[head];
     packet->size = size;
     return packet->data;
@@ -3216,12 +3265,16 @@ static void *wined3d_cs_mt_require_space(struct wined3d_device_context *context,
 static void wined3d_cs_mt_finish(struct wined3d_device_context *context, enum wined3d_cs_queue_id queue_id)
 {
     struct wined3d_cs *cs = wined3d_cs_from_context(context);
+    LONGLONG stall_start;
 
     if (cs->thread_id == GetCurrentThreadId())
         return wined3d_cs_st_finish(context, queue_id);
 
+    stall_start = cs->perf.enabled ? wined3d_cs_perf_counter() : 0;
     while (cs->queue[queue_id].head != *(volatile ULONG *)&cs->queue[queue_id].tail)
         YieldProcessor();
+    if (stall_start)
+        wined3d_cs_perf_add_stall(cs, stall_start);
 }
 
 static const struct wined3d_device_context_ops wined3d_cs_mt_ops =
@@ -3255,6 +3308,8 @@ static void poll_queries(struct wined3d_cs *cs)
 
 static void wined3d_cs_wait_event(struct wined3d_cs *cs)
 {
+    LONGLONG start;
+
     InterlockedExchange(&cs->waiting_for_event, TRUE);
 
     /* The main thread might have enqueued a command and blocked on it after
@@ -3269,7 +3324,15 @@ static void wined3d_cs_wait_event(struct wined3d_cs *cs)
             && InterlockedCompareExchange(&cs->waiting_for_event, FALSE, TRUE))
         return;
 
+    if (!cs->perf.enabled)
+    {
+        WaitForSingleObject(cs->event, INFINITE);
+        return;
+    }
+
+    start = wined3d_cs_perf_counter();
     WaitForSingleObject(cs->event, INFINITE);
+    cs->perf.wait_time += wined3d_cs_perf_counter() - start;
 }
 
 static void wined3d_cs_command_lock(const struct wined3d_cs *cs)
@@ -3369,6 +3432,9 @@ static DWORD WINAPI wined3d_cs_run(void *ctx)
             poll_queries(cs);
             wined3d_cs_command_unlock(cs);
             poll = 0;
+
+            if (cs->perf.enabled && !spin_count)
+                wined3d_cs_perf_report(cs);
         }
 
         queue = &cs->queue[WINED3D_CS_QUEUE_MAP];
@@ -3377,11 +3443,34 @@ static DWORD WINAPI wined3d_cs_run(void *ctx)
             queue = &cs->queue[WINED3D_CS_QUEUE_DEFAULT];
             if (wined3d_cs_queue_is_empty(cs, queue))
             {
+                if (cs->perf.enabled && !spin_count)
+                    cs->perf.spin_start = wined3d_cs_perf_counter();
                 if (++spin_count >= WINED3D_CS_SPIN_COUNT && list_empty(&cs->query_poll_list))
+                {
+                    if (cs->perf.enabled)
+                    {
+                        cs->perf.spin_time += wined3d_cs_perf_counter() - cs->perf.spin_start;
+                        cs->perf.spin_start = 0;
+                    }
                     wined3d_cs_wait_event(cs);
+                }
                 continue;
             }
         }
+
+        if (cs->perf.enabled)
+        {
+            ULONG occupancy = (*(volatile ULONG *)&queue->head - queue->tail) & WINED3D_CS_QUEUE_MASK;
+
+            if (cs->perf.spin_start)
+            {
+                cs->perf.spin_time += wined3d_cs_perf_counter() - cs->perf.spin_start;
+                cs->perf.spin_start = 0;
+            }
+            cs->perf.occupancy_sum += occupancy;
+            cs->perf.occupancy_max = max(cs->perf.occupancy_max, occupancy);
+            ++cs->perf.packet_count;
+        }
         spin_count = 0;
 
         run = wined3d_cs_execute_next(cs, queue);
@@ -3435,6 +3524,15 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device,
     {
         cs->c.ops = &wined3d_cs_mt_ops;
 
+        if ((cs->perf.enabled = TRACE_ON(d3d_perf)))
+        {
+            LARGE_INTEGER frequency;
+
+            QueryPerformanceFrequency(&frequency);
+            cs->perf.frequency = frequency.QuadPart;
+            cs->perf.last_report = wined3d_cs_perf_counter();
+        }
+
         if (!(cs->event = CreateEventW(NULL, FALSE, FALSE, NULL)))
         {
             ERR("Failed to create command stream event.\n");
@@ -4314,8 +4412,7 @@ HRESULT CDECL wined3d_deferred_context_record_command_list(struct wined3d_device
     memory = heap_alloc(sizeof(*object) + deferred->resource_count * sizeof(*object->resources)
             + deferred->upload_count * sizeof(*object->uploads)
             + deferred->command_list_count * sizeof(*object->command_lists)
-            + deferred->query_count * sizeof(*object->queries)
-            + deferred->data_size);
+            + deferred->query_count * sizeof(*object->queries));
 
     if (!memory)
     {
@@ -4354,9 +4451,14 @@ HRESULT CDECL wined3d_deferred_context_record_command_list(struct wined3d_device
     memcpy(object->queries, deferred->queries, deferred->query_count * sizeof(*object->queries));
     /* Transfer our references to the queries to the command list. */
 
-    object->data = memory;
+    /* Hand the recorded packets over to the command list instead of copying
+     * them. Executing the list on the CS thread reads them in place. */
+    object->data = deferred->data;
     object->data_size = deferred->data_size;
-    memcpy(object->data, deferred->data, deferred->data_size);
+    deferred->data = NULL;
+    deferred->data_capacity = 0;
+    /* Command lists recorded on the same context tend to be of similar size. */
+    wined3d_array_reserve(&deferred->data, &deferred->data_capacity, object->data_size, 1);
 
     deferred->data_size = 0;
     deferred->resource_count = 0;
@@ -4400,6 +4502,7 @@ static void wined3d_command_list_destroy_object(void *object)
         }
     }
 
+    heap_free(list->data);
     heap_free(list);
 }
 
@@ -248,6 +248,7 @@ struct glsl_shader_prog_link
     struct glsl_ps_program ps;
     struct glsl_cs_program cs;
     GLuint id;
+    struct wined3d_shader_cache_digest shader_digests[WINED3D_SHADER_TYPE_GRAPHICS_COUNT];
     DWORD constant_update_mask;
     unsigned int constant_version;
     DWORD shader_controlled_clip_distances : 1;
@@ -287,29 +288,34 @@ struct glsl_ps_compiled_shader
     struct ps_compile_args          args;
     struct ps_np2fixup_info         np2fixup;
     GLuint                          id;
+    struct wined3d_shader_cache_digest cache_digest;
 };
 
 struct glsl_vs_compiled_shader
 {
     struct vs_compile_args          args;
     GLuint                          id;
+    struct wined3d_shader_cache_digest cache_digest;
 };
 
 struct glsl_hs_compiled_shader
 {
     GLuint id;
+    struct wined3d_shader_cache_digest cache_digest;
 };
 
 struct glsl_ds_compiled_shader
 {
     struct ds_compile_args args;
     GLuint id;
+    struct wined3d_shader_cache_digest cache_digest;
 };
 
 struct glsl_gs_compiled_shader
 {
     struct gs_compile_args args;
     GLuint id;
+    struct wined3d_shader_cache_digest cache_digest;
 };
 
 struct glsl_cs_compiled_shader
@@ -335,6 +341,7 @@ struct glsl_ffp_vertex_shader
 {
     struct wined3d_ffp_vs_desc desc;
     GLuint id;
+    struct wined3d_shader_cache_digest cache_digest;
     struct list linked_programs;
 };
 
@@ -342,6 +349,7 @@ struct glsl_ffp_fragment_shader
 {
     struct ffp_frag_desc entry;
     GLuint id;
+    struct wined3d_shader_cache_digest cache_digest;
     struct list linked_programs;
 };
 
@@ -636,6 +644,157 @@ void shader_glsl_validate_link(const struct wined3d_gl_info *gl_info, GLuint pro
     print_glsl_info_log(gl_info, program, TRUE);
 }
 
+/* The shader cache key of a GL shader object covers the input it was
+ * generated from: the byte code and the compile arguments. */
+static void shader_glsl_get_shader_digest(const char *type, const struct wined3d_shader *shader,
+        const void *args, size_t args_size, struct wined3d_shader_cache_digest *digest)
+{
+    struct wined3d_shader_cache_key key;
+
+    if (!wined3d_shader_cache_enabled())
+    {
+        memset(digest, 0, sizeof(*digest));
+        return;
+    }
+
+    wined3d_shader_cache_key_init(&key, type);
+    if (shader)
+        wined3d_shader_cache_key_update(&key, shader->byte_code, shader->byte_code_size);
+    wined3d_shader_cache_key_update(&key, args, args_size);
+    wined3d_shader_cache_key_get_digest(&key, digest);
+}
+
+static void shader_glsl_get_vs_digest(const struct wined3d_shader *shader,
+        const struct vs_compile_args *args, struct wined3d_shader_cache_digest *digest)
+{
+    struct vs_compile_args key_args;
+
+    /* struct vs_compile_args has padding, and find_vs_compile_args() doesn't clear it. */
+    memset(&key_args, 0, sizeof(key_args));
+    key_args.swizzle_map = args->swizzle_map;
+    key_args.next_shader_input_count = args->next_shader_input_count;
+    memcpy(key_args.interpolation_mode, args->interpolation_mode, sizeof(key_args.interpolation_mode));
+    key_args.fog_src = args->fog_src;
+    key_args.clip_enabled = args->clip_enabled;
+    key_args.point_size = args->point_size;
+    key_args.per_vertex_point_size = args->per_vertex_point_size;
+    key_args.flatshading = args->flatshading;
+    key_args.next_shader_type = args->next_shader_type;
+    shader_glsl_get_shader_digest("glsl vs", shader, &key_args, sizeof(key_args), digest);
+}
+
+/* Everything besides the shaders that affects the generated GLSL or the
+ * linked program. The cached binary is only used when the program would be
+ * linked from the same shaders, so this includes the build of wined3d. */
+static void shader_glsl_init_program_cache_key(const struct wined3d_context_gl *context_gl,
+        const struct shader_glsl_priv *priv, const void *link_state, size_t link_state_size,
+        const struct wined3d_shader_cache_digest *digests, unsigned int digest_count,
+        struct wined3d_shader_cache_key *key)
+{
+    static const GLenum strings[] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+    const struct wined3d_d3d_info *d3d_info = context_gl->c.d3d_info;
+    const struct wined3d_gl_info *gl_info = context_gl->gl_info;
+    const char *(CDECL *get_build_id)(void);
+    const char *str;
+    unsigned int i;
+
+    wined3d_shader_cache_key_init(key, "glsl program");
+    get_build_id = (void *)GetProcAddress(GetModuleHandleW(L"ntdll.dll"), "wine_get_build_id");
+    str = get_build_id ? get_build_id() : NULL;
+    wined3d_shader_cache_key_update(key, str, str ? strlen(str) : 0);
+    for (i = 0; i < ARRAY_SIZE(strings); ++i)
+    {
+        str = (const char *)gl_info->gl_ops.gl.p_glGetString(strings[i]);
+        wined3d_shader_cache_key_update(key, str, str ? strlen(str) : 0);
+    }
+    wined3d_shader_cache_key_update(key, gl_info, offsetof(struct wined3d_gl_info, filling_convention_offset)
+            + sizeof(gl_info->filling_convention_offset));
+    wined3d_shader_cache_key_update(key, &d3d_info->limits, sizeof(d3d_info->limits));
+    wined3d_shader_cache_key_update(key, &d3d_info->wined3d_creation_flags,
+            offsetof(struct wined3d_d3d_info, filling_convention_offset) + sizeof(d3d_info->filling_convention_offset)
+            - offsetof(struct wined3d_d3d_info, wined3d_creation_flags));
+    wined3d_shader_cache_key_update_uint(key, wined3d_settings.check_float_constants);
+    wined3d_shader_cache_key_update_uint(key, wined3d_settings.strict_shader_math);
+    wined3d_shader_cache_key_update_uint(key, priv->ffp_proj_control);
+    wined3d_shader_cache_key_update_uint(key, priv->legacy_lighting);
+    wined3d_shader_cache_key_update(key, link_state, link_state_size);
+    wined3d_shader_cache_key_update(key, digests, digest_count * sizeof(*digests));
+}
+
+/* Link "program", reusing a program binary from the shader cache when
+ * possible. "digests" identify the shaders attached to the program, and
+ * "link_state" covers any state set on the program before linking that isn't
+ * part of them, like attribute bindings.
+ *
+ * Context activation is done by the caller. */
+static void shader_glsl_link_program(const struct wined3d_context_gl *context_gl,
+        const struct shader_glsl_priv *priv, GLuint program, const void *link_state, size_t link_state_size,
+        const struct wined3d_shader_cache_digest *digests, unsigned int digest_count, BOOL cacheable)
+{
+    const struct wined3d_gl_info *gl_info = context_gl->gl_info;
+    struct wined3d_shader_cache_key key;
+    GLint status, length = 0;
+    GLenum format;
+    void *data;
+    size_t size;
+
+    if (!cacheable || !gl_info->supported[ARB_GET_PROGRAM_BINARY] || !wined3d_shader_cache_enabled())
+    {
+        TRACE("Linking GLSL shader program %u.\n", program);
+        GL_EXTCALL(glLinkProgram(program));
+        shader_glsl_validate_link(gl_info, program);
+        return;
+    }
+
+    shader_glsl_init_program_cache_key(context_gl, priv, link_state, link_state_size, digests, digest_count, &key);
+
+    /* Cache entries consist of the binary format followed by the binary. */
+    if (wined3d_shader_cache_get(&key, &data, &size))
+    {
+        if (size > sizeof(format))
+        {
+            memcpy(&format, data, sizeof(format));
+            GL_EXTCALL(glProgramBinary(program, format, (const BYTE *)data + sizeof(format), size - sizeof(format)));
+            GL_EXTCALL(glGetProgramiv(program, GL_LINK_STATUS, &status));
+            /* Clear any error, drivers reject binaries from e.g. older
+             * versions of themselves. */
+            gl_info->gl_ops.gl.p_glGetError();
+        }
+        else
+        {
+            status = GL_FALSE;
+        }
+        heap_free(data);
+
+        if (status)
+        {
+            TRACE("Loaded GLSL shader program %u from the shader cache.\n", program);
+            return;
+        }
+        WARN("Failed to load cached program binary for program %u, relinking.\n", program);
+    }
+
+    TRACE("Linking GLSL shader program %u.\n", program);
+    GL_EXTCALL(glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+    GL_EXTCALL(glLinkProgram(program));
+    shader_glsl_validate_link(gl_info, program);
+
+    GL_EXTCALL(glGetProgramiv(program, GL_LINK_STATUS, &status));
+    if (status)
+        GL_EXTCALL(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length));
+    if (length > 0 && (data = heap_alloc(sizeof(format) + length)))
+    {
+        GL_EXTCALL(glGetProgramBinary(program, length, &length, &format, (BYTE *)data + sizeof(format)));
+        if (length > 0)
+        {
+            memcpy(data, &format, sizeof(format));
+            wined3d_shader_cache_put(&key, data, sizeof(format) + length);
+        }
+        heap_free(data);
+    }
+    checkGLcall("shader_glsl_link_program");
+}
+
 static BOOL shader_glsl_use_layout_qualifier(const struct wined3d_gl_info *gl_info)
 {
     /* Layout qualifiers were introduced in GLSL 1.40. The Nvidia Legacy GPU
@@ -8503,8 +8662,8 @@ static GLuint shader_glsl_generate_compute_shader(const struct wined3d_context_g
 
 static GLuint find_glsl_fragment_shader(const struct wined3d_context_gl *context_gl,
         struct wined3d_string_buffer *buffer, struct wined3d_string_buffer_list *string_buffers,
-        struct wined3d_shader *shader,
-        const struct ps_compile_args *args, const struct ps_np2fixup_info **np2fixup_info)
+        struct wined3d_shader *shader, const struct ps_compile_args *args,
+        const struct ps_np2fixup_info **np2fixup_info, struct wined3d_shader_cache_digest *digest)
 {
     struct glsl_ps_compiled_shader *gl_shaders, *new_array;
     struct glsl_shader_private *shader_data;
@@ -8534,6 +8693,7 @@ static GLuint find_glsl_fragment_shader(const struct wined3d_context_gl *context
         {
             if (args->np2_fixup)
                 *np2fixup_info = &gl_shaders[i].np2fixup;
+            *digest = gl_shaders[i].cache_digest;
             return gl_shaders[i].id;
         }
     }
@@ -8569,6 +8729,8 @@ static GLuint find_glsl_fragment_shader(const struct wined3d_context_gl *context
 
     string_buffer_clear(buffer);
     ret = shader_glsl_generate_fragment_shader(context_gl, buffer, string_buffers, shader, args, np2fixup);
+    shader_glsl_get_shader_digest("glsl ps", shader, args, sizeof(*args), digest);
+    gl_shaders[shader_data->num_gl_shaders].cache_digest = *digest;
     gl_shaders[shader_data->num_gl_shaders++].id = ret;
 
     return ret;
@@ -8596,8 +8758,8 @@ static BOOL vs_args_equal(const struct vs_compile_args *stored, const struct vs_
     return !memcmp(stored->interpolation_mode, new->interpolation_mode, sizeof(new->interpolation_mode));
 }
 
-static GLuint find_glsl_vertex_shader(const struct wined3d_context_gl *context_gl,
-        struct shader_glsl_priv *priv, struct wined3d_shader *shader, const struct vs_compile_args *args)
+static GLuint find_glsl_vertex_shader(const struct wined3d_context_gl *context_gl, struct shader_glsl_priv *priv,
+        struct wined3d_shader *shader, const struct vs_compile_args *args, struct wined3d_shader_cache_digest *digest)
 {
     struct glsl_vs_compiled_shader *gl_shaders, *new_array;
     uint32_t use_map = context_gl->c.stream_info.use_map;
@@ -8623,7 +8785,10 @@ static GLuint find_glsl_vertex_shader(const struct wined3d_context_gl *context_g
     for (i = 0; i < shader_data->num_gl_shaders; ++i)
     {
         if (vs_args_equal(&gl_shaders[i].args, args, use_map))
+        {
+            *digest = gl_shaders[i].cache_digest;
             return gl_shaders[i].id;
+        }
     }
 
     TRACE("No matching GL shader found for shader %p, compiling a new shader.\n", shader);
@@ -8654,13 +8819,15 @@ static GLuint find_glsl_vertex_shader(const struct wined3d_context_gl *context_g
 
     string_buffer_clear(&priv->shader_buffer);
     ret = shader_glsl_generate_vertex_shader(context_gl, priv, shader, args);
+    shader_glsl_get_vs_digest(shader, args, digest);
+    gl_shaders[shader_data->num_gl_shaders].cache_digest = *digest;
     gl_shaders[shader_data->num_gl_shaders++].id = ret;
 
     return ret;
 }
 
 static GLuint find_glsl_hull_shader(const struct wined3d_context_gl *context_gl,
-        struct shader_glsl_priv *priv, struct wined3d_shader *shader)
+        struct shader_glsl_priv *priv, struct wined3d_shader *shader, struct wined3d_shader_cache_digest *digest)
 {
     struct glsl_hs_compiled_shader *gl_shaders, *new_array;
     struct glsl_shader_private *shader_data;
@@ -8681,6 +8848,7 @@ static GLuint find_glsl_hull_shader(const struct wined3d_context_gl *context_gl,
     if (shader_data->num_gl_shaders > 0)
     {
         assert(shader_data->num_gl_shaders == 1);
+        *digest = gl_shaders[0].cache_digest;
         return gl_shaders[0].id;
     }
 
@@ -8699,13 +8867,15 @@ static GLuint find_glsl_hull_shader(const struct wined3d_context_gl *context_gl,
 
     string_buffer_clear(&priv->shader_buffer);
     ret = shader_glsl_generate_hull_shader(context_gl, priv, shader);
+    shader_glsl_get_shader_digest("glsl hs", shader, NULL, 0, digest);
+    gl_shaders[shader_data->num_gl_shaders].cache_digest = *digest;
     gl_shaders[shader_data->num_gl_shaders++].id = ret;
 
     return ret;
 }
 
-static GLuint find_glsl_domain_shader(const struct wined3d_context_gl *context_gl,
-        struct shader_glsl_priv *priv, struct wined3d_shader *shader, const struct ds_compile_args *args)
+static GLuint find_glsl_domain_shader(const struct wined3d_context_gl *context_gl, struct shader_glsl_priv *priv,
+        struct wined3d_shader *shader, const struct ds_compile_args *args, struct wined3d_shader_cache_digest *digest)
 {
     struct glsl_ds_compiled_shader *gl_shaders, *new_array;
     struct glsl_shader_private *shader_data;
@@ -8726,7 +8896,10 @@ static GLuint find_glsl_domain_shader(const struct wined3d_context_gl *context_g
     for (i = 0; i < shader_data->num_gl_shaders; ++i)
     {
         if (!memcmp(&gl_shaders[i].args, args, sizeof(*args)))
+        {
+            *digest = gl_shaders[i].cache_digest;
             return gl_shaders[i].id;
+        }
     }
 
     TRACE("No matching GL shader found for shader %p, compiling a new shader.\n", shader);
@@ -8753,14 +8926,16 @@ static GLuint find_glsl_domain_shader(const struct wined3d_context_gl *context_g
 
     string_buffer_clear(&priv->shader_buffer);
     ret = shader_glsl_generate_domain_shader(context_gl, priv, shader, args);
+    shader_glsl_get_shader_digest("glsl ds", shader, args, sizeof(*args), digest);
+    gl_shaders[shader_data->num_gl_shaders].cache_digest = *digest;
     gl_shaders[shader_data->num_gl_shaders].args = *args;
     gl_shaders[shader_data->num_gl_shaders++].id = ret;
 
     return ret;
 }
 
-static GLuint find_glsl_geometry_shader(const struct wined3d_context_gl *context_gl,
-        struct shader_glsl_priv *priv, struct wined3d_shader *shader, const struct gs_compile_args *args)
+static GLuint find_glsl_geometry_shader(const struct wined3d_context_gl *context_gl, struct shader_glsl_priv *priv,
+        struct wined3d_shader *shader, const struct gs_compile_args *args, struct wined3d_shader_cache_digest *digest)
 {
     struct glsl_gs_compiled_shader *gl_shaders, *new_array;
     struct glsl_shader_private *shader_data;
@@ -8781,7 +8956,10 @@ static GLuint find_glsl_geometry_shader(const struct wined3d_context_gl *context
     for (i = 0; i < shader_data->num_gl_shaders; ++i)
     {
         if (!memcmp(&gl_shaders[i].args, args, sizeof(*args)))
+        {
+            *digest = gl_shaders[i].cache_digest;
             return gl_shaders[i].id;
+        }
     }
 
     TRACE("No matching GL shader found for shader %p, compiling a new shader.\n", shader);
@@ -8808,6 +8986,8 @@ static GLuint find_glsl_geometry_shader(const struct wined3d_context_gl *context
 
     string_buffer_clear(&priv->shader_buffer);
     ret = shader_glsl_generate_geometry_shader(context_gl, priv, shader, args);
+    shader_glsl_get_shader_digest("glsl gs", shader, args, sizeof(*args), digest);
+    gl_shaders[shader_data->num_gl_shaders].cache_digest = *digest;
     gl_shaders[shader_data->num_gl_shaders].args = *args;
     gl_shaders[shader_data->num_gl_shaders++].id = ret;
 
@@ -9913,6 +10093,7 @@ static struct glsl_ffp_vertex_shader *shader_glsl_find_ffp_vertex_shader(struct
 
     shader->desc.settings = *settings;
     shader->id = shader_glsl_generate_ffp_vertex_shader(priv, settings, gl_info);
+    shader_glsl_get_shader_digest("glsl ffp vs", NULL, settings, sizeof(*settings), &shader->cache_digest);
     list_init(&shader->linked_programs);
     if (wine_rb_put(&priv->ffp_vertex_shaders, &shader->desc.settings, &shader->desc.entry) == -1)
         ERR("Failed to insert ffp vertex shader.\n");
@@ -9934,6 +10115,7 @@ static struct glsl_ffp_fragment_shader *shader_glsl_find_ffp_fragment_shader(str
 
     glsl_desc->entry.settings = *args;
     glsl_desc->id = shader_glsl_generate_ffp_fragment_shader(priv, args, context_gl);
+    shader_glsl_get_shader_digest("glsl ffp ps", NULL, args, sizeof(*args), &glsl_desc->cache_digest);
     list_init(&glsl_desc->linked_programs);
     add_ffp_frag_shader(&priv->ffp_fragment_shaders, &glsl_desc->entry);
 
@@ -10097,6 +10279,7 @@ static HRESULT shader_glsl_compile_compute_shader(struct shader_glsl_priv *priv,
     struct glsl_context_data *ctx_data = context_gl->c.shader_backend_data;
     const struct wined3d_gl_info *gl_info = context_gl->gl_info;
     struct wined3d_string_buffer *buffer = &priv->shader_buffer;
+    struct wined3d_shader_cache_digest digest;
     struct glsl_cs_compiled_shader *gl_shaders;
     struct glsl_shader_private *shader_data;
     struct glsl_shader_prog_link *entry;
@@ -10131,6 +10314,7 @@ static HRESULT shader_glsl_compile_compute_shader(struct shader_glsl_priv *priv,
 
     string_buffer_clear(buffer);
     shader_id = shader_glsl_generate_compute_shader(context_gl, buffer, &priv->string_buffers, shader);
+    shader_glsl_get_shader_digest("glsl cs", shader, NULL, 0, &digest);
     gl_shaders[shader_data->num_gl_shaders++].id = shader_id;
 
     program_id = GL_EXTCALL(glCreateProgram());
@@ -10143,6 +10327,7 @@ static HRESULT shader_glsl_compile_compute_shader(struct shader_glsl_priv *priv,
     entry->gs.id = 0;
     entry->ps.id = 0;
     entry->cs.id = shader_id;
+    memset(entry->shader_digests, 0, sizeof(entry->shader_digests));
     entry->constant_version = 0;
     entry->shader_controlled_clip_distances = 0;
     entry->ps.np2_fixup_info = NULL;
@@ -10154,9 +10339,7 @@ static HRESULT shader_glsl_compile_compute_shader(struct shader_glsl_priv *priv,
 
     list_add_head(&shader->linked_programs, &entry->cs.shader_entry);
 
-    TRACE("Linking GLSL shader program %u.\n", program_id);
-    GL_EXTCALL(glLinkProgram(program_id));
-    shader_glsl_validate_link(gl_info, program_id);
+    shader_glsl_link_program(context_gl, priv, program_id, NULL, 0, &digest, 1, TRUE);
 
     GL_EXTCALL(glUseProgram(program_id));
     checkGLcall("glUseProgram");
@@ -10227,6 +10410,7 @@ static void set_glsl_shader_program(const struct wined3d_context_gl *context_gl,
     struct glsl_shader_prog_link *entry = NULL;
     struct wined3d_shader *vshader = NULL;
     struct wined3d_shader *pshader = NULL;
+    struct wined3d_shader_cache_digest digests[WINED3D_SHADER_TYPE_GRAPHICS_COUNT];
     GLuint reorder_shader_id = 0;
     struct glsl_program_key key;
     uint32_t attribs_map;
@@ -10239,11 +10423,20 @@ static void set_glsl_shader_program(const struct wined3d_context_gl *context_gl,
     GLuint ps_id = 0;
     struct list *ps_list, *vs_list;
     struct wined3d_string_buffer *tmp_name;
+    struct
+    {
+        uint32_t attribs_map;
+        uint32_t dual_source;
+        uint32_t rasterizer_input_setup;
+    } link_state;
+
+    memset(digests, 0, sizeof(digests));
 
     if (!(context_gl->c.shader_update_mask & (1u << WINED3D_SHADER_TYPE_VERTEX)) && ctx_data->glsl_program)
     {
         vs_id = ctx_data->glsl_program->vs.id;
         vs_list = &ctx_data->glsl_program->vs.shader_entry;
+        digests[WINED3D_SHADER_TYPE_VERTEX] = ctx_data->glsl_program->shader_digests[WINED3D_SHADER_TYPE_VERTEX];
 
         if (use_vs(state))
             vshader = state->shader[WINED3D_SHADER_TYPE_VERTEX];
@@ -10255,7 +10448,8 @@ static void set_glsl_shader_program(const struct wined3d_context_gl *context_gl,
         vshader = state->shader[WINED3D_SHADER_TYPE_VERTEX];
 
         find_vs_compile_args(state, vshader, &vs_compile_args, &context_gl->c);
-        vs_id = find_glsl_vertex_shader(context_gl, priv, vshader, &vs_compile_args);
+        vs_id = find_glsl_vertex_shader(context_gl, priv, vshader, &vs_compile_args,
+                &digests[WINED3D_SHADER_TYPE_VERTEX]);
         vs_list = &vshader->linked_programs;
     }
     else if (priv->vertex_pipe == &glsl_vertex_pipe)
@@ -10266,39 +10460,47 @@ static void set_glsl_shader_program(const struct wined3d_context_gl *context_gl,
         wined3d_ffp_get_vs_settings(&context_gl->c, state, &settings);
         ffp_shader = shader_glsl_find_ffp_vertex_shader(priv, gl_info, &settings);
         vs_id = ffp_shader->id;
+        digests[WINED3D_SHADER_TYPE_VERTEX] = ffp_shader->cache_digest;
         vs_list = &ffp_shader->linked_programs;
     }
 
     hshader = state->shader[WINED3D_SHADER_TYPE_HULL];
     if (!(context_gl->c.shader_update_mask & (1u << WINED3D_SHADER_TYPE_HULL)) && ctx_data->glsl_program)
+    {
         hs_id = ctx_data->glsl_program->hs.id;
+        digests[WINED3D_SHADER_TYPE_HULL] = ctx_data->glsl_program->shader_digests[WINED3D_SHADER_TYPE_HULL];
+    }
     else if (hshader)
-        hs_id = find_glsl_hull_shader(context_gl, priv, hshader);
+    {
+        hs_id = find_glsl_hull_shader(context_gl, priv, hshader, &digests[WINED3D_SHADER_TYPE_HULL]);
+    }
 
     dshader = state->shader[WINED3D_SHADER_TYPE_DOMAIN];
     if (!(context_gl->c.shader_update_mask & (1u << WINED3D_SHADER_TYPE_DOMAIN)) && ctx_data->glsl_program)
     {
         ds_id = ctx_data->glsl_program->ds.id;
+        digests[WINED3D_SHADER_TYPE_DOMAIN] = ctx_data->glsl_program->shader_digests[WINED3D_SHADER_TYPE_DOMAIN];
     }
     else if (dshader)
     {
         struct ds_compile_args args;
 
         find_ds_compile_args(state, dshader, &args, &context_gl->c);
-        ds_id = find_glsl_domain_shader(context_gl, priv, dshader, &args);
+        ds_id = find_glsl_domain_shader(context_gl, priv, dshader, &args, &digests[WINED3D_SHADER_TYPE_DOMAIN]);
     }
 
     gshader = state->shader[WINED3D_SHADER_TYPE_GEOMETRY];
     if (!(context_gl->c.shader_update_mask & (1u << WINED3D_SHADER_TYPE_GEOMETRY)) && ctx_data->glsl_program)
     {
         gs_id = ctx_data->glsl_program->gs.id;
+        digests[WINED3D_SHADER_TYPE_GEOMETRY] = ctx_data->glsl_program->shader_digests[WINED3D_SHADER_TYPE_GEOMETRY];
     }
     else if (gshader)
     {
         struct gs_compile_args args;
 
         find_gs_compile_args(state, gshader, &args, &context_gl->c);
-        gs_id = find_glsl_geometry_shader(context_gl, priv, gshader, &args);
+        gs_id = find_glsl_geometry_shader(context_gl, priv, gshader, &args, &digests[WINED3D_SHADER_TYPE_GEOMETRY]);
     }
 
     /* A pixel shader is not used when rasterization is disabled. */
@@ -10311,6 +10513,7 @@ static void set_glsl_shader_program(const struct wined3d_context_gl *context_gl,
     {
         ps_id = ctx_data->glsl_program->ps.id;
         ps_list = &ctx_data->glsl_program->ps.shader_entry;
+        digests[WINED3D_SHADER_TYPE_PIXEL] = ctx_data->glsl_program->shader_digests[WINED3D_SHADER_TYPE_PIXEL];
 
         if (use_ps(state))
             pshader = state->shader[WINED3D_SHADER_TYPE_PIXEL];
@@ -10322,7 +10525,7 @@ static void set_glsl_shader_program(const struct wined3d_context_gl *context_gl,
         find_ps_compile_args(state, pshader, context_gl->c.stream_info.position_transformed,
                 &ps_compile_args, &context_gl->c);
         ps_id = find_glsl_fragment_shader(context_gl, &priv->shader_buffer, &priv->string_buffers,
-                pshader, &ps_compile_args, &np2fixup_info);
+                pshader, &ps_compile_args, &np2fixup_info, &digests[WINED3D_SHADER_TYPE_PIXEL]);
         ps_list = &pshader->linked_programs;
     }
     else if (priv->fragment_pipe == &glsl_fragment_pipe
@@ -10334,6 +10537,7 @@ static void set_glsl_shader_program(const struct wined3d_context_gl *context_gl,
         wined3d_ffp_get_fs_settings(&context_gl->c, state, &settings, FALSE);
         ffp_shader = shader_glsl_find_ffp_fragment_shader(priv, &settings, context_gl);
         ps_id = ffp_shader->id;
+        digests[WINED3D_SHADER_TYPE_PIXEL] = ffp_shader->cache_digest;
         ps_list = &ffp_shader->linked_programs;
     }
 
@@ -10362,6 +10566,7 @@ static void set_glsl_shader_program(const struct wined3d_context_gl *context_gl,
     entry->gs.id = gs_id;
     entry->ps.id = ps_id;
     entry->cs.id = 0;
+    memcpy(entry->shader_digests, digests, sizeof(entry->shader_digests));
     entry->constant_version = 0;
     entry->shader_controlled_clip_distances = 0;
     entry->ps.np2_fixup_info = np2fixup_info;
@@ -10381,15 +10586,22 @@ static void set_glsl_shader_program(const struct wined3d_context_gl *context_gl,
         list_add_head(vs_list, &entry->vs.shader_entry);
     }
 
+    link_state.rasterizer_input_setup = 0;
     if (vshader)
     {
         attribs_map = vshader->reg_maps.input_registers;
         if (vshader->reg_maps.shader_version.major < 4)
         {
+            BOOL per_vertex_point_size = state->primitive_type == WINED3D_PT_POINTLIST
+                    && vshader->reg_maps.point_size;
+            BOOL flatshading = d3d_info->emulated_flatshading
+                    && state->render_states[WINED3D_RS_SHADEMODE] == WINED3D_SHADE_FLAT;
+
+            /* The setup shader is generated from the vertex and pixel shaders,
+             * which are part of the cache key already. */
+            link_state.rasterizer_input_setup = 1 | (per_vertex_point_size << 1) | (flatshading << 2);
             reorder_shader_id = shader_glsl_generate_vs3_rasterizer_input_setup(priv, vshader, pshader,
-                    state->primitive_type == WINED3D_PT_POINTLIST && vshader->reg_maps.point_size,
-                    d3d_info->emulated_flatshading
-                    && state->render_states[WINED3D_RS_SHADEMODE] == WINED3D_SHADE_FLAT, gl_info);
+                    per_vertex_point_size, flatshading, gl_info);
             TRACE("Attaching GLSL shader object %u to program %u.\n", reorder_shader_id, program_id);
             GL_EXTCALL(glAttachShader(program_id, reorder_shader_id));
             checkGLcall("glAttachShader");
@@ -10402,6 +10614,7 @@ static void set_glsl_shader_program(const struct wined3d_context_gl *context_gl,
     {
         attribs_map = (1u << WINED3D_FFP_ATTRIBS_COUNT) - 1;
     }
+    link_state.attribs_map = attribs_map;
 
     if (!shader_glsl_use_explicit_attrib_location(gl_info))
     {
@@ -10484,10 +10697,11 @@ static void set_glsl_shader_program(const struct wined3d_context_gl *context_gl,
         list_add_head(ps_list, &entry->ps.shader_entry);
     }
 
-    /* Link the program */
-    TRACE("Linking GLSL shader program %u.\n", program_id);
-    GL_EXTCALL(glLinkProgram(program_id));
-    shader_glsl_validate_link(gl_info, program_id);
+    /* Link the program. Programs with transform feedback aren't cached;
+     * the varyings set up for it are not part of the cache key. */
+    link_state.dual_source = state->blend_state && state->blend_state->dual_source;
+    shader_glsl_link_program(context_gl, priv, program_id, &link_state, sizeof(link_state),
+            digests, ARRAY_SIZE(digests), !gshader || !gshader->u.gs.so_desc);
 
     shader_glsl_init_vs_uniform_locations(gl_info, priv, program_id, &entry->vs,
             vshader ? vshader->limits->constant_float : 0);
@@ -0,0 +1,468 @@
+/*
+ * Persistent shader cache
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include <stdio.h>
+
+#include "wined3d_private.h"
+#include "bcrypt.h"
+
+WINE_DEFAULT_DEBUG_CHANNEL(d3d_shader);
+WINE_DECLARE_DEBUG_CHANNEL(d3d_perf);
+
+/* The cache stores one file per entry, named after the hex representation of
+ * the SHA-1 digest of the entry key. The key digest is chained, each update
+ * hashes the previous digest along with the new data, so that keys don't hold
+ * any resources and can be copied freely. Keys are computed by the backends from
+ * everything that influences the cached data: the backend, the driver, the
+ * shader byte code and the relevant state. The file header holds the whole
+ * digest, along with the length of the key data and the backend, which are
+ * checked on load. Entries are never updated in place; a hit refreshes the
+ * last write time of the file, which is what eviction is based on. */
+
+#define WINED3D_SHADER_CACHE_MAGIC   0x43533357 /* "W3SC" */
+#define WINED3D_SHADER_CACHE_VERSION 3
+
+struct wined3d_shader_cache_header
+{
+    uint32_t magic;
+    uint32_t version;
+    struct wined3d_shader_cache_digest digest;
+    uint64_t data_size;
+    uint64_t checksum;
+};
+
+struct wined3d_shader_cache_file
+{
+    FILETIME write_time;
+    uint64_t size;
+    WCHAR name[48];
+};
+
+static CRITICAL_SECTION wined3d_shader_cache_cs;
+static CRITICAL_SECTION_DEBUG wined3d_shader_cache_cs_debug =
+{
+    0, 0, &wined3d_shader_cache_cs,
+    {&wined3d_shader_cache_cs_debug.ProcessLocksList,
+    &wined3d_shader_cache_cs_debug.ProcessLocksList},
+    0, 0, {(DWORD_PTR)(__FILE__ ": wined3d_shader_cache_cs")}
+};
+static CRITICAL_SECTION wined3d_shader_cache_cs = {&wined3d_shader_cache_cs_debug, -1, 0, 0, 0, 0};
+
+static struct
+{
+    WCHAR *path;
+    BCRYPT_ALG_HANDLE sha1;
+    uint64_t max_size;
+    uint64_t total_size;
+    BOOL size_known;
+    BOOL directory_created;
+    unsigned int hits, misses, stores;
+} wined3d_shader_cache;
+
+static uint64_t wined3d_shader_cache_mix(uint64_t h)
+{
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ull;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebull;
+    h ^= h >> 31;
+    return h;
+}
+
+/* Only used to detect corrupted entries, the entries themselves are
+ * identified by the key digest. */
+static uint64_t wined3d_shader_cache_checksum(const void *data, size_t size)
+{
+    const uint8_t *p = data;
+    uint64_t h0 = 0xcbf29ce484222325ull, h1 = 0;
+    size_t i;
+
+    for (i = 0; i < size; ++i)
+    {
+        h0 = (h0 ^ p[i]) * 0x100000001b3ull;
+        h1 = (h1 + p[i] + 1) * 0x9e3779b97f4a7c15ull;
+        h1 ^= h1 >> 29;
+    }
+    return wined3d_shader_cache_mix(h0 ^ h1);
+}
+
+void wined3d_shader_cache_key_init(struct wined3d_shader_cache_key *key, const char *backend)
+{
+    memset(key, 0, sizeof(*key));
+    key->backend = backend;
+    wined3d_shader_cache_key_update(key, backend, strlen(backend));
+}
+
+void wined3d_shader_cache_key_update(struct wined3d_shader_cache_key *key, const void *data, size_t size)
+{
+    const unsigned char *p = data;
+    BCRYPT_HASH_HANDLE hash;
+    uint64_t s = size;
+    NTSTATUS status;
+    ULONG count;
+
+    /* Keys are only used when the cache is enabled. */
+    if (!wined3d_shader_cache.sha1)
+        return;
+
+    if ((status = BCryptCreateHash(wined3d_shader_cache.sha1, &hash, NULL, 0, NULL, 0, 0)))
+    {
+        ERR("Failed to create hash, status %#x.\n", status);
+        return;
+    }
+
+    /* Hash the size as well, so that e.g. "ab" + "c" and "a" + "bc" produce
+     * different keys. */
+    BCryptHashData(hash, (UCHAR *)key->sha1, sizeof(key->sha1), 0);
+    BCryptHashData(hash, (UCHAR *)&s, sizeof(s), 0);
+    key->size += size;
+    while (size)
+    {
+        count = min(size, 0x10000000);
+        BCryptHashData(hash, (UCHAR *)p, count, 0);
+        p += count;
+        size -= count;
+    }
+    BCryptFinishHash(hash, (UCHAR *)key->sha1, sizeof(key->sha1), 0);
+    BCryptDestroyHash(hash);
+}
+
+void wined3d_shader_cache_key_get_digest(const struct wined3d_shader_cache_key *key,
+        struct wined3d_shader_cache_digest *digest)
+{
+    memset(digest, 0, sizeof(*digest));
+    memcpy(digest->sha1, key->sha1, sizeof(digest->sha1));
+    digest->size = key->size;
+    lstrcpynA(digest->backend, key->backend, sizeof(digest->backend));
+}
+
+void wined3d_shader_cache_init(const char *path, unsigned int max_size_mb)
+{
+    WCHAR buffer[MAX_PATH];
+    NTSTATUS status;
+    DWORD len;
+
+    if (!(wined3d_shader_cache.max_size = (uint64_t)max_size_mb * 1024 * 1024))
+    {
+        TRACE("Shader cache disabled.\n");
+        return;
+    }
+
+    if ((status = BCryptOpenAlgorithmProvider(&wined3d_shader_cache.sha1, BCRYPT_SHA1_ALGORITHM, NULL, 0)))
+    {
+        WARN("Failed to open the SHA-1 algorithm provider, status %#x, disabling the shader cache.\n", status);
+        wined3d_shader_cache.sha1 = NULL;
+        wined3d_shader_cache.max_size = 0;
+        return;
+    }
+
+    if (path)
+    {
+        if (!(len = MultiByteToWideChar(CP_ACP, 0, path, -1, NULL, 0))
+                || !(wined3d_shader_cache.path = heap_alloc(len * sizeof(WCHAR))))
+            goto fail;
+        MultiByteToWideChar(CP_ACP, 0, path, -1, wined3d_shader_cache.path, len);
+    }
+    else
+    {
+        static const WCHAR suffixW[] = L"\\wined3d\\shader_cache";
+
+        if (!(len = GetEnvironmentVariableW(L"LOCALAPPDATA", buffer, ARRAY_SIZE(buffer)))
+                || len >= ARRAY_SIZE(buffer))
+            goto fail;
+        if (!(wined3d_shader_cache.path = heap_alloc((len + ARRAY_SIZE(suffixW)) * sizeof(WCHAR))))
+            goto fail;
+        memcpy(wined3d_shader_cache.path, buffer, len * sizeof(WCHAR));
+        memcpy(wined3d_shader_cache.path + len, suffixW, sizeof(suffixW));
+    }
+
+    TRACE("Using shader cache %s, size limit %u MiB.\n", debugstr_w(wined3d_shader_cache.path), max_size_mb);
+    return;
+
+fail:
+    WARN("Failed to determine the shader cache path, disabling the shader cache.\n");
+    BCryptCloseAlgorithmProvider(wined3d_shader_cache.sha1, 0);
+    wined3d_shader_cache.sha1 = NULL;
+    wined3d_shader_cache.max_size = 0;
+}
+
+void wined3d_shader_cache_cleanup(void)
+{
+    if (wined3d_shader_cache.max_size)
+        TRACE_(d3d_perf)("Shader cache: %u hits, %u misses, %u stores.\n",
+                wined3d_shader_cache.hits, wined3d_shader_cache.misses, wined3d_shader_cache.stores);
+    if (wined3d_shader_cache.sha1)
+        BCryptCloseAlgorithmProvider(wined3d_shader_cache.sha1, 0);
+    wined3d_shader_cache.sha1 = NULL;
+    heap_free(wined3d_shader_cache.path);
+    wined3d_shader_cache.path = NULL;
+    wined3d_shader_cache.max_size = 0;
+    DeleteCriticalSection(&wined3d_shader_cache_cs);
+}
+
+bool wined3d_shader_cache_enabled(void)
+{
+    return !!wined3d_shader_cache.max_size;
+}
+
+static void wined3d_shader_cache_get_file_path(const struct wined3d_shader_cache_digest *digest,
+        const WCHAR *suffix, WCHAR *path, size_t size)
+{
+    swprintf(path, size, L"%s\\%08x%08x%08x%08x%08x%s", wined3d_shader_cache.path, digest->sha1[0],
+            digest->sha1[1], digest->sha1[2], digest->sha1[3], digest->sha1[4], suffix);
+}
+
+/* Called with the cache lock held. */
+static BOOL wined3d_shader_cache_create_directory(void)
+{
+    WCHAR *path, *p;
+    DWORD attr;
+
+    if (wined3d_shader_cache.directory_created)
+        return TRUE;
+
+    if (!(path = heap_alloc((wcslen(wined3d_shader_cache.path) + 1) * sizeof(WCHAR))))
+        return FALSE;
+    wcscpy(path, wined3d_shader_cache.path);
+
+    /* Create each missing component of the path in turn. Skip the drive or
+     * UNC prefix; creating that would fail anyway. */
+    for (p = path; *p; ++p)
+    {
+        if (p != path && (*p == '\\' || *p == '/') && p[-1] != ':' && p[-1] != '\\' && p[-1] != '/')
+        {
+            *p = 0;
+            CreateDirectoryW(path, NULL);
+            *p = '\\';
+        }
+    }
+    CreateDirectoryW(path, NULL);
+    heap_free(path);
+
+    attr = GetFileAttributesW(wined3d_shader_cache.path);
+    if (attr == INVALID_FILE_ATTRIBUTES || !(attr & FILE_ATTRIBUTE_DIRECTORY))
+    {
+        WARN("Failed to create shader cache directory %s.\n", debugstr_w(wined3d_shader_cache.path));
+        return FALSE;
+    }
+
+    return wined3d_shader_cache.directory_created = TRUE;
+}
+
+static int __cdecl wined3d_shader_cache_file_compare(const void *a, const void *b)
+{
+    const struct wined3d_shader_cache_file *f1 = a, *f2 = b;
+
+    return CompareFileTime(&f1->write_time, &f2->write_time);
+}
+
+/* Scan the cache directory, updating the known total size. If "target" is
+ * non-zero, delete the least recently used entries until the total size is
+ * at most "target". Called with the cache lock held. */
+static void wined3d_shader_cache_scan(uint64_t target)
+{
+    struct wined3d_shader_cache_file *files = NULL, *tmp;
+    SIZE_T count = 0, capacity = 0, i;
+    WCHAR pattern[MAX_PATH], path[MAX_PATH];
+    WIN32_FIND_DATAW data;
+    uint64_t total = 0;
+    HANDLE find;
+
+    swprintf(pattern, ARRAY_SIZE(pattern), L"%s\\*.bin", wined3d_shader_cache.path);
+    if ((find = FindFirstFileW(pattern, &data)) == INVALID_HANDLE_VALUE)
+    {
+        wined3d_shader_cache.total_size = 0;
+        wined3d_shader_cache.size_known = TRUE;
+        return;
+    }
+
+    do
+    {
+        uint64_t size = ((uint64_t)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            continue;
+        total += size;
+        if (!target || wcslen(data.cFileName) >= ARRAY_SIZE(files->name))
+            continue;
+
+        if (count == capacity)
+        {
+            capacity = max(capacity * 2, 64);
+            if (!(tmp = heap_realloc(files, capacity * sizeof(*files))))
+                break;
+            files = tmp;
+        }
+        files[count].write_time = data.ftLastWriteTime;
+        files[count].size = size;
+        wcscpy(files[count].name, data.cFileName);
+        ++count;
+    } while (FindNextFileW(find, &data));
+    FindClose(find);
+
+    if (target && total > target)
+    {
+        qsort(files, count, sizeof(*files), wined3d_shader_cache_file_compare);
+        for (i = 0; i < count && total > target; ++i)
+        {
+            swprintf(path, ARRAY_SIZE(path), L"%s\\%s", wined3d_shader_cache.path, files[i].name);
+            if (DeleteFileW(path))
+                total -= files[i].size;
+        }
+        TRACE_(d3d_perf)("Evicted %lu shader cache entries, total size now %s.\n",
+                (unsigned long)i, wine_dbgstr_longlong(total));
+    }
+    heap_free(files);
+
+    wined3d_shader_cache.total_size = total;
+    wined3d_shader_cache.size_known = TRUE;
+}
+
+bool wined3d_shader_cache_get(const struct wined3d_shader_cache_key *key, void **data, size_t *size)
+{
+    struct wined3d_shader_cache_header header;
+    struct wined3d_shader_cache_digest digest;
+    WCHAR path[MAX_PATH];
+    FILETIME now;
+    HANDLE file;
+    DWORD read;
+    void *buffer;
+
+    *data = NULL;
+    *size = 0;
+
+    if (!wined3d_shader_cache.max_size)
+        return false;
+
+    wined3d_shader_cache_key_get_digest(key, &digest);
+    wined3d_shader_cache_get_file_path(&digest, L".bin", path, ARRAY_SIZE(path));
+
+    file = CreateFileW(path, GENERIC_READ | FILE_WRITE_ATTRIBUTES,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, 0, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        goto miss;
+
+    if (!ReadFile(file, &header, sizeof(header), &read, NULL) || read != sizeof(header)
+            || header.magic != WINED3D_SHADER_CACHE_MAGIC || header.version != WINED3D_SHADER_CACHE_VERSION
+            || memcmp(&header.digest, &digest, sizeof(digest)) || !header.data_size
+            || header.data_size > wined3d_shader_cache.max_size || header.data_size > ~(DWORD)0)
+    {
+        WARN("Invalid shader cache entry %s.\n", debugstr_w(path));
+        CloseHandle(file);
+        goto miss;
+    }
+
+    if (!(buffer = heap_alloc(header.data_size)))
+    {
+        CloseHandle(file);
+        goto miss;
+    }
+
+    if (!ReadFile(file, buffer, header.data_size, &read, NULL) || read != header.data_size
+            || wined3d_shader_cache_checksum(buffer, header.data_size) != header.checksum)
+    {
+        WARN("Corrupted shader cache entry %s.\n", debugstr_w(path));
+        heap_free(buffer);
+        CloseHandle(file);
+        goto miss;
+    }
+
+    /* Refresh the entry for LRU eviction. */
+    GetSystemTimeAsFileTime(&now);
+    SetFileTime(file, NULL, NULL, &now);
+    CloseHandle(file);
+
+    InterlockedIncrement((LONG *)&wined3d_shader_cache.hits);
+    *data = buffer;
+    *size = header.data_size;
+    return true;
+
+miss:
+    InterlockedIncrement((LONG *)&wined3d_shader_cache.misses);
+    return false;
+}
+
+void wined3d_shader_cache_put(const struct wined3d_shader_cache_key *key, const void *data, size_t size)
+{
+    struct wined3d_shader_cache_header header;
+    WCHAR path[MAX_PATH], tmp_path[MAX_PATH], suffix[32];
+    uint64_t file_size;
+    DWORD written;
+    HANDLE file;
+    BOOL ret;
+
+    if (!wined3d_shader_cache.max_size || !size)
+        return;
+
+    file_size = sizeof(header) + size;
+    if (file_size > wined3d_shader_cache.max_size / 4 || size > ~(DWORD)0)
+    {
+        TRACE("Not caching %s bytes of shader data.\n", wine_dbgstr_longlong(size));
+        return;
+    }
+
+    header.magic = WINED3D_SHADER_CACHE_MAGIC;
+    header.version = WINED3D_SHADER_CACHE_VERSION;
+    wined3d_shader_cache_key_get_digest(key, &header.digest);
+    header.data_size = size;
+    header.checksum = wined3d_shader_cache_checksum(data, size);
+
+    wined3d_shader_cache_get_file_path(&header.digest, L".bin", path, ARRAY_SIZE(path));
+    /* Write to a temporary file first, so that concurrent readers never see a
+     * partially written entry. */
+    swprintf(suffix, ARRAY_SIZE(suffix), L".%x-%x.tmp", GetCurrentProcessId(), GetCurrentThreadId());
+    wined3d_shader_cache_get_file_path(&header.digest, suffix, tmp_path, ARRAY_SIZE(tmp_path));
+
+    EnterCriticalSection(&wined3d_shader_cache_cs);
+
+    if (!wined3d_shader_cache_create_directory())
+    {
+        LeaveCriticalSection(&wined3d_shader_cache_cs);
+        return;
+    }
+
+    if (!wined3d_shader_cache.size_known)
+        wined3d_shader_cache_scan(0);
+
+    file = CreateFileW(tmp_path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        WARN("Failed to create %s, error %u.\n", debugstr_w(tmp_path), GetLastError());
+        LeaveCriticalSection(&wined3d_shader_cache_cs);
+        return;
+    }
+
+    ret = WriteFile(file, &header, sizeof(header), &written, NULL) && written == sizeof(header)
+            && WriteFile(file, data, size, &written, NULL) && written == size;
+    CloseHandle(file);
+
+    if (!ret || !MoveFileExW(tmp_path, path, MOVEFILE_REPLACE_EXISTING))
+    {
+        WARN("Failed to write shader cache entry %s, error %u.\n", debugstr_w(path), GetLastError());
+        DeleteFileW(tmp_path);
+        LeaveCriticalSection(&wined3d_shader_cache_cs);
+        return;
+    }
+
+    ++wined3d_shader_cache.stores;
+    wined3d_shader_cache.total_size += file_size;
+    if (wined3d_shader_cache.total_size > wined3d_shader_cache.max_size)
+        wined3d_shader_cache_scan(wined3d_shader_cache.max_size / 4 * 3);
+
+    LeaveCriticalSection(&wined3d_shader_cache_cs);
+}
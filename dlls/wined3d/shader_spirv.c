@@ -235,6 +235,52 @@ static void shader_spirv_init_shader_interface_vk(struct wined3d_shader_spirv_sh
     iface->vkd3d_interface.uav_counter_count = b->uav_counter_count;
 }
 
+static void shader_spirv_init_cache_key(struct wined3d_shader_cache_key *key,
+        const struct wined3d_shader_desc *shader_desc, enum wined3d_shader_type shader_type,
+        const struct shader_spirv_compile_arguments *args, const struct shader_spirv_resource_bindings *bindings)
+{
+    const char *version = vkd3d_shader_get_version(NULL, NULL);
+    const struct vkd3d_shader_uav_counter_binding *counter;
+    const struct vkd3d_shader_resource_binding *binding;
+    SIZE_T i;
+
+    /* Hash the fields one by one, the structures may contain padding. */
+    wined3d_shader_cache_key_init(key, "spirv");
+    wined3d_shader_cache_key_update(key, version, strlen(version));
+    wined3d_shader_cache_key_update_uint(key, shader_type);
+    if (shader_type == WINED3D_SHADER_TYPE_PIXEL)
+    {
+        wined3d_shader_cache_key_update_uint(key, args->u.fs.alpha_swizzle);
+        wined3d_shader_cache_key_update_uint(key, args->u.fs.sample_count);
+    }
+    wined3d_shader_cache_key_update_uint(key, bindings->binding_count);
+    for (i = 0; i < bindings->binding_count; ++i)
+    {
+        binding = &bindings->bindings[i];
+        wined3d_shader_cache_key_update_uint(key, binding->type);
+        wined3d_shader_cache_key_update_uint(key, binding->register_space);
+        wined3d_shader_cache_key_update_uint(key, binding->register_index);
+        wined3d_shader_cache_key_update_uint(key, binding->shader_visibility);
+        wined3d_shader_cache_key_update_uint(key, binding->flags);
+        wined3d_shader_cache_key_update_uint(key, binding->binding.set);
+        wined3d_shader_cache_key_update_uint(key, binding->binding.binding);
+        wined3d_shader_cache_key_update_uint(key, binding->binding.count);
+    }
+    wined3d_shader_cache_key_update_uint(key, bindings->uav_counter_count);
+    for (i = 0; i < bindings->uav_counter_count; ++i)
+    {
+        counter = &bindings->uav_counters[i];
+        wined3d_shader_cache_key_update_uint(key, counter->register_space);
+        wined3d_shader_cache_key_update_uint(key, counter->register_index);
+        wined3d_shader_cache_key_update_uint(key, counter->shader_visibility);
+        wined3d_shader_cache_key_update_uint(key, counter->binding.set);
+        wined3d_shader_cache_key_update_uint(key, counter->binding.binding);
+        wined3d_shader_cache_key_update_uint(key, counter->binding.count);
+        wined3d_shader_cache_key_update_uint(key, counter->offset);
+    }
+    wined3d_shader_cache_key_update(key, shader_desc->byte_code, shader_desc->byte_code_size);
+}
+
 static VkShaderModule shader_spirv_compile_shader(struct wined3d_context_vk *context_vk,
         const struct wined3d_shader_desc *shader_desc, enum wined3d_shader_type shader_type,
         const struct shader_spirv_compile_arguments *args, const struct shader_spirv_resource_bindings *bindings,
@@ -246,12 +292,29 @@ static VkShaderModule shader_spirv_compile_shader(struct wined3d_context_vk *con
     struct vkd3d_shader_compile_info info;
     const struct wined3d_vk_info *vk_info;
     struct wined3d_device_vk *device_vk;
+    struct wined3d_shader_cache_key cache_key;
     struct vkd3d_shader_code spirv;
+    bool cacheable, cached = false;
     VkShaderModule module;
+    void *cached_code;
+    size_t cached_size;
     char *messages;
     VkResult vr;
     int ret;
 
+    /* Stream output declarations aren't part of the cache key. */
+    if ((cacheable = !so_desc && wined3d_shader_cache_enabled()))
+    {
+        shader_spirv_init_cache_key(&cache_key, shader_desc, shader_type, args, bindings);
+        if ((cached = wined3d_shader_cache_get(&cache_key, &cached_code, &cached_size)))
+        {
+            TRACE("Using cached SPIR-V for shader type %#x.\n", shader_type);
+            spirv.code = cached_code;
+            spirv.size = cached_size;
+            goto create_module;
+        }
+    }
+
     shader_spirv_init_shader_interface_vk(&iface, bindings, so_desc);
     shader_spirv_init_compile_args(&compile_args, &iface.vkd3d_interface,
             VKD3D_SHADER_SPIRV_ENVIRONMENT_VULKAN_1_0, shader_type, args);
@@ -288,6 +351,10 @@ static VkShaderModule shader_spirv_compile_shader(struct wined3d_context_vk *con
         return VK_NULL_HANDLE;
     }
 
+    if (cacheable)
+        wined3d_shader_cache_put(&cache_key, spirv.code, spirv.size);
+
+create_module:
     device_vk = wined3d_device_vk(context_vk->c.device);
     vk_info = &device_vk->vk_info;
 
@@ -296,15 +363,19 @@ static VkShaderModule shader_spirv_compile_shader(struct wined3d_context_vk *con
     shader_create_info.flags = 0;
     shader_create_info.codeSize = spirv.size;
     shader_create_info.pCode = spirv.code;
-    if ((vr = VK_CALL(vkCreateShaderModule(device_vk->vk_device, &shader_create_info, NULL, &module))) < 0)
-    {
+    vr = VK_CALL(vkCreateShaderModule(device_vk->vk_device, &shader_create_info, NULL, &module));
+
+    if (cached)
+        heap_free(cached_code);
+    else
         vkd3d_shader_free_shader_code(&spirv);
+
+    if (vr < 0)
+    {
         WARN("Failed to create Vulkan shader module, vr %s.\n", wined3d_debug_vkresult(vr));
         return VK_NULL_HANDLE;
     }
 
-    vkd3d_shader_free_shader_code(&spirv);
-
     return module;
 }
 
@@ -404,8 +475,7 @@ static struct shader_spirv_compute_program_vk *shader_spirv_find_compute_program
     pipeline_info.layout = program->vk_pipeline_layout;
     pipeline_info.basePipelineHandle = VK_NULL_HANDLE;
     pipeline_info.basePipelineIndex = -1;
-    if ((vr = VK_CALL(vkCreateComputePipelines(device_vk->vk_device,
-            VK_NULL_HANDLE, 1, &pipeline_info, NULL, &program->vk_pipeline))) < 0)
+    if ((vr = wined3d_device_vk_create_compute_pipeline(device_vk, &pipeline_info, &program->vk_pipeline)) < 0)
     {
         ERR("Failed to create Vulkan compute pipeline, vr %s.\n", wined3d_debug_vkresult(vr));
         VK_CALL(vkDestroyShaderModule(device_vk->vk_device, program->vk_module, NULL));
@@ -954,6 +1024,9 @@ static void shader_spirv_destroy(struct wined3d_shader *shader)
         return;
     }
 
+    /* Background pipeline compilation may still reference the modules. */
+    wined3d_device_vk_wait_pipeline_compiles(device_vk);
+
     program_vk = shader->backend_data;
     for (i = 0; i < program_vk->variant_count; ++i)
     {
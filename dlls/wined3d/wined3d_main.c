@@ -126,6 +126,7 @@ struct wined3d_settings wined3d_settings =
     .max_sm_cs = UINT_MAX,
     .renderer = WINED3D_RENDERER_AUTO,
     .shader_backend = WINED3D_SHADER_BACKEND_AUTO,
+    .shader_cache_size = 0,
 };
 
 struct wined3d * CDECL wined3d_create(DWORD flags)
@@ -466,6 +467,22 @@ static BOOL wined3d_dll_init(HINSTANCE hInstDLL)
             TRACE("Forcing all constant buffers to be write-mappable.\n");
             wined3d_settings.cb_access_map_w = TRUE;
         }
+        if (!get_config_key_dword(hkey, appkey, env, "ShaderCacheSize", &wined3d_settings.shader_cache_size))
+            TRACE("Using a shader cache of up to %u MiB.\n", wined3d_settings.shader_cache_size);
+        if (!get_config_key_dword(hkey, appkey, env, "AsyncPipelineCompile", &tmpvalue) && tmpvalue)
+        {
+            ERR_(winediag)("Enabling asynchronous pipeline compilation.\n");
+            wined3d_settings.async_pipeline_compile = TRUE;
+        }
+        if (!get_config_key(hkey, appkey, env, "ShaderCachePath", buffer, size))
+        {
+            size_t len = strlen(buffer) + 1;
+
+            if (!(wined3d_settings.shader_cache_path = heap_alloc(len)))
+                ERR("Failed to allocate shader cache path memory.\n");
+            else
+                memcpy(wined3d_settings.shader_cache_path, buffer, len);
+        }
     }
 
     if (appkey) RegCloseKey( appkey );
@@ -473,6 +490,8 @@ static BOOL wined3d_dll_init(HINSTANCE hInstDLL)
 
     vkd3d_set_log_callback(vkd3d_log_callback);
 
+    wined3d_shader_cache_init(wined3d_settings.shader_cache_path, wined3d_settings.shader_cache_size);
+
     return TRUE;
 }
 
@@ -508,6 +527,8 @@ static BOOL wined3d_dll_destroy(HINSTANCE hInstDLL)
     heap_free(swapchain_state_table.hooks);
 
     heap_free(wined3d_settings.logo);
+    wined3d_shader_cache_cleanup();
+    heap_free(wined3d_settings.shader_cache_path);
     UnregisterClassA(WINED3D_OPENGL_WINDOW_CLASS_NAME, hInstDLL);
 
     DeleteCriticalSection(&wined3d_command_cs);
@@ -530,10 +530,45 @@ struct wined3d_settings
     enum wined3d_renderer renderer;
     enum wined3d_shader_backend shader_backend;
     BOOL cb_access_map_w;
+    unsigned int shader_cache_size;
+    char *shader_cache_path;
+    BOOL async_pipeline_compile;
 };
 
 extern struct wined3d_settings wined3d_settings DECLSPEC_HIDDEN;
 
+struct wined3d_shader_cache_key
+{
+    uint32_t sha1[5];
+    uint64_t size;
+    const char *backend;
+};
+
+struct wined3d_shader_cache_digest
+{
+    uint32_t sha1[5];
+    uint32_t padding;
+    uint64_t size;
+    char backend[24];
+};
+
+void wined3d_shader_cache_init(const char *path, unsigned int max_size_mb) DECLSPEC_HIDDEN;
+void wined3d_shader_cache_cleanup(void) DECLSPEC_HIDDEN;
+bool wined3d_shader_cache_enabled(void) DECLSPEC_HIDDEN;
+void wined3d_shader_cache_key_init(struct wined3d_shader_cache_key *key, const char *backend) DECLSPEC_HIDDEN;
+void wined3d_shader_cache_key_update(struct wined3d_shader_cache_key *key,
+        const void *data, size_t size) DECLSPEC_HIDDEN;
+void wined3d_shader_cache_key_get_digest(const struct wined3d_shader_cache_key *key,
+        struct wined3d_shader_cache_digest *digest) DECLSPEC_HIDDEN;
+
+static inline void wined3d_shader_cache_key_update_uint(struct wined3d_shader_cache_key *key, uint32_t value)
+{
+    wined3d_shader_cache_key_update(key, &value, sizeof(value));
+}
+bool wined3d_shader_cache_get(const struct wined3d_shader_cache_key *key, void **data, size_t *size) DECLSPEC_HIDDEN;
+void wined3d_shader_cache_put(const struct wined3d_shader_cache_key *key,
+        const void *data, size_t size) DECLSPEC_HIDDEN;
+
 enum wined3d_shader_byte_code_format
 {
     WINED3D_SHADER_BYTE_CODE_FORMAT_SM1,
@@ -2586,6 +2621,7 @@ struct wined3d_graphics_pipeline_vk
     struct wine_rb_entry entry;
     struct wined3d_graphics_pipeline_key_vk key;
     VkPipeline vk_pipeline;
+    LONG pending;
 };
 
 enum wined3d_shader_descriptor_type
@@ -4174,6 +4210,17 @@ struct wined3d_uav_clear_state_vk
     struct wined3d_pipeline_layout_vk *buffer_layout;
 };
 
+struct wined3d_pipeline_stats_vk
+{
+    LONG graphics_count;
+    LONG compute_count;
+    LONG async_count;
+    LONG skipped_draw_count;
+    /* In QueryPerformanceCounter() ticks. */
+    LONGLONG stall_time;
+    LONGLONG async_time;
+};
+
 struct wined3d_device_vk
 {
     struct wined3d_device d;
@@ -4194,6 +4241,14 @@ struct wined3d_device_vk
     struct wined3d_allocator allocator;
 
     struct wined3d_uav_clear_state_vk uav_clear_state;
+
+    VkPipelineCache vk_pipeline_cache;
+    struct wined3d_shader_cache_key pipeline_cache_key;
+    struct wined3d_pipeline_stats_vk pipeline_stats;
+
+    SRWLOCK pipeline_compile_lock;
+    CONDITION_VARIABLE pipeline_compile_cv;
+    unsigned int pending_pipeline_compiles;
 };
 
 static inline struct wined3d_device_vk *wined3d_device_vk(struct wined3d_device *device)
@@ -4201,6 +4256,12 @@ static inline struct wined3d_device_vk *wined3d_device_vk(struct wined3d_device
     return CONTAINING_RECORD(device, struct wined3d_device_vk, d);
 }
 
+VkResult wined3d_device_vk_create_graphics_pipeline(struct wined3d_device_vk *device_vk,
+        const VkGraphicsPipelineCreateInfo *desc, bool async, VkPipeline *vk_pipeline) DECLSPEC_HIDDEN;
+VkResult wined3d_device_vk_create_compute_pipeline(struct wined3d_device_vk *device_vk,
+        const VkComputePipelineCreateInfo *desc, VkPipeline *vk_pipeline) DECLSPEC_HIDDEN;
+void wined3d_device_vk_wait_pipeline_compiles(struct wined3d_device_vk *device_vk) DECLSPEC_HIDDEN;
+
 static inline struct wined3d_device_vk *wined3d_device_vk_from_allocator(struct wined3d_allocator *allocator)
 {
     return CONTAINING_RECORD(allocator, struct wined3d_device_vk, allocator);
@@ -5027,6 +5088,24 @@ struct wined3d_device_context
     struct wined3d_state *state;
 };
 
+/* Command stream statistics, only collected while the d3d_perf channel is
+ * enabled. Times are in QueryPerformanceCounter() ticks. */
+struct wined3d_cs_perf_stats
+{
+    BOOL enabled;
+    LONGLONG frequency;
+    LONGLONG last_report;
+    LONGLONG spin_start;
+    /* Time spent by producers waiting for queue space or for the CS thread
+     * to finish; updated by the producer threads. */
+    LONGLONG stall_time;
+    LONGLONG spin_time;
+    LONGLONG wait_time;
+    uint64_t occupancy_sum;
+    ULONG occupancy_max;
+    unsigned int packet_count;
+};
+
 struct wined3d_cs
 {
     struct wined3d_device_context c;
@@ -5046,6 +5125,8 @@ struct wined3d_cs
     HANDLE event;
     BOOL waiting_for_event;
     LONG pending_presents;
+
+    struct wined3d_cs_perf_stats perf;
 };
 
 static inline void wined3d_device_context_lock(struct wined3d_device_context *context)
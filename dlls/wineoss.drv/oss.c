@@ -873,14 +873,17 @@ static NTSTATUS timer_loop(void *args)
 {
     struct timer_loop_params *params = args;
     struct oss_stream *stream = handle_get_stream(params->stream);
-    LARGE_INTEGER delay, now, next;
+    LARGE_INTEGER delay, now, next, freq;
+    LONGLONG period;
     int adjust;
 
     oss_lock(stream);
 
+    /* the performance counter doesn't necessarily count in 100 ns units */
     delay.QuadPart = -stream->period;
-    NtQueryPerformanceCounter(&now, NULL);
-    next.QuadPart = now.QuadPart + stream->period;
+    NtQueryPerformanceCounter(&now, &freq);
+    period = stream->period * freq.QuadPart / 10000000;
+    next.QuadPart = now.QuadPart + period;
 
     while(!stream->please_quit){
         if(stream->playing){
@@ -897,13 +900,13 @@ static NTSTATUS timer_loop(void *args)
 
         oss_lock(stream);
         NtQueryPerformanceCounter(&now, NULL);
-        adjust = next.QuadPart - now.QuadPart;
+        adjust = (next.QuadPart - now.QuadPart) * 10000000 / freq.QuadPart;
         if(adjust > stream->period / 2)
             adjust = stream->period / 2;
         else if(adjust < -stream->period / 2)
             adjust = -stream->period / 2;
         delay.QuadPart = -(stream->period + adjust);
-        next.QuadPart += stream->period;
+        next.QuadPart += period;
     }
 
     oss_unlock(stream);
@@ -1371,9 +1371,34 @@ static VkTimeDomainEXT map_to_host_time_domain(VkTimeDomainEXT domain)
     return domain;
 }
 
-static inline uint64_t convert_monotonic_timestamp(uint64_t value)
+static uint64_t convert_monotonic_timestamp(VkTimeDomainEXT host_domain, uint64_t value)
 {
-    return value / (NANOSECONDS_IN_A_SECOND / TICKSPERSEC);
+    LARGE_INTEGER counter, freq;
+#ifdef HAVE_CLOCK_GETTIME
+    struct timespec ts;
+    clockid_t clock_id = CLOCK_MONOTONIC;
+    int64_t delta;
+#endif
+
+    NtQueryPerformanceCounter(&counter, &freq);
+    if (freq.QuadPart == TICKSPERSEC)
+        return value / (NANOSECONDS_IN_A_SECOND / TICKSPERSEC);
+
+#ifdef HAVE_CLOCK_GETTIME
+    /* The performance counter is TSC based, translate relative to the current time. */
+# ifdef CLOCK_MONOTONIC_RAW
+    if (host_domain == VK_TIME_DOMAIN_CLOCK_MONOTONIC_RAW_EXT)
+        clock_id = CLOCK_MONOTONIC_RAW;
+# endif
+    if (!clock_gettime(clock_id, &ts))
+    {
+        delta = (int64_t)value - ((int64_t)ts.tv_sec * NANOSECONDS_IN_A_SECOND + ts.tv_nsec);
+        return counter.QuadPart + delta / NANOSECONDS_IN_A_SECOND * freq.QuadPart
+                + delta % NANOSECONDS_IN_A_SECOND * freq.QuadPart / NANOSECONDS_IN_A_SECOND;
+    }
+#endif
+    return value / NANOSECONDS_IN_A_SECOND * freq.QuadPart
+            + value % NANOSECONDS_IN_A_SECOND * freq.QuadPart / NANOSECONDS_IN_A_SECOND;
 }
 
 static inline uint64_t convert_timestamp(VkTimeDomainEXT host_domain, VkTimeDomainEXT target_domain, uint64_t value)
@@ -1384,7 +1409,7 @@ static inline uint64_t convert_timestamp(VkTimeDomainEXT host_domain, VkTimeDoma
     /* Convert between MONOTONIC time in ns -> QueryPerformanceCounter */
     if ((host_domain == VK_TIME_DOMAIN_CLOCK_MONOTONIC_RAW_EXT || host_domain == VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT)
             && target_domain == VK_TIME_DOMAIN_QUERY_PERFORMANCE_COUNTER_EXT)
-        return convert_monotonic_timestamp(value);
+        return convert_monotonic_timestamp(host_domain, value);
 
     FIXME("Couldn't translate between host domain %d and target domain %d\n", host_domain, target_domain);
     return value;
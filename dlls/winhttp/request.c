@@ -22,6 +22,7 @@
 #include <assert.h>
 #include <stdarg.h>
 #include <wchar.h>
+#include <zlib.h>
 
 #define COBJMACROS
 #include "windef.h"
@@ -1853,14 +1854,18 @@ static DWORD refill_buffer( struct request *request, BOOL notify )
         {
             if ((ret = start_next_chunk( request, notify ))) return ret;
         }
-        len = min( len, request->read_chunked_size );
+        if (min( len, request->read_chunked_size ) <= request->read_size) return ERROR_SUCCESS;
+
+        /* read ahead past the end of the chunk, chunk boundaries are parsed from the buffer */
+        len = -1;
     }
     else if (request->content_length != ~0u)
     {
         len = min( len, request->content_length - request->content_read );
+        if (len <= request->read_size) return ERROR_SUCCESS;
     }
+    else if (len <= request->read_size) return ERROR_SUCCESS;
 
-    if (len <= request->read_size) return ERROR_SUCCESS;
     if ((ret = read_more_data( request, len, notify ))) return ret;
     if (!request->read_size) request->content_length = request->content_read = 0;
     return ERROR_SUCCESS;
@@ -1897,8 +1902,8 @@ static DWORD get_available_data( struct request *request )
     return request->read_size;
 }
 
-/* check if we have reached the end of the data to read */
-static BOOL end_of_read_data( struct request *request )
+/* check if we have reached the end of the raw data to read */
+static BOOL end_of_raw_data( struct request *request )
 {
     if (!request->content_length) return TRUE;
     if (request->read_chunked) return request->read_chunked_eof;
@@ -1906,6 +1911,189 @@ static BOOL end_of_read_data( struct request *request )
     return (request->content_length == request->content_read);
 }
 
+/* consume raw data that has been passed on to the caller or to the decoder */
+static void consume_raw_data( struct request *request, DWORD count )
+{
+    remove_data( request, count );
+    if (request->read_chunked) request->read_chunked_size -= count;
+    request->content_read += count;
+}
+
+struct decoder
+{
+    z_stream zstream;
+    BOOL     raw_deflate;  /* retried as raw deflate data after a zlib header error */
+    BOOL     eof;          /* end of the decoded data */
+    DWORD    pos;          /* current read position in buf */
+    DWORD    size;         /* decoded but not returned data size in buf */
+    char     buf[16384];
+};
+
+static voidpf zalloc( voidpf opaque, uInt items, uInt size )
+{
+    return malloc( items * size );
+}
+
+static void zfree( voidpf opaque, voidpf address )
+{
+    free( address );
+}
+
+void destroy_decoder( struct request *request )
+{
+    if (!request->decoder) return;
+    inflateEnd( &request->decoder->zstream );
+    free( request->decoder );
+    request->decoder = NULL;
+}
+
+/* set up decoding of the content if it's compressed and decompression was requested */
+static DWORD init_decoder( struct request *request )
+{
+    WCHAR encoding[20];
+    DWORD size = sizeof(encoding);
+    struct decoder *decoder;
+    int window_bits;
+
+    destroy_decoder( request );
+
+    if (!request->decompression || !request->content_length) return ERROR_SUCCESS;
+    if (query_headers( request, WINHTTP_QUERY_CONTENT_ENCODING, NULL, encoding, &size, NULL )) return ERROR_SUCCESS;
+
+    if (!wcsicmp( encoding, L"gzip" ) && (request->decompression & WINHTTP_DECOMPRESSION_FLAG_GZIP))
+        window_bits = 16 + MAX_WBITS;
+    else if (!wcsicmp( encoding, L"deflate" ) && (request->decompression & WINHTTP_DECOMPRESSION_FLAG_DEFLATE))
+        window_bits = MAX_WBITS;
+    else
+    {
+        TRACE( "not decoding %s content\n", debugstr_w(encoding) );
+        return ERROR_SUCCESS;
+    }
+
+    if (!(decoder = calloc( 1, sizeof(*decoder) ))) return ERROR_OUTOFMEMORY;
+    decoder->zstream.zalloc = zalloc;
+    decoder->zstream.zfree = zfree;
+    if (inflateInit2( &decoder->zstream, window_bits ) != Z_OK)
+    {
+        ERR( "inflateInit2 failed\n" );
+        free( decoder );
+        return ERROR_OUTOFMEMORY;
+    }
+
+    TRACE( "decoding %s content\n", debugstr_w(encoding) );
+    request->decoder = decoder;
+    return ERROR_SUCCESS;
+}
+
+/* skip raw data following the end of the compressed stream, so that the connection can be reused */
+static DWORD skip_raw_data( struct request *request, BOOL notify )
+{
+    DWORD ret, count;
+
+    while (!end_of_raw_data( request ))
+    {
+        if (!(count = get_available_data( request )))
+        {
+            if ((ret = refill_buffer( request, notify ))) return ret;
+            if (!(count = get_available_data( request ))) break;
+        }
+        consume_raw_data( request, count );
+    }
+    return ERROR_SUCCESS;
+}
+
+/* decode buffered raw data, refilling the buffer if blocking is allowed, until some decoded data is available */
+static DWORD decode_data( struct request *request, BOOL notify, BOOL blocking )
+{
+    struct decoder *decoder = request->decoder;
+    z_stream *zstream = &decoder->zstream;
+    DWORD ret, avail;
+    int zret;
+
+    if (decoder->size) return ERROR_SUCCESS;
+    decoder->pos = 0;
+
+    while (!decoder->eof)
+    {
+        avail = get_available_data( request );
+
+        zstream->next_in   = (Bytef *)request->read_buf + request->read_pos;
+        zstream->avail_in  = avail;
+        zstream->next_out  = (Bytef *)decoder->buf;
+        zstream->avail_out = sizeof(decoder->buf);
+        zret = inflate( zstream, Z_SYNC_FLUSH );
+
+        if (zret == Z_DATA_ERROR && !decoder->raw_deflate && !zstream->total_out &&
+            (request->decompression & WINHTTP_DECOMPRESSION_FLAG_DEFLATE) && inflateReset2( zstream, -MAX_WBITS ) == Z_OK)
+        {
+            /* some servers send deflate content without the zlib header, start over with the same input */
+            TRACE( "retrying as raw deflate data\n" );
+            decoder->raw_deflate = TRUE;
+            continue;
+        }
+
+        consume_raw_data( request, avail - zstream->avail_in );
+        decoder->size = sizeof(decoder->buf) - zstream->avail_out;
+
+        if (zret == Z_STREAM_END)
+        {
+            decoder->eof = TRUE;
+            break;
+        }
+        if (zret != Z_OK && zret != Z_BUF_ERROR)
+        {
+            WARN( "inflate failed %d: %s\n", zret, debugstr_a(zstream->msg) );
+            return ERROR_WINHTTP_INVALID_SERVER_RESPONSE;
+        }
+        if (decoder->size) break;
+
+        /* all buffered input consumed without producing any output */
+        if (end_of_raw_data( request ))
+        {
+            WARN( "unexpected end of compressed data\n" );
+            decoder->eof = TRUE;
+            break;
+        }
+        if (!blocking && !get_available_data( request )) break;
+        if ((ret = refill_buffer( request, notify ))) return ret;
+    }
+    return ERROR_SUCCESS;
+}
+
+/* return the size of data available to be returned without reading from the network */
+static DWORD get_available_content( struct request *request )
+{
+    if (!request->decoder) return get_available_data( request );
+    if (!request->decoder->size) decode_data( request, FALSE, FALSE );
+    return request->decoder->size;
+}
+
+/* check if we have reached the end of the data to read */
+static BOOL end_of_read_data( struct request *request )
+{
+    if (request->decoder) return request->decoder->eof && !request->decoder->size;
+    return end_of_raw_data( request );
+}
+
+static DWORD read_decoded_data( struct request *request, char *buffer, DWORD size, int *read, BOOL notify )
+{
+    struct decoder *decoder = request->decoder;
+    DWORD ret = ERROR_SUCCESS, count;
+
+    while (size)
+    {
+        if ((ret = decode_data( request, notify, TRUE ))) break;
+        if (!(count = min( decoder->size, size ))) break;
+
+        memcpy( buffer + *read, decoder->buf + decoder->pos, count );
+        decoder->pos += count;
+        decoder->size -= count;
+        size -= count;
+        *read += count;
+    }
+    return ret;
+}
+
 static DWORD read_data( struct request *request, void *buffer, DWORD size, DWORD *read, BOOL async )
 {
     int count, bytes_read = 0;
@@ -1913,6 +2101,12 @@ static DWORD read_data( struct request *request, void *buffer, DWORD size, DWORD
 
     if (end_of_read_data( request )) goto done;
 
+    if (request->decoder)
+    {
+        ret = read_decoded_data( request, buffer, size, &bytes_read, async );
+        goto done;
+    }
+
     while (size)
     {
         if (!(count = get_available_data( request )))
@@ -1922,18 +2116,20 @@ static DWORD read_data( struct request *request, void *buffer, DWORD size, DWORD
         }
         count = min( count, size );
         memcpy( (char *)buffer + bytes_read, request->read_buf + request->read_pos, count );
-        remove_data( request, count );
-        if (request->read_chunked) request->read_chunked_size -= count;
+        consume_raw_data( request, count );
         size -= count;
         bytes_read += count;
-        request->content_read += count;
         if (end_of_read_data( request )) goto done;
     }
     if (request->read_chunked && !request->read_chunked_size) ret = refill_buffer( request, async );
 
 done:
     TRACE( "retrieved %u bytes (%lu/%lu)\n", bytes_read, request->content_read, request->content_length );
-    if (end_of_read_data( request )) finished_reading( request );
+    if (end_of_read_data( request ))
+    {
+        if (request->decoder && !ret) ret = skip_raw_data( request, async );
+        finished_reading( request );
+    }
     if (async)
     {
         if (!ret) send_callback( &request->hdr, WINHTTP_CALLBACK_STATUS_READ_COMPLETE, buffer, bytes_read );
@@ -1956,6 +2152,9 @@ static void drain_content( struct request *request )
     DWORD size, bytes_read, bytes_total = 0, bytes_left = request->content_length - request->content_read;
     char buffer[2048];
 
+    /* drain the raw content, there is no point in decoding it */
+    destroy_decoder( request );
+
     refill_buffer( request, FALSE );
     for (;;)
     {
@@ -2194,6 +2393,14 @@ static DWORD send_request( struct request *request, const WCHAR *headers, DWORD
     {
         process_header( request, L"Connection", L"Keep-Alive", WINHTTP_ADDREQ_FLAG_ADD_IF_NEW, TRUE );
     }
+    if (request->decompression)
+    {
+        const WCHAR *encoding = L"gzip, deflate";
+
+        if (!(request->decompression & WINHTTP_DECOMPRESSION_FLAG_DEFLATE)) encoding = L"gzip";
+        else if (!(request->decompression & WINHTTP_DECOMPRESSION_FLAG_GZIP)) encoding = L"deflate";
+        process_header( request, L"Accept-Encoding", encoding, WINHTTP_ADDREQ_FLAG_ADD_IF_NEW, TRUE );
+    }
     if (request->hdr.flags & WINHTTP_FLAG_REFRESH)
     {
         process_header( request, L"Pragma", L"no-cache", WINHTTP_ADDREQ_FLAG_ADD_IF_NEW, TRUE );
@@ -2826,6 +3033,7 @@ static DWORD receive_response( struct request *request, BOOL async )
 
     if (request->netconn) netconn_set_timeout( request->netconn, FALSE, request->receive_timeout );
     if (request->content_length) ret = refill_buffer( request, FALSE );
+    if (!ret) ret = init_decoder( request );
 
     if (async)
     {
@@ -2898,8 +3106,9 @@ static DWORD query_data_ready( struct request *request )
 {
     DWORD count;
 
-    count = get_available_data( request );
-    if (!request->read_chunked && request->netconn) count += netconn_query_data_available( request->netconn );
+    count = get_available_content( request );
+    if (!request->decoder && !request->read_chunked && request->netconn)
+        count += netconn_query_data_available( request->netconn );
 
     return count;
 }
@@ -2917,7 +3126,9 @@ static DWORD query_data_available( struct request *request, DWORD *available, BO
 
     if (!(count = query_data_ready( request )))
     {
-        if ((ret = refill_buffer( request, async ))) goto done;
+        if (request->decoder) ret = decode_data( request, async, TRUE );
+        else ret = refill_buffer( request, async );
+        if (ret) goto done;
         count = query_data_ready( request );
     }
 
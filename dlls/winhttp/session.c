@@ -196,6 +196,27 @@ static BOOL session_set_option( struct object_header *hdr, DWORD option, void *b
         SetLastError( ERROR_WINHTTP_INCORRECT_HANDLE_TYPE );
         return FALSE;
 
+    case WINHTTP_OPTION_DECOMPRESSION:
+    {
+        DWORD flags;
+
+        if (buflen != sizeof(flags))
+        {
+            SetLastError( ERROR_INSUFFICIENT_BUFFER );
+            return FALSE;
+        }
+
+        flags = *(DWORD *)buffer;
+        TRACE( "%#lx\n", flags );
+        if (flags & ~WINHTTP_DECOMPRESSION_FLAG_ALL)
+        {
+            SetLastError( ERROR_INVALID_PARAMETER );
+            return FALSE;
+        }
+        session->decompression = flags;
+        return TRUE;
+    }
+
     case WINHTTP_OPTION_RESOLVE_TIMEOUT:
         session->resolve_timeout = *(DWORD *)buffer;
         return TRUE;
@@ -609,6 +630,7 @@ static void request_destroy( struct object_header *hdr )
 
     destroy_authinfo( request->authinfo );
     destroy_authinfo( request->proxy_authinfo );
+    destroy_decoder( request );
 
     free( request->verb );
     free( request->path );
@@ -905,6 +927,26 @@ static BOOL request_set_option( struct object_header *hdr, DWORD option, void *b
         hdr->logon_policy = policy;
         return TRUE;
     }
+    case WINHTTP_OPTION_DECOMPRESSION:
+    {
+        DWORD flags;
+
+        if (buflen != sizeof(DWORD))
+        {
+            SetLastError( ERROR_INSUFFICIENT_BUFFER );
+            return FALSE;
+        }
+
+        flags = *(DWORD *)buffer;
+        TRACE( "%#lx\n", flags );
+        if (flags & ~WINHTTP_DECOMPRESSION_FLAG_ALL)
+        {
+            SetLastError( ERROR_INVALID_PARAMETER );
+            return FALSE;
+        }
+        request->decompression = flags;
+        return TRUE;
+    }
     case WINHTTP_OPTION_REDIRECT_POLICY:
     {
         DWORD policy;
@@ -1173,6 +1215,7 @@ HINTERNET WINAPI WinHttpOpenRequest( HINTERNET hconnect, const WCHAR *verb, cons
     request->send_timeout = connect->session->send_timeout;
     request->receive_timeout = connect->session->receive_timeout;
     request->receive_response_timeout = connect->session->receive_response_timeout;
+    request->decompression = connect->session->decompression;
     request->max_redirects = 10;
 
     if (!verb || !verb[0]) verb = L"GET";
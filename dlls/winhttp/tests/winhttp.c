@@ -2285,6 +2285,34 @@ static const char unauthorized[] = "Unauthorized";
 static const char hello_world[] = "Hello World";
 static const char auth_unseen[] = "Auth Unseen";
 
+static const char gzipmsg[] =
+"HTTP/1.1 200 OK\r\n"
+"Server: winetest\r\n"
+"Content-Encoding: gzip\r\n"
+"Content-Length: 68\r\n"
+"\r\n";
+
+static const char deflatemsg[] =
+"HTTP/1.1 200 OK\r\n"
+"Server: winetest\r\n"
+"Content-Encoding: deflate\r\n"
+"Transfer-Encoding: chunked\r\n"
+"\r\n";
+
+/* "winhttp content decoding test\r\n" repeated 64 times */
+static const char gzip_data[] =
+    "\x1f\x8b\x08\x00\x00\x00\x00\x00\x02\x03\x2b\xcf\xcc\xcb\x28\x29"
+    "\x29\x50\x48\xce\xcf\x2b\x49\xcd\x2b\x51\x48\x49\x4d\xce\x4f\xc9"
+    "\xcc\x4b\x57\x28\x49\x2d\x2e\xe1\xe5\x2a\x1f\x95\x1e\x95\x1e\x95"
+    "\x1e\x95\x1e\x95\x1e\x95\x1e\x95\x1e\x7c\xd2\x00\x16\x0e\x35\xfb"
+    "\xc0\x07\x00\x00";
+
+static const char deflate_data[] =
+    "\x78\x9c\x2b\xcf\xcc\xcb\x28\x29\x29\x50\x48\xce\xcf\x2b\x49\xcd"
+    "\x2b\x51\x48\x49\x4d\xce\x4f\xc9\xcc\x4b\x57\x28\x49\x2d\x2e\xe1"
+    "\xe5\x2a\x1f\x95\x1e\x95\x1e\x95\x1e\x95\x1e\x95\x1e\x95\x1e\x95"
+    "\x1e\x7c\xd2\x00\x3d\x5a\xdf\x5f";
+
 struct server_info
 {
     HANDLE event;
@@ -2523,6 +2551,24 @@ static DWORD CALLBACK server_thread(LPVOID param)
             send(c, okmsg, sizeof okmsg - 1, 0);
             send(c, page1, sizeof page1 - 1, 0);
         }
+        if (strstr(buffer, "GET /gzip"))
+        {
+            if (strstr(buffer, "GET /gzip_accept"))
+                ok(!!strstr(buffer, "Accept-Encoding: gzip, deflate\r\n"), "Accept-Encoding missing from request %s.\n",
+                   debugstr_a(buffer));
+            send(c, gzipmsg, sizeof(gzipmsg) - 1, 0);
+            send(c, gzip_data, sizeof(gzip_data) - 1, 0);
+        }
+        if (strstr(buffer, "GET /deflate"))
+        {
+            /* split the stream over two chunks */
+            send(c, deflatemsg, sizeof(deflatemsg) - 1, 0);
+            send(c, "14\r\n", 4, 0);
+            send(c, deflate_data, 20, 0);
+            send(c, "\r\n24\r\n", 6, 0);
+            send(c, deflate_data + 20, 36, 0);
+            send(c, "\r\n0\r\n\r\n", 7, 0);
+        }
         if (strstr(buffer, "GET /quit"))
         {
             send(c, okmsg, sizeof okmsg - 1, 0);
@@ -3720,6 +3766,119 @@ static void test_multiple_reads(int port)
     WinHttpCloseHandle(ses);
 }
 
+static DWORD read_all_data( HINTERNET req, char *buf, DWORD size )
+{
+    DWORD total = 0, len, bytes_read;
+    BOOL ret;
+
+    for (;;)
+    {
+        len = 0xdeadbeef;
+        ret = WinHttpQueryDataAvailable( req, &len );
+        ok( ret, "WinHttpQueryDataAvailable failed with error %lu\n", GetLastError() );
+        if (!ret || !len) break;
+        if (len > size - total) len = size - total;
+        bytes_read = 0;
+        ret = WinHttpReadData( req, buf + total, len, &bytes_read );
+        ok( ret, "WinHttpReadData failed: %lu\n", GetLastError() );
+        if (!ret || !bytes_read) break;
+        total += bytes_read;
+        if (total == size) break;
+    }
+    return total;
+}
+
+static void test_content_decoding( int port )
+{
+    static const char line[] = "winhttp content decoding test\r\n";
+    HINTERNET ses, con, req;
+    char expected[64 * (sizeof(line) - 1)], buf[4096];
+    DWORD flags, count, i;
+    BOOL ret;
+
+    for (i = 0; i < 64; i++) memcpy( expected + i * (sizeof(line) - 1), line, sizeof(line) - 1 );
+
+    ses = WinHttpOpen( L"winetest", WINHTTP_ACCESS_TYPE_NO_PROXY, NULL, NULL, 0 );
+    ok( ses != NULL, "failed to open session %lu\n", GetLastError() );
+
+    flags = WINHTTP_DECOMPRESSION_FLAG_ALL;
+    ret = WinHttpSetOption( ses, WINHTTP_OPTION_DECOMPRESSION, &flags, sizeof(flags) );
+    if (!ret && GetLastError() == ERROR_WINHTTP_INVALID_OPTION)
+    {
+        win_skip( "WINHTTP_OPTION_DECOMPRESSION not supported\n" );
+        WinHttpCloseHandle( ses );
+        return;
+    }
+    ok( ret, "failed to set decompression option %lu\n", GetLastError() );
+
+    flags = 0x80;
+    SetLastError( 0xdeadbeef );
+    ret = WinHttpSetOption( ses, WINHTTP_OPTION_DECOMPRESSION, &flags, sizeof(flags) );
+    ok( !ret, "expected failure\n" );
+    ok( GetLastError() == ERROR_INVALID_PARAMETER, "got %lu\n", GetLastError() );
+
+    con = WinHttpConnect( ses, L"localhost", port, 0 );
+    ok( con != NULL, "failed to open a connection %lu\n", GetLastError() );
+
+    /* gzip with content length, option inherited from the session */
+    req = WinHttpOpenRequest( con, NULL, L"/gzip_accept", NULL, NULL, NULL, 0 );
+    ok( req != NULL, "failed to open a request %lu\n", GetLastError() );
+
+    ret = WinHttpSendRequest( req, NULL, 0, NULL, 0, 0, 0 );
+    ok( ret, "failed to send request %lu\n", GetLastError() );
+    ret = WinHttpReceiveResponse( req, NULL );
+    ok( ret, "failed to receive response %lu\n", GetLastError() );
+
+    count = read_all_data( req, buf, sizeof(buf) );
+    ok( count == sizeof(expected), "got %lu\n", count );
+    ok( !memcmp( buf, expected, sizeof(expected) ), "unexpected data\n" );
+    WinHttpCloseHandle( req );
+
+    /* deflate split over chunks, small reads */
+    req = WinHttpOpenRequest( con, NULL, L"/deflate", NULL, NULL, NULL, 0 );
+    ok( req != NULL, "failed to open a request %lu\n", GetLastError() );
+
+    ret = WinHttpSendRequest( req, NULL, 0, NULL, 0, 0, 0 );
+    ok( ret, "failed to send request %lu\n", GetLastError() );
+    ret = WinHttpReceiveResponse( req, NULL );
+    ok( ret, "failed to receive response %lu\n", GetLastError() );
+
+    count = 0;
+    for (;;)
+    {
+        DWORD bytes_read = 0;
+        ret = WinHttpReadData( req, buf + count, 7, &bytes_read );
+        ok( ret, "WinHttpReadData failed: %lu\n", GetLastError() );
+        if (!ret || !bytes_read) break;
+        count += bytes_read;
+        if (count > sizeof(expected)) break;
+    }
+    ok( count == sizeof(expected), "got %lu\n", count );
+    ok( !memcmp( buf, expected, sizeof(expected) ), "unexpected data\n" );
+    WinHttpCloseHandle( req );
+
+    /* decoding disabled on the request */
+    req = WinHttpOpenRequest( con, NULL, L"/gzip", NULL, NULL, NULL, 0 );
+    ok( req != NULL, "failed to open a request %lu\n", GetLastError() );
+
+    flags = 0;
+    ret = WinHttpSetOption( req, WINHTTP_OPTION_DECOMPRESSION, &flags, sizeof(flags) );
+    ok( ret, "failed to set decompression option %lu\n", GetLastError() );
+
+    ret = WinHttpSendRequest( req, NULL, 0, NULL, 0, 0, 0 );
+    ok( ret, "failed to send request %lu\n", GetLastError() );
+    ret = WinHttpReceiveResponse( req, NULL );
+    ok( ret, "failed to receive response %lu\n", GetLastError() );
+
+    count = read_all_data( req, buf, sizeof(buf) );
+    ok( count == sizeof(gzip_data) - 1, "got %lu\n", count );
+    ok( !memcmp( buf, gzip_data, sizeof(gzip_data) - 1 ), "unexpected data\n" );
+    WinHttpCloseHandle( req );
+
+    WinHttpCloseHandle( con );
+    WinHttpCloseHandle( ses );
+}
+
 static void test_cookies( int port )
 {
     HINTERNET ses, con, req;
@@ -5675,6 +5834,7 @@ START_TEST (winhttp)
     test_large_data_authentication(si.port);
     test_bad_header(si.port);
     test_multiple_reads(si.port);
+    test_content_decoding(si.port);
     test_cookies(si.port);
     test_request_path_escapes(si.port);
     test_passport_auth(si.port);
@@ -85,6 +85,7 @@ struct session
     HANDLE unload_event;
     DWORD secure_protocols;
     DWORD passport_flags;
+    DWORD decompression;
 };
 
 struct connect
@@ -204,7 +205,9 @@ struct request
     BOOL  read_chunked_size; /* chunk size remaining */
     DWORD read_pos;       /* current read position in read_buf */
     DWORD read_size;      /* valid data size in read_buf */
-    char  read_buf[8192]; /* buffer for already read but not returned data */
+    char  read_buf[65536]; /* buffer for already read but not returned data, large enough to read ahead */
+    DWORD decompression;  /* WINHTTP_DECOMPRESSION_FLAG_* */
+    struct decoder *decoder; /* content decoder, NULL if the content is returned as is */
     struct header *headers;
     DWORD num_headers;
     struct authinfo *authinfo;
@@ -361,6 +364,7 @@ BOOL free_handle( HINTERNET ) DECLSPEC_HIDDEN;
 
 void send_callback( struct object_header *, DWORD, LPVOID, DWORD ) DECLSPEC_HIDDEN;
 void close_connection( struct request * ) DECLSPEC_HIDDEN;
+void destroy_decoder( struct request * ) DECLSPEC_HIDDEN;
 void init_queue( struct queue *queue ) DECLSPEC_HIDDEN;
 void stop_queue( struct queue * ) DECLSPEC_HIDDEN;
 
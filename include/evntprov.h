@@ -26,6 +26,8 @@ extern "C" {
 #define EVENT_LEVEL_MIN 0x00
 #define EVENT_LEVEL_MAX 0xff
 
+#define MAX_EVENT_DATA_DESCRIPTORS 128
+
 typedef ULONGLONG REGHANDLE, *PREGHANDLE;
 
 typedef struct _EVENT_DATA_DESCRIPTOR
@@ -30,6 +30,10 @@ extern "C" {
 #define EVENT_TRACE_CONTROL_UPDATE    2
 #define EVENT_TRACE_CONTROL_FLUSH     3
 
+#define EVENT_CONTROL_CODE_DISABLE_PROVIDER 0
+#define EVENT_CONTROL_CODE_ENABLE_PROVIDER  1
+#define EVENT_CONTROL_CODE_CAPTURE_STATE    2
+
 #define TRACE_LEVEL_NONE              0
 #define TRACE_LEVEL_CRITICAL          1
 #define TRACE_LEVEL_FATAL             1
@@ -831,6 +831,47 @@ typedef struct
     lparam_t info;
 } cursor_pos_t;
 
+/* user state shared read-only with the clients; the server increments seq
+ * before and after each update, so it is odd while an update is in progress */
+
+typedef volatile struct
+{
+    int                  seq;
+    int                  cursor_x;
+    int                  cursor_y;
+    unsigned int         cursor_last_change;
+    rectangle_t          cursor_clip;
+    unsigned char        keystate[256];
+} desktop_shm_t;
+
+typedef volatile struct
+{
+    int                  seq;
+    user_handle_t        focus;
+    user_handle_t        capture;
+    user_handle_t        active;
+    user_handle_t        menu_owner;
+    user_handle_t        move_size;
+    user_handle_t        caret;
+    rectangle_t          caret_rect;
+    user_handle_t        cursor;
+    int                  cursor_count;
+    int                  keystate_lock;
+    unsigned char        keystate[256];
+    unsigned char        desktop_keystate[256];
+} input_shm_t;
+
+typedef volatile struct
+{
+    int                  seq;
+    unsigned int         input_id;
+    unsigned int         wake_bits;
+    unsigned int         wake_mask;
+    unsigned int         changed_bits;
+    unsigned int         changed_mask;
+    unsigned int         last_get_msg;
+} queue_shm_t;
+
 
 
 
@@ -5288,6 +5329,23 @@ struct get_cursor_history_reply
 
 
 
+struct get_user_shared_memory_request
+{
+    struct request_header __header;
+    int            type;
+};
+struct get_user_shared_memory_reply
+{
+    struct reply_header __header;
+    obj_handle_t   handle;
+    unsigned int   input_id;
+};
+#define USER_SHM_DESKTOP  0
+#define USER_SHM_QUEUE    1
+#define USER_SHM_INPUT    2
+
+
+
 struct get_rawinput_buffer_request
 {
     struct request_header __header;
@@ -5741,6 +5799,7 @@ enum request
     REQ_free_user_handle,
     REQ_set_cursor,
     REQ_get_cursor_history,
+    REQ_get_user_shared_memory,
     REQ_get_rawinput_buffer,
     REQ_update_rawinput_devices,
     REQ_create_job,
@@ -6025,6 +6084,7 @@ union generic_request
     struct free_user_handle_request free_user_handle_request;
     struct set_cursor_request set_cursor_request;
     struct get_cursor_history_request get_cursor_history_request;
+    struct get_user_shared_memory_request get_user_shared_memory_request;
     struct get_rawinput_buffer_request get_rawinput_buffer_request;
     struct update_rawinput_devices_request update_rawinput_devices_request;
     struct create_job_request create_job_request;
@@ -6307,6 +6367,7 @@ union generic_reply
     struct free_user_handle_reply free_user_handle_reply;
     struct set_cursor_reply set_cursor_reply;
     struct get_cursor_history_reply get_cursor_history_reply;
+    struct get_user_shared_memory_reply get_user_shared_memory_reply;
     struct get_rawinput_buffer_reply get_rawinput_buffer_reply;
     struct update_rawinput_devices_reply update_rawinput_devices_reply;
     struct create_job_reply create_job_reply;
@@ -6324,7 +6385,7 @@ union generic_reply
 
 /* ### protocol_version begin ### */
 
-#define SERVER_PROTOCOL_VERSION 755
+#define SERVER_PROTOCOL_VERSION 756
 
 /* ### protocol_version end ### */
 
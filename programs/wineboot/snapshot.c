@@ -0,0 +1,369 @@
+/*
+ * Prefix snapshots
+ *
+ * Copyright 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/*
+ * A snapshot is a directory containing the registry hives and the system
+ * directories of a freshly installed prefix, so that later prefix creations
+ * with the same Wine build and wine.inf can copy it instead of running the
+ * whole wine.inf installation again. The layout is:
+ *
+ *   version       identifies the build the snapshot was made with
+ *   machine.reg   HKEY_LOCAL_MACHINE
+ *   userdef.reg   HKEY_USERS\.Default
+ *   user.reg      HKEY_CURRENT_USER
+ *   files\...     copy of the system directories of drive C:
+ *
+ * The version file is written last and removed first, so that an incomplete
+ * snapshot is never applied. Values that must be unique to each prefix are
+ * removed when a snapshot is applied, they are created again on first use.
+ */
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ntstatus.h"
+#define WIN32_NO_STATUS
+#include "windef.h"
+#include "winbase.h"
+#include "winreg.h"
+#include "winternl.h"
+
+#include "wine/debug.h"
+
+WINE_DEFAULT_DEBUG_CHANNEL(wineboot);
+
+static const WCHAR *snapshot_dirs[] =
+{
+    L"windows",
+    L"Program Files",
+    L"Program Files (x86)",
+    L"ProgramData",
+};
+
+/* values unique to the prefix the snapshot was recorded in */
+static const struct
+{
+    const WCHAR *key;
+    const WCHAR *value;
+}
+unique_values[] =
+{
+    /* created by advapi32 when missing */
+    { L"Software\\Microsoft\\Cryptography", L"MachineGuid" },
+};
+
+static WCHAR *path_append( const WCHAR *dir, const WCHAR *name )
+{
+    WCHAR *ret;
+    size_t len = lstrlenW( dir ) + lstrlenW( name ) + 2;
+
+    if (!(ret = HeapAlloc( GetProcessHeap(), 0, len * sizeof(WCHAR) ))) return NULL;
+    swprintf( ret, len, L"%s\\%s", dir, name );
+    return ret;
+}
+
+/* convert the snapshot directory to a DOS path, it is usually given as a Unix path */
+static WCHAR *get_snapshot_path( const WCHAR *dir, const WCHAR *name )
+{
+    WCHAR *unix_dir, *p, *ret;
+
+    if (dir[0] != '/') return path_append( dir, name );
+
+    if (!(unix_dir = path_append( L"\\\\?\\unix", dir + 1 ))) return NULL;
+    for (p = unix_dir; *p; p++) if (*p == '/') *p = '\\';
+    ret = path_append( unix_dir, name );
+    HeapFree( GetProcessHeap(), 0, unix_dir );
+    return ret;
+}
+
+static BOOL enable_privilege( const WCHAR *name )
+{
+    TOKEN_PRIVILEGES privs;
+    HANDLE token;
+    BOOL ret;
+
+    if (!OpenProcessToken( GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES, &token )) return FALSE;
+    privs.PrivilegeCount = 1;
+    privs.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+    ret = LookupPrivilegeValueW( NULL, name, &privs.Privileges[0].Luid ) &&
+          AdjustTokenPrivileges( token, FALSE, &privs, 0, NULL, NULL ) &&
+          GetLastError() == ERROR_SUCCESS;
+    CloseHandle( token );
+    return ret;
+}
+
+static char *read_version_file( const WCHAR *dir )
+{
+    WCHAR *path = get_snapshot_path( dir, L"version" );
+    HANDLE file = INVALID_HANDLE_VALUE;
+    char *ret = NULL;
+    DWORD size, read;
+
+    if (path) file = CreateFileW( path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, 0 );
+    HeapFree( GetProcessHeap(), 0, path );
+    if (file == INVALID_HANDLE_VALUE) return NULL;
+
+    size = GetFileSize( file, NULL );
+    if (size != INVALID_FILE_SIZE && size < 4096 && (ret = HeapAlloc( GetProcessHeap(), 0, size + 1 )))
+    {
+        if (ReadFile( file, ret, size, &read, NULL ) && read == size) ret[size] = 0;
+        else
+        {
+            HeapFree( GetProcessHeap(), 0, ret );
+            ret = NULL;
+        }
+    }
+    CloseHandle( file );
+    return ret;
+}
+
+static BOOL write_version_file( const WCHAR *dir, const char *version )
+{
+    WCHAR *path = get_snapshot_path( dir, L"version" );
+    HANDLE file = INVALID_HANDLE_VALUE;
+    DWORD written;
+    BOOL ret;
+
+    if (path) file = CreateFileW( path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, 0 );
+    HeapFree( GetProcessHeap(), 0, path );
+    if (file == INVALID_HANDLE_VALUE) return FALSE;
+
+    ret = WriteFile( file, version, strlen(version), &written, NULL ) && written == strlen(version);
+    CloseHandle( file );
+    return ret;
+}
+
+static BOOL create_directories( WCHAR *path )
+{
+    WCHAR *p;
+    BOOL ret;
+
+    if (CreateDirectoryW( path, NULL ) || GetLastError() == ERROR_ALREADY_EXISTS) return TRUE;
+    if (GetLastError() != ERROR_PATH_NOT_FOUND || !(p = wcsrchr( path, '\\' ))) return FALSE;
+
+    *p = 0;
+    ret = create_directories( path );
+    *p = '\\';
+    return ret && (CreateDirectoryW( path, NULL ) || GetLastError() == ERROR_ALREADY_EXISTS);
+}
+
+/* recursively copy the contents of a directory, replacing existing files */
+static BOOL copy_tree( const WCHAR *src, const WCHAR *dst )
+{
+    WIN32_FIND_DATAW data;
+    WCHAR *mask, *src_path, *dst_path;
+    HANDLE handle;
+    BOOL ret = TRUE;
+
+    if (!(mask = path_append( src, L"*" ))) return FALSE;
+    handle = FindFirstFileW( mask, &data );
+    HeapFree( GetProcessHeap(), 0, mask );
+    if (handle == INVALID_HANDLE_VALUE) return GetLastError() == ERROR_FILE_NOT_FOUND;
+
+    do
+    {
+        if (!wcscmp( data.cFileName, L"." ) || !wcscmp( data.cFileName, L".." )) continue;
+
+        src_path = path_append( src, data.cFileName );
+        dst_path = path_append( dst, data.cFileName );
+        if (!src_path || !dst_path) ret = FALSE;
+        else if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            ret = create_directories( dst_path ) && copy_tree( src_path, dst_path );
+        else if (!(ret = CopyFileW( src_path, dst_path, FALSE )))
+            WINE_WARN( "failed to copy %s to %s, error %lu\n",
+                       debugstr_w(src_path), debugstr_w(dst_path), GetLastError() );
+        HeapFree( GetProcessHeap(), 0, src_path );
+        HeapFree( GetProcessHeap(), 0, dst_path );
+    } while (ret && FindNextFileW( handle, &data ));
+
+    FindClose( handle );
+    return ret;
+}
+
+/* copy the system directories between drive C: and the snapshot */
+static BOOL copy_snapshot_files( const WCHAR *dir, BOOL record )
+{
+    WCHAR drive[MAX_PATH], *files, *src, *dst;
+    unsigned int i;
+    BOOL ret = TRUE;
+
+    GetWindowsDirectoryW( drive, MAX_PATH );
+    drive[2] = 0;  /* keep only the drive letter */
+
+    if (!(files = get_snapshot_path( dir, L"files" ))) return FALSE;
+
+    for (i = 0; ret && i < ARRAY_SIZE(snapshot_dirs); i++)
+    {
+        WCHAR *system_path = path_append( drive, snapshot_dirs[i] );
+        WCHAR *snapshot_path = path_append( files, snapshot_dirs[i] );
+
+        src = record ? system_path : snapshot_path;
+        dst = record ? snapshot_path : system_path;
+        if (!src || !dst) ret = FALSE;
+        else if (GetFileAttributesW( src ) != INVALID_FILE_ATTRIBUTES)
+            ret = create_directories( dst ) && copy_tree( src, dst );
+
+        HeapFree( GetProcessHeap(), 0, system_path );
+        HeapFree( GetProcessHeap(), 0, snapshot_path );
+    }
+
+    HeapFree( GetProcessHeap(), 0, files );
+    return ret;
+}
+
+static BOOL load_hive( const WCHAR *dir, const WCHAR *name, const WCHAR *key_name )
+{
+    OBJECT_ATTRIBUTES key_attr, file_attr;
+    UNICODE_STRING key_str, file_str;
+    WCHAR *path;
+    NTSTATUS status;
+
+    if (!(path = get_snapshot_path( dir, name ))) return FALSE;
+    if (!RtlDosPathNameToNtPathName_U( path, &file_str, NULL, NULL ))
+    {
+        HeapFree( GetProcessHeap(), 0, path );
+        return FALSE;
+    }
+    HeapFree( GetProcessHeap(), 0, path );
+
+    RtlInitUnicodeString( &key_str, key_name );
+    InitializeObjectAttributes( &key_attr, &key_str, OBJ_CASE_INSENSITIVE, 0, NULL );
+    InitializeObjectAttributes( &file_attr, &file_str, OBJ_CASE_INSENSITIVE, 0, NULL );
+
+    /* the hive is merged into the existing key */
+    if ((status = NtLoadKey( &key_attr, &file_attr )))
+        WINE_WARN( "failed to load %s into %s, status %#lx\n",
+                   debugstr_w(file_str.Buffer), debugstr_w(key_name), status );
+    RtlFreeUnicodeString( &file_str );
+    return !status;
+}
+
+static BOOL save_hive( const WCHAR *dir, const WCHAR *name, HKEY root, const WCHAR *subkey )
+{
+    WCHAR *path;
+    HKEY key;
+    LSTATUS res;
+
+    if (!(path = get_snapshot_path( dir, name ))) return FALSE;
+    if (!(res = RegOpenKeyExW( root, subkey, 0, KEY_READ, &key )))
+    {
+        DeleteFileW( path );
+        res = RegSaveKeyW( key, path, NULL );
+        RegCloseKey( key );
+    }
+    if (res) WINE_WARN( "failed to save %s, error %ld\n", debugstr_w(path), res );
+    HeapFree( GetProcessHeap(), 0, path );
+    return !res;
+}
+
+static void delete_unique_values(void)
+{
+    unsigned int i;
+    LSTATUS res;
+
+    for (i = 0; i < ARRAY_SIZE(unique_values); i++)
+    {
+        res = RegDeleteKeyValueW( HKEY_LOCAL_MACHINE, unique_values[i].key, unique_values[i].value );
+        if (res && res != ERROR_FILE_NOT_FOUND)
+            WINE_WARN( "failed to delete %s\\%s, error %ld\n", debugstr_w(unique_values[i].key),
+                       debugstr_w(unique_values[i].value), res );
+    }
+}
+
+/***********************************************************************
+ *           apply_prefix_snapshot
+ *
+ * Populate the prefix from a snapshot, if one exists for the given version.
+ */
+BOOL apply_prefix_snapshot( const WCHAR *dir, const char *version )
+{
+    UNICODE_STRING user_key;
+    DWORD start = GetTickCount();
+    char *snapshot_version;
+    BOOL ret;
+
+    if (!(snapshot_version = read_version_file( dir ))) return FALSE;
+    ret = !strcmp( snapshot_version, version );
+    HeapFree( GetProcessHeap(), 0, snapshot_version );
+    if (!ret)
+    {
+        WINE_TRACE( "snapshot in %s is out of date\n", debugstr_w(dir) );
+        return FALSE;
+    }
+
+    if (!enable_privilege( L"SeRestorePrivilege" ))
+    {
+        WINE_WARN( "failed to enable restore privilege, not using snapshot\n" );
+        return FALSE;
+    }
+    if (RtlFormatCurrentUserKeyPath( &user_key )) return FALSE;
+
+    ret = load_hive( dir, L"machine.reg", L"\\Registry\\Machine" ) &&
+          load_hive( dir, L"userdef.reg", L"\\Registry\\User\\.Default" ) &&
+          load_hive( dir, L"user.reg", user_key.Buffer ) &&
+          copy_snapshot_files( dir, FALSE );
+    RtlFreeUnicodeString( &user_key );
+    if (ret) delete_unique_values();
+
+    if (ret) WINE_TRACE( "applied snapshot %s in %lu ms\n", debugstr_w(dir), GetTickCount() - start );
+    else WINE_ERR( "failed to apply snapshot %s, prefix may be incomplete\n", debugstr_w(dir) );
+    return ret;
+}
+
+/***********************************************************************
+ *           record_prefix_snapshot
+ *
+ * Save the state of the freshly installed prefix to a snapshot.
+ */
+void record_prefix_snapshot( const WCHAR *dir, const char *version )
+{
+    DWORD start = GetTickCount();
+    WCHAR *path;
+
+    if (!(path = get_snapshot_path( dir, L"version" ))) return;
+    DeleteFileW( path );
+    HeapFree( GetProcessHeap(), 0, path );
+
+    if (!(path = get_snapshot_path( dir, L"" ))) return;
+    path[lstrlenW( path ) - 1] = 0;  /* strip the trailing backslash */
+    if (!create_directories( path ))
+    {
+        WINE_WARN( "failed to create snapshot directory %s\n", debugstr_w(path) );
+        HeapFree( GetProcessHeap(), 0, path );
+        return;
+    }
+    HeapFree( GetProcessHeap(), 0, path );
+
+    if (!enable_privilege( L"SeBackupPrivilege" ))
+    {
+        WINE_WARN( "failed to enable backup privilege, not recording snapshot\n" );
+        return;
+    }
+
+    if (save_hive( dir, L"machine.reg", HKEY_LOCAL_MACHINE, NULL ) &&
+        save_hive( dir, L"userdef.reg", HKEY_USERS, L".Default" ) &&
+        save_hive( dir, L"user.reg", HKEY_CURRENT_USER, NULL ) &&
+        copy_snapshot_files( dir, TRUE ) &&
+        write_version_file( dir, version ))
+        WINE_TRACE( "recorded snapshot %s in %lu ms\n", debugstr_w(dir), GetTickCount() - start );
+    else
+        WINE_WARN( "failed to record snapshot %s\n", debugstr_w(dir) );
+}
@@ -85,6 +85,8 @@ WINE_DEFAULT_DEBUG_CHANNEL(wineboot);
 extern BOOL shutdown_close_windows( BOOL force );
 extern BOOL shutdown_all_desktops( BOOL force );
 extern void kill_processes( BOOL kill_desktop );
+extern BOOL apply_prefix_snapshot( const WCHAR *dir, const char *version );
+extern void record_prefix_snapshot( const WCHAR *dir, const char *version );
 
 static WCHAR windowsdir[MAX_PATH];
 static const BOOL is_64bit = sizeof(void *) > sizeof(int);
@@ -241,12 +243,132 @@ static void initialize_xstate_features(struct _KUSER_SHARED_DATA *data)
     TRACE("XSAVE feature 2 %#x, %#x, %#x, %#x.\n", regs[0], regs[1], regs[2], regs[3]);
 }
 
+static ULONGLONG read_tsc( UCHAR flags )
+{
+    unsigned int aux;
+
+    if (flags & SHARED_GLOBAL_FLAGS_QPC_BYPASS_USE_RDTSCP) return __rdtscp( &aux );
+    if (flags & SHARED_GLOBAL_FLAGS_QPC_BYPASS_USE_LFENCE) __asm__ __volatile__( "lfence" : : : "memory" );
+    if (flags & SHARED_GLOBAL_FLAGS_QPC_BYPASS_USE_MFENCE) __asm__ __volatile__( "mfence" : : : "memory" );
+    return __rdtsc();
+}
+
+/* the kernel stops using the TSC when it finds it unreliable, don't use it unless we can check */
+static BOOL is_tsc_clocksource(void)
+{
+    char buffer[32];
+    DWORD count;
+    HANDLE file;
+    BOOL ret = FALSE;
+
+    file = CreateFileW( L"\\\\?\\unix\\sys\\devices\\system\\clocksource\\clocksource0\\current_clocksource",
+                        GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL );
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        TRACE( "kernel clock source unknown\n" );
+        return FALSE;
+    }
+    if (ReadFile( file, buffer, sizeof(buffer) - 1, &count, NULL ))
+    {
+        buffer[count] = 0;
+        ret = !strncmp( buffer, "tsc", 3 );
+        if (!ret) TRACE( "kernel clock source is %s\n", debugstr_a(buffer) );
+    }
+    CloseHandle( file );
+    return ret;
+}
+
+/* read the performance counter and the TSC, keeping the sample with the tightest TSC bounds */
+static void read_tsc_and_counter( UCHAR flags, ULONGLONG *tsc, LARGE_INTEGER *counter )
+{
+    ULONGLONG before, after, best = ~(ULONGLONG)0;
+    LARGE_INTEGER value;
+    unsigned int i;
+
+    for (i = 0; i < 8; i++)
+    {
+        before = read_tsc( flags );
+        NtQueryPerformanceCounter( &value, NULL );
+        after = read_tsc( flags );
+        if (after - before >= best) continue;
+        best = after - before;
+        *tsc = before + best / 2;
+        *counter = value;
+    }
+}
+
+/* measure the TSC frequency against the monotonic performance counter */
+static ULONGLONG read_tsc_frequency( UCHAR flags )
+{
+    LARGE_INTEGER counter0, counter1;
+    ULONGLONG tsc0, tsc1;
+
+    read_tsc_and_counter( flags, &tsc0, &counter0 );
+    Sleep( 50 );
+    read_tsc_and_counter( flags, &tsc1, &counter1 );
+
+    if (tsc1 <= tsc0 || counter1.QuadPart <= counter0.QuadPart) return 0;
+    return (tsc1 - tsc0) * 10000000 / (counter1.QuadPart - counter0.QuadPart);
+}
+
+static void initialize_qpc_features( struct _KUSER_SHARED_DATA *data )
+{
+    ULONGLONG freq;
+    UCHAR flags;
+    int regs[4];
+
+    /* keep the calibration of a previous run, running processes depend on it */
+    if (data->QpcBypassEnabled) return;
+
+    data->QpcFrequency = 10000000;
+    data->QpcShift = 0;
+    data->QpcBias = 0;
+
+    if (!data->ProcessorFeatures[PF_RDTSC_INSTRUCTION_AVAILABLE]) return;
+
+    __cpuid( regs, 0x80000000 );
+    if ((unsigned int)regs[0] < 0x80000007) return;
+    __cpuid( regs, 0x80000007 );
+    if (!(regs[3] & (1 << 8)))
+    {
+        TRACE( "no invariant TSC, not using it for QueryPerformanceCounter\n" );
+        return;
+    }
+    if (!is_tsc_clocksource()) return;
+
+    __cpuid( regs, 0x80000001 );
+    if (regs[3] & (1 << 27))
+        flags = SHARED_GLOBAL_FLAGS_QPC_BYPASS_USE_RDTSCP;
+    else if (data->ProcessorFeatures[PF_XMMI64_INSTRUCTIONS_AVAILABLE])
+        flags = SHARED_GLOBAL_FLAGS_QPC_BYPASS_USE_LFENCE;
+    else
+        flags = SHARED_GLOBAL_FLAGS_QPC_BYPASS_USE_MFENCE;
+
+    if (!(freq = read_tsc_frequency( flags )))
+    {
+        WARN( "TSC frequency calibration failed, not using it for QueryPerformanceCounter\n" );
+        return;
+    }
+
+    /* like Windows without a hypervisor, count in units of 1024 TSC cycles */
+    data->QpcShift = 10;
+    data->QpcFrequency = (freq + 512) >> 10;
+    MemoryBarrier();
+    data->QpcBypassEnabled = flags | SHARED_GLOBAL_FLAGS_QPC_BYPASS_ENABLED;
+    TRACE( "using TSC for QueryPerformanceCounter, frequency %s\n", wine_dbgstr_longlong(data->QpcFrequency) );
+}
+
 #else
 
 static void initialize_xstate_features(struct _KUSER_SHARED_DATA *data)
 {
 }
 
+static void initialize_qpc_features( struct _KUSER_SHARED_DATA *data )
+{
+    data->QpcFrequency = 10000000;
+}
+
 #endif
 
 static void create_user_shared_data(void)
@@ -336,6 +458,7 @@ static void create_user_shared_data(void)
     data->ActiveGroupCount = 1;
 
     initialize_xstate_features( data );
+    initialize_qpc_features( data );
 
     UnmapViewOfFile( data );
 }
@@ -1329,13 +1452,30 @@ static HWND show_wait_window(void)
     return hwnd;
 }
 
+/* number of processes setupapi uses to register dlls, from WINEBOOT_REGISTER_JOBS */
+static int get_register_jobs(void)
+{
+    const WCHAR *str = _wgetenv( L"WINEBOOT_REGISTER_JOBS" );
+    SYSTEM_INFO si;
+    int jobs;
+
+    if (!str) return 0;
+    if ((jobs = wcstol( str, NULL, 10 )) <= 0)
+    {
+        GetSystemInfo( &si );
+        jobs = si.dwNumberOfProcessors;
+    }
+    return jobs;
+}
+
 static HANDLE start_rundll32( const WCHAR *inf_path, const WCHAR *install, WORD machine )
 {
     WCHAR app[MAX_PATH + ARRAY_SIZE(L"\\rundll32.exe" )];
     STARTUPINFOW si;
     PROCESS_INFORMATION pi;
-    WCHAR *buffer;
+    WCHAR *buffer, jobs[16];
     DWORD len;
+    int count;
 
     memset( &si, 0, sizeof(si) );
     si.cb = sizeof(si);
@@ -1349,11 +1489,19 @@ static HANDLE start_rundll32( const WCHAR *inf_path, const WCHAR *install, WORD
     if (!(buffer = HeapAlloc( GetProcessHeap(), 0, len * sizeof(WCHAR) ))) return 0;
     swprintf( buffer, len, L"%s setupapi,InstallHinfSection %s 128 %s", app, install, inf_path );
 
+    /* only the wine.inf installation registers dlls in parallel */
+    if ((count = get_register_jobs()))
+    {
+        swprintf( jobs, ARRAY_SIZE(jobs), L"%d", count );
+        SetEnvironmentVariableW( L"__WINE_REGISTER_DLL_JOBS", jobs );
+    }
+
     if (CreateProcessW( app, buffer, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi ))
         CloseHandle( pi.hThread );
     else
         pi.hProcess = 0;
 
+    if (count) SetEnvironmentVariableW( L"__WINE_REGISTER_DLL_JOBS", NULL );
     HeapFree( GetProcessHeap(), 0, buffer );
     return pi.hProcess;
 }
@@ -1446,10 +1594,29 @@ static void update_user_profile(void)
     LocalFree(sid);
 }
 
+/* build the string identifying prefix snapshots compatible with this installation */
+static void get_snapshot_version( char *buffer, size_t size, const struct stat *st, const ULONG *machines )
+{
+    const char * (CDECL *pwine_get_build_id)(void);
+    WCHAR user[256];
+    DWORD len = ARRAY_SIZE(user);
+    int pos;
+
+    pwine_get_build_id = (void *)GetProcAddress( GetModuleHandleW( L"ntdll.dll" ), "wine_get_build_id" );
+    if (!GetUserNameW( user, &len )) user[0] = 0;
+
+    pos = snprintf( buffer, size, "%s\n%lx-%lx\n%s\n",
+                    pwine_get_build_id ? pwine_get_build_id() : "unknown",
+                    (unsigned long)st->st_mtime, (unsigned long)st->st_size, debugstr_w(user) );
+    for (; *machines && pos >= 0 && pos < size; machines++)
+        pos += snprintf( buffer + pos, size - pos, "%lx\n", *machines );
+}
+
 /* execute rundll32 on the wine.inf file if necessary */
 static void update_wineprefix( BOOL force )
 {
     const WCHAR *config_dir = _wgetenv( L"WINECONFIGDIR" );
+    const WCHAR *snapshot_dir = _wgetenv( L"WINEBOOT_SNAPSHOT" );
     WCHAR *inf_path = get_wine_inf_path();
     int fd;
     struct stat st;
@@ -1471,13 +1638,23 @@ static void update_wineprefix( BOOL force )
     if (update_timestamp( config_dir, st.st_mtime ) || force)
     {
         ULONG machines[8];
+        char version[512];
         HANDLE process = 0;
         DWORD count = 0;
+        BOOL installed = FALSE;
 
         if (NtQuerySystemInformationEx( SystemSupportedProcessorArchitectures, &process, sizeof(process),
                                         machines, sizeof(machines), NULL )) machines[0] = 0;
 
-        if ((process = start_rundll32( inf_path, L"PreInstall", IMAGE_FILE_MACHINE_TARGET_HOST )))
+        if (snapshot_dir) get_snapshot_version( version, sizeof(version), &st, machines );
+
+        if (snapshot_dir && apply_prefix_snapshot( snapshot_dir, version ))
+        {
+            /* the snapshot contains the values of the prefix it was recorded in */
+            create_environment_registry_keys();
+            create_computer_name_keys();
+        }
+        else if ((process = start_rundll32( inf_path, L"PreInstall", IMAGE_FILE_MACHINE_TARGET_HOST )))
         {
             HWND hwnd = show_wait_window();
             for (;;)
@@ -1487,7 +1664,11 @@ static void update_wineprefix( BOOL force )
                 if (res == WAIT_OBJECT_0)
                 {
                     CloseHandle( process );
-                    if (!machines[count]) break;
+                    if (!machines[count])
+                    {
+                        installed = TRUE;
+                        break;
+                    }
                     if (HIWORD(machines[count]) & 4 /* native machine */)
                         process = start_rundll32( inf_path, L"DefaultInstall", IMAGE_FILE_MACHINE_TARGET_HOST );
                     else
@@ -1498,6 +1679,7 @@ static void update_wineprefix( BOOL force )
                 else while (PeekMessageW( &msg, 0, 0, 0, PM_REMOVE )) DispatchMessageW( &msg );
             }
             DestroyWindow( hwnd );
+            if (snapshot_dir && installed) record_prefix_snapshot( snapshot_dir, version );
         }
         install_root_pnp_devices();
         update_user_profile();
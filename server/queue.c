@@ -114,6 +114,9 @@ struct thread_input
     unsigned char          keystate[256]; /* state of each key */
     unsigned char          desktop_keystate[256]; /* desktop keystate when keystate was synced */
     int                    keystate_lock; /* keystate is locked */
+    unsigned int           id;            /* unique id, published in the queue shared memory */
+    struct object         *shm_mapping;   /* mapping for the shared memory */
+    input_shm_t           *shm;           /* state shared with the clients */
 };
 
 struct msg_queue
@@ -141,6 +144,8 @@ struct msg_queue
     struct hook_table     *hooks;           /* hook table */
     timeout_t              last_get_msg;    /* time of last get message call */
     int                    keystate_lock;   /* owns an input keystate lock */
+    struct object         *shm_mapping;     /* mapping for the shared memory */
+    queue_shm_t           *shm;             /* state shared with the clients */
 };
 
 struct hotkey
@@ -231,9 +236,49 @@ static unsigned int last_input_time;
 static cursor_pos_t cursor_history[64];
 static unsigned int cursor_history_latest;
 
+static unsigned int last_input_id;
+
 static void queue_hardware_message( struct desktop *desktop, struct message *msg, int always_queue );
 static void free_message( struct message *msg );
 
+/* publish the thread input state to its shared memory */
+static void update_input_shm( struct thread_input *input )
+{
+    input_shm_t *shm = input->shm;
+
+    if (!shm) return;
+    shared_write_begin( &shm->seq );
+    shm->focus         = input->focus;
+    shm->capture       = input->capture;
+    shm->active        = input->active;
+    shm->menu_owner    = input->menu_owner;
+    shm->move_size     = input->move_size;
+    shm->caret         = input->caret;
+    shm->caret_rect    = input->caret_rect;
+    shm->cursor        = input->cursor;
+    shm->cursor_count  = input->cursor_count;
+    shm->keystate_lock = input->keystate_lock;
+    memcpy( (void *)shm->keystate, input->keystate, sizeof(shm->keystate) );
+    memcpy( (void *)shm->desktop_keystate, input->desktop_keystate, sizeof(shm->desktop_keystate) );
+    shared_write_end( &shm->seq );
+}
+
+/* publish the queue state to its shared memory */
+static void update_queue_shm( struct msg_queue *queue )
+{
+    queue_shm_t *shm = queue->shm;
+
+    if (!shm) return;
+    shared_write_begin( &shm->seq );
+    shm->input_id     = queue->input ? queue->input->id : 0;
+    shm->wake_bits    = queue->wake_bits;
+    shm->wake_mask    = queue->wake_mask;
+    shm->changed_bits = queue->changed_bits;
+    shm->changed_mask = queue->changed_mask;
+    shm->last_get_msg = get_tick_count() - (current_time - queue->last_get_msg) / 10000;
+    shared_write_end( &shm->seq );
+}
+
 /* set the caret window in a given thread input */
 static void set_caret_window( struct thread_input *input, user_handle_t win )
 {
@@ -267,6 +312,9 @@ static struct thread_input *create_thread_input( struct thread *thread )
         set_caret_window( input, 0 );
         memset( input->keystate, 0, sizeof(input->keystate) );
         input->keystate_lock = 0;
+        input->id            = ++last_input_id;
+        input->shm_mapping   = NULL;
+        input->shm           = NULL;
 
         if (!(input->desktop = get_thread_desktop( thread, 0 /* FIXME: access rights */ )))
         {
@@ -309,6 +357,8 @@ static struct msg_queue *create_msg_queue( struct thread *thread, struct thread_
         queue->hooks           = NULL;
         queue->last_get_msg    = current_time;
         queue->keystate_lock   = 0;
+        queue->shm_mapping     = NULL;
+        queue->shm             = NULL;
         list_init( &queue->send_result );
         list_init( &queue->callback_result );
         list_init( &queue->pending_timers );
@@ -333,19 +383,22 @@ void free_msg_queue( struct thread *thread )
 /* synchronize thread input keystate with the desktop */
 static void sync_input_keystate( struct thread_input *input )
 {
-    int i;
+    int i, changed = 0;
     if (!input->desktop || input->keystate_lock) return;
     for (i = 0; i < sizeof(input->keystate); ++i)
     {
         if (input->desktop_keystate[i] == input->desktop->keystate[i]) continue;
         input->keystate[i] = input->desktop_keystate[i] = input->desktop->keystate[i];
+        changed = 1;
     }
+    if (changed) update_input_shm( input );
 }
 
 /* locks thread input keystate to prevent synchronization */
 static void lock_input_keystate( struct thread_input *input )
 {
     input->keystate_lock++;
+    update_input_shm( input );
 }
 
 /* unlock the thread input keystate and synchronize it again */
@@ -353,6 +406,7 @@ static void unlock_input_keystate( struct thread_input *input )
 {
     input->keystate_lock--;
     if (!input->keystate_lock) sync_input_keystate( input );
+    update_input_shm( input );
 }
 
 /* change the thread input data of a given thread */
@@ -369,11 +423,14 @@ static int assign_thread_input( struct thread *thread, struct thread_input *new_
     {
         queue->input->cursor_count -= queue->cursor_count;
         if (queue->keystate_lock) unlock_input_keystate( queue->input );
+        update_input_shm( queue->input );
         release_object( queue->input );
     }
     queue->input = (struct thread_input *)grab_object( new_input );
     if (queue->keystate_lock) lock_input_keystate( queue->input );
     new_input->cursor_count += queue->cursor_count;
+    update_input_shm( new_input );
+    update_queue_shm( queue );
     return 1;
 }
 
@@ -413,6 +470,7 @@ static int update_desktop_cursor_pos( struct desktop *desktop, int x, int y )
     desktop->cursor.x = x;
     desktop->cursor.y = y;
     desktop->cursor.last_change = get_tick_count();
+    update_desktop_shm( desktop );
 
     return updated;
 }
@@ -466,6 +524,7 @@ static void set_clip_rectangle( struct desktop *desktop, const rectangle_t *rect
         desktop->cursor.clip = new_rect;
     }
     else desktop->cursor.clip = top_rect;
+    update_desktop_shm( desktop );
 
     if (desktop->cursor.clip_msg && send_clip_msg)
         post_desktop_message( desktop, desktop->cursor.clip_msg, rect != NULL, 0 );
@@ -516,6 +575,7 @@ static inline void set_queue_bits( struct msg_queue *queue, unsigned int bits )
     }
     queue->wake_bits |= bits;
     queue->changed_bits |= bits;
+    update_queue_shm( queue );
     if (is_signaled( queue )) wake_up( &queue->obj, 0 );
 }
 
@@ -529,6 +589,7 @@ static inline void clear_queue_bits( struct msg_queue *queue, unsigned int bits
         if (queue->keystate_lock) unlock_input_keystate( queue->input );
         queue->keystate_lock = 0;
     }
+    update_queue_shm( queue );
 }
 
 /* check whether msg is a keyboard message */
@@ -1038,6 +1099,7 @@ static void msg_queue_satisfied( struct object *obj, struct wait_queue_entry *en
     struct msg_queue *queue = (struct msg_queue *)obj;
     queue->wake_mask = 0;
     queue->changed_mask = 0;
+    update_queue_shm( queue );
 }
 
 static void msg_queue_destroy( struct object *obj )
@@ -1074,9 +1136,11 @@ static void msg_queue_destroy( struct object *obj )
     if (queue->timeout) remove_timeout_user( queue->timeout );
     queue->input->cursor_count -= queue->cursor_count;
     if (queue->keystate_lock) unlock_input_keystate( queue->input );
+    update_input_shm( queue->input );
     release_object( queue->input );
     if (queue->hooks) release_object( queue->hooks );
     if (queue->fd) release_object( queue->fd );
+    free_shared_mapping( queue->shm_mapping, (void *)queue->shm, sizeof(*queue->shm) );
 }
 
 static void msg_queue_poll_event( struct fd *fd, int event )
@@ -1106,6 +1170,7 @@ static void thread_input_destroy( struct object *obj )
         if (input->desktop->foreground_input == input) set_foreground_input( input->desktop, NULL );
         release_object( input->desktop );
     }
+    free_shared_mapping( input->shm_mapping, (void *)input->shm, sizeof(*input->shm) );
 }
 
 /* fix the thread input data when a window is destroyed */
@@ -1119,6 +1184,7 @@ static inline void thread_input_cleanup_window( struct msg_queue *queue, user_ha
     if (window == input->menu_owner) input->menu_owner = 0;
     if (window == input->move_size) input->move_size = 0;
     if (window == input->caret) set_caret_window( input, 0 );
+    update_input_shm( input );
 }
 
 /* check if the specified window can be set in the input data of a given queue */
@@ -1174,6 +1240,7 @@ int attach_thread_input( struct thread *thread_from, struct thread *thread_to )
 
     ret = assign_thread_input( thread_from, input );
     if (ret) memset( input->keystate, 0, sizeof(input->keystate) );
+    update_input_shm( input );
     release_object( input );
     return ret;
 }
@@ -1405,6 +1472,14 @@ static void update_input_key_state( struct desktop *desktop, unsigned char *keys
         }
         break;
     }
+    if (keystate == desktop->keystate) update_desktop_shm( desktop );
+}
+
+/* update the thread input key state for a message */
+static void update_thread_input_key_state( struct thread_input *input, unsigned int msg, lparam_t wparam )
+{
+    update_input_key_state( input->desktop, input->keystate, msg, wparam );
+    update_input_shm( input );
 }
 
 /* update the desktop key state according to a mouse message flags */
@@ -1456,7 +1531,7 @@ static void release_hardware_message( struct msg_queue *queue, unsigned int hw_i
     }
     if (clr_bit) clear_queue_bits( queue, clr_bit );
 
-    update_input_key_state( input->desktop, input->keystate, msg->msg, msg->wparam );
+    update_thread_input_key_state( input, msg->msg, msg->wparam );
     list_remove( &msg->entry );
     free_message( msg );
 }
@@ -1603,7 +1678,7 @@ static void queue_hardware_message( struct desktop *desktop, struct message *msg
     win = find_hardware_message_window( desktop, input, msg, &msg_code, &thread );
     if (!win || !thread)
     {
-        if (input) update_input_key_state( input->desktop, input->keystate, msg->msg, msg->wparam );
+        if (input) update_thread_input_key_state( input, msg->msg, msg->wparam );
         free_message( msg );
         return;
     }
@@ -1785,6 +1860,7 @@ static int queue_mouse_message( struct desktop *desktop, user_handle_t win, cons
     };
 
     desktop->cursor.last_change = get_tick_count();
+    update_desktop_shm( desktop );
     flags = input->mouse.flags;
     time  = input->mouse.time;
     if (!time) time = desktop->cursor.last_change;
@@ -1947,6 +2023,7 @@ static int queue_keyboard_message( struct desktop *desktop, user_handle_t win, c
         desktop->keystate[VK_MENU] &= ~0x02;
         break;
     }
+    update_desktop_shm( desktop );
 
     if ((foreground = get_foreground_thread( desktop, win )))
     {
@@ -2135,7 +2212,7 @@ static int get_hardware_message( struct thread *thread, unsigned int hw_id, user
         if (!win || !win_thread)
         {
             /* no window at all, remove it */
-            update_input_key_state( input->desktop, input->keystate, msg->msg, msg->wparam );
+            update_thread_input_key_state( input, msg->msg, msg->wparam );
             list_remove( &msg->entry );
             free_message( msg );
             continue;
@@ -2151,7 +2228,7 @@ static int get_hardware_message( struct thread *thread, unsigned int hw_id, user
             else
             {
                 /* for another thread input, drop it */
-                update_input_key_state( input->desktop, input->keystate, msg->msg, msg->wparam );
+                update_thread_input_key_state( input, msg->msg, msg->wparam );
                 list_remove( &msg->entry );
                 free_message( msg );
             }
@@ -2448,6 +2525,7 @@ DECL_HANDLER(set_queue_mask)
             if (req->skip_wait) queue->wake_mask = queue->changed_mask = 0;
             else wake_up( &queue->obj, 0 );
         }
+        update_queue_shm( queue );
     }
 }
 
@@ -2461,6 +2539,7 @@ DECL_HANDLER(get_queue_status)
         reply->wake_bits    = queue->wake_bits;
         reply->changed_bits = queue->changed_bits;
         queue->changed_bits &= ~req->clear_bits;
+        if (reply->changed_bits & req->clear_bits) update_queue_shm( queue );
     }
     else reply->wake_bits = reply->changed_bits = 0;
 }
@@ -2643,6 +2722,7 @@ DECL_HANDLER(get_message)
     }
     if (filter & QS_INPUT) queue->changed_bits &= ~QS_INPUT;
     if (filter & QS_PAINT) queue->changed_bits &= ~QS_PAINT;
+    update_queue_shm( queue );
 
     /* then check for posted messages */
     if ((filter & QS_POSTMESSAGE) &&
@@ -2697,6 +2777,7 @@ DECL_HANDLER(get_message)
     if (get_win == -1 && current->process->idle_event) set_event( current->process->idle_event );
     queue->wake_mask = req->wake_mask;
     queue->changed_mask = req->changed_mask;
+    update_queue_shm( queue );
     set_error( STATUS_PENDING );  /* FIXME */
 }
 
@@ -3072,6 +3153,7 @@ DECL_HANDLER(get_key_state)
         {
             reply->state = desktop->keystate[req->key & 0xff];
             desktop->keystate[req->key & 0xff] &= ~0x40;
+            if (reply->state & 0x40) update_desktop_shm( desktop );
         }
         set_reply_data( desktop->keystate, size );
         release_object( desktop );
@@ -3099,9 +3181,11 @@ DECL_HANDLER(set_key_state)
 
     memcpy( queue->input->keystate, get_req_data(), size );
     memcpy( queue->input->desktop_keystate, queue->input->desktop->keystate, 256 );
+    update_input_shm( queue->input );
     if (req->async && (desktop = get_thread_desktop( current, 0 )))
     {
         memcpy( desktop->keystate, get_req_data(), size );
+        update_desktop_shm( desktop );
         release_object( desktop );
     }
 }
@@ -3143,6 +3227,7 @@ DECL_HANDLER(set_focus_window)
     {
         reply->previous = queue->input->focus;
         queue->input->focus = get_user_full_handle( req->handle );
+        update_input_shm( queue->input );
     }
 }
 
@@ -3159,6 +3244,7 @@ DECL_HANDLER(set_active_window)
         {
             reply->previous = queue->input->active;
             queue->input->active = get_user_full_handle( req->handle );
+            update_input_shm( queue->input );
         }
         else set_error( STATUS_INVALID_HANDLE );
     }
@@ -3186,6 +3272,7 @@ DECL_HANDLER(set_capture_window)
         input->menu_owner = (req->flags & CAPTURE_MENU) ? input->capture : 0;
         input->move_size = (req->flags & CAPTURE_MOVESIZE) ? input->capture : 0;
         reply->full_handle = input->capture;
+        update_input_shm( input );
     }
 }
 
@@ -3208,6 +3295,7 @@ DECL_HANDLER(set_caret_window)
         set_caret_window( input, get_user_full_handle(req->handle) );
         input->caret_rect.right  = input->caret_rect.left + req->width;
         input->caret_rect.bottom = input->caret_rect.top + req->height;
+        update_input_shm( input );
     }
 }
 
@@ -3236,6 +3324,7 @@ DECL_HANDLER(set_caret_info)
         input->caret_rect.bottom += req->y - input->caret_rect.top;
         input->caret_rect.left = req->x;
         input->caret_rect.top  = req->y;
+        update_input_shm( input );
     }
     if (req->flags & SET_CARET_HIDE)
     {
@@ -3291,6 +3380,7 @@ DECL_HANDLER(set_cursor)
         queue->cursor_count += req->show_count;
         input->cursor_count += req->show_count;
     }
+    if (req->flags & (SET_CURSOR_HANDLE | SET_CURSOR_COUNT)) update_input_shm( input );
     if (req->flags & SET_CURSOR_POS)
     {
         set_cursor_pos( input->desktop, req->x, req->y );
@@ -3323,6 +3413,51 @@ DECL_HANDLER(get_cursor_history)
             pos[i] = cursor_history[(i + cursor_history_latest) % ARRAY_SIZE(cursor_history)];
 }
 
+/* get a handle to the shared memory holding user state of the current thread */
+DECL_HANDLER(get_user_shared_memory)
+{
+    struct msg_queue *queue = current->queue;
+    struct desktop *desktop;
+    struct object *mapping = NULL;
+    void *ptr;
+
+    switch (req->type)
+    {
+    case USER_SHM_DESKTOP:
+        /* don't create a queue, the thread desktop is the input desktop until a queue exists */
+        if (queue) desktop = (struct desktop *)grab_object( queue->input->desktop );
+        else if (!(desktop = get_thread_desktop( current, 0 ))) return;
+        if ((mapping = get_desktop_shared_mapping( desktop )))
+            reply->handle = alloc_handle( current->process, mapping, SECTION_MAP_READ | SECTION_QUERY, 0 );
+        release_object( desktop );
+        return;
+    case USER_SHM_QUEUE:
+        if (!(queue = get_current_queue())) return;
+        if (!queue->shm_mapping && (queue->shm_mapping = create_shared_mapping( sizeof(*queue->shm), &ptr )))
+        {
+            queue->shm = ptr;
+            update_queue_shm( queue );
+        }
+        mapping = queue->shm_mapping;
+        break;
+    case USER_SHM_INPUT:
+        if (!(queue = get_current_queue())) return;
+        if (!queue->input->shm_mapping &&
+            (queue->input->shm_mapping = create_shared_mapping( sizeof(*queue->input->shm), &ptr )))
+        {
+            queue->input->shm = ptr;
+            update_input_shm( queue->input );
+        }
+        mapping = queue->input->shm_mapping;
+        reply->input_id = queue->input->id;
+        break;
+    default:
+        set_error( STATUS_INVALID_PARAMETER );
+        return;
+    }
+    if (mapping) reply->handle = alloc_handle( current->process, mapping, SECTION_MAP_READ | SECTION_QUERY, 0 );
+}
+
 DECL_HANDLER(get_rawinput_buffer)
 {
     struct thread_input *input = current->queue->input;
@@ -383,6 +383,7 @@ DECL_HANDLER(alloc_user_handle);
 DECL_HANDLER(free_user_handle);
 DECL_HANDLER(set_cursor);
 DECL_HANDLER(get_cursor_history);
+DECL_HANDLER(get_user_shared_memory);
 DECL_HANDLER(get_rawinput_buffer);
 DECL_HANDLER(update_rawinput_devices);
 DECL_HANDLER(create_job);
@@ -666,6 +667,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_free_user_handle,
     (req_handler)req_set_cursor,
     (req_handler)req_get_cursor_history,
+    (req_handler)req_get_user_shared_memory,
     (req_handler)req_get_rawinput_buffer,
     (req_handler)req_update_rawinput_devices,
     (req_handler)req_create_job,
@@ -2217,6 +2219,11 @@ C_ASSERT( FIELD_OFFSET(struct set_cursor_reply, last_change) == 48 );
 C_ASSERT( sizeof(struct set_cursor_reply) == 56 );
 C_ASSERT( sizeof(struct get_cursor_history_request) == 16 );
 C_ASSERT( sizeof(struct get_cursor_history_reply) == 8 );
+C_ASSERT( FIELD_OFFSET(struct get_user_shared_memory_request, type) == 12 );
+C_ASSERT( sizeof(struct get_user_shared_memory_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_user_shared_memory_reply, handle) == 8 );
+C_ASSERT( FIELD_OFFSET(struct get_user_shared_memory_reply, input_id) == 12 );
+C_ASSERT( sizeof(struct get_user_shared_memory_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_rawinput_buffer_request, rawinput_size) == 12 );
 C_ASSERT( FIELD_OFFSET(struct get_rawinput_buffer_request, buffer_size) == 16 );
 C_ASSERT( sizeof(struct get_rawinput_buffer_request) == 24 );
@@ -4390,6 +4390,17 @@ static void dump_get_cursor_history_reply( const struct get_cursor_history_reply
     dump_varargs_cursor_positions( " history=", cur_size );
 }
 
+static void dump_get_user_shared_memory_request( const struct get_user_shared_memory_request *req )
+{
+    fprintf( stderr, " type=%d", req->type );
+}
+
+static void dump_get_user_shared_memory_reply( const struct get_user_shared_memory_reply *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+    fprintf( stderr, ", input_id=%08x", req->input_id );
+}
+
 static void dump_get_rawinput_buffer_request( const struct get_rawinput_buffer_request *req )
 {
     fprintf( stderr, " rawinput_size=%u", req->rawinput_size );
@@ -4764,6 +4775,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_free_user_handle_request,
     (dump_func)dump_set_cursor_request,
     (dump_func)dump_get_cursor_history_request,
+    (dump_func)dump_get_user_shared_memory_request,
     (dump_func)dump_get_rawinput_buffer_request,
     (dump_func)dump_update_rawinput_devices_request,
     (dump_func)dump_create_job_request,
@@ -5044,6 +5056,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     NULL,
     (dump_func)dump_set_cursor_reply,
     (dump_func)dump_get_cursor_history_reply,
+    (dump_func)dump_get_user_shared_memory_reply,
     (dump_func)dump_get_rawinput_buffer_reply,
     NULL,
     (dump_func)dump_create_job_reply,
@@ -5324,6 +5337,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "free_user_handle",
     "set_cursor",
     "get_cursor_history",
+    "get_user_shared_memory",
     "get_rawinput_buffer",
     "update_rawinput_devices",
     "create_job",
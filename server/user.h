@@ -77,8 +77,23 @@ struct desktop
     unsigned int         users;            /* processes and threads using this desktop */
     struct global_cursor cursor;           /* global cursor information */
     unsigned char        keystate[256];    /* asynchronous key state */
+    struct object       *shm_mapping;      /* mapping for the shared memory */
+    desktop_shm_t       *shm;              /* state shared with the clients */
 };
 
+/* shared memory updates, the clients retry their reads while the sequence number is odd or changed */
+
+static inline void shared_write_begin( volatile int *seq )
+{
+    __atomic_add_fetch( seq, 1, __ATOMIC_RELAXED );
+    __atomic_thread_fence( __ATOMIC_RELEASE );
+}
+
+static inline void shared_write_end( volatile int *seq )
+{
+    __atomic_add_fetch( seq, 1, __ATOMIC_RELEASE );
+}
+
 /* user handles functions */
 
 extern user_handle_t alloc_user_handle( void *ptr, enum user_object type );
@@ -190,6 +205,8 @@ extern void set_process_default_desktop( struct process *process, struct desktop
 extern void close_process_desktop( struct process *process );
 extern void set_thread_default_desktop( struct thread *thread, struct desktop *desktop, obj_handle_t handle );
 extern void release_thread_desktop( struct thread *thread, int close );
+extern struct object *get_desktop_shared_mapping( struct desktop *desktop );
+extern void update_desktop_shm( struct desktop *desktop );
 
 static inline int is_rect_empty( const rectangle_t *rect )
 {
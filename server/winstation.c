@@ -237,6 +237,8 @@ static struct desktop *create_desktop( const struct unicode_str *name, unsigned
             desktop->users = 0;
             memset( &desktop->cursor, 0, sizeof(desktop->cursor) );
             memset( desktop->keystate, 0, sizeof(desktop->keystate) );
+            desktop->shm_mapping = NULL;
+            desktop->shm = NULL;
             list_add_tail( &winstation->desktops, &desktop->entry );
             list_init( &desktop->hotkeys );
         }
@@ -291,10 +293,40 @@ static void desktop_destroy( struct object *obj )
     if (desktop->msg_window) free_window_handle( desktop->msg_window );
     if (desktop->global_hooks) release_object( desktop->global_hooks );
     if (desktop->close_timeout) remove_timeout_user( desktop->close_timeout );
+    free_shared_mapping( desktop->shm_mapping, (void *)desktop->shm, sizeof(*desktop->shm) );
     list_remove( &desktop->entry );
     release_object( desktop->winstation );
 }
 
+/* publish the desktop cursor and key state to its shared memory */
+void update_desktop_shm( struct desktop *desktop )
+{
+    desktop_shm_t *shm = desktop->shm;
+
+    if (!shm) return;
+    shared_write_begin( &shm->seq );
+    shm->cursor_x           = desktop->cursor.x;
+    shm->cursor_y           = desktop->cursor.y;
+    shm->cursor_last_change = desktop->cursor.last_change;
+    shm->cursor_clip        = desktop->cursor.clip;
+    memcpy( (void *)shm->keystate, desktop->keystate, sizeof(shm->keystate) );
+    shared_write_end( &shm->seq );
+}
+
+/* get the desktop shared memory mapping, creating it on first use */
+struct object *get_desktop_shared_mapping( struct desktop *desktop )
+{
+    void *ptr;
+
+    if (!desktop->shm_mapping)
+    {
+        if (!(desktop->shm_mapping = create_shared_mapping( sizeof(*desktop->shm), &ptr ))) return NULL;
+        desktop->shm = ptr;
+        update_desktop_shm( desktop );
+    }
+    return desktop->shm_mapping;
+}
+
 /* retrieve the thread desktop, checking the handle access rights */
 struct desktop *get_thread_desktop( struct thread *thread, unsigned int access )
 {